@@ -0,0 +1,115 @@
+# ifndef H_DATAFLOW_BENCHMARKS_COMMON_H
+# define H_DATAFLOW_BENCHMARKS_COMMON_H
+
+/*
+ * Minimalistic helpers shared by the benchmark executables: wall-clock
+ * timing, optional heap accounting and resident set size reporting.
+ *
+ * Define DATAFLOW_BENCH_COUNT_ALLOCATIONS before including this header (in
+ * exactly one translation unit of the executable) to replace global
+ * `operator new`/`operator delete` with counting versions.
+ */
+
+# include <chrono>
+# include <cstdio>
+# include <cstdlib>
+# include <atomic>
+# include <sys/resource.h>
+
+# ifdef DATAFLOW_BENCH_COUNT_ALLOCATIONS
+#   include <malloc.h>
+#   include <new>
+# endif
+
+namespace dataflow {
+namespace bench {
+
+/// Monotonic wall-clock time in seconds.
+inline double
+now() {
+    return std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+/// Peak resident set size of the process, in kilobytes.
+inline long
+peak_rss_kb() {
+    struct rusage ru;
+    getrusage( RUSAGE_SELF, &ru );
+    return ru.ru_maxrss;
+}
+
+/// Prevents compiler from optimizing out the computation of value.
+template<typename T> inline void
+do_not_optimize( const T & v ) {
+    asm volatile( "" : : "g"(&v) : "memory" );
+}
+
+/// Heap usage counters (updated only if allocations counting is enabled).
+struct HeapCounters {
+    std::atomic<long> nAllocs;  ///< Number of allocations done
+    std::atomic<long> bytesInUse;  ///< Bytes currently allocated
+};
+
+inline HeapCounters &
+heap_counters() {
+    static HeapCounters c = { {0}, {0} };
+    return c;
+}
+
+}  // namespace ::dataflow::bench
+}  // namespace ::dataflow
+
+# ifdef DATAFLOW_BENCH_COUNT_ALLOCATIONS
+void *
+operator new( size_t sz ) {
+    void * p = malloc( sz ? sz : 1 );
+    if( !p ) throw std::bad_alloc();
+    ++dataflow::bench::heap_counters().nAllocs;
+    dataflow::bench::heap_counters().bytesInUse += malloc_usable_size(p);
+    return p;
+}
+
+void *
+operator new[]( size_t sz ) {
+    return operator new( sz );
+}
+
+void
+operator delete( void * p ) noexcept {
+    if( !p ) return;
+    dataflow::bench::heap_counters().bytesInUse -= malloc_usable_size(p);
+    free( p );
+}
+
+void
+operator delete[]( void * p ) noexcept {
+    operator delete( p );
+}
+
+void
+operator delete( void * p, size_t ) noexcept {
+    operator delete( p );
+}
+
+void
+operator delete[]( void * p, size_t ) noexcept {
+    operator delete( p );
+}
+
+void *
+operator new( size_t sz, std::align_val_t al ) {
+    void * p = aligned_alloc( (size_t) al, (sz + (size_t) al - 1) & ~((size_t) al - 1) );
+    if( !p ) throw std::bad_alloc();
+    ++dataflow::bench::heap_counters().nAllocs;
+    dataflow::bench::heap_counters().bytesInUse += malloc_usable_size(p);
+    return p;
+}
+
+void
+operator delete( void * p, std::align_val_t ) noexcept {
+    operator delete( p );
+}
+# endif
+
+# endif  // H_DATAFLOW_BENCHMARKS_COMMON_H
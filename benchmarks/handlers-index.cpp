@@ -0,0 +1,96 @@
+/*
+ * Compares per-event cost of the handler chain resolved by name on each
+ * event (registry lookup, RTTI check of the value type, then call -- as
+ * straightforward implementation of the registry would do) with the one of
+ * the pipeline built from the same names once, and cost of the pipeline
+ * construction itself.
+ *
+ * Usage: dataflow-bench-handlers-index [nEvents]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/pipeline.hpp"
+
+# include <map>
+# include <random>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+static bool cut_negative( const double & x ) { return x > 0; }
+static void calibrate( double & x ) { x = 1.02*x - 0.5; }
+static float to_float( const double & x ) { return float(x); }
+static bool cut_low( const double & x ) { return x > 1.; }
+
+DATAFLOW_REGISTER_HANDLER( "cut_negative", cut_negative )
+DATAFLOW_REGISTER_HANDLER( "calibrate", calibrate )
+DATAFLOW_REGISTER_HANDLER( "to_float", to_float )
+DATAFLOW_REGISTER_HANDLER( "cut_low", cut_low )
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nEvents = argc > 1 ? atoi(argv[1]) : 10000000
+               , nBuilds = 100000;
+    const std::vector<std::string> names
+            = { "cut_negative", "calibrate", "to_float", "cut_low" };
+    std::mt19937 gen( 1337 );
+    std::normal_distribution<double> amp( 5., 5. );
+    std::vector<double> values( 4096 );
+    for( double & v : values ) v = amp(gen);
+
+    // Ordered map of registered handlers, looked up on each event
+    std::map<std::string, HandlerDescription> byName;
+    for( const std::string & n : names ) byName.emplace( n, HandlersIndex::self().get(n) );
+    const Stage adapter = HandlersIndex::self().adapter( PortType::of<float>()
+                                                       , PortType::of<double>() );
+    byName.emplace( "<float to double>", HandlerDescription{ adapter.invoke, nullptr
+                  , adapter.input, adapter.output, kMap, nullptr } );
+    const std::vector<std::string> lookupNames
+            = { "cut_negative", "calibrate", "to_float", "<float to double>", "cut_low" };
+
+    double sum = 0;
+    size_t nLookup = 0, nBuilt = 0;
+    Slot s;
+    double t0 = bench::now();
+    for( size_t i = 0; i < nEvents; ++i ) {
+        s.emplace<double>( values[i % values.size()] );
+        bool passed = true;
+        for( const std::string & n : lookupNames ) {
+            const HandlerDescription & d = byName.find(n)->second;
+            if( std::type_index(d.input.index) != std::type_index(typeid(double))
+             && std::type_index(d.input.index) != std::type_index(typeid(float)) ) abort();
+            if( !d.invoke( nullptr, s ) ) { passed = false; break; }
+        }
+        if( passed ) { sum += s.get<double>(); ++nLookup; }
+    }
+    const double tLookup = bench::now() - t0;
+
+    t0 = bench::now();
+    for( size_t i = 0; i < nBuilds; ++i ) {
+        Pipeline p{ "cut_negative", "calibrate", "to_float", "cut_low" };
+        bench::do_not_optimize( p.size() );
+    }
+    const double tBuild = bench::now() - t0;
+
+    Pipeline p{ "cut_negative", "calibrate", "to_float", "cut_low" };
+    t0 = bench::now();
+    for( size_t i = 0; i < nEvents; ++i ) {
+        if( (p << values[i % values.size()]).succeed() ) {
+            sum += p.get<double>();
+            ++nBuilt;
+        }
+    }
+    const double tBuilt = bench::now() - t0;
+    bench::do_not_optimize( sum );
+    if( nLookup != nBuilt ) {
+        fprintf( stderr, "Chains disagree: %zu vs %zu events passed.\n", nLookup, nBuilt );
+        return 1;
+    }
+    printf( "%zu events, %zu passed, %zu stages\n", nEvents, nBuilt, p.size() );
+    printf( "lookup per event: %6.2f ns/event\n", 1e9*tLookup/nEvents );
+    printf( "built pipeline:   %6.2f ns/event\n", 1e9*tBuilt/nEvents );
+    printf( "pipeline build:   %6.2f us\n", 1e6*tBuild/nBuilds );
+    return 0;
+}
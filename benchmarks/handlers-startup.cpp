@@ -0,0 +1,87 @@
+/*
+ * Compares cost of loading the library of 5000 handlers registered by
+ * constant table entries (described on lookup) with the one of the library
+ * registering them by static initializers, and cost of the first pipeline
+ * built from five of its handlers. Each measurement is done in the new
+ * process (plugin can not be loaded twice), median is reported.
+ *
+ * Usage: dataflow-bench-handlers-startup [nRuns]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/pipeline.hpp"
+
+# include <algorithm>
+# include <vector>
+
+# include <sys/wait.h>
+# include <unistd.h>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+static bool cut_negative( const double & x ) { return x > 0; }
+
+DATAFLOW_REGISTER_HANDLER( "cut_negative", cut_negative )
+
+// Measures load of the plugin and build of the pipeline in child process
+static bool
+measure( const std::string & plugin, const std::string & path, double & tLoad, double & tBuild ) {
+    int fds[2];
+    if( pipe( fds ) ) return false;
+    const pid_t pid = fork();
+    if( !pid ) {
+        double t[2] = {0, 0};
+        double t0 = bench::now();
+        if( !plugin.empty() ) {
+            HandlersIndex::self().add_plugin( plugin, path );
+            HandlersIndex::self().load( plugin );
+        }
+        t[0] = bench::now() - t0;
+        t0 = bench::now();
+        Pipeline p( "cut_negative" );
+        if( !plugin.empty() ) {
+            for( int i : { 1, 10, 100, 1000, 4999 } ) {
+                p.append( plugin + "/synthetic_" + std::to_string(i) );
+            }
+        }
+        t[1] = bench::now() - t0;
+        bench::do_not_optimize( p.size() );
+        const bool ok = sizeof(t) == write( fds[1], t, sizeof(t) );
+        _exit( ok ? 0 : 1 );
+    }
+    close( fds[1] );
+    double t[2];
+    const bool ok = sizeof(t) == read( fds[0], t, sizeof(t) );
+    close( fds[0] );
+    int status;
+    waitpid( pid, &status, 0 );
+    tLoad = t[0];
+    tBuild = t[1];
+    return ok && WIFEXITED(status) && !WEXITSTATUS(status);
+}
+
+int
+main( int argc, char * argv[] ) {
+    const int nRuns = argc > 1 ? atoi(argv[1]) : 21;
+    const char * names[3] = { "not referenced", "table entries", "static initializers" };
+    const std::string plugins[3] = { "", "synthetic", "eager" }
+                    , paths[3] = { "", DATAFLOW_BENCH_SYNTHETIC, DATAFLOW_BENCH_SYNTHETIC_EAGER };
+
+    printf( "%d runs, medians\n", nRuns );
+    printf( "%-22s %12s %12s\n", "", "load, us", "build, us" );
+    for( int k = 0; k < 3; ++k ) {
+        std::vector<double> tLoad( nRuns ), tBuild( nRuns );
+        for( int i = 0; i < nRuns; ++i ) {
+            if( !measure( plugins[k], paths[k], tLoad[i], tBuild[i] ) ) {
+                fprintf( stderr, "Unable to load \"%s\".\n", paths[k].c_str() );
+                return 1;
+            }
+        }
+        std::sort( tLoad.begin(), tLoad.end() );
+        std::sort( tBuild.begin(), tBuild.end() );
+        printf( "%-22s %12.1f %12.1f\n", names[k], 1e6*tLoad[nRuns/2], 1e6*tBuild[nRuns/2] );
+    }
+    return 0;
+}
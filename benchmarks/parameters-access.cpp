@@ -0,0 +1,57 @@
+/*
+ * Measures the cost of typed access to the parameter value: former
+ * RTTI-based `dynamic_cast` downcast against the tag-checked as<T>() and
+ * unchecked as_unchecked<T>() accessors.
+ *
+ * Usage: dataflow-bench-parameters-access [nIterations]
+ */
+
+# include "common.hpp"
+
+# include "parameters/parameter.tcc"
+
+# include <vector>
+
+using namespace dataflow::config;
+namespace bench = dataflow::bench;
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nIterations = argc > 1 ? atol(argv[1]) : 100000000
+               , nParameters = 1024;
+    std::vector<std::shared_ptr<AbstractParameter> > ps;
+    for( size_t i = 0; i < nParameters; ++i ) {
+        ps.emplace_back( new Parameter<double>(i) );
+    }
+    // Hide the container from optimizer to prevent devirtualization
+    std::vector<std::shared_ptr<AbstractParameter> > * psp = &ps;
+    bench::do_not_optimize( psp );
+
+    double sum = 0, t0 = bench::now();
+    for( size_t i = 0; i < nIterations; ++i ) {
+        sum += dynamic_cast<const Parameter<double>&>(*(*psp)[i % nParameters]).value();
+    }
+    const double tDynamic = bench::now() - t0;
+    bench::do_not_optimize( sum );
+
+    sum = 0;
+    t0 = bench::now();
+    for( size_t i = 0; i < nIterations; ++i ) {
+        sum += (*psp)[i % nParameters]->as<double>();
+    }
+    const double tChecked = bench::now() - t0;
+    bench::do_not_optimize( sum );
+
+    sum = 0;
+    t0 = bench::now();
+    for( size_t i = 0; i < nIterations; ++i ) {
+        sum += (*psp)[i % nParameters]->as_unchecked<double>();
+    }
+    const double tUnchecked = bench::now() - t0;
+    bench::do_not_optimize( sum );
+
+    printf( "dynamic_cast (former as<T>()): %6.2f ns/access\n", 1e9*tDynamic/nIterations );
+    printf( "tag-checked as<T>():           %6.2f ns/access\n", 1e9*tChecked/nIterations );
+    printf( "as_unchecked<T>():             %6.2f ns/access\n", 1e9*tUnchecked/nIterations );
+    return 0;
+}
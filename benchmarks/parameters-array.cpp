@@ -0,0 +1,97 @@
+/*
+ * Compares memory footprint and loop throughput of per-channel constants
+ * stored as Tuple of scalar parameters and as dense kRealArray parameter:
+ *
+ *      pedestals[<c>]
+ *
+ * Usage: dataflow-bench-parameters-array [nChannels]
+ */
+
+# define DATAFLOW_BENCH_COUNT_ALLOCATIONS
+# include "common.hpp"
+
+# include "parameters/path.hpp"
+
+using namespace dataflow::config;
+namespace bench = dataflow::bench;
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nChannels = argc > 1 ? atoi(argv[1]) : 1000000
+               , nPasses = 20
+               ;
+    Dictionary tupleRoot, arrayRoot;
+
+    long heap0 = bench::heap_counters().bytesInUse;
+    {
+        auto t = std::make_shared<Tuple>();
+        for( size_t c = 0; c < nChannels; ++c ) {
+            t->emplace( c, new Parameter<double>(1e-3*c) );
+        }
+        tupleRoot.emplace( "pedestals", t );
+    }
+    const long tupleBytes = bench::heap_counters().bytesInUse - heap0;
+
+    heap0 = bench::heap_counters().bytesInUse;
+    {
+        auto a = std::make_shared<Parameter<RealArray>>( RealArray( nChannels ) );
+        RealArray & v = *a->value_ptr();
+        for( size_t c = 0; c < nChannels; ++c ) v[c] = 1e-3*c;
+        arrayRoot.emplace( "pedestals", a );
+    }
+    const long arrayBytes = bench::heap_counters().bytesInUse - heap0;
+
+    printf( "values: %zu\n", nChannels );
+    printf( "tuple heap usage:  %10ld bytes (%.1f bytes/value)\n"
+          , tupleBytes, tupleBytes/double(nChannels) );
+    printf( "array heap usage:  %10ld bytes (%.1f bytes/value)\n"
+          , arrayBytes, arrayBytes/double(nChannels) );
+
+    // Sum over all the values, as handler would do (e.g. pedestal
+    // subtraction over all channels)
+    double sum = 0, t0 = bench::now();
+    for( size_t p = 0; p < nPasses; ++p ) {
+        const Tuple & t = static_cast<const Tuple &>(
+                get_parameter_ref( tupleRoot, "pedestals" ) );
+        for( const auto & e : t ) sum += e.second->as_unchecked<double>();
+        bench::do_not_optimize( sum );
+    }
+    const double tTuple = bench::now() - t0;
+
+    sum = 0;
+    t0 = bench::now();
+    for( size_t p = 0; p < nPasses; ++p ) {
+        Span<const double> s = get_parameter_ref( arrayRoot, "pedestals" )
+                                    .as<RealArray>().span();
+        double acc = 0;
+        for( size_t i = 0; i < s.size(); ++i ) acc += s[i];
+        sum += acc;
+        bench::do_not_optimize( sum );
+    }
+    const double tArray = bench::now() - t0;
+
+    printf( "tuple loop:        %8.2f ns/value\n", 1e9*tTuple/(nPasses*nChannels) );
+    printf( "array span loop:   %8.2f ns/value\n", 1e9*tArray/(nPasses*nChannels) );
+
+    // Element access by path
+    const size_t nLookups = 1000000;
+    char bf[64];
+    sum = 0;
+    t0 = bench::now();
+    for( size_t i = 0; i < nLookups; ++i ) {
+        snprintf( bf, sizeof(bf), "pedestals[%zu]", (i*7919) % nChannels );
+        sum += get_value<double>( tupleRoot, bf );
+    }
+    const double tTupleLookup = bench::now() - t0;
+    bench::do_not_optimize( sum );
+    t0 = bench::now();
+    for( size_t i = 0; i < nLookups; ++i ) {
+        snprintf( bf, sizeof(bf), "pedestals[%zu]", (i*7919) % nChannels );
+        sum += get_value<double>( arrayRoot, bf );
+    }
+    const double tArrayLookup = bench::now() - t0;
+    bench::do_not_optimize( sum );
+    printf( "tuple path lookup: %8.1f ns/lookup\n", 1e9*tTupleLookup/nLookups );
+    printf( "array path lookup: %8.1f ns/lookup\n", 1e9*tArrayLookup/nLookups );
+    return 0;
+}
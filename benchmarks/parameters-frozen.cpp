@@ -0,0 +1,85 @@
+/*
+ * Compares memory footprint and lookup latency of the mutable parameters tree
+ * and its frozen snapshot. The tree mimics calibration constants:
+ *
+ *      calibration.detectors[<d>].channels[<c>].{pedestal,gain,threshold}
+ *
+ * Usage: dataflow-bench-parameters-frozen [nDetectors [nChannels]]
+ */
+
+# define DATAFLOW_BENCH_COUNT_ALLOCATIONS
+# include "common.hpp"
+
+# include "parameters/frozen.hpp"
+
+# include <random>
+# include <vector>
+
+using namespace dataflow::config;
+namespace bench = dataflow::bench;
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nDetectors = argc > 1 ? atoi(argv[1]) : 100
+               , nChannels = argc > 2 ? atoi(argv[2]) : 334
+               , nLookups = 1000000
+               ;
+    const long heap0 = bench::heap_counters().bytesInUse;
+    auto root = std::make_shared<Dictionary>();
+    {
+        auto calib = std::make_shared<Dictionary>();
+        auto detectors = std::make_shared<Tuple>();
+        for( size_t d = 0; d < nDetectors; ++d ) {
+            auto det = std::make_shared<Dictionary>();
+            auto channels = std::make_shared<Tuple>();
+            for( size_t c = 0; c < nChannels; ++c ) {
+                auto ch = std::make_shared<Dictionary>();
+                ch->emplace( "pedestal", new Parameter<double>(d + 1e-3*c) );
+                ch->emplace( "gain", new Parameter<double>(1.) );
+                ch->emplace( "threshold", new Parameter<int>(c) );
+                channels->emplace( c, ch );
+            }
+            det->emplace( "channels", channels );
+            detectors->emplace( d, det );
+        }
+        calib->emplace( "detectors", detectors );
+        root->emplace( "calibration", calib );
+    }
+    const long treeBytes = bench::heap_counters().bytesInUse - heap0;
+    FrozenConfig frozen = freeze( *root );
+    printf( "leaves: %zu\n", 3*nDetectors*nChannels );
+    printf( "mutable tree heap usage: %10ld bytes (%.1f bytes/leaf)\n"
+          , treeBytes, treeBytes/(3.*nDetectors*nChannels) );
+    printf( "frozen arena size:       %10zu bytes (%.1f bytes/leaf)\n"
+          , frozen.size(), frozen.size()/(3.*nDetectors*nChannels) );
+
+    // Random paths, pre-generated
+    std::mt19937 gen( 1337 );
+    std::vector<std::string> paths;
+    const char * leaves[] = { "pedestal", "gain", "threshold" };
+    for( size_t i = 0; i < 4096; ++i ) {
+        char bf[128];
+        snprintf( bf, sizeof(bf), "calibration.detectors[%zu].channels[%zu].%s"
+                , gen() % nDetectors, gen() % nChannels, leaves[gen()%2] );
+        paths.push_back( bf );
+    }
+
+    double sum = 0, t0 = bench::now();
+    for( size_t i = 0; i < nLookups; ++i ) {
+        sum += get_parameter_ref( *root, paths[i % paths.size()] ).as<double>();
+    }
+    const double tMutable = bench::now() - t0;
+    bench::do_not_optimize( sum );
+
+    sum = 0;
+    t0 = bench::now();
+    for( size_t i = 0; i < nLookups; ++i ) {
+        sum += get_parameter_ref( frozen, paths[i % paths.size()] ).as<double>();
+    }
+    const double tFrozen = bench::now() - t0;
+    bench::do_not_optimize( sum );
+
+    printf( "mutable tree lookup:     %8.1f ns/lookup\n", 1e9*tMutable/nLookups );
+    printf( "frozen lookup:           %8.1f ns/lookup\n", 1e9*tFrozen/nLookups );
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Measures job startup time with binary configuration image against
+ * parsing of the JSON configuration, and memory shared between processes
+ * mapping the same image.
+ *
+ * Usage: dataflow-bench-parameters-image [nChannels [nProcesses]]
+ */
+
+# include "common.hpp"
+
+# include "parameters/json.hpp"
+# include "parameters/frozen.hpp"
+
+# include <cstring>
+# include <fstream>
+# include <string>
+# include <sys/wait.h>
+# include <unistd.h>
+
+using namespace dataflow::config;
+namespace bench = dataflow::bench;
+
+/// Returns value of given field (kB) of the mapping of given file from
+/// /proc/self/smaps.
+static long
+smaps_field( const std::string & filename, const char * name ) {
+    std::ifstream ifs( "/proc/self/smaps" );
+    std::string line;
+    const size_t len = strlen( name );
+    bool inMapping = false;
+    while( std::getline( ifs, line ) ) {
+        if( line.size() > filename.size()
+         && !line.compare( line.size() - filename.size(), filename.size(), filename ) ) {
+            inMapping = true;
+        } else if( inMapping && !line.compare( 0, len, name ) && ':' == line[len] ) {
+            return atol( line.c_str() + len + 1 );
+        }
+    }
+    return -1;
+}
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nChannels = argc > 1 ? atoi(argv[1]) : 500000
+               , nProcesses = argc > 2 ? atoi(argv[2]) : 8;
+    const std::string jsonFile = "/tmp/dataflow-bench-cfg.json"
+                    , imageFile = "/tmp/dataflow-bench-cfg.dfc";
+    {
+        std::ofstream ofs( jsonFile );
+        ofs << "{ \"channels\" : [\n";
+        for( size_t i = 0; i < nChannels; ++i ) {
+            ofs << (i ? "," : " ") << "{ \"pedestal\" : " << 100 + (i % 977)*1e-3
+                << ", \"gain\" : 1.25, \"threshold\" : " << i % 50
+                << ", \"name\" : \"ch" << i << "\" }\n";
+        }
+        ofs << "] }\n";
+    }
+    char path[64];
+    snprintf( path, sizeof(path), "channels[%zu].pedestal", nChannels/2 );
+
+    // Conventional startup: parse JSON, build the tree
+    double t0 = bench::now();
+    std::shared_ptr<AbstractParameter> root;
+    {
+        auto doc = json::Document::load( jsonFile );
+        root = json::to_parameters( doc->root() );
+    }
+    double v = get_parameter_ref( *root, path ).as<double>();
+    const double tParse = bench::now() - t0;
+    bench::do_not_optimize( v );
+
+    // One-time compilation of the image
+    t0 = bench::now();
+    write_image( freeze( *root ), imageFile );
+    const double tCompile = bench::now() - t0;
+    root.reset();
+
+    // Startup with image
+    t0 = bench::now();
+    {
+        FrozenConfig cfg = map_image( imageFile );
+        v = get_parameter_ref( cfg, path ).as<double>();
+    }
+    const double tMap = bench::now() - t0;
+    bench::do_not_optimize( v );
+
+    printf( "channels: %zu\n", nChannels );
+    printf( "startup, JSON parse + tree:   %10.3f ms\n", 1e3*tParse );
+    printf( "image compilation (one-time): %10.3f ms\n", 1e3*tCompile );
+    printf( "startup, image mapping:       %10.3f ms\n", 1e3*tMap );
+
+    // Shared pages: all processes map and read entire image simultaneously
+    int ready[2], go[2];
+    if( pipe( ready ) || pipe( go ) ) return 1;
+    fflush( stdout );
+    for( size_t n = 0; n < nProcesses; ++n ) {
+        if( fork() ) continue;
+        close( ready[0] );
+        close( go[1] );
+        FrozenConfig cfg = map_image( imageFile );
+        long sum = 0;
+        for( size_t i = 0; i < cfg.size(); i += 4096 ) sum += cfg.data()[i];
+        bench::do_not_optimize( sum );
+        char c = 0;
+        if( 1 != write( ready[1], &c, 1 ) ) _exit( 1 );
+        if( read( go[0], &c, 1 ) ) {}  // barrier: blocks until all are ready
+        if( !n ) {
+            printf( "image size: %zu kB, %zu processes mapped it;"
+                    " mapping Rss: %ld kB, Pss: %ld kB\n"
+                  , cfg.size()/1024, nProcesses
+                  , smaps_field(imageFile, "Rss"), smaps_field(imageFile, "Pss") );
+            fflush( stdout );
+        }
+        char c2;
+        if( read( go[0], &c2, 1 ) ) {}  // keep mapping until parent closes pipe
+        _exit( 0 );
+    }
+    close( ready[1] );
+    close( go[0] );
+    for( size_t n = 0; n < nProcesses; ++n ) {
+        char c;
+        if( 1 != read( ready[0], &c, 1 ) ) break;
+    }
+    // Release all the processes from barrier, give the first one time to
+    // report while others still keep the mapping
+    for( size_t n = 0; n < nProcesses; ++n ) {
+        char c = 0;
+        if( 1 != write( go[1], &c, 1 ) ) return 1;
+    }
+    usleep( 200000 );
+    close( go[1] );
+    while( wait( nullptr ) > 0 ) {}
+    remove( jsonFile.c_str() );
+    remove( imageFile.c_str() );
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Compares throughput and peak memory of memory-mapped JSON loader against
+ * naive approach: reading file with `std::ifstream` into string and building
+ * the parameters tree with separate allocation per node.
+ *
+ * Generates synthetic calibrations file (array of channels with couple of
+ * numeric and string values each), then runs each loader in separate process
+ * to measure its peak RSS.
+ *
+ * Usage: dataflow-bench-parameters-json [sizeMB [filename]]
+ */
+
+# include "common.hpp"
+
+# include "parameters/json.hpp"
+
+# include <fstream>
+# include <sstream>
+# include <sys/wait.h>
+# include <unistd.h>
+
+using namespace dataflow::config;
+namespace bench = dataflow::bench;
+
+/// Writes synthetic calibrations file of approximately given size.
+static void
+generate( const char * filename, size_t sizeMB ) {
+    std::ofstream ofs( filename );
+    ofs << "{ \"run\" : 4242, \"channels\" : [\n";
+    size_t written = 0;
+    for( size_t i = 0; written < sizeMB*1024*1024; ++i ) {
+        char bf[256];
+        int n = snprintf( bf, sizeof(bf)
+                , "%s{ \"id\" : %zu, \"pedestal\" : %.6f, \"gain\" : %.6e,"
+                  " \"enabled\" : %s, \"name\" : \"ch%zu\" }\n"
+                , i ? "," : " ", i, 100 + (i % 977)*1e-3, 1. + (i % 13)*1e-4
+                , i % 7 ? "true" : "false", i );
+        ofs.write( bf, n );
+        written += n;
+    }
+    ofs << "] }\n";
+}
+
+//
+// Naive baseline: recursive descent over std::string, node per value
+
+namespace naive {
+
+struct Parser {
+    const std::string & s;
+    size_t p;
+
+    void ws() { while( p < s.size() && isspace(s[p]) ) ++p; }
+    std::string str() {
+        size_t e = s.find( '"', ++p );
+        std::string r = s.substr( p, e - p );
+        p = e + 1;
+        return r;
+    }
+    std::shared_ptr<AbstractParameter> value() {
+        ws();
+        if( '{' == s[p] ) {
+            auto d = std::make_shared<Dictionary>();
+            ++p; ws();
+            while( '}' != s[p] ) {
+                std::string k = str();
+                ws(); ++p;  // ':'
+                d->emplace( k, value() );
+                ws();
+                if( ',' == s[p] ) { ++p; ws(); }
+            }
+            ++p;
+            return d;
+        } else if( '[' == s[p] ) {
+            auto t = std::make_shared<Tuple>();
+            ++p; ws();
+            for( size_t n = 0; ']' != s[p]; ++n ) {
+                t->emplace( n, value() );
+                ws();
+                if( ',' == s[p] ) ++p;
+                ws();
+            }
+            ++p;
+            return t;
+        } else if( '"' == s[p] ) {
+            return std::make_shared<Parameter<std::string> >( str() );
+        } else if( 't' == s[p] || 'f' == s[p] ) {
+            bool v = 't' == s[p];
+            p += v ? 4 : 5;
+            return std::make_shared<Parameter<bool> >( v );
+        }
+        size_t e = s.find_first_of( ",]} \n", p );
+        std::string num = s.substr( p, e - p );
+        p = e;
+        if( num.find_first_of( ".eE" ) != std::string::npos ) {
+            return std::make_shared<Parameter<double> >( std::stod(num) );
+        }
+        return std::make_shared<Parameter<int> >( std::stoi(num) );
+    }
+};
+
+}  // namespace naive
+
+/// Runs loader in child process, prints results.
+template<typename CallableT> static void
+run_in_child( const char * name, size_t fileSize, CallableT f ) {
+    fflush( stdout );
+    pid_t pid = fork();
+    if( !pid ) {
+        const long rss0 = bench::peak_rss_kb();
+        const double t0 = bench::now();
+        double sum = f();
+        const double t = bench::now() - t0;
+        bench::do_not_optimize( sum );
+        printf( "%-34s %8.1f MB/s, peak RSS %8ld kB (+%ld kB)\n"
+              , name, fileSize/t/1024/1024
+              , bench::peak_rss_kb(), bench::peak_rss_kb() - rss0 );
+        fflush( stdout );
+        _exit( 0 );
+    }
+    waitpid( pid, nullptr, 0 );
+}
+
+int
+main( int argc, char * argv[] ) {
+    const size_t sizeMB = argc > 1 ? atoi(argv[1]) : 100;
+    const char * filename = argc > 2 ? argv[2] : "/tmp/dataflow-bench.json";
+    generate( filename, sizeMB );
+    size_t fileSize;
+    {
+        std::ifstream ifs( filename, std::ios::binary | std::ios::ate );
+        fileSize = ifs.tellg();
+    }
+    printf( "file: %s, %.1f MB\n", filename, fileSize/1024./1024 );
+
+    run_in_child( "ifstream + node per value:", fileSize, [&]() {
+        std::ifstream ifs( filename );
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        const std::string content = ss.str();
+        naive::Parser p{ content, 0 };
+        auto root = p.value();
+        return get_parameter_ref( *root, "channels[42].pedestal" ).as<double>();
+    } );
+    run_in_child( "mmap + tape (lazy numbers):", fileSize, [&]() {
+        auto doc = json::Document::load( filename );
+        return get_parameter_ref( *doc, "channels[42].pedestal" ).as<double>();
+    } );
+    run_in_child( "mmap + tape + all numbers parsed:", fileSize, [&]() {
+        auto doc = json::Document::load( filename );
+        double sum = 0;
+        for( uint32_t i = 0; i < doc->tape().size(); ++i ) {
+            if( kReal == doc->tape()[i].type ) {
+                sum += json::Value( *doc, i ).as<double>();
+            }
+        }
+        return sum;
+    } );
+    remove( filename );
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Compares memory footprint of configuration variants built as deep copies
+ * of the default tree and as copy-on-write overlays sharing unchanged
+ * subtrees with it, and lookup latency in the variants. The default tree
+ * mimics calibration constants:
+ *
+ *      calibration.detectors[<d>].channels[<c>].{pedestal,gain,threshold}
+ *
+ * Each variant overrides few pedestals.
+ *
+ * Usage: dataflow-bench-parameters-overlay [nVariants [nChanges]]
+ */
+
+# define DATAFLOW_BENCH_COUNT_ALLOCATIONS
+# include "common.hpp"
+
+# include "parameters/overlay.hpp"
+
+# include <random>
+# include <vector>
+
+using namespace dataflow::config;
+namespace bench = dataflow::bench;
+
+/// Returns deep copy of the tree.
+static std::shared_ptr<AbstractParameter>
+deep_copy( const AbstractParameter & p ) {
+    std::shared_ptr<AbstractParameter> c = shallow_copy( p );
+    if( kDict == c->type_code() ) {
+        for( auto & e : static_cast<Dictionary &>(*c) ) e.second = deep_copy( *e.second );
+    } else if( kTuple == c->type_code() ) {
+        for( auto & e : static_cast<Tuple &>(*c) ) e.second = deep_copy( *e.second );
+    }
+    return c;
+}
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nDetectors = 100
+               , nChannels = 334
+               , nVariants = argc > 1 ? atoi(argv[1]) : 1000
+               , nChanges = argc > 2 ? atoi(argv[2]) : 3
+               , nDeepCopies = 10
+               , nLookups = 1000000
+               ;
+    long heap0 = bench::heap_counters().bytesInUse;
+    std::shared_ptr<const AbstractParameter> base;
+    {
+        auto root = std::make_shared<Dictionary>();
+        auto calib = std::make_shared<Dictionary>();
+        auto detectors = std::make_shared<Tuple>();
+        for( size_t d = 0; d < nDetectors; ++d ) {
+            auto det = std::make_shared<Dictionary>();
+            auto channels = std::make_shared<Tuple>();
+            for( size_t c = 0; c < nChannels; ++c ) {
+                auto ch = std::make_shared<Dictionary>();
+                ch->emplace( "pedestal", new Parameter<double>(d + 1e-3*c) );
+                ch->emplace( "gain", new Parameter<double>(1.) );
+                ch->emplace( "threshold", new Parameter<int>(c) );
+                channels->emplace( c, ch );
+            }
+            det->emplace( "channels", channels );
+            detectors->emplace( d, det );
+        }
+        calib->emplace( "detectors", detectors );
+        root->emplace( "calibration", calib );
+        base = root;
+    }
+    const long baseBytes = bench::heap_counters().bytesInUse - heap0;
+
+    std::mt19937 gen( 1337 );
+    auto random_path = [&]( const char * leaf ) {
+        char bf[128];
+        snprintf( bf, sizeof(bf), "calibration.detectors[%zu].channels[%zu].%s"
+                , gen() % nDetectors, gen() % nChannels, leaf );
+        return std::string(bf);
+    };
+
+    // Deep copies (only few, as they are expensive)
+    heap0 = bench::heap_counters().bytesInUse;
+    std::vector<std::shared_ptr<AbstractParameter> > copies;
+    for( size_t i = 0; i < nDeepCopies; ++i ) {
+        copies.push_back( deep_copy( *base ) );
+        for( size_t k = 0; k < nChanges; ++k ) {
+            static_cast<Parameter<double> &>( get_parameter_ref( *copies.back()
+                        , random_path("pedestal") ) ).value( -1. );
+        }
+    }
+    const long copyBytes = bench::heap_counters().bytesInUse - heap0;
+
+    // Overlays
+    heap0 = bench::heap_counters().bytesInUse;
+    double t0 = bench::now();
+    std::vector<std::shared_ptr<const AbstractParameter> > variants;
+    for( size_t i = 0; i < nVariants; ++i ) {
+        Overlay o( base );
+        for( size_t k = 0; k < nChanges; ++k ) {
+            o.set( random_path("pedestal"), -1. );
+        }
+        variants.push_back( o.result() );
+    }
+    const double tOverlay = bench::now() - t0;
+    const long overlayBytes = bench::heap_counters().bytesInUse - heap0;
+
+    printf( "default tree: %ld bytes; %zu changes per variant\n", baseBytes, nChanges );
+    printf( "deep copy:    %10.0f bytes/variant\n", copyBytes/double(nDeepCopies) );
+    printf( "overlay:      %10.0f bytes/variant (%zu variants, %.1f us/variant)\n"
+          , overlayBytes/double(nVariants), nVariants, 1e6*tOverlay/nVariants );
+
+    std::vector<std::string> paths;
+    for( size_t i = 0; i < 4096; ++i ) paths.push_back( random_path("gain") );
+    double sum = 0;
+    t0 = bench::now();
+    for( size_t i = 0; i < nLookups; ++i ) {
+        sum += get_parameter_ref( *copies[i % copies.size()]
+                                , paths[i % paths.size()] ).as<double>();
+    }
+    const double tCopy = bench::now() - t0;
+    t0 = bench::now();
+    for( size_t i = 0; i < nLookups; ++i ) {
+        sum += get_parameter_ref( *variants[i % copies.size()]
+                                , paths[i % paths.size()] ).as<double>();
+    }
+    const double tVariant = bench::now() - t0;
+    bench::do_not_optimize( sum );
+    printf( "lookup in deep copy: %8.1f ns/lookup\n", 1e9*tCopy/nLookups );
+    printf( "lookup in overlay:   %8.1f ns/lookup\n", 1e9*tVariant/nLookups );
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Compares dictionaries keyed by `std::string` (former Dictionary) with the
+ * ones keyed by interned symbols: heap usage of the tree reusing few hundred
+ * key names and cost of the key lookup by string and by symbol (as done
+ * for the parsed Path).
+ *
+ * Usage: dataflow-bench-parameters-symbols [nLookups]
+ */
+
+# define DATAFLOW_BENCH_COUNT_ALLOCATIONS
+# include "common.hpp"
+
+# include "parameters/path.hpp"
+
+# include <random>
+# include <vector>
+
+using namespace dataflow::config;
+namespace bench = dataflow::bench;
+
+typedef ParametersMap<std::string, std::less<> > StringMap;
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nLookups = argc > 1 ? atol(argv[1]) : 10000000
+               , nDicts = 10000, nKeys = 300, nKeysPerDict = 30;
+    std::vector<std::string> names;
+    const char * stems[] = { "pedestal", "gain", "threshold", "calibration_offset"
+                           , "time_window_lower_bound" };
+    for( size_t i = 0; i < nKeys; ++i ) {
+        names.push_back( stems[i % 5] + std::string("_") + std::to_string(i) );
+    }
+    for( const std::string & n : names ) Symbol s( n );  // interned once
+    auto value = std::make_shared<Parameter<double> >( 1.5 );
+    std::mt19937 gen( 1337 );
+    std::uniform_int_distribution<size_t> key( 0, nKeys - 1 ), dict( 0, nDicts - 1 );
+
+    long bytes0 = bench::heap_counters().bytesInUse;
+    std::vector<StringMap> strDicts( nDicts );
+    for( StringMap & d : strDicts ) {
+        for( size_t i = 0; i < nKeysPerDict; ++i ) d.emplace( names[key(gen)], value );
+    }
+    const long strBytes = bench::heap_counters().bytesInUse - bytes0;
+    bytes0 = bench::heap_counters().bytesInUse;
+    std::vector<Dictionary> symDicts( nDicts );
+    for( size_t n = 0; n < nDicts; ++n ) {
+        for( const auto & e : strDicts[n] ) symDicts[n].emplace( e.first, value );
+    }
+    const long symBytes = bench::heap_counters().bytesInUse - bytes0;
+
+    std::vector<size_t> qDicts( 4096 ), qKeys( 4096 );
+    std::vector<Symbol> qSyms( 4096 );
+    for( size_t i = 0; i < qKeys.size(); ++i ) {
+        qDicts[i] = dict(gen);
+        qKeys[i] = key(gen);
+        qSyms[i] = Symbol( names[qKeys[i]] );
+    }
+    size_t nFound[3] = {0, 0, 0};
+    double t0 = bench::now();
+    for( size_t i = 0; i < nLookups; ++i ) {
+        const StringMap & d = strDicts[qDicts[i % 4096]];
+        nFound[0] += d.end() != d.find( std::string_view( names[qKeys[i % 4096]] ) );
+    }
+    const double tStr = bench::now() - t0;
+    t0 = bench::now();
+    for( size_t i = 0; i < nLookups; ++i ) {
+        const Dictionary & d = symDicts[qDicts[i % 4096]];
+        nFound[1] += d.end() != d.find( std::string_view( names[qKeys[i % 4096]] ) );
+    }
+    const double tSymStr = bench::now() - t0;
+    t0 = bench::now();
+    for( size_t i = 0; i < nLookups; ++i ) {
+        const Dictionary & d = symDicts[qDicts[i % 4096]];
+        nFound[2] += d.end() != d.find( qSyms[i % 4096] );
+    }
+    const double tSym = bench::now() - t0;
+    if( nFound[0] != nFound[1] || nFound[0] != nFound[2] ) {
+        fprintf( stderr, "Results differ: %zu, %zu, %zu\n", nFound[0], nFound[1], nFound[2] );
+        return 1;
+    }
+
+    printf( "%zu dictionaries of ~%zu entries, %zu key names\n", nDicts, nKeysPerDict, nKeys );
+    printf( "%-28s %12s %12s\n", "", "heap, MiB", "ns/lookup" );
+    printf( "%-28s %12.2f %12.1f\n", "std::string keys", strBytes/1048576., 1e9*tStr/nLookups );
+    printf( "%-28s %12.2f %12.1f\n", "symbol keys, by string", symBytes/1048576., 1e9*tSymStr/nLookups );
+    printf( "%-28s %12s %12.1f\n", "symbol keys, by symbol", "", 1e9*tSym/nLookups );
+    return 0;
+}
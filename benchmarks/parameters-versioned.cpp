@@ -0,0 +1,131 @@
+/*
+ * Measures reader throughput of versioned (RCU) configuration holder under
+ * concurrent writer publishing new versions, against the common
+ * alternatives: `std::shared_mutex`-protected pointer and atomic
+ * `std::shared_ptr` load. Each reader operation pins the current version and
+ * either performs single lookup by path, or just reads the size of the
+ * snapshot (to expose the cost of pinning itself).
+ *
+ * Usage: dataflow-bench-parameters-versioned [nReaders [writePeriodUs]]
+ */
+
+# include "common.hpp"
+
+# include "parameters/frozen.hpp"
+# include "parameters/versioned.hpp"
+
+# include <shared_mutex>
+# include <thread>
+# include <vector>
+
+using namespace dataflow::config;
+namespace bench = dataflow::bench;
+
+static FrozenConfig
+make_config( int v ) {
+    Dictionary root;
+    auto calib = std::make_shared<Dictionary>();
+    for( int i = 0; i < 100; ++i ) {
+        calib->emplace( "p" + std::to_string(i), new Parameter<double>(v + i) );
+    }
+    root.emplace( "calib", calib );
+    return freeze( root );
+}
+
+/// Runs readers and writer for given time, returns reader operations/s.
+template<typename ReadT, typename WriteT> static double
+run( size_t nReaders, long writePeriodUs, ReadT read, WriteT write ) {
+    std::atomic<bool> stop(false);
+    std::atomic<long> nOps(0);
+    std::vector<std::thread> threads;
+    for( size_t i = 0; i < nReaders; ++i ) {
+        threads.emplace_back( [&]() {
+            long n = 0;
+            double sum = 0;
+            auto reader = read();
+            while( !stop.load( std::memory_order_relaxed ) ) {
+                for( int k = 0; k < 64; ++k, ++n ) sum += reader();
+            }
+            bench::do_not_optimize( sum );
+            nOps += n;
+        } );
+    }
+    const double t0 = bench::now(), tDuration = 1.;
+    long nWrites = 0;
+    while( bench::now() - t0 < tDuration ) {
+        if( writePeriodUs ) {
+            std::this_thread::sleep_for( std::chrono::microseconds(writePeriodUs) );
+            write( ++nWrites );
+        } else {
+            std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+        }
+    }
+    stop = true;
+    for( auto & t : threads ) t.join();
+    return nOps/(bench::now() - t0);
+}
+
+/// Lookup performed by reader
+static double
+lookup( const FrozenConfig & c ) {
+    return get_parameter_ref( c, "calib.p42" ).as<double>();
+}
+
+/// Trivial access performed by reader
+static double
+trivial( const FrozenConfig & c ) {
+    return c.size();
+}
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nReaders = argc > 1 ? atoi(argv[1]) : 2;
+    const long writePeriodUs = argc > 2 ? atol(argv[2]) : 1000;
+    // Configs to publish are prepared in advance to measure readers only
+    std::vector<FrozenConfig> cfgs;
+    for( int i = 0; i < 16; ++i ) cfgs.push_back( make_config(i) );
+    printf( "readers: %zu, write period: %ld us, hardware threads: %u\n"
+          , nReaders, writePeriodUs, std::thread::hardware_concurrency() );
+
+    Versioned<FrozenConfig> versioned( cfgs[0] );
+    std::shared_mutex mtx;
+    auto locked = std::make_shared<FrozenConfig>( cfgs[0] );
+    auto shared = std::make_shared<const FrozenConfig>( cfgs[0] );
+    for( auto access : { lookup, trivial } ) {
+        printf( "%s:\n", lookup == access ? "pin and lookup" : "pin only" );
+        // Versioned holder
+        const double rVersioned = run( nReaders, writePeriodUs
+            , [&]() {
+                auto r = std::make_shared<Versioned<FrozenConfig>::Reader>( versioned );
+                return [r, access]() { return access( *r->pin() ); };
+            }
+            , [&]( long n ) { versioned.publish( cfgs[n % cfgs.size()] ); } );
+        // Reader-writer lock
+        const double rLocked = run( nReaders, writePeriodUs
+            , [&]() {
+                return [&]() {
+                    std::shared_lock<std::shared_mutex> l( mtx );
+                    return access( *locked );
+                };
+            }
+            , [&]( long n ) {
+                auto c = std::make_shared<FrozenConfig>( cfgs[n % cfgs.size()] );
+                std::unique_lock<std::shared_mutex> l( mtx );
+                locked = c;
+            } );
+        // Atomic shared pointer
+        const double rShared = run( nReaders, writePeriodUs
+            , [&]() {
+                return [&]() { return access( *std::atomic_load( &shared ) ); };
+            }
+            , [&]( long n ) {
+                std::atomic_store( &shared
+                        , std::make_shared<const FrozenConfig>( cfgs[n % cfgs.size()] ) );
+            } );
+        printf( "  versioned (RCU):    %8.2f Mops/s\n", rVersioned*1e-6 );
+        printf( "  shared_mutex:       %8.2f Mops/s\n", rLocked*1e-6 );
+        printf( "  atomic shared_ptr:  %8.2f Mops/s\n", rShared*1e-6 );
+    }
+    printf( "versions published: %lu\n", versioned.version() );
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Compares fill rate of the histogram filled by concurrent threads:
+ * guarded by mutex, sharded per thread (with and without snapshots taken
+ * concurrently), and as the terminal stage of ParallelPipeline declared
+ * serialized (lock per fill) or cloned (per-worker copies merged).
+ *
+ *      values -> histogram (100 bins)
+ *
+ * Usage: dataflow-bench-pipeline-accumulators [nFills]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/accumulators.hpp"
+# include "pipeline/parallel.hpp"
+
+# include <random>
+# include <thread>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+typedef Histogram1D<> Histogram;
+
+// Histogram filled under the lock of ParallelPipeline
+struct SerializedHistogram {
+    static constexpr ConcurrencyPolicy kConcurrency = kSerialized;
+    Histogram h;
+    SerializedHistogram() : h( FixedAxis( 100, 0., 1. ) ) {}
+    void call( const double & x ) { h.fill( x ); }
+};
+
+static double identity( double x ) { return x; }
+
+// Runs `fill(t, i)` for `nFills` values split among threads, returns seconds
+template<typename F> static double
+run_threads( unsigned nThreads, size_t nFills, F && fill ) {
+    const double t0 = bench::now();
+    std::vector<std::thread> threads;
+    for( unsigned t = 0; t < nThreads; ++t ) {
+        threads.emplace_back( [&fill, t, nThreads, nFills]() {
+            for( size_t i = t; i < nFills; i += nThreads ) fill( i );
+        } );
+    }
+    for( auto & t : threads ) t.join();
+    return bench::now() - t0;
+}
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nFills = argc > 1 ? atoi(argv[1]) : 50000000;
+    std::mt19937 gen( 1337 );
+    std::uniform_real_distribution<double> u( 0., 1. );
+    std::vector<double> values( 1 << 16 );
+    for( double & v : values ) v = u(gen);
+    const size_t mask = values.size() - 1;
+
+    printf( "%u hardware threads\n", std::thread::hardware_concurrency() );
+    printf( "%-36s %8s %12s %10s\n", "", "threads", "Mfills/s", "ns/fill" );
+    auto report = [nFills]( const char * name, unsigned nThreads, double t ) {
+        printf( "%-36s %8u %12.1f %10.2f\n", name, nThreads, nFills/t/1e6, 1e9*t/nFills );
+    };
+
+    // single thread, plain array of bins (reference)
+    {
+        std::vector<double> bins( 102 );
+        const FixedAxis axis( 100, 0., 1. );
+        const double t0 = bench::now();
+        for( size_t i = 0; i < nFills; ++i ) bins[axis.index( values[i & mask] )] += 1.;
+        report( "plain bins", 1, bench::now() - t0 );
+        bench::do_not_optimize( bins );
+    }
+    double total = 0;
+    for( unsigned nThreads : { 1u, 2u, 4u } ) {
+        Histogram h( FixedAxis( 100, 0., 1. ) );
+        std::mutex m;
+        report( "mutex", nThreads, run_threads( nThreads, nFills, [&]( size_t i ) {
+                    std::lock_guard<std::mutex> lock( m );
+                    h.fill( values[i & mask] );
+                } ) );
+        total += h.entries();
+
+        Sharded<Histogram> s( h.clone() );
+        report( "sharded", nThreads, run_threads( nThreads, nFills, [&]( size_t i ) {
+                    s.call( values[i & mask] );
+                } ) );
+        total += s.snapshot().entries();
+
+        Sharded<Histogram> sr( h.clone() );
+        std::atomic<bool> done( false );
+        size_t nSnapshots = 0;
+        std::thread reader( [&]() {
+            while( !done.load() ) {
+                bench::do_not_optimize( sr.snapshot() );
+                ++nSnapshots;
+                std::this_thread::sleep_for( std::chrono::milliseconds(1) );
+            }
+        } );
+        const double t = run_threads( nThreads, nFills, [&]( size_t i ) {
+                    sr.call( values[i & mask] );
+                } );
+        done = true;
+        reader.join();
+        report( "sharded, snapshots every 1 ms", nThreads, t );
+        total += sr.snapshot().entries();
+    }
+    for( unsigned nWorkers : { 1u, 2u, 4u } ) {
+        auto serialized = std::make_shared<SerializedHistogram>();
+        Pipeline ps;
+        ps.append<identity>( "identity" ).append( serialized, "histogram" );
+        auto cloned = std::make_shared<Histogram>( FixedAxis( 100, 0., 1. ) );
+        Pipeline pc;
+        pc.append<identity>( "identity" ).append( cloned, "histogram" );
+        for( int k = 0; k < 2; ++k ) {
+            ParallelPipeline pp( k ? pc : ps, nWorkers, 4096 );
+            const double t0 = bench::now();
+            for( size_t n = 0; n < nFills; n += values.size() ) {
+                pp.process( values.data(), std::min( values.size(), nFills - n ) );
+            }
+            report( k ? "pipeline, cloned" : "pipeline, serialized", nWorkers, bench::now() - t0 );
+        }
+        if( serialized->h.entries() != cloned->entries() ) {
+            fprintf( stderr, "Results differ: %lu vs %lu\n"
+                   , serialized->h.entries(), cloned->entries() );
+            return 1;
+        }
+    }
+    if( total != 9.*nFills ) {
+        fprintf( stderr, "Lost fills: %.0f of %.0f\n", 9.*nFills - total, 9.*nFills );
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Compares per-event cost and number of global heap allocations of the
+ * chain producing intermediate containers (hits, then tracks) allocated
+ * from the heap and from the event arena.
+ *
+ *      reconstruct hits -> find tracks -> sum
+ *
+ * Usage: dataflow-bench-pipeline-arena [nEvents]
+ */
+
+# define DATAFLOW_BENCH_COUNT_ALLOCATIONS
+# include "common.hpp"
+
+# include "pipeline/parallel.hpp"
+
+# include <random>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+struct Hit { double x, y, z; };
+struct Track { double slope, offset; };
+
+// Heap-allocated intermediate data
+
+static std::vector<Hit>
+reconstruct_heap( const double & x ) {
+    std::vector<Hit> hits;
+    for( int i = 0; i < 20 + int(x) % 20; ++i ) hits.push_back( Hit{ x, 0.5*i, 1.*i } );
+    return hits;
+}
+
+static std::vector<Track>
+find_tracks_heap( const std::vector<Hit> & hits ) {
+    std::vector<Track> tracks;
+    for( size_t i = 1; i < hits.size(); i += 4 ) {
+        tracks.push_back( Track{ hits[i].y - hits[i - 1].y, hits[i].x } );
+    }
+    return tracks;
+}
+
+static double
+sum_heap( const std::vector<Track> & tracks ) {
+    double s = 0;
+    for( const Track & t : tracks ) s += t.slope + t.offset;
+    return s;
+}
+
+// Arena-allocated intermediate data
+
+static std::pmr::vector<Hit>
+reconstruct_arena( const double & x ) {
+    std::pmr::vector<Hit> hits( event_arena() );
+    for( int i = 0; i < 20 + int(x) % 20; ++i ) hits.push_back( Hit{ x, 0.5*i, 1.*i } );
+    return hits;
+}
+
+static std::pmr::vector<Track>
+find_tracks_arena( const std::pmr::vector<Hit> & hits ) {
+    std::pmr::vector<Track> tracks( event_arena() );
+    for( size_t i = 1; i < hits.size(); i += 4 ) {
+        tracks.push_back( Track{ hits[i].y - hits[i - 1].y, hits[i].x } );
+    }
+    return tracks;
+}
+
+static double
+sum_arena( const std::pmr::vector<Track> & tracks ) {
+    double s = 0;
+    for( const Track & t : tracks ) s += t.slope + t.offset;
+    return s;
+}
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nEvents = argc > 1 ? atoi(argv[1]) : 2000000;
+    std::mt19937 gen( 1337 );
+    std::uniform_real_distribution<double> amp( 0., 100. );
+    std::vector<double> values( nEvents );
+    for( double & v : values ) v = amp(gen);
+
+    Pipeline heap, arena;
+    heap.append<reconstruct_heap>( "reconstruct" )
+        .append<find_tracks_heap>( "find_tracks" )
+        .append<sum_heap>( "sum" );
+    arena.append<reconstruct_arena>( "reconstruct" )
+         .append<find_tracks_arena>( "find_tracks" )
+         .append<sum_arena>( "sum" );
+    Pipeline * ps[2] = { &heap, &arena };
+    const char * names[2] = { "heap", "arena" };
+
+    printf( "%zu events\n", nEvents );
+    printf( "%-22s %10s %18s %18s\n", "", "ns/event", "heap allocs/event", "arena allocs/event" );
+    double sums[2] = {0, 0};
+    for( int k = 0; k < 2; ++k ) {
+        for( size_t i = 0; i < 1000; ++i ) *ps[k] << values[i];  // warm-up
+        const long n0 = bench::heap_counters().nAllocs;
+        size_t nArena = 0;
+        const double t0 = bench::now();
+        for( double v : values ) {
+            *ps[k] << v;
+            sums[k] += ps[k]->get<double>();
+            nArena += ps[k]->arena().n_allocations();
+        }
+        const double t = bench::now() - t0;
+        printf( "%-22s %10.1f %18.2f %18.2f\n", names[k], 1e9*t/nEvents
+              , double(bench::heap_counters().nAllocs - n0)/nEvents, double(nArena)/nEvents );
+    }
+    if( sums[0] != sums[1] ) {
+        fprintf( stderr, "Results differ: %g vs %g\n", sums[0], sums[1] );
+        return 1;
+    }
+    for( int k = 0; k < 2; ++k ) {
+        ParallelPipeline pp( *ps[k], 2, 1024 );
+        pp.process( values.data(), 10000 );  // warm-up
+        const long n0 = bench::heap_counters().nAllocs;
+        const double t0 = bench::now();
+        pp.process( values.data(), nEvents );
+        const double t = bench::now() - t0;
+        printf( "%-22s %10.1f %18.2f\n"
+              , (std::string(names[k]) + ", 2 workers").c_str(), 1e9*t/nEvents
+              , double(bench::heap_counters().nAllocs - n0)/nEvents );
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Compares throughput of the pipeline fed with values one by one (type-erased
+ * and fused chains) and in batch mode, for various batch sizes. The chain is
+ * the common cut/transform sequence over amplitudes:
+ *
+ *      cut_negative -> calibrate -> cut_low -> energy
+ *
+ * Usage: dataflow-bench-pipeline-batch [nValues]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/pipeline.hpp"
+
+# include <random>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+static bool cut_negative( const double & x ) { return x > 0; }
+static void calibrate( double & x ) { x = 1.02*x - 0.5; }
+static bool cut_low( const double & x ) { return x > 1.; }
+static float energy( const double & x ) { return float(0.37*x); }
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nValues = argc > 1 ? atoi(argv[1]) : 1 << 24;
+    std::mt19937 gen( 1337 );
+    std::normal_distribution<double> amp( 5., 5. );
+    std::vector<double> values( nValues );
+    for( double & v : values ) v = amp(gen);
+
+    double sum = 0;
+    size_t nPassed = 0;
+
+    Pipeline p;
+    p.append<cut_negative>( "cut_negative" )
+     .append<calibrate>( "calibrate" )
+     .append<cut_low>( "cut_low" )
+     .append<energy>( "energy" );
+    double t0 = bench::now();
+    for( double v : values ) {
+        if( (p << v).succeed() ) { sum += p.get<float>(); ++nPassed; }
+    }
+    const double tScalar = bench::now() - t0;
+
+    StaticPipeline<cut_negative, calibrate, cut_low, energy> sp;
+    t0 = bench::now();
+    for( double v : values ) {
+        if( (sp << v).succeed() ) sum += sp.get();
+    }
+    const double tFused = bench::now() - t0;
+
+    printf( "%zu values, %zu passed\n", nValues, nPassed );
+    printf( "one by one, dynamic: %6.2f ns/value\n", 1e9*tScalar/nValues );
+    printf( "one by one, fused:   %6.2f ns/value\n", 1e9*tFused/nValues );
+    printf( "%10s %14s %14s\n", "batch", "dynamic", "fused" );
+
+    Pipeline fp;
+    fp.append<cut_negative, calibrate, cut_low, energy>( "fused" );
+    for( size_t batchSize : {1, 8, 64, 512, 4096, 32768} ) {
+        double tb[2];
+        Pipeline * ps[2] = { &p, &fp };
+        for( int k = 0; k < 2; ++k ) {
+            size_t nBatchPassed = 0;
+            t0 = bench::now();
+            for( size_t i = 0; i < nValues; i += batchSize ) {
+                const Batch & b = ps[k]->process( values.data() + i
+                                                , std::min(batchSize, nValues - i) );
+                if( b.empty() ) continue;
+                for( float e : b.values<float>() ) sum += e;
+                nBatchPassed += b.size();
+            }
+            tb[k] = bench::now() - t0;
+            if( nBatchPassed != nPassed ) {
+                fprintf( stderr, "Batch mode disagrees: %zu vs %zu values passed.\n"
+                       , nBatchPassed, nPassed );
+                return 1;
+            }
+        }
+        printf( "%10zu %11.2f ns %11.2f ns\n", batchSize
+              , 1e9*tb[0]/nValues, 1e9*tb[1]/nValues );
+    }
+    bench::do_not_optimize( sum );
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * Compares throughput of the same chain of handlers run as hand-written
+ * loop, as chain fused at compile time (StaticPipeline) and as type-erased
+ * chain built at run time (Pipeline). The chain mimics typical event
+ * selection: a cut, calibration transform and computation of derived
+ * quantity:
+ *
+ *      cut_negative -> calibrate -> energy -> cut_low_energy
+ *
+ * Usage: dataflow-bench-pipeline-chain [nEvents]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/pipeline.hpp"
+
+# include <random>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+struct Hit {
+    double amplitude;
+    int channel;
+};
+
+static bool cut_negative( const Hit & h ) { return h.amplitude > 0; }
+static void calibrate( Hit & h ) { h.amplitude = 1.02*h.amplitude - 0.5*(h.channel & 0x7); }
+static double energy( const Hit & h ) { return 0.37*h.amplitude; }
+static bool cut_low_energy( double e ) { return e > 1.; }
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nEvents = argc > 1 ? atoi(argv[1]) : 20000000;
+    std::mt19937 gen( 1337 );
+    std::normal_distribution<double> amp( 10., 10. );
+    std::vector<Hit> hits( 4096 );
+    for( Hit & h : hits ) h = Hit{ amp(gen), int(gen() % 64) };
+
+    double sum = 0;
+    size_t nPassed;
+
+    // Hand-written loop
+    nPassed = 0;
+    double t0 = bench::now();
+    for( size_t i = 0; i < nEvents; ++i ) {
+        Hit h = hits[i % hits.size()];
+        if( !cut_negative(h) ) continue;
+        calibrate(h);
+        double e = energy(h);
+        if( !cut_low_energy(e) ) continue;
+        sum += e;
+        ++nPassed;
+    }
+    const double tHand = bench::now() - t0;
+    const size_t nHand = nPassed;
+
+    // Fused at compile time
+    nPassed = 0;
+    StaticPipeline<cut_negative, calibrate, energy, cut_low_energy> sp;
+    t0 = bench::now();
+    for( size_t i = 0; i < nEvents; ++i ) {
+        if( (sp << hits[i % hits.size()]).succeed() ) {
+            sum += sp.get();
+            ++nPassed;
+        }
+    }
+    const double tFused = bench::now() - t0;
+    const size_t nFused = nPassed;
+
+    // Type-erased stages, built at run time
+    nPassed = 0;
+    Pipeline dp;
+    dp.append<cut_negative>( "cut_negative" )
+      .append<calibrate>( "calibrate" )
+      .append<energy>( "energy" )
+      .append<cut_low_energy>( "cut_low_energy" );
+    t0 = bench::now();
+    for( size_t i = 0; i < nEvents; ++i ) {
+        if( (dp << hits[i % hits.size()]).succeed() ) {
+            sum += dp.get<double>();
+            ++nPassed;
+        }
+    }
+    const double tDynamic = bench::now() - t0;
+    const size_t nDynamic = nPassed;
+
+    bench::do_not_optimize( sum );
+    if( nHand != nFused || nHand != nDynamic ) {
+        fprintf( stderr, "Chains disagree: %zu, %zu, %zu events passed.\n"
+               , nHand, nFused, nDynamic );
+        return 1;
+    }
+    printf( "%zu events, %zu passed\n", nEvents, nHand );
+    printf( "hand-written: %6.2f ns/event\n", 1e9*tHand/nEvents );
+    printf( "fused:        %6.2f ns/event\n", 1e9*tFused/nEvents );
+    printf( "dynamic:      %6.2f ns/event\n", 1e9*tDynamic/nEvents );
+    return 0;
+}
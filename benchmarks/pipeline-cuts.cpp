@@ -0,0 +1,77 @@
+/*
+ * Compares per-event cost of the sequence of commutative cuts of various
+ * cost and selectivity applied in the configured (arbitrary) order, in the
+ * best static order and reordered adaptively by CutGroup. In the second
+ * half of the events the selectivities change.
+ *
+ * Usage: dataflow-bench-pipeline-cuts [nEvents]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/cuts.hpp"
+
+# include <random>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+struct Event { double u[6]; };
+
+// pass thresholds (rejection rate is `1 - threshold`), changed for drift
+static double gPass[6] = { .99, .95, .9, .7, .5, .2 };
+
+template<int N> static bool
+cut( const Event & e ) {
+    // cost grows as the selectivity does: configured order is the worst one
+    double s = e.u[N];
+    for( int i = 0; i < (6 - N)*(6 - N)*8; ++i ) s = s*0.999 + 1e-6;
+    return s < gPass[N];
+}
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nEvents = argc > 1 ? atoi(argv[1]) : 2000000;
+    std::mt19937 gen( 1337 );
+    std::uniform_real_distribution<double> u( 0, 1 );
+    std::vector<Event> events( nEvents );
+    for( Event & e : events ) for( double & x : e.u ) x = u(gen);
+
+    Pipeline configured, best, adaptive;
+    configured.append<cut<0>, cut<1>, cut<2>, cut<3>, cut<4>, cut<5> >( "configured" );
+    best.append<cut<5>, cut<4>, cut<3>, cut<2>, cut<1>, cut<0> >( "best" );
+    auto cuts = std::make_shared<CutGroup>();
+    cuts->add<cut<0> >( "c0" ).add<cut<1> >( "c1" ).add<cut<2> >( "c2" )
+         .add<cut<3> >( "c3" ).add<cut<4> >( "c4" ).add<cut<5> >( "c5" );
+    adaptive.append( CutGroup::stage( cuts, "adaptive" ) );
+
+    Pipeline * ps[3] = { &configured, &best, &adaptive };
+    const char * names[3] = { "configured order", "best static order", "adaptive" };
+    printf( "%zu events, ns/event\n%-20s %12s %12s\n", nEvents, "", "stable", "drifted" );
+    size_t nPassed[3][2] = {};
+    for( int k = 0; k < 3; ++k ) {
+        double t[2];
+        for( int half = 0; half < 2; ++half ) {
+            static const double stable[6] = { .99, .95, .9, .7, .5, .2 };
+            static const double drifted[6] = { .2, .5, .7, .9, .95, .99 };
+            std::copy( half ? drifted : stable, (half ? drifted : stable) + 6, gPass );
+            const size_t b = half*nEvents/2, e = (half + 1)*nEvents/2;
+            const double t0 = bench::now();
+            for( size_t i = b; i < e; ++i ) nPassed[k][half] += (*ps[k] << events[i]).succeed();
+            t[half] = 1e9*(bench::now() - t0)/(e - b);
+        }
+        printf( "%-20s %12.1f %12.1f\n", names[k], t[0], t[1] );
+    }
+    for( int k = 1; k < 3; ++k ) {
+        if( nPassed[k][0] == nPassed[0][0] && nPassed[k][1] == nPassed[0][1] ) continue;
+        fprintf( stderr, "Results differ.\n" );
+        return 1;
+    }
+    printf( "\nfinal order:" );
+    for( const CutGroup::Cut & c : cuts->cuts() ) {
+        printf( " %s (%.0f%%, %.0f ticks)", c.name.c_str(), 100*c.rejection(), c.cost() );
+    }
+    printf( "\nreorders: %zu\n", cuts->n_reorders() );
+    return 0;
+}
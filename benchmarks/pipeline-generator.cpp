@@ -0,0 +1,158 @@
+/*
+ * Compares unpacking of the raw data blocks into hits by the handler
+ * returning vector of hits and by the generator yielding them one by one:
+ *
+ *      unpack -> hits loop -> cut_noise -> calibrate -> sum   (vector)
+ *      unpack -> cut_noise -> calibrate -> sum               (generator)
+ *
+ * Reported are the time per hit, the latency (from feeding the block to
+ * the first hit reaching the last stage), heap allocations per block and
+ * the peak of heap used by the pipeline (intermediate vector or pooled
+ * coroutine frame) while the hits are processed.
+ *
+ * Usage: dataflow-bench-pipeline-generator [nHits]
+ */
+
+# define DATAFLOW_BENCH_COUNT_ALLOCATIONS
+# include "common.hpp"
+
+# include "pipeline/generator.hpp"
+# include "pipeline/pipeline.hpp"
+
+# include <random>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+# ifdef DATAFLOW_GENERATORS
+
+struct Hit {
+    int32_t channel;
+    float amplitude;
+};
+// Raw words of the block (kept elsewhere, so feeding it does not copy)
+struct Block {
+    const uint64_t * words;
+    size_t size;
+};
+
+static inline Hit
+decode( uint64_t w ) {
+    return Hit{ int32_t(w >> 32), 0.1f*float(w & 0xffff) };
+}
+static bool cut_noise( const Hit & h ) { return h.amplitude > 5.f; }
+static void calibrate( Hit & h ) { h.amplitude = 1.02f*h.amplitude - 0.5f*(h.channel & 0x7); }
+
+static std::vector<Hit>
+unpack_vector( const Block & b ) {
+    std::vector<Hit> hits;
+    hits.reserve( b.size );
+    for( size_t i = 0; i < b.size; ++i ) hits.push_back( decode( b.words[i] ) );
+    return hits;
+}
+
+static Generator<Hit>
+unpack( const Block & b ) {
+    for( size_t i = 0; i < b.size; ++i ) co_yield decode( b.words[i] );
+}
+
+// Measures last stage: sum, latency of the first hit and peak heap use
+struct Sink {
+    double sum = 0;
+    double tFed = 0, latency = 0;  // seconds
+    bool first = true;
+    long heapBase = 0, heapPeak = 0;
+    size_t nHits = 0;
+
+    void fed() {
+        first = true;
+        tFed = bench::now();
+    }
+    void call( const Hit & h ) {
+        if( first ) {
+            latency += bench::now() - tFed;
+            first = false;
+        }
+        const long used = bench::heap_counters().bytesInUse - heapBase;
+        if( used > heapPeak ) heapPeak = used;
+        sum += h.amplitude;
+        ++nHits;
+    }
+};
+
+// Runs selection over the hits of unpacked vector
+struct HitsLoop {
+    std::shared_ptr<Sink> sink;
+    void call( const std::vector<Hit> & hits ) {
+        for( Hit h : hits ) {
+            if( !cut_noise(h) ) continue;
+            calibrate(h);
+            sink->call(h);
+        }
+    }
+};
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nHits = argc > 1 ? atoi(argv[1]) : 20000000;
+    std::mt19937_64 gen( 1337 );
+    printf( "%-22s %8s %10s %12s %12s %12s\n", "", "hits", "ns/hit", "latency, ns"
+          , "allocs/block", "peak, bytes" );
+    for( size_t blockSize : { 16u, 256u, 4096u, 65536u } ) {
+        std::vector<uint64_t> words( std::max( size_t(1) << 20, blockSize ) );
+        for( uint64_t & w : words ) w = gen();
+        const size_t nWordBlocks = words.size()/blockSize;
+        const size_t nBlocks = std::max( size_t(1), nHits/blockSize );
+        double sums[3];
+        for( int k = 0; k < 3; ++k ) {
+            auto sink = std::make_shared<Sink>();
+            Pipeline p;
+            if( 0 == k ) {
+                p.append<unpack_vector>( "unpack" )
+                 .append( std::make_shared<HitsLoop>( HitsLoop{ sink } ), "hits" );
+            } else if( 1 == k ) {
+                p.append<unpack>( "unpack" )
+                 .append<cut_noise>( "cut_noise" )
+                 .append<calibrate>( "calibrate" )
+                 .append( sink, "sum" );
+            } else {
+                p.append<unpack, cut_noise, calibrate>( "unpack" ).append( sink, "sum" );
+            }
+            const long heapBase = bench::heap_counters().bytesInUse;
+            p << Block{ words.data(), blockSize };  // warm up
+            *sink = Sink();
+            sink->heapBase = heapBase;
+            const long nAllocs0 = bench::heap_counters().nAllocs;
+            double tFeed = 0;
+            for( size_t i = 0; i < nBlocks; ++i ) {
+                const Block b{ words.data() + (i % nWordBlocks)*blockSize, blockSize };
+                sink->fed();
+                const double t0 = sink->tFed;
+                p << b;
+                tFeed += bench::now() - t0;
+            }
+            const long nAllocs = bench::heap_counters().nAllocs - nAllocs0;
+            sums[k] = sink->sum;
+            const char * names[3] = { "vector", "generator", "generator, fused" };
+            printf( "%-22s %8zu %10.2f %12.0f %12.2f %12ld\n", names[k], blockSize
+                  , 1e9*tFeed/(nBlocks*blockSize), 1e9*sink->latency/nBlocks
+                  , double(nAllocs)/nBlocks, sink->heapPeak );
+        }
+        if( sums[1] != sums[0] || sums[2] != sums[0] ) {
+            fprintf( stderr, "Results differ: %f, %f vs %f\n", sums[1], sums[2], sums[0] );
+            return 1;
+        }
+    }
+    return 0;
+}
+
+# else
+
+int
+main() {
+    fprintf( stderr, "Generators need C++20 coroutines.\n" );
+    return 1;
+}
+
+# endif  // DATAFLOW_GENERATORS
@@ -0,0 +1,131 @@
+/*
+ * Compares per-event cost of the branching workflow
+ *
+ *      decode -+-> calo ---+-> match
+ *              +-> tracks -+
+ *
+ * run as dataflow graph (decoded hits shared by both branches), as two
+ * linear pipelines (each decoding the event) and hand-written. Second part
+ * measures the pruning: tracking branch is guarded by a cut passing given
+ * fraction of events.
+ *
+ * Usage: dataflow-bench-pipeline-graph [nEvents]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/graph.hpp"
+
+# include <random>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+typedef std::pmr::vector<double> Hits;
+
+static double gThreshold = 0.5;
+
+static Hits
+decode( const double & seed ) {
+    Hits hits( event_arena() );
+    double x = seed;
+    for( int i = 0; i < 64; ++i ) {
+        x = x*3.9*(1 - x);  // logistic map as "unpacking"
+        hits.push_back( x );
+    }
+    return hits;
+}
+
+static double
+calo( const Hits & hits ) {
+    double e = 0;
+    for( double h : hits ) e += h*h;
+    return e;
+}
+
+static bool
+has_tracks( const Hits & hits ) { return hits.front() < gThreshold; }
+
+static double
+tracks( const Hits & hits ) {
+    // pairs of hits as "track candidates"
+    double s = 0;
+    for( size_t i = 0; i < hits.size(); ++i ) {
+        for( size_t j = i + 1; j < hits.size(); ++j ) s += std::abs( hits[j] - hits[i] );
+    }
+    return s;
+}
+
+static double
+match( const double & e, const double & t ) { return e - t; }
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nEvents = argc > 1 ? atoi(argv[1]) : 1000000;
+    std::mt19937 gen( 1337 );
+    std::uniform_real_distribution<double> u( 0.01, 0.99 );
+    std::vector<double> seeds( nEvents );
+    for( double & s : seeds ) s = u(gen);
+
+    printf( "%zu events\n", nEvents );
+    double sums[3] = {0, 0, 0};
+    {
+        Arena arena;
+        double t0 = bench::now();
+        for( double s : seeds ) {
+            arena.reset();
+            aux::EventArenaScope scope( &arena );
+            Hits hits = decode( s );
+            sums[0] += match( calo(hits), tracks(hits) );
+        }
+        printf( "%-34s %8.1f ns/event\n", "hand-written", 1e9*(bench::now() - t0)/nEvents );
+    }
+    {
+        Pipeline pc, pt;
+        pc.append<decode, calo>( "calo" );
+        pt.append<decode, tracks>( "tracks" );
+        double t0 = bench::now();
+        for( double s : seeds ) {
+            pc << s;
+            pt << s;
+            sums[1] += match( pc.get<double>(), pt.get<double>() );
+        }
+        printf( "%-34s %8.1f ns/event\n", "two pipelines (decode twice)"
+              , 1e9*(bench::now() - t0)/nEvents );
+    }
+    for( unsigned nWorkers : {1u, 2u} ) {
+        Graph g( nWorkers );
+        g.add<decode>( "decode", Graph::kInput )
+         .add<calo>( "calo", "decode" )
+         .add<tracks>( "tracks", "decode" )
+         .join<match>( "match", {"calo", "tracks"} );
+        double sum = 0, t0 = bench::now();
+        for( double s : seeds ) sum += (g << s).get<double>( "match" );
+        printf( "%-34s %8.1f ns/event\n"
+              , nWorkers > 1 ? "graph, 2 workers" : "graph"
+              , 1e9*(bench::now() - t0)/nEvents );
+        sums[2] = sum;
+    }
+    if( sums[0] != sums[1] || sums[0] != sums[2] ) {
+        fprintf( stderr, "Results differ: %g, %g, %g\n", sums[0], sums[1], sums[2] );
+        return 1;
+    }
+
+    printf( "\npruning (tracks guarded by cut):\n" );
+    Graph g;
+    g.add<decode>( "decode", Graph::kInput )
+     .add<calo>( "calo", "decode" )
+     .add<has_tracks, tracks>( "tracks", "decode" )
+     .join<match>( "match", {"calo", "tracks"} );
+    g.output( "calo" );
+    for( double fraction : {1., 0.5, 0.1} ) {
+        gThreshold = fraction;
+        size_t nMatched = 0;
+        double t0 = bench::now();
+        for( double s : seeds ) nMatched += (g << s).succeed( "match" );
+        printf( "  %3.0f%% passed: %8.1f ns/event (%zu matched)\n", 100*fraction
+              , 1e9*(bench::now() - t0)/nEvents, nMatched );
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Compares throughput of the pipeline fed from the file by the event
+ * sources with and without prefetching, and of the pipeline writing its
+ * results by the sink with and without background writing.
+ *
+ *      read record -> checksum -> (write record)
+ *
+ * Page cache of the input file is dropped before each run (fadvise), so
+ * the reading is done from the storage.
+ *
+ * Usage: dataflow-bench-pipeline-io [sizeMiB] [directory]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/io.hpp"
+
+# include <random>
+
+# include <fcntl.h>
+# include <unistd.h>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+// Some work per word, so handlers are comparable to reading from storage
+static uint64_t
+checksum( const EventView & v ) {
+    uint64_t h = 1469598103934665603ull, w;
+    size_t i = 0;
+    for( ; i + 8 <= v.size; i += 8 ) {
+        memcpy( &w, v.data + i, 8 );
+        h = (h ^ w)*1099511628211ull;
+    }
+    for( ; i < v.size; ++i ) h = (h ^ uint8_t(v.data[i]))*1099511628211ull;
+    return h;
+}
+
+static void
+drop_cache( const std::string & path ) {
+    const int fd = open( path.c_str(), O_RDONLY );
+    fdatasync( fd );
+    posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+    close( fd );
+}
+
+int
+main( int argc, char * argv[] ) {
+    const size_t size = size_t( argc > 1 ? atoi(argv[1]) : 256 ) << 20;
+    const std::string dir = argc > 2 ? argv[2] : "/tmp";
+    const std::string input = dir + "/dataflow-bench-io.in", output = dir + "/dataflow-bench-io.out";
+
+    // variable-size records of 64..1024 bytes
+    std::mt19937 gen( 1337 );
+    std::uniform_int_distribution<int> len( 64, 1024 );
+    std::vector<char> record( 1024 );
+    for( char & c : record ) c = char(gen());
+    size_t nRecords = 0;
+    {
+        AsyncSink sink( input );
+        for( size_t n = 0; n < size; ++nRecords ) {
+            const size_t l = len(gen);
+            record[nRecords % l] ^= 1;
+            sink.write( record.data(), l );
+            n += l + 4;
+        }
+    }
+    printf( "%zu records, %zu MiB\n", nRecords, size >> 20 );
+    printf( "%-30s %10s %10s %10s\n", "", "MiB/s", "ns/event", "stalls" );
+
+    uint64_t sums[5] = {};
+    const char * names[5] = { "read, 1 buffer", "read ahead, 2 buffers", "read ahead, 3 buffers"
+                            , "mmap", "mmap, prefetch" };
+    for( int k = 0; k < 5; ++k ) {
+        drop_cache( input );
+        const double t0 = bench::now();
+        std::unique_ptr<EventSource> src;
+        if( k < 3 ) src.reset( new StreamSource( input, 0, k + 1 ) );
+        else src.reset( new MappedSource( input, 0, 3 == k ? 0 : 8 << 20 ) );
+        EventView v;
+        while( src->next( v ) ) sums[k] += checksum( v );
+        const double t = bench::now() - t0;
+        const StreamSource * s = dynamic_cast<const StreamSource *>( src.get() );
+        printf( "%-30s %10.1f %10.1f %10s\n", names[k], size/t/(1 << 20), 1e9*t/nRecords
+              , s ? std::to_string( s->n_stalls() ).c_str() : "-" );
+        if( sums[k] != sums[0] ) {
+            fprintf( stderr, "Results differ: %lu vs %lu\n", sums[k], sums[0] );
+            return 1;
+        }
+    }
+
+    // Whole pipeline: records passed through and written
+    for( unsigned nBuffers : { 1u, 2u } ) {
+        drop_cache( input );
+        const double t0 = bench::now();
+        auto sink = std::make_shared<AsyncSink>( output, 0, nBuffers );
+        Pipeline p;
+        p.append<checksum>( "checksum" )
+         .append( AsyncSink::stage<uint64_t>( sink, "write" ) );
+        StreamSource src( input, 0, 1 == nBuffers ? 1 : 3 );
+        drain( src, p );
+        sink->close();
+        const double t = bench::now() - t0;
+        printf( "%-30s %10.1f %10.1f\n"
+              , 1 == nBuffers ? "pipeline, synchronous" : "pipeline, read ahead, async sink"
+              , size/t/(1 << 20), 1e9*t/nRecords );
+    }
+    remove( input.c_str() );
+    remove( output.c_str() );
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Compares parallel pipeline reading large per-handler lookup table
+ * (calibration constants) with workers floating and table shared by all of
+ * them, against workers pinned to NUMA nodes with the table replicated by
+ * each worker in its node's memory.
+ *
+ *      channels -> calibrated sum (table of 2^21 floats)
+ *
+ * Usage: dataflow-bench-pipeline-numa [nValues] [workersPerNode]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/numa.hpp"
+# include "pipeline/parallel.hpp"
+
+# include <cmath>
+# include <random>
+# include <thread>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+typedef std::vector<float> Table;
+
+// Sums calibrated amplitudes of the channels; copies share the table or
+// have their own one
+template<bool kReplicate>
+struct Calibrated {
+    static constexpr ConcurrencyPolicy kConcurrency = kCloned;
+    std::shared_ptr<const Table> table;
+    double sum = 0;
+    explicit Calibrated( std::shared_ptr<const Table> t ) : table( std::move(t) ) {}
+    void call( const uint32_t & channel ) { sum += (*table)[channel & (table->size() - 1)]; }
+    Calibrated clone() const {
+        return Calibrated( kReplicate ? std::make_shared<const Table>( *table ) : table );
+    }
+    void merge( const Calibrated & o ) { sum += o.sum; }
+};
+
+static uint32_t identity( uint32_t c ) { return c; }
+
+static double
+run( ParallelPipeline & pp, const std::vector<uint32_t> & channels, size_t nValues ) {
+    const double t0 = bench::now();
+    for( size_t n = 0; n < nValues; n += channels.size() ) {
+        pp.process( channels.data(), std::min( channels.size(), nValues - n ) );
+    }
+    return bench::now() - t0;
+}
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nValues = argc > 1 ? atoi(argv[1]) : 50000000;
+    const unsigned perNode = argc > 2 ? atoi(argv[2]) : 0;
+    const std::vector<NumaNode> nodes = numa_nodes();
+    printf( "%u hardware threads, %zu NUMA node(s):", std::thread::hardware_concurrency(), nodes.size() );
+    for( const NumaNode & n : nodes ) printf( " node%u (%zu cpus)", n.id, n.cpus.size() );
+    printf( "\n" );
+
+    std::mt19937 gen( 1337 );
+    auto table = std::make_shared<Table>( 1 << 21 );
+    for( float & x : *table ) x = std::uniform_real_distribution<float>( 0.9f, 1.1f )( gen );
+    std::vector<uint32_t> channels( 1 << 22 );
+    for( uint32_t & c : channels ) c = gen();
+
+    auto shared = std::make_shared< Calibrated<false> >( table );
+    auto replicated = std::make_shared< Calibrated<true> >( table );
+    Pipeline ps, pr;
+    ps.append<identity>( "identity" ).append( shared, "calibrated sum" );
+    pr.append<identity>( "identity" ).append( replicated, "calibrated sum" );
+
+    printf( "%-40s %8s %12s %10s\n", "", "workers", "Mvalues/s", "ns/value" );
+    auto report = [nValues]( const char * name, unsigned nWorkers, double t ) {
+        printf( "%-40s %8u %12.1f %10.2f\n", name, nWorkers, nValues/t/1e6, 1e9*t/nValues );
+    };
+    ParallelPipeline floating( ps, 0, 4096 );
+    ParallelPipeline placedShared( ps, nodes, perNode, 4096 );
+    ParallelPipeline placed( pr, nodes, perNode, 4096 );
+    // warm up, so that tables are paged in
+    run( floating, channels, channels.size() );
+    run( placed, channels, channels.size() );
+    shared->sum = replicated->sum = 0;
+    report( "floating, shared table", floating.workers(), run( floating, channels, nValues ) );
+    report( "pinned, shared table", placedShared.workers(), run( placedShared, channels, nValues ) );
+    report( "pinned, table replicated per worker", placed.workers(), run( placed, channels, nValues ) );
+    if( std::abs( 2*replicated->sum - shared->sum ) > 1e-6*shared->sum ) {
+        fprintf( stderr, "Results differ: %g vs %g\n", 2*replicated->sum, shared->sum );
+        return 1;
+    }
+    return 0;
+}
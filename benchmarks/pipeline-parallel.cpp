@@ -0,0 +1,79 @@
+/*
+ * Measures scaling of the parallel pipeline with the number of workers for
+ * stateless-heavy chain: a cut, compute-bound "reconstruction" handler and
+ * a stateful cloned histogram. Speedup is relative to the single worker;
+ * ideal scaling requires as many hardware threads as workers.
+ *
+ * Usage: dataflow-bench-pipeline-parallel [maxWorkers [nEvents]]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/parallel.hpp"
+
+# include <cmath>
+# include <random>
+# include <thread>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+static bool cut_negative( const double & x ) { return x > 0; }
+
+// Compute-bound handler: few iterations of Newton's method
+static double reconstruct( const double & x ) {
+    double r = x;
+    for( int i = 0; i < 16; ++i ) r = r - (r*r*r - x)/(3*r*r);
+    return std::log1p( r );
+}
+
+struct Histogram {
+    static constexpr ConcurrencyPolicy kConcurrency = kCloned;
+    std::vector<size_t> bins = std::vector<size_t>( 100 );
+    void call( const double & x ) { ++bins[ std::min( size_t(x*20), bins.size() - 1 ) ]; }
+    Histogram clone() const { return Histogram(); }
+    void merge( const Histogram & o ) {
+        for( size_t i = 0; i < bins.size(); ++i ) bins[i] += o.bins[i];
+    }
+};
+
+int
+main( int argc, char * argv[] ) {
+    const unsigned hw = std::max( 1u, std::thread::hardware_concurrency() );
+    const unsigned maxWorkers = argc > 1 ? atoi(argv[1]) : std::max( hw, 4u );
+    const size_t nEvents = argc > 2 ? atoi(argv[2]) : 4000000;
+    std::mt19937 gen( 1337 );
+    std::normal_distribution<double> amp( 5., 5. );
+    std::vector<double> values( nEvents );
+    for( double & v : values ) v = amp(gen);
+
+    auto hst = std::make_shared<Histogram>();
+    Pipeline p;
+    p.append<cut_negative, reconstruct>( "reconstruction" )
+     .append( hst, "histogram" );
+
+    double t0 = bench::now();
+    size_t nSeq = 0;
+    for( double v : values ) nSeq += (p << v).succeed();
+    const double tSeq = bench::now() - t0;
+    bench::do_not_optimize( nSeq );
+
+    printf( "%u hardware threads, %zu events\n", hw, nEvents );
+    printf( "sequential Pipeline: %.2f Mevents/s\n", 1e-6*nEvents/tSeq );
+    printf( "%8s %14s %9s %11s\n", "workers", "Mevents/s", "speedup", "efficiency" );
+    double rate1 = 0;
+    for( unsigned nWorkers = 1; nWorkers <= maxWorkers; nWorkers *= 2 ) {
+        ParallelPipeline pp( p, nWorkers, 1024 );
+        pp.process( values.data(), values.size()/10 );  // warm-up
+        t0 = bench::now();
+        size_t nPassed = pp.process( values.data(), values.size() );
+        const double t = bench::now() - t0;
+        bench::do_not_optimize( nPassed );
+        const double rate = nEvents/t;
+        if( 1 == nWorkers ) rate1 = rate;
+        printf( "%8u %14.2f %9.2f %10.0f%%\n", nWorkers, 1e-6*rate
+              , rate/rate1, 100*rate/rate1/nWorkers );
+    }
+    return 0;
+}
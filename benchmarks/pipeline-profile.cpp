@@ -0,0 +1,69 @@
+/*
+ * Measures the cost of per-handler instrumentation: per-event time of the
+ * dynamic pipeline of cheap handlers (to be compared between the builds
+ * with and without DATAFLOW_PROFILING) and the cost of single record.
+ *
+ * Usage: dataflow-bench-pipeline-profile [nEvents]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/pipeline.hpp"
+
+# include <iostream>
+# include <random>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+static bool cut_negative( const double & x ) { return x >= 0; }
+static double scale( const double & x ) { return 1.5*x; }
+static void clamp( double & x ) { if( x > 100 ) x = 100; }
+static long to_long( const double & x ) { return long(x); }
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nEvents = argc > 1 ? atoi(argv[1]) : 10000000;
+    std::mt19937 gen( 1337 );
+    std::uniform_real_distribution<double> u( -50, 100 );
+    std::vector<double> values( nEvents );
+    for( double & v : values ) v = u(gen);
+
+    Pipeline p;
+    p.append<cut_negative>( "cut_negative" )
+     .append<scale>( "scale" )
+     .append<clamp>( "clamp" )
+     .append<to_long>( "to_long" );
+    double t0;
+    for( unsigned period : {16u, 1u} ) {
+        Profiler::self().set_sampling( period );
+        Profiler::self().reset();
+        long sum = 0;
+        size_t nCalls = 0;
+        t0 = bench::now();
+        for( double v : values ) {
+            if( (p << v).succeed() ) {
+                sum += p.get<long>();
+                nCalls += 4;
+            } else ++nCalls;
+        }
+        const double t = bench::now() - t0;
+        if( Profiler::enabled ) printf( "profiling enabled, timing every %u call: ", period );
+        else printf( "profiling disabled: " );
+        printf( "%.2f ns/event, %.2f ns/call (sum %ld)\n", 1e9*t/nEvents, 1e9*t/nCalls, sum );
+        if( !Profiler::enabled ) break;
+    }
+
+    // cost of single record
+    aux::ProfileTable * table = aux::thread_profile_table();
+    const unsigned probe = Profiler::self().probe( "bench-record" );
+    t0 = bench::now();
+    for( size_t i = 0; i < nEvents; ++i ) {
+        const uint64_t c0 = aux::ticks();
+        table->record( probe, aux::ticks() - c0, 1, i & 1 );
+    }
+    printf( "timestamps and record: %.2f ns\n\n", 1e9*(bench::now() - t0)/nEvents );
+    Profiler::self().report( std::cout );
+    return 0;
+}
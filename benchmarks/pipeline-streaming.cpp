@@ -0,0 +1,111 @@
+/*
+ * Compares throughput of the sequential pipeline (fed value by value and in
+ * batch mode) with the streaming pipeline running groups of stages on their
+ * own threads, and measures latency of the streaming pipeline (time from
+ * feeding the batch to its delivery to the sink). The chain is:
+ *
+ *      cut_negative -> reconstruct (compute-bound) -> running mean (ordered)
+ *
+ * Note that stage parallelism needs as many hardware threads as groups.
+ *
+ * Usage: dataflow-bench-pipeline-streaming [nEvents]
+ */
+
+# include "common.hpp"
+
+# include "pipeline/streaming.hpp"
+
+# include <algorithm>
+# include <cmath>
+# include <random>
+# include <thread>
+# include <vector>
+
+using namespace dataflow;
+namespace bench = dataflow::bench;
+
+static bool cut_negative( const double & x ) { return x > 0; }
+
+static double reconstruct( const double & x ) {
+    double r = x;
+    for( int i = 0; i < 16; ++i ) r = r - (r*r*r - x)/(3*r*r);
+    return std::log1p( r );
+}
+
+// Exponential moving average: result depends on order of the values
+struct RunningMean {
+    double mean = 0;
+    void call( const double & x ) { mean = 0.999*mean + 0.001*x; }
+};
+
+int
+main( int argc, char * argv[] ) {
+    const size_t nEvents = argc > 1 ? atoi(argv[1]) : 4000000;
+    std::mt19937 gen( 1337 );
+    std::normal_distribution<double> amp( 5., 5. );
+    std::vector<double> values( nEvents );
+    for( double & v : values ) v = amp(gen);
+
+    auto mean = std::make_shared<RunningMean>();
+    Pipeline p;
+    p.append<cut_negative>( "cut_negative" )
+     .append<reconstruct>( "reconstruct" )
+     .append( mean, "mean" );
+
+    double t0 = bench::now();
+    for( double v : values ) p << v;
+    const double tSeq = bench::now() - t0;
+    const double meanSeq = mean->mean;
+
+    printf( "%u hardware threads, %zu events\n", std::thread::hardware_concurrency(), nEvents );
+    printf( "sequential, value by value: %7.2f Mevents/s\n", 1e-6*nEvents/tSeq );
+    for( size_t batchSize : {64, 1024} ) {
+        mean->mean = 0;
+        t0 = bench::now();
+        for( size_t i = 0; i < nEvents; i += batchSize ) {
+            p.process( values.data() + i, std::min( batchSize, nEvents - i ) );
+        }
+        const double t = bench::now() - t0;
+        printf( "sequential, batch %5zu:     %7.2f Mevents/s\n", batchSize, 1e-6*nEvents/t );
+    }
+
+    printf( "%-10s %6s %14s %12s %12s %s\n", "groups", "batch", "Mevents/s"
+          , "latency p50", "latency p99", "queue max occupancy" );
+    const std::vector< std::vector<size_t> > groupings = { {1, 1, 1}, {2, 1}, {3} };
+    for( const auto & groups : groupings ) {
+        for( size_t batchSize : {64, 1024} ) {
+            mean->mean = 0;
+            const size_t nBatches = (nEvents + batchSize - 1)/batchSize;
+            std::vector<double> fedAt( nBatches ), latency( nBatches, 0. );
+            std::vector<RingStats> st;
+            t0 = bench::now();
+            {
+                StreamingPipeline sp( p, groups, [&]( size_t offset, const Batch & ) {
+                        const size_t nb = offset/batchSize;
+                        latency[nb] = bench::now() - fedAt[nb];
+                    }, batchSize, 8 );
+                for( size_t nb = 0; nb < nBatches; ++nb ) {
+                    fedAt[nb] = bench::now();
+                    const size_t i = nb*batchSize;
+                    sp.feed( values.data() + i, std::min( batchSize, nEvents - i ) );
+                }
+                sp.close();
+                st = sp.queue_stats();
+            }
+            const double t = bench::now() - t0;
+            if( std::fabs( mean->mean - meanSeq ) > 1e-9*std::fabs(meanSeq) ) {
+                fprintf( stderr, "Results differ: %g vs %g\n", mean->mean, meanSeq );
+                return 1;
+            }
+            std::sort( latency.begin(), latency.end() );
+            char groupsStr[32] = "", * c = groupsStr;
+            for( size_t g : groups ) c += sprintf( c, "%s%zu", c == groupsStr ? "" : "+", g );
+            printf( "%-10s %6zu %14.2f %9.1f us %9.1f us "
+                  , groupsStr, batchSize, 1e-6*nEvents/t
+                  , 1e6*latency[latency.size()/2], 1e6*latency[latency.size()*99/100] );
+            for( size_t q = 0; q + 1 < st.size(); ++q ) printf( " %zu/%zu", st[q].maxOccupancy, st[q].capacity );
+            printf( "\n" );
+        }
+    }
+    return 0;
+}
@@ -1,11 +1,7 @@
 # ifndef H_DATAFLOW_HANDLER_H
 # define H_DATAFLOW_HANDLER_H
 
-# include <tuple>
 # include <type_traits>
-# include <list>
-
-# include "handlers/index.hpp"
 
 namespace dataflow {
 
@@ -19,82 +15,104 @@ public:
     // HandlerSignature signature();
 };
 
-/// Handler description entry
-struct HandlerDescription {
-    const std::type_info & returnType;
-    std::list<const std::type_info *> argumentTypes;
+/// \brief Kind of the handler deduced from its signature.
+/// \details Handler takes single argument (the value being processed) and:
+/// - `bool f(T)`, `bool f(const T &)`, `bool f(T &)` is a cut: returned
+///   `false` aborts propagation of the value;
+/// - `void f(T &)` is a transform modifying the value in place (or an
+///   observer, if it takes constant reference or value);
+/// - `U f(T)` (for other `U`) maps the value to new one of type `U`;
+/// - `Generator<U> f(T)` (or other type declaring `Yielded` type, see
+///   Generator) yields any number of values of type `U`, each passed to
+///   the next stage before the following one is produced.
+enum HandlerKind {
+    kCut,
+    kTransform,
+    kMap,
+    kGenerate,
+};
+
+/// \brief How the handler instance may be used by concurrent workers.
+/// \details Stateless (function) handlers are always reentrant. Stateful
+/// handlers are serialized unless declared otherwise (see
+/// ConcurrencyTraits).
+enum ConcurrencyPolicy {
+    kSerialized,  ///< Single instance, calls are serialized by lock
+    kCloned,  ///< Instance per worker, merged after processing
+    kReentrant,  ///< Single instance, called concurrently
 };
 
 namespace meta {
 
-/// Meta-function used to retrieve return type (plain function case).
-template<typename R, typename... A>
-R ret( R (*)(A...) );
-
-/// Meta-function used to retrieve return type (class method case).
-template<typename C, typename R, typename... A>
-R ret( R (C::*)(A...) );
-
-/// Meta-function used to retrieve argument types tuple.
-template <typename R, typename... T>
-std::tuple<T...> function_args(R (*)(T...)) {
-    return std::tuple<T...>();
-}
-
-/// Handler traits struct -- depending on T routes to either a function traits
-/// for stateless handlers, or to class traits for stateful hadnlers.
-template<typename T, bool=std::is_function<T>::value>
-struct HandlerTraits;
-
-template<typename T, typename... Ts>
-inline typename std::enable_if<sizeof...(Ts) == 0, void>::type
-append_arg_typeinfo( std::list<const std::type_info *> & l ) {
-    l.push_back(&typeid(T));
-}
-
-template<typename T, typename... Ts>
-inline typename std::enable_if<sizeof...(Ts) != 0, void>::type
-append_arg_typeinfo( std::list<const std::type_info *> & l ) {
-    l.push_back(&typeid(T));
-    append_arg_typeinfo<Ts...>(l);
-}
-
-template<typename R, typename... Ts> void
-retrieve_arg_types( R (*)(Ts...), std::list<const std::type_info *> & l ) {
-    append_arg_typeinfo<Ts...>(l);
-}
-
-/// Function traits
-template<typename T>
-struct HandlerTraits<T, true> {
-    template<T f>
-    static HandlerDescription description() {
-        static_assert( 0 < std::tuple_size<decltype(function_args(f))>::value
-                     , "Unable to declare stateless handler with no I/O ports." );
-        HandlerDescription hd { typeid( ret(f) ) };
-        retrieve_arg_types(f, hd.argumentTypes);
-        //hd.argumetTypes.push_back
-        return hd;
-    }
+/// Single-argument signature of the callable entity (undefined for others).
+template<typename F> struct Signature;
+
+/// Signature specialization for plain function
+template<typename R, typename A>
+struct Signature<R (*)(A)> {
+    typedef R Return;
+    typedef A Argument;
+    typedef void Class;
 };
 
-/// Class traits
-template<typename T>
-struct HandlerTraits<T, false> {
-    template<typename TT>
-    static HandlerDescription description() {
-        
-    }
+/// Signature specialization for plain `noexcept` function
+template<typename R, typename A>
+struct Signature<R (*)(A) noexcept> : Signature<R (*)(A)> {};
+
+/// Signature specialization for class method
+template<typename C, typename R, typename A>
+struct Signature<R (C::*)(A)> {
+    typedef R Return;
+    typedef A Argument;
+    typedef C Class;
 };
 
+/// Signature specialization for constant class method
+template<typename C, typename R, typename A>
+struct Signature<R (C::*)(A) const> : Signature<R (C::*)(A)> {};
+
+/// Signature specialization for `noexcept` class method
+template<typename C, typename R, typename A>
+struct Signature<R (C::*)(A) noexcept> : Signature<R (C::*)(A)> {};
+
+/// Type of values yielded by the generator `T` (`void` for other types).
+template<typename T, typename=void> struct Yielded { typedef void type; };
+/// Yielded type specialization for generators
+template<typename T>
+struct Yielded<T, std::void_t<typename T::Yielded> > { typedef typename T::Yielded type; };
+
+/// \brief Pipeline stage traits of the handler.
+/// \details Deduces handler kind and its input and output value types from
+/// the signature of function or method `F`.
+template<typename F>
+struct StageTraits : public Signature<F> {
+    typedef Signature<F> Parent;
+    typedef typename Parent::Return Return;
+    typedef typename Parent::Argument Argument;
+    static_assert( !std::is_rvalue_reference<Argument>::value
+                 , "Handlers can not take argument by rvalue reference." );
+    /// Type of the value handler accepts
+    typedef typename std::decay<Argument>::type Input;
+    /// Kind of the handler
+    static constexpr HandlerKind kind = std::is_same<Return, bool>::value ? kCut
+                                      : std::is_void<Return>::value ? kTransform
+                                      : !std::is_void<typename Yielded<Return>::type>::value ? kGenerate
+                                      : kMap;
+    /// Type of the value handler produces
+    typedef typename std::conditional< kMap == kind
+                                     , typename std::decay<Return>::type
+                                     , typename std::conditional< kGenerate == kind
+                                                                , typename Yielded<Return>::type
+                                                                , Input >::type >::type Output;
+    /// Handler may modify its input
+    static constexpr bool modifies = std::is_lvalue_reference<Argument>::value
+            && !std::is_const<typename std::remove_reference<Argument>::type>::value;
+    /// Handler is a class method (stateful)
+    static constexpr bool stateful = !std::is_void<typename Parent::Class>::value;
+};
 
 }  // namespace ::dataflow::meta
 }  // namespace dataflow
 
-# define DATAFLOW_ADD_FUNCTION( strName, C )                                \
-const static ::dataflow::HandlerDescription __ ## strName ## _handlerInfo   \
-    = ::dataflow::meta::HandlerTraits<decltype(C)>::description<C>();       \
-/* call HandlersIndex::self().emplace(strName, &__ ## f ## _handlerInfo ) */
-
 # endif  // H_DATAFLOW_HANDLER_H
 
@@ -1,24 +1,278 @@
 # ifndef H_DATAFLOW_HANDLERS_INDEX_H
 # define H_DATAFLOW_HANDLERS_INDEX_H
 
-# include "handlers/handler.hpp"
-# include "parameters/parameter.tcc"
+# include "pipeline/stage.hpp"
+
+# include <atomic>
+# include <map>
+# include <mutex>
+# include <stdexcept>
+# include <unordered_map>
+# include <vector>
 
 namespace dataflow {
 
-struct HandlerDescription;
+/// \brief Handler description entry.
+/// \details Keeps everything needed to instantiate the handler as a
+/// pipeline stage: the invoker (resolved at compile time, so calling it does
+/// neither type checks nor allocations), the port signature and, for
+/// stateful handlers, the factory constructing the handler instance.
+struct HandlerDescription {
+    Stage::Invoker invoke;  ///< Invoker function
+    Stage::BatchInvoker invoke_batch;  ///< Batch invoker (may be `nullptr`)
+    PortType input;  ///< Type of accepted value
+    PortType output;  ///< Type of produced value
+    HandlerKind kind;  ///< Kind of the handler
+    /// Constructs handler instance (`nullptr` for stateless handlers)
+    std::shared_ptr<void> (*construct)();
+    /// Sets concurrency policy of the stage (`nullptr` for stateless handlers)
+    void (*set_concurrency)( Stage & ) = nullptr;
+    /// Read invoker (`nullptr` if handler modifies its input)
+    Stage::ReadInvoker invoke_read = nullptr;
+    /// Expand invoker (`nullptr` unless handler is a generator)
+    Stage::ExpandInvoker expand = nullptr;
+
+    /// Returns description of the function handler `F`.
+    template<auto F> static HandlerDescription of_function() {
+        typedef Fused<F> Chain;
+        return HandlerDescription{ Chain::invoker(), Chain::batch_invoker()
+                                 , PortType::of<typename Chain::Input>()
+                                 , PortType::of<typename Chain::Output>()
+                                 , meta::StageTraits<decltype(F)>::kind
+                                 , nullptr, nullptr, Chain::read_invoker()
+                                 , Chain::expand_invoker() };
+    }
+    /// Returns description of the stateful handler class `C`.
+    template<typename C> static HandlerDescription of_class() {
+        typedef MethodInvoker<C> Invoker;
+        return HandlerDescription{ Invoker::invoker(), Invoker::batch_invoker()
+                                 , PortType::of<typename Invoker::Input>()
+                                 , PortType::of<typename Invoker::Output>()
+                                 , Invoker::Traits::kind
+                                 , []() -> std::shared_ptr<void> { return std::make_shared<C>(); }
+                                 , &Invoker::set_concurrency
+                                 , Invoker::read_invoker()
+                                 , Invoker::expand_invoker() };
+    }
+
+    /// \brief Returns pipeline stage running the handler.
+    /// \details For stateful handler new instance is constructed.
+    Stage stage( const std::string & name ) const;
+};
+
+/// \brief Exception thrown on lookup of handler not being registered.
+class UnknownHandler : public std::runtime_error {
+public:
+    UnknownHandler( const std::string & name )
+        : std::runtime_error( "Handler \"" + name + "\" is not registered." ) {}
+};
+
+/// \brief Exception thrown if plugin library can not be loaded.
+class BadPlugin : public std::runtime_error {
+public:
+    BadPlugin( const std::string & what ) : std::runtime_error(what) {}
+};
+
+namespace aux {
+/// Returns FNV-1a hash of the handler name (computed at compile time for
+/// the registered ones).
+constexpr uint64_t
+hash_name( const char * name, size_t n ) {
+    uint64_t h = 14695981039346656037ull;
+    for( size_t i = 0; i < n; ++i ) h = (h ^ uint8_t(name[i]))*1099511628211ull;
+    return h;
+}
+}  // namespace ::dataflow::aux
+
+/// \brief Constant entry of the handler registered by macro.
+/// \details Entries are constant-initialized (no code runs for them at
+/// startup); the description is made by `describe()` on the first lookup
+/// of the handler.
+struct HandlerEntry {
+    const char * name;  ///< Name of the handler
+    uint64_t hash;  ///< Hash of the name
+    HandlerDescription (*describe)();  ///< Makes description of the handler
+};
+
+namespace aux {
+/// \brief Table of the handlers registered by macros in the shared object.
+/// \details Pointers to the entries are placed by the linker into the
+/// `dataflow_handlers` section, bounded by `__start_`/`__stop_` symbols
+/// local to the shared object (or executable). Each object including this
+/// header has single instance of the table, added to the list on startup or
+/// `dlopen()`.
+struct HandlersModule {
+    const HandlerEntry * const * begin;
+    const HandlerEntry * const * end;
+    const HandlersModule * next;  ///< Previously loaded module
+
+    HandlersModule( const HandlerEntry * const * b, const HandlerEntry * const * e );
+};
+
+/// Returns last loaded module (head of the list).
+const HandlersModule * handlers_modules();
+}  // namespace ::dataflow::aux
 
-/// Singleton class representing registry for all handlers defined handlers in
+/// \brief Singleton class representing registry for all handlers defined in
 /// the application.
-class HandlersIndex : public std::map<std::string, HandlerDescription *> {
+/// \details Handlers are registered with `DATAFLOW_REGISTER_HANDLER()` and
+/// `DATAFLOW_REGISTER_CLASS()` macros and retrieved by name when the
+/// pipeline is built. Macros define constant entries in the table of the
+/// shared object, so the registration costs nothing at startup: the index
+/// is created, tables are indexed by names and descriptions are made on
+/// the first lookup.
+///
+/// Handlers of the plugins (shared objects with registered handlers) are
+/// referred as `"<plugin>/<handler>"`; plugin is loaded with `dlopen()` on
+/// the first lookup of its handler, from the path given by `add_plugin()`
+/// or, by default, `lib<plugin>.so` found by the dynamic linker. Plugin's
+/// handlers are looked up in its own table only (they are not visible by
+/// bare names), so different plugins may define handlers of the same name.
+/// Handlers the plugin adds by `add()` while being loaded get the qualified
+/// names too.
+///
+/// Besides the handlers, the index keeps the adapters: stages converting
+/// the value of one type into another, inserted between the handlers with
+/// mismatching port types. Conversions between arithmetic types `int`,
+/// `long`, `float` and `double` are registered by default.
+class HandlersIndex {
 private:
-    static HandlersIndex * _self;
+    /// Loaded plugin
+    struct Plugin {
+        void * handle;  ///< Handle of the library (never unloaded)
+        /// Modules registered while the library was loaded
+        std::vector<const aux::HandlersModule *> modules;
+        /// Entries of the modules (open addressing by name hash), made on
+        /// the first lookup
+        std::vector<const HandlerEntry *> entries;
+    };
+
+    /// Handlers added at run time and descriptions of looked up entries
+    std::unordered_map<std::string, HandlerDescription> _handlers;
+    /// Entries of the indexed modules (open addressing by name hash)
+    std::vector<const HandlerEntry *> _entries;
+    size_t _nEntries;  ///< Number of entries
+    const aux::HandlersModule * _indexed;  ///< Last indexed module
+    size_t _nAdded;  ///< Handlers added at run time
+    std::map<std::string, std::string> _plugins;  ///< Paths of plugins
+    std::map<std::string, Plugin> _loaded;  ///< Loaded plugins
+    const std::string * _loading;  ///< Plugin being loaded
+    mutable std::recursive_mutex _mutex;
+    std::map< std::pair<std::type_index, std::type_index>
+            , std::pair<Stage::Invoker, Stage::BatchInvoker> > _adapters;
+
+    HandlersIndex();
+    void _index();
+    static size_t _slot( const std::vector<const HandlerEntry *> & entries
+                       , const char * name, size_t n, uint64_t hash );
+    static const HandlerEntry * _entry( const std::vector<const HandlerEntry *> & entries
+                                      , const char * name, size_t n );
+    const HandlerEntry * _entry( const std::string & name ) const {
+        return _entry( _entries, name.c_str(), name.size() );
+    }
+    const HandlerDescription * _find( const std::string & name );
+    const HandlerDescription * _find_plugin( const std::string & name, size_t n );
 public:
     /// Returns instance of the index.
     static HandlersIndex & self();
+
+    /// Registers handler; throws `std::runtime_error` if name is taken.
+    void add( const std::string & name, const HandlerDescription & d );
+    /// Registers function handler `F`, returns `true` (for use in
+    /// static initializers).
+    template<auto F> bool add( const std::string & name ) {
+        add( name, HandlerDescription::of_function<F>() );
+        return true;
+    }
+    /// Registers stateful handler class `C`, returns `true`.
+    template<typename C> bool add_class( const std::string & name ) {
+        add( name, HandlerDescription::of_class<C>() );
+        return true;
+    }
+
+    /// \brief Returns handler description or `nullptr` if not found.
+    /// \details Loads plugin if the name refers one; throws BadPlugin if
+    /// it can not be loaded.
+    const HandlerDescription * find( const std::string & name ) const;
+    /// Returns handler description; throws UnknownHandler if not found.
+    const HandlerDescription & get( const std::string & name ) const;
+    /// Returns number of handlers registered by the program (and its
+    /// libraries) and added at run time.
+    size_t size() const;
+
+    /// Sets path of the plugin library (not loaded until referenced).
+    void add_plugin( const std::string & plugin, const std::string & path );
+    /// Loads plugin library now; throws BadPlugin on failure.
+    void load( const std::string & plugin );
+    /// Returns whether the plugin is loaded.
+    bool loaded( const std::string & plugin ) const;
+
+    /// Registers (or overrides) adapter converting `From` into `To`.
+    template<typename From, typename To> void add_adapter() {
+        std::lock_guard<std::recursive_mutex> lock( _mutex );
+        _adapters[std::make_pair( std::type_index(typeid(From))
+                                , std::type_index(typeid(To)) )]
+                = std::make_pair( &_convert<From, To>, &_convert_batch<From, To> );
+    }
+    /// \brief Returns stage converting value between given port types.
+    /// \details Returned stage has null invoker if there is no adapter.
+    Stage adapter( const PortType & from, const PortType & to ) const;
+private:
+    template<typename From, typename To> static bool
+    _convert( void *, Slot & s ) {
+        To v = static_cast<To>( s.get_unchecked<From>() );
+        s.emplace<To>( v );
+        return true;
+    }
+    template<typename From, typename To> static bool
+    _convert_batch( void *, Batch & b ) {
+        const std::vector<From> & v = b.column<From>();
+        To * out = b.output<To>();
+        for( size_t i = 0; i < v.size(); ++i ) out[i] = static_cast<To>( v[i] );
+        b.flip();
+        return true;
+    }
 };
 
 }  // namespace ::dataflow
 
-# endif  // H_DATAFLOW_HANDLERS_INDEX_H
+// Bounds of the handlers table of the shared object, defined by linker if
+// the object registers handlers (null otherwise)
+extern "C" {
+extern const ::dataflow::HandlerEntry * const __start_dataflow_handlers[]
+        __attribute__((weak, visibility("hidden")));
+extern const ::dataflow::HandlerEntry * const __stop_dataflow_handlers[]
+        __attribute__((weak, visibility("hidden")));
+}
 
+namespace dataflow {
+namespace aux {
+/// Handlers table of the shared object
+inline HandlersModule gHandlersModule __attribute__((visibility("hidden")))
+        { __start_dataflow_handlers, __stop_dataflow_handlers };
+}  // namespace ::dataflow::aux
+}  // namespace ::dataflow
+
+/// \brief Registers function `f` as handler named `strName`.
+# define DATAFLOW_REGISTER_HANDLER( strName, f )                             \
+DATAFLOW_AUX_ENTRY( strName, ::dataflow::HandlerDescription::of_function<f> )
+
+/// \brief Registers class `C` (having `call()` method) as stateful handler
+/// named `strName`.
+# define DATAFLOW_REGISTER_CLASS( strName, C )                               \
+DATAFLOW_AUX_ENTRY( strName, ::dataflow::HandlerDescription::of_class<C> )
+
+# define DATAFLOW_AUX_ENTRY( strName, describe )                             \
+static constexpr ::dataflow::HandlerEntry                                    \
+    DATAFLOW_AUX_CAT( _dataflowHandler, __LINE__ )                           \
+        = { strName, ::dataflow::aux::hash_name( strName, sizeof(strName) - 1 ) \
+          , &describe };                                                     \
+static constexpr const ::dataflow::HandlerEntry *                            \
+    DATAFLOW_AUX_CAT( _dataflowHandlerPtr, __LINE__ )                        \
+    __attribute__((section("dataflow_handlers"), used))                      \
+        = &DATAFLOW_AUX_CAT( _dataflowHandler, __LINE__ );
+
+# define DATAFLOW_AUX_CAT( a, b ) DATAFLOW_AUX_CAT_( a, b )
+# define DATAFLOW_AUX_CAT_( a, b ) a ## b
+
+# endif  // H_DATAFLOW_HANDLERS_INDEX_H
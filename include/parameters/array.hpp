@@ -0,0 +1,159 @@
+# ifndef H_DATAFLOW_PARAMETERS_ARRAY_H
+# define H_DATAFLOW_PARAMETERS_ARRAY_H
+
+# include <algorithm>
+# include <cstddef>
+# include <initializer_list>
+# include <new>
+# include <stdexcept>
+# include <type_traits>
+
+namespace dataflow {
+
+/// \addtogroup Parameters
+/// @{
+
+namespace config {
+
+/// \brief Non-owning view over contiguous sequence of values.
+/// \details Minimal analogue of C++20 `std::span`: pointer and number of
+/// elements, with no bounds checking.
+template<typename T>
+class Span {
+private:
+    T * _data;
+    size_t _size;
+public:
+    typedef T value_type;  ///< Element type
+
+    /// Constructs empty view.
+    constexpr Span() : _data(nullptr), _size(0) {}
+    /// Constructs view over `n` elements starting at `data`.
+    constexpr Span( T * data, size_t n ) : _data(data), _size(n) {}
+    /// Converts view over mutable elements to view over constant ones.
+    template<typename U, typename=typename std::enable_if<
+            std::is_same<const U, T>::value>::type>
+    constexpr Span( const Span<U> & o ) : _data(o.data()), _size(o.size()) {}
+
+    /// Returns pointer to the first element.
+    constexpr T * data() const { return _data; }
+    /// Returns number of elements.
+    constexpr size_t size() const { return _size; }
+    /// Returns `true` if view is empty.
+    constexpr bool empty() const { return !_size; }
+    /// Returns element by number (no range check).
+    constexpr T & operator[]( size_t i ) const { return _data[i]; }
+    /// Returns pointer to the first element.
+    constexpr T * begin() const { return _data; }
+    /// Returns pointer past the last element.
+    constexpr T * end() const { return _data + _size; }
+};
+
+/// \brief Fixed-size dense array of numeric values.
+/// \details Keeps elements in single contiguous block aligned at
+/// `kAlignment` bytes, so loops over span() are suitable for vectorization.
+/// Used as the value of kRealArray and kIntArray parameters to represent
+/// large tables (per-channel calibrations, etc.) with no per-element
+/// overhead, unlike Tuple of scalar parameters.
+///
+/// Assignment of array of the same size copies elements in place, so
+/// pointers to elements (e.g. held by ParamHandle) remain valid.
+template<typename T>
+class Array {
+public:
+    static_assert( std::is_trivially_copyable<T>::value
+                 , "Array elements have to be trivially copyable." );
+    /// Alignment of the elements block, bytes
+    static constexpr size_t kAlignment = 64;
+    typedef T value_type;  ///< Element type
+private:
+    T * _data;
+    size_t _size;
+
+    static T * _allocate( size_t n ) {
+        if( !n ) return nullptr;
+        return static_cast<T *>( ::operator new( sizeof(T)*n
+                                               , std::align_val_t(kAlignment) ) );
+    }
+    static void _free( T * p ) {
+        if( p ) ::operator delete( p, std::align_val_t(kAlignment) );
+    }
+public:
+    /// Constructs empty array.
+    Array() : _data(nullptr), _size(0) {}
+    /// Constructs array of `n` elements set to `v`.
+    explicit Array( size_t n, T v=T() ) : _data(_allocate(n)), _size(n)
+        { std::fill( _data, _data + n, v ); }
+    /// Constructs array by copying elements of the range.
+    Array( const T * b, const T * e ) : _data(_allocate(e - b)), _size(e - b)
+        { std::copy( b, e, _data ); }
+    /// Constructs array from initializer list.
+    Array( std::initializer_list<T> l ) : Array( l.begin(), l.end() ) {}
+    /// Copy ctr.
+    Array( const Array & o ) : Array( o.begin(), o.end() ) {}
+    /// Move ctr.
+    Array( Array && o ) : _data(o._data), _size(o._size)
+        { o._data = nullptr; o._size = 0; }
+    ~Array() { _free(_data); }
+
+    /// Copies elements; storage is reused if sizes are equal.
+    Array & operator=( const Array & o ) {
+        if( this == &o ) return *this;
+        if( _size != o._size ) {
+            T * d = _allocate(o._size);
+            _free(_data);
+            _data = d;
+            _size = o._size;
+        }
+        std::copy( o.begin(), o.end(), _data );
+        return *this;
+    }
+    /// Takes ownership of other array's storage.
+    Array & operator=( Array && o ) {
+        std::swap( _data, o._data );
+        std::swap( _size, o._size );
+        return *this;
+    }
+
+    /// Returns number of elements.
+    size_t size() const { return _size; }
+    /// Returns `true` if array is empty.
+    bool empty() const { return !_size; }
+    /// Returns pointer to the first element.
+    T * data() { return _data; }
+    /// Returns pointer to the first element (const).
+    const T * data() const { return _data; }
+    /// Returns element by number (no range check).
+    T & operator[]( size_t i ) { return _data[i]; }
+    /// Returns element by number (no range check, const).
+    const T & operator[]( size_t i ) const { return _data[i]; }
+    /// Returns element by number, throws `std::out_of_range`.
+    const T & at( size_t i ) const {
+        if( i >= _size ) throw std::out_of_range( "Array index out of range." );
+        return _data[i];
+    }
+    /// Returns pointer to the first element.
+    T * begin() { return _data; }
+    /// Returns pointer past the last element.
+    T * end() { return _data + _size; }
+    /// Returns pointer to the first element (const).
+    const T * begin() const { return _data; }
+    /// Returns pointer past the last element (const).
+    const T * end() const { return _data + _size; }
+    /// Returns view over elements.
+    Span<T> span() { return Span<T>( _data, _size ); }
+    /// Returns view over elements (const).
+    Span<const T> span() const { return Span<const T>( _data, _size ); }
+};
+
+/// Dense array of floating point values (kRealArray parameter value)
+typedef Array<double> RealArray;
+/// Dense array of integer values (kIntArray parameter value)
+typedef Array<int> IntArray;
+
+}  // namespace ::dataflow::config
+/// @} End of Parameters group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PARAMETERS_ARRAY_H
@@ -0,0 +1,252 @@
+# ifndef H_DATAFLOW_PARAMETERS_FROZEN_H
+# define H_DATAFLOW_PARAMETERS_FROZEN_H
+
+# include "parameters/path.hpp"
+
+# include <cstdint>
+# include <string_view>
+# include <memory>
+
+namespace dataflow {
+
+/// \addtogroup Parameters
+/// @{
+
+namespace config {
+
+/// \brief Layout of the frozen configuration snapshot.
+/// \details Snapshot is a single contiguous block of memory ("arena")
+/// containing only offsets relative to its beginning, thus it is
+/// relocatable. All the entries are aligned at 8 bytes.
+///
+/// Arena starts with Header. Each parameter is represented by Node:
+/// - scalars (logic, int, real) are stored inline in Node::v
+/// - strings refer to null-terminated characters array, Node::count is the
+///   length of the string
+/// - dictionaries refer to sorted array of Node::count KeyRef entries,
+///   followed by the array of the same number of Node entries
+/// - dense tuples (indexes are `0...count-1`) refer to plain array of Node
+///   entries; sparse tuples refer to sorted array of `uint64_t` indexes
+///   followed by the array of Node entries.
+/// - dense arrays (kRealArray, kIntArray) refer to plain array of
+///   Node::count elements.
+///
+/// Being relocatable, the arena may be written to file as is ("binary
+/// image", see write_image()) and used directly from read-only memory
+/// mapping (see map_image()).
+namespace frozen {
+
+/// Flag set in Node::flags for tuples with indexes `0...count-1`.
+constexpr uint16_t kDenseTuple = 0x1;
+
+/// Single parameter entry in the arena
+struct Node {
+    uint16_t type;  ///< ParameterType code
+    uint16_t flags;  ///< Layout flags (kDenseTuple)
+    uint32_t count;  ///< String length or number of entries in container
+    union {
+        int64_t i;  ///< Logic or integer value
+        double d;  ///< Floating point value
+        uint64_t off;  ///< Offset of data (strings and containers)
+    } v;  ///< Value or reference to data
+};
+static_assert( sizeof(Node) == 16, "Unexpected size of frozen node." );
+
+/// Dictionary key reference
+struct KeyRef {
+    uint32_t off;  ///< Offset of key characters
+    uint32_t len;  ///< Length of the key
+};
+
+/// Snapshot header
+struct Header {
+    char magic[8];  ///< Identifies the snapshot format
+    uint32_t version;  ///< Format version
+    uint32_t byteOrder;  ///< Set to gByteOrderMark in native byte order
+    uint64_t size;  ///< Size of the arena, including this header
+    Node root;  ///< Root parameter
+};
+
+/// Magic sequence starting the snapshot
+extern const char gMagic[8];
+/// Current format version
+constexpr uint32_t gVersion = 1;
+/// Byte order marker, written in native byte order
+constexpr uint32_t gByteOrderMark = 0x01020304;
+
+}  // namespace ::dataflow::config::frozen
+
+/// \brief Types returned by FrozenNode::as<T>() template method.
+/// \details Differs from ParameterTypeTraits for strings: since the arena
+/// keeps only characters, the `std::string_view` is returned.
+template<typename T> struct FrozenTypeTraits {
+    typedef T CRef;
+};
+
+/// Template traits specification for string value
+template<> struct FrozenTypeTraits<std::string> {
+    typedef std::string_view CRef;
+};
+
+/// Template traits specification for dense array of floating point values
+template<> struct FrozenTypeTraits<RealArray> {
+    typedef Span<const double> CRef;
+};
+
+/// Template traits specification for dense array of integer values
+template<> struct FrozenTypeTraits<IntArray> {
+    typedef Span<const int> CRef;
+};
+
+/// \brief Read-only view over parameter in the frozen snapshot.
+/// \details Lightweight (two pointers and element number) value type
+/// providing read API similar to AbstractParameter, Dictionary and Tuple.
+/// View may refer to the element of dense array (found by `find(n)` on
+/// the array), having type of the element.
+class FrozenNode {
+private:
+    /// Element number of the view not referring to array element
+    static constexpr uint32_t kNoElement = ~uint32_t(0);
+    const char * _base;  ///< Arena beginning
+    const frozen::Node * _node;  ///< Parameter node
+    uint32_t _element;  ///< Element number, if node is dense array
+    /// Throws BadParameterType exception.
+    [[noreturn]] void _throw_bad_type( ParameterType ) const;
+    /// Returns pointer to the element of dense array.
+    template<typename T> const T & _elem() const {
+        return reinterpret_cast<const T *>(_base + _node->v.off)[_element];
+    }
+public:
+    /// Constructs view over given node in given arena.
+    FrozenNode( const char * base, const frozen::Node * node, uint32_t element=kNoElement )
+        : _base(base), _node(node), _element(element) {}
+
+    /// Returns parameter's type code
+    ParameterType type_code() const {
+        return kNoElement == _element ? (ParameterType) _node->type
+                                      : array_element_type( (ParameterType) _node->type );
+    }
+    /// Returns number of entries in container or array, or length of the string.
+    size_t size() const { return kNoElement == _element ? _node->count : 0; }
+
+    /// Retreival shortcut template method (throws BadParameterType).
+    template<typename T> typename FrozenTypeTraits<T>::CRef as() const;
+
+    /// Returns `true` and sets `dest` if dictionary entry exists.
+    bool find( std::string_view key, FrozenNode & dest ) const;
+    /// Returns `true` and sets `dest` if tuple entry (or dense array
+    /// element) exists.
+    bool find( size_t n, FrozenNode & dest ) const;
+
+    /// Returns key of dictionary's i-th entry (in sorted order).
+    std::string_view key( size_t i ) const;
+    /// Returns index of tuple's i-th entry (in sorted order).
+    size_t index( size_t i ) const;
+    /// Returns value of container's i-th entry (in sorted order).
+    FrozenNode value( size_t i ) const;
+};
+
+template<> inline bool
+FrozenNode::as<bool>() const {
+    if( kLogic != type_code() ) _throw_bad_type( kLogic );
+    return _node->v.i;
+}
+
+template<> inline int
+FrozenNode::as<int>() const {
+    if( kInt != type_code() ) _throw_bad_type( kInt );
+    return kNoElement == _element ? (int) _node->v.i : _elem<int>();
+}
+
+template<> inline double
+FrozenNode::as<double>() const {
+    if( kReal != type_code() ) _throw_bad_type( kReal );
+    return kNoElement == _element ? _node->v.d : _elem<double>();
+}
+
+template<> inline std::string_view
+FrozenNode::as<std::string>() const {
+    if( kString != type_code() ) _throw_bad_type( kString );
+    return std::string_view( _base + _node->v.off, _node->count );
+}
+
+template<> inline Span<const double>
+FrozenNode::as<RealArray>() const {
+    if( kRealArray != type_code() ) _throw_bad_type( kRealArray );
+    return Span<const double>( reinterpret_cast<const double *>(_base + _node->v.off)
+                             , _node->count );
+}
+
+template<> inline Span<const int>
+FrozenNode::as<IntArray>() const {
+    if( kIntArray != type_code() ) _throw_bad_type( kIntArray );
+    return Span<const int>( reinterpret_cast<const int *>(_base + _node->v.off)
+                          , _node->count );
+}
+
+/// \brief Immutable snapshot of the parameters tree.
+/// \details Keeps entire tree in the single contiguous arena with flat
+/// sorted key arrays for dictionaries and plain arrays for dense tuples.
+/// Created by freeze() function. Copies share the arena.
+///
+/// \code
+/// FrozenConfig cfg = freeze( root );
+/// double ped = get_parameter_ref( cfg, "calibration.multiwiredChamber[28].pedestal" ).as<double>();
+/// \endcode
+class FrozenConfig {
+private:
+    /// Keeps the memory block alive
+    std::shared_ptr<const void> _storage;
+    /// Arena beginning
+    const char * _base;
+public:
+    /// Constructs snapshot over given memory block (checks the header).
+    FrozenConfig( std::shared_ptr<const void> storage, const char * base );
+    /// Returns root parameter.
+    FrozenNode root() const;
+    /// Returns arena beginning.
+    const char * data() const { return _base; }
+    /// Returns size of the arena in bytes.
+    size_t size() const;
+};
+
+/// \brief Builds frozen snapshot of the given parameters tree.
+/// \details Throws `std::runtime_error` if tree contains null entries or
+/// exceeds arena limits (4Gb).
+FrozenConfig freeze( const AbstractParameter & root );
+
+/// \brief Writes frozen snapshot to file ("binary image").
+/// \details The image is written to temporary file in the same directory
+/// and renamed over the target, so processes having previous image mapped
+/// are not affected. Throws `std::runtime_error` on I/O error.
+void write_image( const FrozenConfig & cfg, const std::string & filename );
+
+/// \brief Maps the binary image written by write_image().
+/// \details The image is used directly from the read-only shared mapping,
+/// with no deserialization, so processes mapping the same image share the
+/// pages. Header (format, version, byte order) and size are checked, as
+/// well as all the offsets of the image; throws `std::runtime_error` on
+/// error.
+FrozenConfig map_image( const std::string & filename );
+
+/// Performs single step of path traversal in the frozen snapshot.
+FrozenNode get_entry( FrozenNode container, const PathToken & tok );
+
+/// Returns parameter by path string from the frozen snapshot.
+FrozenNode get_parameter_ref( FrozenNode root, std::string_view strPath );
+
+/// Returns parameter by path string from the frozen snapshot.
+inline FrozenNode
+get_parameter_ref( const FrozenConfig & cfg, std::string_view strPath ) {
+    return get_parameter_ref( cfg.root(), strPath );
+}
+
+/// Returns parameter by path tokens list from the frozen snapshot.
+FrozenNode get_parameter_ref( FrozenNode root, const Path * pathPtr );
+
+}  // namespace ::dataflow::config
+/// @} End of Parameters group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PARAMETERS_FROZEN_H
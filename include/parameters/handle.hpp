@@ -0,0 +1,134 @@
+# ifndef H_DATAFLOW_PARAMETERS_HANDLE_H
+# define H_DATAFLOW_PARAMETERS_HANDLE_H
+
+# include "parameters/path.hpp"
+
+# include <vector>
+# include <stdexcept>
+
+namespace dataflow {
+
+/// \addtogroup Parameters
+/// @{
+
+namespace config {
+
+/// \brief Pre-parsed parameter path.
+/// \details Keeps the tokens of the path string parsed once, so it can be
+/// resolved against various roots repeatedly with no parsing. Copies share
+/// the (immutable) source string.
+///
+/// \code
+/// CompiledPath p("calibration.multiwiredChamber[28].pedestal");
+/// double ped = p.resolve(root).as<double>();
+/// \endcode
+class CompiledPath {
+public:
+    /// \brief Generation of a container traversed during the resolution.
+    /// \details Used by ParamHandle to detect modifications of the tree.
+    struct Guard {
+        const MutationCounter * counter;  ///< Container's counter
+        uint64_t generation;  ///< Generation at the moment of resolution
+    };
+private:
+    /// Source string the tokens refer to
+    std::shared_ptr<const std::string> _src;
+    /// Tokens parsed
+    std::vector<PathToken> _toks;
+public:
+    /// Parses given path string. Throws InvalidPathString on grammar errors.
+    explicit CompiledPath( std::string_view strPath );
+    /// Returns path string.
+    const std::string & str() const { return *_src; }
+    /// Returns parsed tokens.
+    const std::vector<PathToken> & tokens() const { return _toks; }
+    /// \brief Traverses the tree from given root with respect to path.
+    /// \details If `guards` is given, appends generation of each container
+    /// traversed (root first).
+    AbstractParameter & resolve( AbstractParameter & root
+                               , std::vector<Guard> * guards=nullptr ) const;
+    /// \brief Returns pointer to the value of expected type by the path.
+    /// \details Same as resolve(), but the last integer token may refer to
+    /// the element of dense array (see get_value()). Throws
+    /// `std::runtime_error` on type mismatch.
+    const void * resolve_value( AbstractParameter & root
+                              , ParameterType expected
+                              , std::vector<Guard> * guards=nullptr ) const;
+};
+
+/// \brief Resolved typed reference to the parameter value.
+/// \details Resolves the path against root once, checking the parameter
+/// type against ParameterTypeTraits<T>::code. Afterwards the value is
+/// accessed by single pointer dereference.
+///
+/// Path may refer to the element of dense array (e.g. `pedestals[28]` for
+/// kRealArray parameter `pedestals`), see get_value().
+///
+/// Mutations of containers along the path (insertion, removal, etc.) and
+/// replacement of the array value are tracked by their MutationCounter:
+/// checked accessor get() re-resolves the
+/// path once handle became stale, while unchecked `operator*` just reads the
+/// cached pointer. Until anything is modified, get() compares only the
+/// global epoch (see MutationCounter::epoch()) besides the dereference.
+///
+/// \code
+/// ParamHandle<double> ped( root, "calibration.multiwiredChamber[28].pedestal" );
+/// // ... per-event code:
+/// double v = ped.get();
+/// \endcode
+/// \warning Root instance has to outlive the handle.
+template<typename T>
+class ParamHandle {
+private:
+    AbstractParameter * _root;  ///< Root the path is resolved against
+    CompiledPath _path;  ///< Path being resolved
+    std::vector<CompiledPath::Guard> _guards;  ///< Containers on the path
+    uint64_t _epoch;  ///< Modifications epoch the guards were checked at
+    const T * _value;  ///< Cached pointer to the value
+public:
+    /// Resolves pre-parsed path against the root.
+    ParamHandle( AbstractParameter & root, const CompiledPath & path )
+            : _root(&root), _path(path), _epoch(0), _value(nullptr) { resolve(); }
+    /// Parses path string and resolves it against the root.
+    ParamHandle( AbstractParameter & root, std::string_view strPath )
+            : ParamHandle( root, CompiledPath(strPath) ) {}
+
+    /// Returns `false` if any container on the path was modified since
+    /// last resolution.
+    bool valid() const {
+        for( const auto & g : _guards ) {
+            if( g.counter->generation() != g.generation ) return false;
+        }
+        return true;
+    }
+    /// (Re-)resolves the path. Throws `std::runtime_error` if parameter
+    /// does not exist or is of different type.
+    void resolve() {
+        _value = nullptr;
+        _guards.clear();
+        _epoch = MutationCounter::epoch();
+        _value = static_cast<const T *>(
+                _path.resolve_value( *_root, ParameterTypeTraits<T>::code, &_guards ) );
+    }
+    /// Checked accessor: re-resolves the path if handle is stale.
+    typename ParameterTypeTraits<T>::CRef get() {
+        const uint64_t epoch = MutationCounter::epoch();
+        if( epoch != _epoch ) {
+            // something was modified, check the containers on the path
+            if( valid() ) _epoch = epoch;
+            else resolve();
+        }
+        return *_value;
+    }
+    /// Unchecked accessor: dereferences cached pointer.
+    typename ParameterTypeTraits<T>::CRef operator*() const { return *_value; }
+    /// Returns path being resolved.
+    const CompiledPath & path() const { return _path; }
+};
+
+}  // namespace ::dataflow::config
+/// @} End of Parameters group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PARAMETERS_HANDLE_H
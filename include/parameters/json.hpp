@@ -0,0 +1,214 @@
+# ifndef H_DATAFLOW_PARAMETERS_JSON_H
+# define H_DATAFLOW_PARAMETERS_JSON_H
+
+# include "parameters/path.hpp"
+# include "util/mmap.hpp"
+
+# include <cstdint>
+# include <memory>
+# include <string_view>
+# include <vector>
+
+namespace dataflow {
+
+/// \addtogroup Parameters
+/// @{
+
+namespace config {
+
+/// \brief Configuration file adaptor for JSON subset.
+/// \details Supported subset of JSON: objects (mapped to Dictionary), arrays
+/// (mapped to Tuple), strings, numbers (integers fitting `int` are mapped to
+/// `int`, others to `double`) and `true`/`false` literals. The `null` is not
+/// supported as parameters have no representation for it. If object has
+/// several members of the same key, the last one is taken.
+namespace json {
+
+/// \brief Exception thrown on JSON syntax error.
+class ParseError : public std::runtime_error {
+private:
+    size_t _line, _column;
+public:
+    /// Constructs exception with message and location.
+    ParseError( const std::string & what, size_t line, size_t column );
+    /// Returns line number (starting from 1) of the error.
+    size_t line() const { return _line; }
+    /// Returns column number (starting from 1) of the error.
+    size_t column() const { return _column; }
+};
+
+/// \brief Single entry of the parsed document "tape".
+/// \details Document is represented by flat array of entries in the order of
+/// their appearance. Containers know the index past their last descendant,
+/// so the subtrees can be skipped. Object members are represented by the
+/// key entry followed by the value subtree.
+struct TapeEntry {
+    uint16_t type;  ///< ParameterType code
+    uint16_t flags;  ///< Entry flags (kKey, kUnescaped)
+    uint32_t count;  ///< Containers: number of elements; text: its length
+    /// Container references
+    struct Span {
+        uint32_t end;  ///< Index past the last descendant
+        /// Arrays having container elements: offset of their indices in
+        /// the document's element index (kFlat for others)
+        uint32_t elements;
+    };
+    union {
+        Span c;  ///< Containers
+        uint64_t off;  ///< Text: offset of characters
+    };
+};
+static_assert( sizeof(TapeEntry) == 16, "Unexpected size of tape entry." );
+
+/// Flag of TapeEntry: entry is the object member key.
+constexpr uint16_t kKey = 0x1;
+/// Flag of TapeEntry: text refers to unescaped copy, not to the source.
+constexpr uint16_t kUnescaped = 0x2;
+/// Value of TapeEntry::Span::elements: array elements follow each other.
+constexpr uint32_t kFlat = ~uint32_t(0);
+
+class Value;  // fwd
+
+/// \brief Parsed JSON document.
+/// \details Scans the text once, producing the tape of entries. Keys,
+/// strings and numbers are not copied: tape entries refer to characters of
+/// the source (only strings containing escape sequences are copied, being
+/// unescaped). Numbers are converted on access.
+///
+/// When loaded from file with load(), the source text is memory-mapped, so
+/// the document size is limited only by address space. Tape capacity is
+/// reserved for the typical density (about one entry per 16 characters)
+/// and grows if the document is denser.
+///
+/// Array elements are accessed in constant time: elements of arrays of
+/// scalars follow each other on the tape, for arrays having containers the
+/// element indices are kept aside.
+///
+/// \code
+/// auto doc = json::Document::load( "calibrations.json" );
+/// double ped = get_parameter_ref( *doc, "chambers[28].pedestal" ).as<double>();
+/// // or, to obtain the parameters tree:
+/// std::shared_ptr<AbstractParameter> root = json::to_parameters( doc->root() );
+/// \endcode
+class Document {
+private:
+    /// Mapped file (if loaded from file)
+    std::unique_ptr<util::MappedFile> _file;
+    /// Owned copy of the text (if parsed from string)
+    std::unique_ptr<char[]> _ownText;
+    /// Source text
+    const char * _text;
+    /// Size of the source text
+    size_t _size;
+    /// Parsed entries
+    std::vector<TapeEntry> _tape;
+    /// Characters of the strings with escape sequences, unescaped
+    std::string _unescaped;
+    /// Tape indices of the elements of arrays having containers
+    std::vector<uint32_t> _elements;
+
+    Document() : _text(nullptr), _size(0) {}
+    /// Scans the text, filling the tape.
+    void _parse();
+    friend class Scanner;
+public:
+    /// Maps and parses given file.
+    static std::unique_ptr<Document> load( const std::string & filename );
+    /// Parses (copy of) given text.
+    static std::unique_ptr<Document> parse( std::string_view text );
+
+    /// Returns root value.
+    Value root() const;
+    /// Returns the tape.
+    const std::vector<TapeEntry> & tape() const { return _tape; }
+    /// Returns characters the text entry refers to.
+    std::string_view text( const TapeEntry & e ) const {
+        return std::string_view( ((e.flags & kUnescaped) ? _unescaped.data() : _text) + e.off
+                               , e.count );
+    }
+    /// Returns size of the source text.
+    size_t size() const { return _size; }
+    /// Returns tape index of the array element (`n` is not checked).
+    uint32_t element( const TapeEntry & array, uint32_t idx, size_t n ) const {
+        return kFlat == array.c.elements ? uint32_t(idx + 1 + n) : _elements[array.c.elements + n];
+    }
+};
+
+/// \brief Types returned by Value::as<T>() template method.
+template<typename T> struct ValueTypeTraits {
+    typedef T CRef;
+};
+
+/// Template traits specification for string value
+template<> struct ValueTypeTraits<std::string> {
+    typedef std::string_view CRef;
+};
+
+/// \brief Read-only view over the value in JSON document.
+/// \details Provides read API similar to AbstractParameter, Dictionary and
+/// Tuple. Note that object members lookup is linear (JSON objects are not
+/// sorted), so for repeated lookups one should convert the document with
+/// to_parameters() or `freeze()` the result.
+class Value {
+private:
+    const Document * _doc;  ///< Document
+    uint32_t _idx;  ///< Index of the entry in the tape
+    /// Throws BadParameterType exception.
+    [[noreturn]] void _throw_bad_type( ParameterType ) const;
+public:
+    /// Constructs view over the entry of the document.
+    Value( const Document & doc, uint32_t idx ) : _doc(&doc), _idx(idx) {}
+
+    /// Returns parameter's type code.
+    ParameterType type_code() const { return (ParameterType) entry().type; }
+    /// Returns tape entry.
+    const TapeEntry & entry() const { return _doc->tape()[_idx]; }
+    /// Returns number of elements in container.
+    size_t size() const;
+
+    /// Retreival shortcut template method (throws BadParameterType).
+    template<typename T> typename ValueTypeTraits<T>::CRef as() const;
+
+    /// Returns `true` and sets `dest` if object member exists (the last
+    /// one of duplicated keys).
+    bool find( std::string_view key, Value & dest ) const;
+    /// Returns `true` and sets `dest` if array element exists.
+    bool find( size_t n, Value & dest ) const;
+
+    /// Returns first element of container (or first member key of object).
+    Value first() const { return Value( *_doc, _idx + 1 ); }
+    /// Returns next sibling (for object members: key follows value).
+    Value next() const;
+    /// Returns `true` if views refer to the same entry.
+    bool operator==( const Value & o ) const { return _idx == o._idx && _doc == o._doc; }
+    /// Returns `true` if views refer to different entries.
+    bool operator!=( const Value & o ) const { return !(*this == o); }
+};
+
+template<> bool Value::as<bool>() const;
+template<> int Value::as<int>() const;
+template<> double Value::as<double>() const;
+template<> std::string_view Value::as<std::string>() const;
+
+/// Performs single step of path traversal in the document.
+Value get_entry( Value container, const PathToken & tok );
+
+/// Returns value by path string from the document.
+Value get_parameter_ref( Value root, std::string_view strPath );
+
+/// Returns value by path string from the document.
+inline Value
+get_parameter_ref( const Document & doc, std::string_view strPath ) {
+    return get_parameter_ref( doc.root(), strPath );
+}
+
+/// Builds parameters tree (copying the data) from the document value.
+std::shared_ptr<AbstractParameter> to_parameters( Value );
+
+}  // namespace ::dataflow::config::json
+}  // namespace ::dataflow::config
+/// @} End of Parameters group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PARAMETERS_JSON_H
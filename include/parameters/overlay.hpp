@@ -0,0 +1,108 @@
+# ifndef H_DATAFLOW_PARAMETERS_OVERLAY_H
+# define H_DATAFLOW_PARAMETERS_OVERLAY_H
+
+# include "parameters/path.hpp"
+
+# include <type_traits>
+# include <unordered_set>
+# include <vector>
+
+namespace dataflow {
+
+/// \addtogroup Parameters
+/// @{
+
+namespace config {
+
+/// \brief Returns shallow copy of the parameter.
+/// \details Containers are copied with their entries referring to the same
+/// (shared) child instances; scalars and arrays are copied by value.
+std::shared_ptr<AbstractParameter> shallow_copy( const AbstractParameter & );
+
+/// \brief Builder of configuration variant derived from the base tree.
+/// \details Implements copy-on-write with structural sharing ("path
+/// copying", as in persistent data structures): modification copies only
+/// the containers on the path from the root to the entry being changed,
+/// all the other subtrees are shared with the base. Thus memory used by
+/// variant is proportional to the size of the difference, while the
+/// result is the ordinary tree of Dictionary and Tuple instances, so
+/// lookups are exactly as fast as in the base.
+///
+/// Trees sharing the subtrees must be treated as immutable: base and
+/// result are returned as pointers to const, and all the lookup functions
+/// accept const trees.
+///
+/// \code
+/// Overlay o( defaults );
+/// o.set( "calib.chambers[28].pedestal", 1.5 );
+/// o.erase( "calib.chambers[29]" );
+/// std::shared_ptr<const AbstractParameter> run42 = o.result();
+/// \endcode
+class Overlay {
+private:
+    /// Current root (shared with base until first modification)
+    std::shared_ptr<AbstractParameter> _root;
+    /// Containers copied by this overlay (thus, modifiable in place)
+    std::unordered_set<const AbstractParameter *> _owned;
+    /// Keeps owned containers alive, so their addresses are not reused
+    std::vector<std::shared_ptr<AbstractParameter> > _keep;
+
+    /// Returns container owned by overlay, copying it if needed.
+    AbstractParameter & _own( std::shared_ptr<AbstractParameter> & p );
+    /// Returns owned entry of owned container, creating or copying it.
+    std::shared_ptr<AbstractParameter> & _child( AbstractParameter & c
+                                               , const PathToken & tok
+                                               , const PathToken & nextTok );
+    /// Merges patch into owned container's entry.
+    void _merge( std::shared_ptr<AbstractParameter> & dst
+               , const std::shared_ptr<AbstractParameter> & src );
+public:
+    /// Starts variant of given base tree.
+    explicit Overlay( std::shared_ptr<const AbstractParameter> base );
+
+    /// \brief Sets (inserts or replaces) entry by path.
+    /// \details Absent intermediate containers are created (Dictionary for
+    /// string tokens, Tuple for integer ones). Throws `std::runtime_error` on
+    /// container type mismatch.
+    void set( std::string_view strPath
+            , std::shared_ptr<const AbstractParameter> value );
+    /// Sets (inserts or replaces) scalar or array value by path.
+    template<typename T> typename std::enable_if<
+            !std::is_convertible<T, std::shared_ptr<const AbstractParameter> >::value>::type
+    set( std::string_view strPath, const T & v ) {
+        set( strPath, std::shared_ptr<const AbstractParameter>(
+                        std::make_shared<Parameter<T>>( v ) ) );
+    }
+    /// Sets string value by path.
+    void set( std::string_view strPath, const char * v ) {
+        set( strPath, std::string(v) );
+    }
+    /// \brief Removes entry by path.
+    /// \details Returns `false` if there was no such entry. Throws
+    /// `std::runtime_error` if path refers to element of dense array.
+    bool erase( std::string_view strPath );
+    /// \brief Applies patch tree.
+    /// \details Dictionaries and tuples of the patch are merged recursively
+    /// with corresponding containers, other entries replace ones of the
+    /// tree. Entries of the patch are shared, not copied.
+    void merge( std::shared_ptr<const AbstractParameter> patch );
+
+    /// \brief Returns resulting tree.
+    /// \details Further modifications of the overlay copy the containers
+    /// again, so the returned tree stays unchanged.
+    std::shared_ptr<const AbstractParameter> result();
+    /// Returns number of containers copied or created by this overlay.
+    size_t n_owned() const { return _owned.size(); }
+};
+
+/// Returns tree with patch applied to base, sharing unchanged subtrees.
+std::shared_ptr<const AbstractParameter>
+overlay( std::shared_ptr<const AbstractParameter> base
+       , std::shared_ptr<const AbstractParameter> patch );
+
+}  // namespace ::dataflow::config
+/// @} End of Parameters group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PARAMETERS_OVERLAY_H
@@ -1,9 +1,16 @@
 # ifndef H_DATAFLOW_SYS_IPARAMETER_H
 # define H_DATAFLOW_SYS_IPARAMETER_H
 
+# include "parameters/array.hpp"
+# include "parameters/symbol.hpp"
+
+# include <atomic>
 # include <map>
 # include <string>
 # include <memory>
+# include <cstdint>
+# include <typeinfo>
+# include <type_traits>
 
 /*!
  * \addtogroup Parameters
@@ -41,8 +48,19 @@ enum ParameterType {
     kString = 0x20,  ///< code of scalar parameter for string value
     //kDictString  = kString | kDict,
     //kTupleString = kString | kTuple,
+
+    kRealArray = 0x40,  ///< dense array of floating-point values
+    kIntArray  = 0x80,  ///< dense array of integer values
 };
 
+/// Returns type code of the dense array elements (or 0 if not an array).
+constexpr ParameterType
+array_element_type( ParameterType t ) {
+    return kRealArray == t ? kReal
+         : kIntArray == t ? kInt
+         : ParameterType(0);
+}
+
 /// Template traits specification for logic value
 template<> struct ParameterTypeTraits<bool> {
     constexpr static ParameterType code = kLogic;
@@ -67,7 +85,35 @@ template<> struct ParameterTypeTraits<std::string> {
     typedef const std::string & CRef;
 };
 
-/// Base class for all the parameters.
+/// Template traits specification for dense array of floating point values
+template<> struct ParameterTypeTraits<RealArray> {
+    constexpr static ParameterType code = kRealArray;
+    typedef const RealArray & CRef;
+};
+
+/// Template traits specification for dense array of integer values
+template<> struct ParameterTypeTraits<IntArray> {
+    constexpr static ParameterType code = kIntArray;
+    typedef const IntArray & CRef;
+};
+
+/// \brief Exception thrown on parameter type mismatch.
+/// \details Inherits `std::bad_cast` as it replaces one formerly thrown by
+/// `dynamic_cast` in AbstractParameter::as().
+class BadParameterType : public std::bad_cast {
+private:
+    char _bf[128];
+public:
+    /// Constructs exception with actual and expected type codes.
+    BadParameterType( ParameterType actual, ParameterType expected );
+    /// Returns human-readable error description.
+    virtual const char * what() const throw () { return _bf; }
+};
+
+/// \brief Base class for all the parameters.
+/// \details Keeps the type code (tag) identifying the concrete Parameter<T>
+/// type exactly. Descendant stores the value inline, so the access by as<T>()
+/// is a tag compare followed by load, with no RTTI involved.
 class AbstractParameter {
 private:
     /// Knows its concrete type.
@@ -82,9 +128,20 @@ public:
     /// Dtr, made virtual to force vtable generation
     virtual ~AbstractParameter() {}
 
-    /// Retreival shortcut template method (checked downcast).
+    /// \brief Retreival shortcut template method (checked downcast).
+    /// \details Throws BadParameterType if type does not match.
     template<typename T> typename ParameterTypeTraits<T>::CRef as() const {
-        return dynamic_cast<const Parameter<T>&>(*this).value();
+        if( ParameterTypeTraits<T>::code != _pType ) {
+            throw BadParameterType( _pType, ParameterTypeTraits<T>::code );
+        }
+        return as_unchecked<T>();
+    }
+
+    /// \brief Retreival shortcut template method (unchecked downcast).
+    /// \details Type has to be assured by caller (e.g. by type_code()),
+    /// otherwise behaviour is undefined.
+    template<typename T> typename ParameterTypeTraits<T>::CRef as_unchecked() const {
+        return static_cast<const Parameter<T>&>(*this).value();
     }
 };
 
@@ -105,10 +162,132 @@ public:
         , _value( v ) {}
     /// Value getter.
     typename ParameterTypeTraits<T>::CRef value() const { return _value; }
+    /// Returns pointer to the value (valid for the lifetime of the instance).
+    const T * value_ptr() const { return &_value; }
+    /// \brief Returns pointer to the value for in-place modification.
+    /// \details Useful for large values (arrays) to avoid copying.
+    T * value_ptr() { return &_value; }
     /// Value setter.
     void value( typename ParameterTypeTraits<T>::CRef v ) { _value = v; }
 };
 
+/// \brief Counter of modifications applied to the parameters container.
+/// \details Incremented each time the content of the container is changed
+/// by its mutating methods. Used by ParamHandle to detect that resolved
+/// reference became stale.
+class MutationCounter {
+private:
+    uint64_t _generation;
+    /// Number of modifications of all the containers
+    static inline std::atomic<uint64_t> _epoch{0};
+public:
+    MutationCounter() : _generation(0) {}
+    MutationCounter( const MutationCounter & ) : _generation(0) {}
+    /// Assignment replaces the content, so it is modification.
+    MutationCounter & operator=( const MutationCounter & ) { touch(); return *this; }
+    /// Returns current generation number.
+    uint64_t generation() const { return _generation; }
+    /// \brief Returns number of modifications of all the containers.
+    /// \details Unchanged epoch guarantees that none of the containers was
+    /// modified, so that handles check it first.
+    static uint64_t epoch() { return _epoch.load( std::memory_order_relaxed ); }
+    /// \brief Marks container as modified.
+    /// \details Has to be called explicitly if container was modified
+    /// bypassing its methods (e.g. by assigning `it->second`).
+    void touch() {
+        ++_generation;
+        _epoch.fetch_add( 1, std::memory_order_relaxed );
+    }
+};
+
+/// \brief Dense array parameter (kRealArray, kIntArray).
+/// \details Elements are not parameters: path traversal returns the array
+/// and the element number (see get_value()). Replacing the value, or
+/// obtaining mutable pointer to it, is counted by MutationCounter as the
+/// array may be resized, so ParamHandle referring to its element
+/// re-resolves.
+template<typename T>
+class Parameter< Array<T> > : public AbstractParameter
+                            , public MutationCounter {
+private:
+    /// Value kept by the parameter instance.
+    Array<T> _value;
+public:
+    /// Constructs empty array parameter.
+    Parameter() : AbstractParameter( ParameterTypeTraits< Array<T> >::code ) {}
+    /// Constructs parameter entry and assigns value given.
+    Parameter( const Array<T> & v )
+        : AbstractParameter( ParameterTypeTraits< Array<T> >::code ), _value( v ) {}
+    /// Constructs parameter entry taking the value given.
+    Parameter( Array<T> && v )
+        : AbstractParameter( ParameterTypeTraits< Array<T> >::code ), _value( std::move(v) ) {}
+
+    /// Value getter.
+    const Array<T> & value() const { return _value; }
+    /// Returns pointer to the value (valid for the lifetime of the instance).
+    const Array<T> * value_ptr() const { return &_value; }
+    /// \brief Returns pointer to the value for in-place modification.
+    /// \details Useful for large values to avoid copying. Counted as
+    /// modification.
+    Array<T> * value_ptr() { touch(); return &_value; }
+    /// Value setter.
+    void value( const Array<T> & v ) { _value = v; touch(); }
+};
+
+/// \brief Map of parameters tracking its modifications.
+/// \details Hides mutating methods of `std::map` with versions incrementing
+/// the MutationCounter. Lookups (`find()`, `at()`, `begin()`, etc.) are not
+/// counted, even non-const ones: entry assigned through the returned
+/// reference or iterator (e.g. `it->second.reset(...)`) has to be followed
+/// by explicit touch(). Note that non-const `operator[]` is counted as it may
+/// insert.
+template<typename KeyT, typename CompareT=std::less<KeyT> >
+class ParametersMap : public std::map< KeyT
+                                     , std::shared_ptr<AbstractParameter>
+                                     , CompareT >
+                    , public MutationCounter {
+public:
+    typedef std::map< KeyT
+                    , std::shared_ptr<AbstractParameter>
+                    , CompareT > Parent;
+    typedef typename Parent::iterator iterator;
+    typedef typename Parent::const_iterator const_iterator;
+    typedef typename Parent::size_type size_type;
+
+    typename Parent::mapped_type &
+    operator[]( const KeyT & k ) { touch(); return Parent::operator[](k); }
+    typename Parent::mapped_type &
+    operator[]( KeyT && k ) { touch(); return Parent::operator[](std::move(k)); }
+    template<typename... ArgsT> std::pair<iterator, bool>
+    emplace( ArgsT && ... args ) { touch(); return Parent::emplace(std::forward<ArgsT>(args)...); }
+    template<typename... ArgsT> iterator
+    emplace_hint( const_iterator h, ArgsT && ... args ) { touch(); return Parent::emplace_hint(h, std::forward<ArgsT>(args)...); }
+    template<typename... ArgsT> auto
+    insert( ArgsT && ... args ) { touch(); return Parent::insert(std::forward<ArgsT>(args)...); }
+    template<typename... ArgsT> auto
+    insert_or_assign( ArgsT && ... args ) { touch(); return Parent::insert_or_assign(std::forward<ArgsT>(args)...); }
+    template<typename... ArgsT> auto
+    try_emplace( ArgsT && ... args ) { touch(); return Parent::try_emplace(std::forward<ArgsT>(args)...); }
+    template<typename... ArgsT> auto
+    erase( ArgsT && ... args ) { touch(); return Parent::erase(std::forward<ArgsT>(args)...); }
+    void clear() { touch(); Parent::clear(); }
+    template<typename... ArgsT> auto
+    extract( ArgsT && ... args ) { touch(); return Parent::extract(std::forward<ArgsT>(args)...); }
+    /// Moves entries of other map, both are modified.
+    template<typename MapT> void
+    merge( MapT && other ) {
+        touch();
+        if constexpr( std::is_base_of<MutationCounter, std::decay_t<MapT> >::value ) other.touch();
+        Parent::merge( other );
+    }
+    void swap( ParametersMap & other ) {
+        touch();
+        other.touch();
+        Parent::swap( other );
+    }
+    friend void swap( ParametersMap & a, ParametersMap & b ) { a.swap( b ); }
+};
+
 /// \brief Associative array for enumerated entries of various types.
 /// \details Although it is not a real "tuple" (e.g. statically typed set of
 /// values), this container is designed to keep parameter entries of various
@@ -119,20 +298,50 @@ public:
 /// class has: entries are sorted by keys, it is unbalanced RB-tree,
 /// collision-safe, etc.
 class Tuple : public AbstractParameter
-            , public std::map<size_t, std::shared_ptr<AbstractParameter> > {
+            , public ParametersMap<size_t> {
 public:
     Tuple() : AbstractParameter( kTuple ) {}
 };  // class Tuple
 
 /// \brief Associative array for named entries of various types.
 /// \details Most natural way to represent a set of parameters by their names.
+/// Keys are interned strings (Symbol), so the lookup along the tree compares
+/// integers and the names are shared by all the dictionaries. Entries are
+/// inserted by string keys as usual (the key is interned); lookup by string
+/// (`std::string_view`, C-string, `std::string`) finds the symbol without
+/// interning it.
 /// \note Since it is built over std::map, it has all the features original
-/// class has: entries are sorted by keys, it is unbalanced RB-tree,
-/// collision-safe, etc.
+/// class has: it is RB-tree, collision-safe, etc. Entries are sorted by the
+/// symbol numbers (order of interning), not alphabetically.
 class Dictionary : public AbstractParameter
-                 , public std::map<std::string, std::shared_ptr<AbstractParameter> > {
+                 , public ParametersMap<Symbol> {
 public:
     Dictionary() : AbstractParameter( kDict ) {}
+
+    using ParametersMap<Symbol>::find;
+    using ParametersMap<Symbol>::count;
+
+    /// Finds entry by string key.
+    template<typename StrT, typename=std::enable_if_t<
+            std::is_convertible<const StrT &, std::string_view>::value> >
+    iterator find( const StrT & k ) {
+        Symbol s;
+        return Symbol::find( k, s ) ? find( s ) : end();
+    }
+    /// Finds entry by string key (const).
+    template<typename StrT, typename=std::enable_if_t<
+            std::is_convertible<const StrT &, std::string_view>::value> >
+    const_iterator find( const StrT & k ) const {
+        Symbol s;
+        return Symbol::find( k, s ) ? find( s ) : end();
+    }
+    /// Returns number of entries of string key.
+    template<typename StrT, typename=std::enable_if_t<
+            std::is_convertible<const StrT &, std::string_view>::value> >
+    size_type count( const StrT & k ) const {
+        Symbol s;
+        return Symbol::find( k, s ) ? count( s ) : 0;
+    }
 };  // class Dictionary
 
 }  // namespace ::dataflow::config
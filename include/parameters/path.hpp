@@ -4,8 +4,10 @@
 # include "parameters/parameter.tcc"
 
 # include <string>
+# include <string_view>
 # include <ostream>
 # include <list>
+# include <memory>
 
 /*!\defgroup Parameters
  * \brief Run-time configuration sub-system module.
@@ -71,6 +73,97 @@ public:
     virtual const char* what() const throw ();
 };
 
+/// \brief Single token of the parameter path string.
+/// \details Produced by PathTokenizer. String tokens refer to the characters
+/// of the source string, so the tokenized string must outlive the token.
+struct PathToken {
+    bool isStr;  ///< `true`, if token is a string, false if it is a number
+    std::string_view str;  ///< Set to word identifier when token is string
+    size_t n;  ///< Set to integer value when token is integer
+};
+
+/// \brief Linear single-pass tokenizer for the parameter path string.
+/// \details Hand-written scanner producing PathToken entries one by one
+/// without any heap allocation or regular expression matching. Grammar
+/// violations are reported by InvalidPathString exception with the stack
+/// of tokens preceding the erroneous one (same diagnostics as emitted by
+/// Path::from_string()).
+///
+/// \code
+/// PathTokenizer t("one.two[3]");
+/// PathToken tok;
+/// while( t.next(tok) ) {
+///     // ... use tok
+/// }
+/// \endcode
+class PathTokenizer {
+private:
+    std::string_view _src;  ///< String being tokenized
+    size_t _pos;  ///< Current position within the string
+    /// Raises InvalidPathString with tokens stack preceding `tokStart'.
+    [[noreturn]] void _throw( const char * reason, size_t tokStart ) const;
+public:
+    /// Constructs tokenizer over given string. Does not copy the string.
+    PathTokenizer( std::string_view src ) : _src(src), _pos(0) {}
+    /// \brief Extracts next token.
+    /// \details Returns `false` when the end of string is reached.
+    /// Throws InvalidPathString on grammar violation.
+    bool next( PathToken & );
+    /// Returns current position within the string.
+    size_t position() const { return _pos; }
+};
+
+/// \brief Contiguous sequence of path tokens with small-buffer optimization.
+/// \details Tokens are kept in fixed-size array embedded in the object while
+/// the path depth does not exceed `kInlineCapacity`; only deeper paths cause
+/// heap allocation. As PathToken refers to the source string, the tokenized
+/// string must outlive the sequence.
+///
+/// \code
+/// PathTokens toks("calibration.multiwiredChamber[28].pedestal");
+/// assert( 4 == toks.size() && toks[2].n == 28 );
+/// \endcode
+class PathTokens {
+public:
+    /// Number of tokens stored without heap allocation.
+    static constexpr size_t kInlineCapacity = 8;
+private:
+    PathToken _inline[kInlineCapacity];  ///< Embedded storage
+    std::unique_ptr<PathToken[]> _heap;  ///< Heap storage for deep paths
+    PathToken * _data;  ///< Points either to _inline, or to _heap
+    size_t _size  ///< Number of tokens
+         , _capacity  ///< Number of tokens available at _data
+         ;
+public:
+    /// Constructs empty sequence.
+    PathTokens() : _data(_inline), _size(0), _capacity(kInlineCapacity) {}
+    /// Constructs sequence by tokenizing given string.
+    explicit PathTokens( std::string_view strPath ) : PathTokens()
+        { assign(strPath); }
+    /// Since the tokens refer to embedded storage, copying is not supported.
+    PathTokens( const PathTokens & ) = delete;
+    /// Since the tokens refer to embedded storage, copying is not supported.
+    PathTokens & operator=( const PathTokens & ) = delete;
+
+    /// Drops current content and tokenizes given string.
+    void assign( std::string_view strPath );
+    /// Appends token, reallocating storage if needed.
+    void push_back( const PathToken & );
+    /// Drops all the tokens (storage is kept).
+    void clear() { _size = 0; }
+
+    /// Returns number of tokens.
+    size_t size() const { return _size; }
+    /// Returns `true` if there are no tokens.
+    bool empty() const { return !_size; }
+    /// Returns token by number (no range check).
+    const PathToken & operator[]( size_t i ) const { return _data[i]; }
+    /// Returns pointer to the first token.
+    const PathToken * begin() const { return _data; }
+    /// Returns pointer past the last token.
+    const PathToken * end() const { return _data + _size; }
+};
+
 /// \brief A representation of the parameter path string being parsed.
 /// \details String path has to be tokenized into this representation. Each
 /// token within the path grammar can be either a string denoting an element
@@ -98,9 +191,9 @@ public:
 class Path {
 public:
     union {
-        char * str;  ///< Set to word identifier when token is string
+        uint32_t sym;  ///< Set to word symbol number when token is string
         size_t n;  ///< Set to integer value when token is integer
-    } _key;  ///< Stores either a string key, or an integer
+    } _key;  ///< Stores either a string key (interned), or an integer
 private:
     bool _isStr;  ///< `true`, if token is a string, false if it is a number
     Path * _next;  ///< Pointer to the next element, if chained
@@ -108,7 +201,7 @@ protected:
     /// Constructs new path token instance with integer.
     Path( size_t );
     /// Constructs new path token from string _key.
-    Path( const std::string & );
+    Path( std::string_view );
 public:
     /// Tokenizes given string into path returning new list of tokens. Invokes
     /// `new' allocation internally, so one need to `delete' the pointer returned
@@ -116,8 +209,7 @@ public:
     static Path * from_string( const std::string & );
     /// Destructor recursively deleting the subsequent tokens in the list.
     ~Path() {
-        if( _next ) delete _next; 
-        if( _isStr ) delete [] _key.str;
+        if( _next ) delete _next;
     }
     /// Returns true if its is a string token.
     bool is_str() const { return _isStr; }
@@ -131,6 +223,9 @@ public:
     /// Returns string token value, if this is a string token otherwise throws
     /// a `runtime_error').
     const char * str_first() const;
+    /// Returns string token symbol, if this is a string token otherwise
+    /// throws a `runtime_error').
+    Symbol symbol() const;
     /// Returns an int value, if this is a string token otherwise throws a
     /// `runtime_error').
     size_t n() const;
@@ -139,12 +234,47 @@ public:
 /// Renders Path list instance into string representation
 std::ostream & operator<<( std::ostream &, const Path & );
 
+///\brief Performs single step of the path traversal, if entry exists.
+///\details Returns pointer to the entry of the `container` referenced by
+/// the token or `nullptr` if there is no such entry. Raises
+/// `std::runtime_error` if string token dereferences not a Dictionary or
+/// integer token dereferences not a Tuple (elements of dense arrays are
+/// values rather than parameters, they are read by get_value()).
+const AbstractParameter *
+find_entry( const AbstractParameter & container
+          , const PathToken & tok );
+
+/// Performs single step of the path traversal, if entry exists (mutable).
+inline AbstractParameter *
+find_entry( AbstractParameter & container
+          , const PathToken & tok ) {
+    return const_cast<AbstractParameter *>( find_entry(
+                static_cast<const AbstractParameter &>(container), tok ) );
+}
+
+///\brief Performs single step of the path traversal.
+///\details Returns entry of the `container` referenced by the token. Raises
+/// `std::runtime_error` if string token dereferences not a Dictionary,
+/// integer token dereferences neither Tuple nor array, or there is no such
+/// entry. Never inserts new entries.
+const AbstractParameter &
+get_entry( const AbstractParameter & container
+         , const PathToken & tok );
+
+/// Performs single step of the path traversal (mutable).
+inline AbstractParameter &
+get_entry( AbstractParameter & container
+         , const PathToken & tok ) {
+    return const_cast<AbstractParameter &>( get_entry(
+                static_cast<const AbstractParameter &>(container), tok ) );
+}
+
 ///\brief Returns parameter instance reference by given path tokens list. If
 /// path pointer is NULL, returns reference to the `root'.
 ///\details Performs recursive traversing of the given AbstractParameter
 /// instance with respect to Path token list. Basic type checking is performed:
 /// raises `std::runtime_error` if string path token derefeences Tuple or
-/// integer path token dereferences Dictionary.
+/// integer path token dereferences Dictionary, or if entry does not exist.
 /// \code
 /// Path * p = Path::from_string("one.two");
 /// AbstractParameter &param = get_parameter_ref( dct, p );
@@ -153,10 +283,103 @@ std::ostream & operator<<( std::ostream &, const Path & );
 /// Assuming dct is an instance of Dictionary.
 /// \param root input parameters node
 /// \param pathPtr Head of the path tokens list
-AbstractParameter &
-get_parameter_ref( AbstractParameter & root
+const AbstractParameter &
+get_parameter_ref( const AbstractParameter & root
                  , const Path * pathPtr=nullptr );
 
+/// Returns parameter instance reference by given path tokens list (mutable).
+inline AbstractParameter &
+get_parameter_ref( AbstractParameter & root
+                 , const Path * pathPtr=nullptr ) {
+    return const_cast<AbstractParameter &>( get_parameter_ref(
+                static_cast<const AbstractParameter &>(root), pathPtr ) );
+}
+
+///\brief Returns parameter instance reference by given path string.
+///\details Parses the path and traverses the parameters tree in a single
+/// pass, without building intermediate Path list (thus, without heap
+/// allocations). Grammar errors are reported by InvalidPathString exception,
+/// type mismatches and absent entries -- by `std::runtime_error`. Empty
+/// string refers to the `root` itself.
+///
+/// Lookup never modifies the tree (no entries are inserted, no modification
+/// counters are touched), so concurrent reads of the tree not being
+/// modified are safe.
+/// \code
+/// const AbstractParameter &param = get_parameter_ref( dct, "one.two[3]" );
+/// \endcode
+const AbstractParameter &
+get_parameter_ref( const AbstractParameter & root
+                 , std::string_view strPath );
+
+/// Returns parameter instance reference by given path string (mutable).
+inline AbstractParameter &
+get_parameter_ref( AbstractParameter & root
+                 , std::string_view strPath ) {
+    return const_cast<AbstractParameter &>( get_parameter_ref(
+                static_cast<const AbstractParameter &>(root), strPath ) );
+}
+
+///\brief Returns pointer to parameter by given path string, if it exists.
+///\details Same as get_parameter_ref(), but returns `nullptr` if any entry
+/// on the path does not exist.
+const AbstractParameter *
+find_parameter( const AbstractParameter & root
+              , std::string_view strPath );
+
+/// Returns pointer to parameter by given path string, if it exists (mutable).
+inline AbstractParameter *
+find_parameter( AbstractParameter & root
+              , std::string_view strPath ) {
+    return const_cast<AbstractParameter *>( find_parameter(
+                static_cast<const AbstractParameter &>(root), strPath ) );
+}
+
+namespace aux {
+
+///\brief Returns pointer to the value of the parameter of expected type.
+///\details Throws BadParameterType if type does not match.
+const void *
+value_ptr( const AbstractParameter & p, ParameterType expected );
+
+///\brief Returns pointer to the element of dense array.
+///\details Returns `nullptr` if `n` is out of range. Array type (kRealArray
+/// or kIntArray) has to be assured by caller.
+const void *
+find_array_element( const AbstractParameter & arr, size_t n );
+
+///\brief Returns pointer to the dense array element of expected type.
+///\details Throws BadParameterType if `arr` is not an array or its element
+/// type does not match, `std::runtime_error` if index is out of range.
+const void *
+array_element_ptr( const AbstractParameter & arr
+                 , size_t n
+                 , ParameterType expected );
+
+///\brief Returns pointer to the value by given path string.
+///\details Implements get_value().
+const void *
+get_value_ptr( const AbstractParameter & root
+             , std::string_view strPath
+             , ParameterType expected );
+
+}  // namespace ::dataflow::config::aux
+
+///\brief Returns value by given path string.
+///\details The last integer token of the path may refer to an element of
+/// dense array (kRealArray, kIntArray), so tables of values are addressed
+/// the same way whether they are stored as Tuple of scalars or as dense
+/// array (schemas, ParamHandle and FrozenNode lookups do the same):
+/// \code
+/// double ped = get_value<double>( root, "pedestals[28]" );
+/// \endcode
+/// Throws BadParameterType on type mismatch and `std::runtime_error` if
+/// entry does not exist.
+template<typename T> typename ParameterTypeTraits<T>::CRef
+get_value( const AbstractParameter & root, std::string_view strPath ) {
+    return *static_cast<const T *>(
+            aux::get_value_ptr( root, strPath, ParameterTypeTraits<T>::code ) );
+}
 
 }  // namespace ::dataflow::config
 /// @} End of Parameters group
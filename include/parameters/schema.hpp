@@ -0,0 +1,228 @@
+# ifndef H_DATAFLOW_PARAMETERS_SCHEMA_H
+# define H_DATAFLOW_PARAMETERS_SCHEMA_H
+
+# include "parameters/path.hpp"
+
+# include <tuple>
+# include <list>
+# include <utility>
+# include <type_traits>
+
+namespace dataflow {
+
+/// \addtogroup Parameters
+/// @{
+
+namespace config {
+
+/// \brief Checks the path string grammar at compile time.
+/// \details Mirrors the grammar of PathTokenizer: string identifiers
+/// delimited by `.` and decimal indexes (no leading zeros) enclosed in
+/// `[`...`]`. Empty path is valid (refers to the root).
+constexpr bool
+is_valid_path( const char * p ) {
+    bool first = true;
+    while( *p ) {
+        if( '[' == *p ) {
+            ++p;
+            if( '0' == *p && ']' == p[1] ) {
+                ++p;
+            } else {
+                if( *p < '1' || *p > '9' ) return false;
+                while( *p >= '0' && *p <= '9' ) ++p;
+            }
+            if( ']' != *p ) return false;
+            ++p;
+        } else {
+            if( '.' == *p ) {
+                if( first ) return false;
+                ++p;
+            } else if( !first ) {
+                return false;
+            }
+            if( !( (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || '_' == *p ) ) {
+                return false;
+            }
+            while( (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')
+                || (*p >= '0' && *p <= '9') || '_' == *p ) ++p;
+        }
+        first = false;
+    }
+    return true;
+}
+
+/// \brief Type of default value for schema field.
+/// \details Literal type is needed for schema to be a `constexpr` object,
+/// so strings defaults are given as C-strings.
+template<typename T> struct SchemaDefaultType {
+    typedef T Type;
+};
+
+/// Template traits specification for string value
+template<> struct SchemaDefaultType<std::string> {
+    typedef const char * Type;
+};
+
+/// \brief Single entry of the configuration schema.
+/// \details Binds the member of the struct `S` to the parameter path.
+/// Constructed by field() and required() functions. When created in constant
+/// expression, invalid path grammar causes compilation error.
+template<typename S, typename T>
+struct SchemaField {
+    typedef S Struct;  ///< Configuration struct type
+    typedef T Value;  ///< Parameter type
+    static_assert( ParameterTypeTraits<T>::code
+                 , "Type is not supported by parameters." );
+
+    T S::* member;  ///< Member of the struct to fill
+    const char * path;  ///< Path of the parameter
+    typename SchemaDefaultType<T>::Type dflt;  ///< Default value
+    bool isRequired;  ///< If set, parameter must be provided
+
+    constexpr SchemaField( T S::* m
+                         , const char * p
+                         , typename SchemaDefaultType<T>::Type d
+                         , bool r )
+        : member(m)
+        , path( is_valid_path(p) ? p
+              : throw InvalidPathString( "Bad path in schema field." ) )
+        , dflt(d)
+        , isRequired(r) {}
+};
+
+/// Creates schema field for optional parameter with default value.
+template<typename S, typename T> constexpr SchemaField<S, T>
+field( T S::* m, const char * path, typename SchemaDefaultType<T>::Type dflt ) {
+    return SchemaField<S, T>( m, path, dflt, false );
+}
+
+/// Creates schema field for mandatory parameter.
+template<typename S, typename T> constexpr SchemaField<S, T>
+required( T S::* m, const char * path ) {
+    return SchemaField<S, T>( m, path, typename SchemaDefaultType<T>::Type(), true );
+}
+
+/// \brief Exception thrown when configuration does not conform the schema.
+/// \details Collects all the errors found during the schema application.
+class SchemaError : public std::runtime_error {
+private:
+    std::list<std::string> _errors;
+public:
+    /// Constructs exception from list of errors.
+    SchemaError( const std::list<std::string> & errors );
+    /// Returns errors found.
+    const std::list<std::string> & errors() const { return _errors; }
+};
+
+namespace aux {
+
+/// Keeps the state of schema application.
+struct SchemaApplication {
+    AbstractParameter * root;  ///< Root of the subtree
+    std::string_view prefix;  ///< Parent path of the previous field
+    AbstractParameter * parent;  ///< Resolved parent of the previous field
+    bool resolved;  ///< Parent of `prefix` was looked up (may be missing)
+    std::string parentError;  ///< Error of the parent lookup, if any
+    std::list<std::string> errors;  ///< Errors found
+
+    /// \brief Sets pointer to the value by path or `nullptr` if it does not
+    /// exist.
+    /// \details Returns `false` (and appends error) if path can not be
+    /// traversed or the value is not of `expected` type. The last integer
+    /// token may refer to the element of dense array. Parent container of
+    /// the previous field is reused if the fields share the parent path, so
+    /// fields listed in natural order (grouped by their containers) are
+    /// resolved without re-traversal, whether the parent exists or not.
+    bool find( const char * path, ParameterType expected, const void *& dest );
+    /// Appends formatted error message.
+    void error( const char * path, const char * what );
+};
+
+}  // namespace ::dataflow::config::aux
+
+/// \brief Compile-time description of the configuration struct.
+/// \details Declares how to fill the plain struct `S` from the parameters
+/// subtree. Application of the schema validates all the fields at once and
+/// reports all the errors together by SchemaError, so once struct is filled
+/// no lookups or string operations are needed.
+///
+/// \code
+/// struct MyCfg { double pedestal; int threshold; bool enabled; };
+/// constexpr auto gMyCfgSchema = make_schema<MyCfg>(
+///           required( &MyCfg::pedestal,  "calib.pedestal" )
+///         , field( &MyCfg::threshold, "calib.threshold", 10 )
+///         , field( &MyCfg::enabled,   "enabled", true ) );
+/// // ...
+/// MyCfg cfg = gMyCfgSchema.extract( root );
+/// \endcode
+template<typename S, typename... FieldsT>
+class Schema {
+private:
+    std::tuple<FieldsT...> _fields;
+
+    template<typename T> static void
+    _apply( aux::SchemaApplication & app
+          , const SchemaField<S, T> & f
+          , S & dest ) {
+        const void * p;
+        if( !app.find( f.path, ParameterTypeTraits<T>::code, p ) ) return;
+        if( !p ) {
+            if( f.isRequired ) {
+                app.error( f.path, "required parameter is not provided" );
+            } else {
+                dest.*f.member = T(f.dflt);
+            }
+            return;
+        }
+        dest.*f.member = *static_cast<const T *>(p);
+    }
+
+    template<size_t... Is> void
+    _apply_all( aux::SchemaApplication & app
+              , S & dest
+              , std::index_sequence<Is...> ) const {
+        (_apply( app, std::get<Is>(_fields), dest ), ...);
+    }
+public:
+    static_assert( (std::is_same<S, typename FieldsT::Struct>::value && ...)
+                 , "Schema fields refer to members of different struct." );
+
+    /// Constructs schema from given fields.
+    constexpr Schema( FieldsT... fields ) : _fields(fields...) {}
+
+    /// \brief Fills the struct with values from the subtree.
+    /// \details Throws SchemaError with all the errors found.
+    void fill( AbstractParameter & root, S & dest ) const {
+        aux::SchemaApplication app{ &root, std::string_view(), nullptr, false, {}, {} };
+        _apply_all( app, dest, std::index_sequence_for<FieldsT...>() );
+        if( !app.errors.empty() ) throw SchemaError( app.errors );
+    }
+
+    /// Fills the struct from the subtree at given path.
+    void fill( AbstractParameter & root, std::string_view subtree, S & dest ) const {
+        fill( get_parameter_ref( root, subtree ), dest );
+    }
+
+    /// Returns struct filled from the subtree.
+    S extract( AbstractParameter & root ) const {
+        S s;
+        fill( root, s );
+        return s;
+    }
+
+    /// Returns number of fields.
+    static constexpr size_t size() { return sizeof...(FieldsT); }
+};
+
+/// Creates schema for struct `S` from given fields.
+template<typename S, typename... FieldsT> constexpr Schema<S, FieldsT...>
+make_schema( FieldsT... fields ) {
+    return Schema<S, FieldsT...>( fields... );
+}
+
+}  // namespace ::dataflow::config
+/// @} End of Parameters group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PARAMETERS_SCHEMA_H
@@ -0,0 +1,153 @@
+# ifndef H_DATAFLOW_SYS_SYMBOL_H
+# define H_DATAFLOW_SYS_SYMBOL_H
+
+# include <atomic>
+# include <cstdint>
+# include <functional>
+# include <memory>
+# include <mutex>
+# include <ostream>
+# include <string>
+# include <string_view>
+
+namespace dataflow {
+
+/// \addtogroup Parameters
+/// @{
+
+namespace config {
+
+/// \brief Global thread-safe table of interned strings.
+/// \details Each distinct string is stored once and identified by the
+/// number given in order of interning (empty string is number zero).
+/// Strings are never removed, so references to them stay valid. Lookups
+/// (of the string by number and of the number by string) take no locks:
+/// the strings are kept in chunks, the numbers -- in open-addressing hash
+/// table, replaced by the larger one when filled by half (replaced tables
+/// are kept, as lookups may still use them). Interning takes the lock.
+class SymbolTable {
+public:
+    /// Number of bits of the symbol number addressing string within chunk.
+    static constexpr unsigned kChunkBits = 12;
+    /// Maximum number of chunks (limits number of symbols).
+    static constexpr size_t kMaxChunks = 4096;
+private:
+    /// Hash table of symbol numbers (plus one, zero marks empty slot)
+    struct Index {
+        size_t mask;
+        std::unique_ptr<std::atomic<uint32_t>[]> slots;
+        std::unique_ptr<Index> previous;  ///< Replaced table
+    };
+
+    std::mutex _mutex;  ///< Taken by interning
+    std::atomic<Index *> _index;  ///< Current hash table
+    /// Chunks of `1 << kChunkBits` strings each
+    std::atomic<std::string *> _chunks[kMaxChunks];
+    std::atomic<uint32_t> _size;  ///< Number of interned strings
+
+    SymbolTable();
+    void _insert( Index & ix, uint32_t id, size_t hash );
+public:
+    SymbolTable( const SymbolTable & ) = delete;
+    SymbolTable & operator=( const SymbolTable & ) = delete;
+
+    /// Returns instance of the table.
+    static SymbolTable & self();
+
+    /// Returns number of the string, interning it if needed.
+    uint32_t intern( std::string_view );
+    /// Sets number of the string if it is interned, returns `false` if not.
+    bool find( std::string_view, uint32_t & ) const;
+    /// Returns interned string by its number (no range check).
+    const std::string & str( uint32_t id ) const {
+        return _chunks[id >> kChunkBits].load( std::memory_order_acquire )
+                      [id & ((1u << kChunkBits) - 1)];
+    }
+    /// Returns number of interned strings.
+    size_t size() const { return _size.load( std::memory_order_acquire ); }
+};
+
+/// \brief Interned string: compact key of Dictionary and Path.
+/// \details Keeps the number of the string in SymbolTable, so copying,
+/// comparison and hashing are those of integer, and the strings are shared
+/// by all the keys. Constructed implicitly from strings (interning them)
+/// and converted implicitly to `const std::string &`, so the string-based
+/// code keeps working.
+///
+/// Symbols are ordered by their numbers, i.e. in order of interning, not
+/// alphabetically.
+///
+/// \code
+/// Symbol s( "pedestal" );
+/// assert( s == Symbol("pedestal") && s == "pedestal" );
+/// std::cout << s << s.size();
+/// \endcode
+class Symbol {
+private:
+    uint32_t _id;
+public:
+    /// Constructs symbol of empty string.
+    Symbol() : _id(0) {}
+    /// Constructs symbol of the string, interning it.
+    Symbol( std::string_view s ) : _id( SymbolTable::self().intern(s) ) {}
+    /// Constructs symbol of the string, interning it.
+    Symbol( const std::string & s ) : Symbol( std::string_view(s) ) {}
+    /// Constructs symbol of the string, interning it.
+    Symbol( const char * s ) : Symbol( std::string_view(s) ) {}
+
+    /// Returns symbol by its number (given by SymbolTable, not checked).
+    static Symbol from_id( uint32_t id ) {
+        Symbol s;
+        s._id = id;
+        return s;
+    }
+    /// Sets symbol of the string if it is interned, returns `false` if not
+    /// (then no entry is keyed by the string).
+    static bool find( std::string_view s, Symbol & sym ) {
+        return SymbolTable::self().find( s, sym._id );
+    }
+
+    /// Returns number of the symbol.
+    uint32_t id() const { return _id; }
+    /// Returns the string.
+    const std::string & str() const { return SymbolTable::self().str( _id ); }
+    /// Returns the string.
+    operator const std::string & () const { return str(); }
+    /// Returns the string as C-string.
+    const char * c_str() const { return str().c_str(); }
+    /// Returns length of the string.
+    size_t size() const { return str().size(); }
+    /// Returns `true` for empty string.
+    bool empty() const { return !_id; }
+
+    bool operator==( Symbol o ) const { return _id == o._id; }
+    bool operator!=( Symbol o ) const { return _id != o._id; }
+    bool operator<( Symbol o ) const { return _id < o._id; }
+    bool operator==( std::string_view s ) const { return str() == s; }
+    bool operator!=( std::string_view s ) const { return str() != s; }
+    bool operator==( const std::string & s ) const { return str() == s; }
+    bool operator!=( const std::string & s ) const { return str() != s; }
+    bool operator==( const char * s ) const { return str() == s; }
+    bool operator!=( const char * s ) const { return str() != s; }
+};
+
+/// Prints the string of the symbol.
+inline std::ostream &
+operator<<( std::ostream & os, Symbol s ) {
+    return os << s.str();
+}
+
+}  // namespace ::dataflow::config
+
+/// @} End of Parameters group
+
+}  // namespace ::dataflow
+
+namespace std {
+/// Hash of the symbol is its number.
+template<> struct hash< ::dataflow::config::Symbol > {
+    size_t operator()( ::dataflow::config::Symbol s ) const { return s.id(); }
+};
+}  // namespace std
+
+# endif  // H_DATAFLOW_SYS_SYMBOL_H
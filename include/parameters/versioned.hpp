@@ -0,0 +1,250 @@
+# ifndef H_DATAFLOW_PARAMETERS_VERSIONED_H
+# define H_DATAFLOW_PARAMETERS_VERSIONED_H
+
+# include <atomic>
+# include <cstdint>
+# include <memory>
+# include <mutex>
+# include <stdexcept>
+# include <utility>
+# include <vector>
+
+namespace dataflow {
+
+/// \addtogroup Parameters
+/// @{
+
+namespace config {
+
+/// \brief Holder of the immutable configuration versions ("RCU").
+/// \details Keeps current version of the value `T` (e.g. FrozenConfig or
+/// `std::shared_ptr<const Dictionary>`) and lets the writer publish new
+/// version atomically while readers keep working with the one they have
+/// pinned.
+///
+/// Each reader thread registers a Reader, owning one of the slots. Slots
+/// are allocated in blocks of `kBlockReaders`; when all of them are taken,
+/// the new block is chained (lock-free), so number of readers is not
+/// limited. Slots are reused once their readers are destroyed. Reader::pin() publishes the pointer to current version in its
+/// slot ("hazard pointer") and returns Pin keeping the version alive until
+/// destroyed. Pinning is wait-free for the readers in absence of writes: two
+/// atomic loads and one store, no locks and no shared counters modified.
+///
+/// Writers (serialized by mutex) exchange the current version and retire
+/// the old one; retired versions are deleted once no reader slot refers
+/// to them (checked on each publish() and by reclaim()).
+///
+/// \code
+/// Versioned<FrozenConfig> cfg( freeze( root ) );
+/// // reader thread:
+/// Versioned<FrozenConfig>::Reader r( cfg );
+/// for( ;; ) {  // for each event or batch
+///     auto pin = r.pin();
+///     double ped = get_parameter_ref( *pin, "calib.pedestal" ).as<double>();
+/// }
+/// // writer thread:
+/// cfg.publish( freeze( newRoot ) );
+/// \endcode
+template<typename T>
+class Versioned {
+public:
+    /// Number of reader slots allocated at once
+    static constexpr size_t kBlockReaders = 64;
+
+    /// Published version
+    struct Version {
+        T value;  ///< Immutable value
+        uint64_t number;  ///< Sequential number of the version
+    };
+private:
+    /// Reader's slot, padded to avoid false sharing
+    struct alignas(64) Slot {
+        std::atomic<const Version *> pinned{nullptr};  ///< Version in use
+        std::atomic<bool> used{false};  ///< Slot is owned by a Reader
+    };
+    /// Block of reader slots, chained when all the slots are taken
+    struct SlotBlock {
+        Slot slots[kBlockReaders];
+        std::atomic<SlotBlock *> next{nullptr};  ///< Next block (never removed)
+    };
+
+    /// First block of reader slots
+    SlotBlock _slots;
+    std::atomic<const Version *> _current;
+    /// Serializes writers, guards `_retired` and `_number`
+    mutable std::mutex _mtx;
+    /// Versions replaced but possibly still pinned
+    std::vector<const Version *> _retired;
+    /// Number of the last version published
+    uint64_t _number;
+
+    /// Deletes retired versions not pinned by any reader (lock held).
+    void _reclaim() {
+        auto it = _retired.begin();
+        while( _retired.end() != it ) {
+            bool pinned = false;
+            for( const SlotBlock * b = &_slots; b && !pinned; b = b->next.load() ) {
+                for( const Slot & s : b->slots ) {
+                    if( s.pinned.load() == *it ) { pinned = true; break; }
+                }
+            }
+            if( pinned ) {
+                ++it;
+            } else {
+                delete *it;
+                it = _retired.erase(it);
+            }
+        }
+    }
+public:
+    /// \brief Version kept alive for the reader.
+    /// \details Move-only; unpins the version when destroyed.
+    class Pin {
+    private:
+        const Version * _v;
+        std::atomic<const Version *> * _slot;
+    public:
+        /// Constructs pin (used by Reader).
+        Pin( const Version * v, std::atomic<const Version *> * slot )
+            : _v(v), _slot(slot) {}
+        Pin( Pin && o ) : _v(o._v), _slot(o._slot) { o._slot = nullptr; }
+        Pin( const Pin & ) = delete;
+        Pin & operator=( const Pin & ) = delete;
+        ~Pin() { if( _slot ) _slot->store( nullptr, std::memory_order_release ); }
+
+        /// Returns pinned value.
+        const T & operator*() const { return _v->value; }
+        /// Returns pointer to pinned value.
+        const T * operator->() const { return &_v->value; }
+        /// Returns number of pinned version.
+        uint64_t version() const { return _v->number; }
+    };
+
+    /// \brief Reader thread's registration.
+    /// \details Owns one slot of the holder, taking free one or adding the
+    /// block of slots. Only one Pin per Reader may exist at a time.
+    class Reader {
+    private:
+        Versioned * _h;
+        Slot * _slot;
+    public:
+        /// Registers reader at the holder.
+        explicit Reader( Versioned & h ) : _h(&h), _slot(nullptr) {
+            SlotBlock * b = &h._slots;
+            for(;;) {
+                for( Slot & s : b->slots ) {
+                    bool expected = false;
+                    if( s.used.compare_exchange_strong( expected, true ) ) {
+                        _slot = &s;
+                        return;
+                    }
+                }
+                SlotBlock * next = b->next.load();
+                if( !next ) {
+                    // all slots taken: chain new block with the first slot ours
+                    std::unique_ptr<SlotBlock> nb( new SlotBlock );
+                    nb->slots[0].used.store( true, std::memory_order_relaxed );
+                    if( b->next.compare_exchange_strong( next, nb.get() ) ) {
+                        _slot = nb->slots;
+                        nb.release();
+                        return;
+                    }
+                    // other reader chained the block first, `next' is set to it
+                }
+                b = next;
+            }
+        }
+        Reader( const Reader & ) = delete;
+        Reader & operator=( const Reader & ) = delete;
+        /// Releases the slot.
+        ~Reader() {
+            _slot->pinned.store( nullptr );
+            _slot->used.store( false );
+        }
+
+        /// \brief Pins current version.
+        /// \details Throws `std::logic_error` if previous Pin still exists.
+        Pin pin() {
+            if( _slot->pinned.load( std::memory_order_relaxed ) ) {
+                throw std::logic_error( "Versioned config reader is already pinned." );
+            }
+            const Version * v = _h->_current.load( std::memory_order_acquire );
+            for(;;) {
+                _slot->pinned.store( v );
+                // re-check: writer could retire `v' before it noticed our slot
+                const Version * cur = _h->_current.load();
+                if( cur == v ) break;
+                v = cur;
+            }
+            return Pin( v, &_slot->pinned );
+        }
+    };
+
+    /// Constructs holder with initial version (number 1).
+    explicit Versioned( T initial )
+        : _current( new Version{ std::move(initial), 1 } )
+        , _number(1) {}
+    Versioned( const Versioned & ) = delete;
+    Versioned & operator=( const Versioned & ) = delete;
+    /// Deletes all the versions; readers must be destroyed before.
+    ~Versioned() {
+        delete _current.load();
+        for( auto v : _retired ) delete v;
+        for( SlotBlock * b = _slots.next.load(); b; ) {
+            SlotBlock * next = b->next.load();
+            delete b;
+            b = next;
+        }
+    }
+
+    /// \brief Publishes new version, returns its number.
+    /// \details Readers pinning afterwards get the new version; the previous
+    /// one is deleted once no reader refers to it.
+    uint64_t publish( T value ) {
+        std::lock_guard<std::mutex> l( _mtx );
+        const Version * v = new Version{ std::move(value), ++_number };
+        _retired.push_back( _current.exchange( v ) );
+        _reclaim();
+        return v->number;
+    }
+
+    /// \brief Publishes new version produced from the current one.
+    /// \details Calls `f(const T &)` returning new value under writer's
+    /// lock, so concurrent updates are not lost. Readers are not blocked.
+    template<typename F> uint64_t update( F f ) {
+        std::lock_guard<std::mutex> l( _mtx );
+        const Version * v = new Version{ f( _current.load()->value ), ++_number };
+        _retired.push_back( _current.exchange( v ) );
+        _reclaim();
+        return v->number;
+    }
+
+    /// Deletes retired versions not pinned anymore.
+    void reclaim() {
+        std::lock_guard<std::mutex> l( _mtx );
+        _reclaim();
+    }
+
+    /// Returns number of the current version.
+    uint64_t version() const { return _current.load( std::memory_order_acquire )->number; }
+
+    /// Returns number of reader slots allocated.
+    size_t n_slots() const {
+        size_t n = 0;
+        for( const SlotBlock * b = &_slots; b; b = b->next.load() ) n += kBlockReaders;
+        return n;
+    }
+
+    /// Returns number of retired versions not deleted yet.
+    size_t n_retired() const {
+        std::lock_guard<std::mutex> l( _mtx );
+        return _retired.size();
+    }
+};
+
+}  // namespace ::dataflow::config
+/// @} End of Parameters group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PARAMETERS_VERSIONED_H
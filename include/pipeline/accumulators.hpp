@@ -0,0 +1,356 @@
+# ifndef H_DATAFLOW_PIPELINE_ACCUMULATORS_H
+# define H_DATAFLOW_PIPELINE_ACCUMULATORS_H
+
+# include "pipeline/stage.hpp"
+
+# include <atomic>
+# include <cmath>
+# include <cstdint>
+# include <memory>
+# include <mutex>
+# include <stdexcept>
+# include <utility>
+# include <vector>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Exception thrown on invalid binning or merge of accumulators of
+/// different binning.
+class BadBinning : public std::runtime_error {
+public:
+    BadBinning( const std::string & what ) : std::runtime_error(what) {}
+};
+
+namespace aux {
+
+/// \brief Value of the accumulator.
+/// \details Written by single thread (the one filling the accumulator),
+/// may be read by others concurrently: relaxed atomic loads and stores
+/// compile to plain moves, so filling costs the same as with plain value,
+/// while snapshot taken by other thread reads defined (possibly stale)
+/// values.
+template<typename T>
+class Cell {
+private:
+    std::atomic<T> _v;
+public:
+    Cell( T v=T() ) : _v(v) {}
+    Cell( const Cell & o ) : _v( o.load() ) {}
+    Cell & operator=( const Cell & o ) {
+        store( o.load() );
+        return *this;
+    }
+    T load() const { return _v.load( std::memory_order_relaxed ); }
+    void store( T v ) { _v.store( v, std::memory_order_relaxed ); }
+    /// Adds to the value (by its only writer).
+    void add( T d ) { store( load() + d ); }
+};
+
+/// Maximum number of threads filling sharded accumulators at once.
+constexpr unsigned kMaxThreadSlots = 256;
+
+/// Slot of the thread, taken on construction, released on destruction.
+struct ThreadSlot {
+    const unsigned id;
+    ThreadSlot();
+    ~ThreadSlot();
+};
+
+/// \brief Returns slot of the calling thread.
+/// \details Slots are dense numbers of the threads alive, reused after the
+/// thread exits. Throws std::length_error if `kMaxThreadSlots` are taken.
+inline unsigned
+thread_slot() {
+    static thread_local ThreadSlot slot;
+    return slot.id;
+}
+
+/// \brief Merges accumulators pairwise (tree of `log2(n)` levels).
+/// \details Result is left in the first one. Compared to merging one by
+/// one, rounding errors of the sums grow with the depth of the tree, and
+/// merges of each level are independent (may run concurrently).
+template<typename AccT> void
+merge_tree( std::vector<AccT> & accs ) {
+    for( size_t s = 1; s < accs.size(); s *= 2 ) {
+        for( size_t i = 0; i + s < accs.size(); i += 2*s ) accs[i].merge( accs[i + s] );
+    }
+}
+
+}  // namespace ::dataflow::aux
+
+/// \brief Counter of the values of type `T`.
+/// \details Stateful handler (observer) accumulating per-worker copies (see
+/// ConcurrencyTraits).
+template<typename T>
+class Counter {
+private:
+    aux::Cell<uint64_t> _n;
+public:
+    static constexpr ConcurrencyPolicy kConcurrency = kCloned;
+
+    /// Counts the value.
+    void call( const T & ) { _n.add( 1 ); }
+    /// Returns number of values counted.
+    uint64_t count() const { return _n.load(); }
+
+    Counter clone() const { return Counter(); }
+    void merge( const Counter & o ) { _n.add( o.count() ); }
+};
+
+/// \brief Running mean and variance of the values.
+/// \details Updated by Welford's algorithm, merged by Chan's formulae, so
+/// the precision does not suffer from the large mean.
+class Moments {
+private:
+    aux::Cell<uint64_t> _n;
+    aux::Cell<double> _mean, _m2;  ///< Mean and sum of squared deviations
+public:
+    static constexpr ConcurrencyPolicy kConcurrency = kCloned;
+
+    /// Accumulates the value.
+    void fill( double x ) {
+        const uint64_t n = _n.load() + 1;
+        const double mean = _mean.load(), d = x - mean, m = mean + d/n;
+        _n.store( n );
+        _mean.store( m );
+        _m2.add( d*(x - m) );
+    }
+    void call( const double & x ) { fill( x ); }
+
+    /// Returns number of values.
+    uint64_t count() const { return _n.load(); }
+    /// Returns mean of the values.
+    double mean() const { return _mean.load(); }
+    /// Returns (population) variance of the values.
+    double variance() const { return _n.load() ? _m2.load()/_n.load() : 0.; }
+
+    Moments clone() const { return Moments(); }
+    void merge( const Moments & o );
+};
+
+/// \brief Histogram axis of `n` equal bins covering `[lo, hi)`.
+/// \details Bin numbers are 1 to `n`; zero is underflow (and NaN), `n + 1`
+/// is overflow.
+class FixedAxis {
+private:
+    size_t _n;
+    double _lo, _hi, _scale;
+public:
+    /// Creates axis; throws BadBinning if `n` is zero or `lo >= hi`.
+    FixedAxis( size_t n, double lo, double hi );
+
+    /// Returns number of bins (not counting underflow and overflow).
+    size_t size() const { return _n; }
+    /// Returns number of the bin value falls into.
+    size_t index( double x ) const {
+        if( !(x >= _lo) ) return 0;
+        if( x >= _hi ) return _n + 1;
+        const size_t i = size_t( (x - _lo)*_scale );
+        return 1 + (i < _n ? i : _n - 1);  // rounding near `hi`
+    }
+    /// Returns lower edge of the bin `1..n`.
+    double lower( size_t bin ) const { return _lo + (bin - 1)/_scale; }
+    /// Returns upper edge of the bin `1..n`.
+    double upper( size_t bin ) const { return bin == _n ? _hi : _lo + bin/_scale; }
+
+    bool operator==( const FixedAxis & o ) const {
+        return _n == o._n && _lo == o._lo && _hi == o._hi;
+    }
+    bool operator!=( const FixedAxis & o ) const { return !(*this == o); }
+};
+
+/// \brief Histogram axis of bins given by increasing edges.
+/// \details Bin numbers are as of FixedAxis; bin is found by binary search.
+class VariableAxis {
+private:
+    std::vector<double> _edges;
+public:
+    /// Creates axis; throws BadBinning unless there are at least two edges,
+    /// strictly increasing.
+    explicit VariableAxis( std::vector<double> edges );
+
+    /// Returns number of bins (not counting underflow and overflow).
+    size_t size() const { return _edges.size() - 1; }
+    /// Returns number of the bin value falls into.
+    size_t index( double x ) const;
+    /// Returns lower edge of the bin `1..n`.
+    double lower( size_t bin ) const { return _edges[bin - 1]; }
+    /// Returns upper edge of the bin `1..n`.
+    double upper( size_t bin ) const { return _edges[bin]; }
+
+    bool operator==( const VariableAxis & o ) const { return _edges == o._edges; }
+    bool operator!=( const VariableAxis & o ) const { return _edges != o._edges; }
+};
+
+/// \brief One-dimensional histogram of weighted values.
+/// \details Stateful handler filled by `double` values, accumulating
+/// per-worker copies (see ConcurrencyTraits). Copies are merged if their
+/// axes are equal (BadBinning is thrown otherwise).
+///
+/// \code
+/// auto h = std::make_shared< Histogram1D<> >( FixedAxis( 100, 0., 50. ) );
+/// p.append<energy>( "energy" ).append( h, "energy histogram" );
+/// \endcode
+template<typename AxisT=FixedAxis>
+class Histogram1D {
+private:
+    AxisT _axis;
+    std::vector< aux::Cell<double> > _bins;  ///< Including underflow, overflow
+    aux::Cell<uint64_t> _n;
+public:
+    static constexpr ConcurrencyPolicy kConcurrency = kCloned;
+
+    explicit Histogram1D( const AxisT & axis ) : _axis(axis), _bins( axis.size() + 2 ) {}
+
+    /// Adds weight `w` to the bin of value `x`.
+    void fill( double x, double w=1. ) {
+        _bins[_axis.index(x)].add( w );
+        _n.add( 1 );
+    }
+    void call( const double & x ) { fill( x ); }
+
+    /// Returns the axis.
+    const AxisT & axis() const { return _axis; }
+    /// Returns sum of weights in the bin (0 is underflow, `n + 1` overflow).
+    double bin( size_t i ) const { return _bins[i].load(); }
+    /// Returns number of fills.
+    uint64_t entries() const { return _n.load(); }
+
+    Histogram1D clone() const { return Histogram1D( _axis ); }
+    void merge( const Histogram1D & o ) {
+        if( _axis != o._axis ) throw BadBinning( "Histograms of different binning are merged." );
+        for( size_t i = 0; i < _bins.size(); ++i ) _bins[i].add( o._bins[i].load() );
+        _n.add( o.entries() );
+    }
+};
+
+/// \brief Two-dimensional histogram of weighted values.
+/// \details As Histogram1D, filled by pairs of values.
+template<typename XAxisT=FixedAxis, typename YAxisT=XAxisT>
+class Histogram2D {
+private:
+    XAxisT _x;
+    YAxisT _y;
+    std::vector< aux::Cell<double> > _bins;  ///< Row per `x` bin
+    aux::Cell<uint64_t> _n;
+public:
+    static constexpr ConcurrencyPolicy kConcurrency = kCloned;
+
+    Histogram2D( const XAxisT & x, const YAxisT & y )
+            : _x(x), _y(y), _bins( (x.size() + 2)*(y.size() + 2) ) {}
+
+    /// Adds weight `w` to the bin of values `x`, `y`.
+    void fill( double x, double y, double w=1. ) {
+        _bins[_x.index(x)*(_y.size() + 2) + _y.index(y)].add( w );
+        _n.add( 1 );
+    }
+    void call( const std::pair<double, double> & v ) { fill( v.first, v.second ); }
+
+    /// Returns the `x` axis.
+    const XAxisT & x_axis() const { return _x; }
+    /// Returns the `y` axis.
+    const YAxisT & y_axis() const { return _y; }
+    /// Returns sum of weights in the bin (see Histogram1D::bin()).
+    double bin( size_t i, size_t j ) const { return _bins[i*(_y.size() + 2) + j].load(); }
+    /// Returns number of fills.
+    uint64_t entries() const { return _n.load(); }
+
+    Histogram2D clone() const { return Histogram2D( _x, _y ); }
+    void merge( const Histogram2D & o ) {
+        if( _x != o._x || _y != o._y ) {
+            throw BadBinning( "Histograms of different binning are merged." );
+        }
+        for( size_t i = 0; i < _bins.size(); ++i ) _bins[i].add( o._bins[i].load() );
+        _n.add( o.entries() );
+    }
+};
+
+/// \brief Accumulator filled concurrently by threads, each to its own
+/// shard.
+/// \details Reentrant handler: the thread calling it fills its private
+/// copy of accumulator `AccT` (created on the first fill by the thread,
+/// cache-line aligned), without locks. `snapshot()` merges the shards
+/// pairwise (see aux::merge_tree()) while the threads keep filling: the
+/// values of the accumulators are read atomically, though each reflects
+/// the fills done by the moment it was read. Final result is exact when
+/// no thread fills the shards any longer.
+///
+/// Unlike kCloned handlers in ParallelPipeline (merged at the end of each
+/// `process()`), sharded accumulator may be used by any threads (e.g. by
+/// groups of StreamingPipeline) and inspected at any time.
+///
+/// \code
+/// auto h = std::make_shared< Sharded< Histogram1D<> > >( Histogram1D<>( FixedAxis( 100, 0., 50. ) ) );
+/// p.append( h, "energy histogram" );
+/// ...
+/// Histogram1D<> result = h->snapshot();  // workers keep running
+/// \endcode
+template<typename AccT>
+class Sharded {
+public:
+    static constexpr ConcurrencyPolicy kConcurrency = kReentrant;
+    /// Type of value accumulated
+    typedef typename meta::StageTraits<decltype(&AccT::call)>::Input Input;
+private:
+    struct alignas(64) Shard {
+        AccT acc;
+        explicit Shard( AccT a ) : acc( std::move(a) ) {}
+    };
+
+    const AccT _prototype;  ///< Empty accumulator the shards are cloned from
+    std::atomic<Shard *> _slots[aux::kMaxThreadSlots];  ///< Shards by thread slot
+    mutable std::mutex _mutex;  ///< Guards the list of shards
+    std::vector< std::unique_ptr<Shard> > _shards;
+
+    Shard * _add_shard( unsigned slot ) {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _shards.emplace_back( new Shard( _prototype.clone() ) );
+        _slots[slot].store( _shards.back().get(), std::memory_order_release );
+        return _shards.back().get();
+    }
+public:
+    /// Creates sharded accumulator of the (empty) prototype binning.
+    explicit Sharded( const AccT & prototype ) : _prototype( prototype.clone() ) {
+        for( auto & s : _slots ) s.store( nullptr, std::memory_order_relaxed );
+    }
+    Sharded( const Sharded & ) = delete;
+    Sharded & operator=( const Sharded & ) = delete;
+
+    /// Returns accumulator of the calling thread.
+    AccT & local() {
+        // shard of the slot is set by the thread owning the slot only
+        const unsigned slot = aux::thread_slot();
+        Shard * s = _slots[slot].load( std::memory_order_acquire );
+        if( !s ) s = _add_shard( slot );
+        return s->acc;
+    }
+    /// Fills the value into accumulator of the calling thread.
+    void call( const Input & v ) { local().call( v ); }
+
+    /// Returns number of shards (threads filled the accumulator).
+    size_t size() const {
+        std::lock_guard<std::mutex> lock( _mutex );
+        return _shards.size();
+    }
+    /// Returns accumulator merged of all the shards.
+    AccT snapshot() const {
+        std::vector<AccT> accs;
+        {
+            std::lock_guard<std::mutex> lock( _mutex );
+            accs.reserve( _shards.size() + 1 );
+            accs.push_back( _prototype.clone() );
+            for( const auto & s : _shards ) accs.push_back( s->acc );
+        }
+        aux::merge_tree( accs );
+        return std::move( accs.front() );
+    }
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_ACCUMULATORS_H
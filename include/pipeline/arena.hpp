@@ -0,0 +1,116 @@
+# ifndef H_DATAFLOW_PIPELINE_ARENA_H
+# define H_DATAFLOW_PIPELINE_ARENA_H
+
+# include <cstddef>
+# include <cstdint>
+# include <memory_resource>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Bump allocator for the data of single event (or batch).
+/// \details Memory resource serving allocations from the chunks obtained
+/// from upstream resource, by advancing the pointer; deallocation does
+/// nothing. `reset()` rewinds the arena to the beginning of the first chunk
+/// in constant time, keeping all the chunks, so once the arena has grown
+/// to fit the largest event, processing does no upstream allocations.
+///
+/// Pipelines keep the arena per event being processed and reset it once the
+/// event leaves the pipeline. Handlers obtain it with `event_arena()`:
+///
+/// \code
+/// std::pmr::vector<Hit> hits( event_arena() );
+/// \endcode
+class Arena : public std::pmr::memory_resource {
+public:
+    /// Default size of the chunk, bytes
+    static constexpr size_t kDefaultChunkSize = 64*1024;
+private:
+    /// Header of the chunk, followed by the data
+    struct Chunk {
+        Chunk * next;
+        size_t size;  ///< Size of data, bytes
+        char * data() { return reinterpret_cast<char *>(this + 1); }
+    };
+
+    const size_t _chunkSize;
+    std::pmr::memory_resource * const _upstream;
+    Chunk * _first;  ///< First chunk of the list
+    Chunk * _current;  ///< Chunk allocations are served from
+    char * _ptr, * _end;  ///< Free space of the current chunk
+    size_t _nAllocations, _nBytes;  ///< Counters since reset
+    size_t _nChunks, _capacity;  ///< Chunks allocated
+
+    void * _allocate_slow( size_t bytes, size_t alignment );
+protected:
+    void * do_allocate( size_t bytes, size_t alignment ) override {
+        const uintptr_t p = ( reinterpret_cast<uintptr_t>(_ptr) + alignment - 1 )
+                          & ~( uintptr_t(alignment) - 1 );
+        if( !_ptr || p + bytes > reinterpret_cast<uintptr_t>(_end) ) {
+            return _allocate_slow( bytes, alignment );
+        }
+        _ptr = reinterpret_cast<char *>( p + bytes );
+        ++_nAllocations;
+        _nBytes += bytes;
+        return reinterpret_cast<void *>( p );
+    }
+    void do_deallocate( void *, size_t, size_t ) override {}
+    bool do_is_equal( const std::pmr::memory_resource & o ) const noexcept override {
+        return this == &o;
+    }
+public:
+    /// Creates empty arena; chunks are allocated on demand.
+    explicit Arena( size_t chunkSize=kDefaultChunkSize
+                  , std::pmr::memory_resource * upstream=std::pmr::new_delete_resource() );
+    Arena( const Arena & ) = delete;
+    Arena & operator=( const Arena & ) = delete;
+    ~Arena();
+
+    /// Releases all the memory allocated (without returning it to upstream).
+    void reset() {
+        _current = _first;
+        _ptr = _first ? _first->data() : nullptr;
+        _end = _first ? _ptr + _first->size : nullptr;
+        _nAllocations = _nBytes = 0;
+    }
+    /// Returns `true` if something was allocated since reset.
+    bool used() const { return _nAllocations; }
+    /// Returns number of allocations since reset.
+    size_t n_allocations() const { return _nAllocations; }
+    /// Returns number of bytes allocated since reset.
+    size_t n_bytes() const { return _nBytes; }
+    /// Returns number of chunks obtained from upstream resource.
+    size_t n_chunks() const { return _nChunks; }
+    /// Returns total size of the chunks, bytes.
+    size_t capacity() const { return _capacity; }
+};
+
+/// \brief Returns memory resource for the data of the event being processed.
+/// \details Within the handler called by pipeline, returns the arena of
+/// the current event (valid until the event leaves the pipeline); outside,
+/// returns default memory resource.
+std::pmr::memory_resource * event_arena();
+
+namespace aux {
+/// Sets event arena of the calling thread, returns previous one.
+std::pmr::memory_resource * set_event_arena( std::pmr::memory_resource * );
+
+/// Sets event arena of the calling thread for the scope lifetime.
+class EventArenaScope {
+private:
+    std::pmr::memory_resource * _prev;
+public:
+    explicit EventArenaScope( std::pmr::memory_resource * mr ) : _prev( set_event_arena(mr) ) {}
+    EventArenaScope( const EventArenaScope & ) = delete;
+    EventArenaScope & operator=( const EventArenaScope & ) = delete;
+    ~EventArenaScope() { set_event_arena( _prev ); }
+};
+}  // namespace ::dataflow::aux
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_ARENA_H
@@ -0,0 +1,230 @@
+# ifndef H_DATAFLOW_PIPELINE_BATCH_H
+# define H_DATAFLOW_PIPELINE_BATCH_H
+
+# include "handlers/handler.hpp"
+# include "parameters/array.hpp"
+# include "pipeline/slot.hpp"
+
+# include <cstdint>
+# include <vector>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Batch of values processed by the pipeline in batch mode.
+/// \details Values of the batch are kept in contiguous column
+/// (`std::vector<T>`), so each stage runs a tight loop over it. Cuts do not
+/// break the loop: selected values are compacted to the beginning of the
+/// column (by pass mask filled by cut kernel, or by predicate evaluated in
+/// the same pass), so the following stages again run over dense array. The
+/// positions of the selected values in the input are tracked in index list.
+///
+/// Batch keeps two columns: handlers mapping the values to the other type
+/// write the result into the spare one. Columns, mask and index are reused
+/// by subsequent batches, so steady-state processing does no allocations.
+class Batch {
+private:
+    Slot _columns[2];  ///< Current and spare columns
+    void (*_clear[2])( Slot & );  ///< Clears the column (keeping capacity)
+    unsigned _cur;  ///< Number of current column
+    std::vector<uint32_t> _index;  ///< Input positions of selected values
+    std::vector<uint8_t> _pass;  ///< Pass mask filled by cuts
+
+    template<typename T> static void _clear_column( Slot & s ) {
+        s.get_unchecked< std::vector<T> >().clear();
+    }
+    template<typename T> std::vector<T> & _column( unsigned i ) {
+        if( !_columns[i].holds< std::vector<T> >() ) {
+            _columns[i].emplace< std::vector<T> >();
+            _clear[i] = &_clear_column<T>;
+        }
+        return _columns[i].get_unchecked< std::vector<T> >();
+    }
+public:
+    Batch() : _clear{nullptr, nullptr}, _cur(0) {}
+
+    /// Sets the batch to copy of `n` values starting from `data`.
+    template<typename T> void assign( const T * data, size_t n ) {
+        if( !_columns[_cur].holds< std::vector<T> >()
+          && _columns[1 - _cur].holds< std::vector<T> >() ) _cur = 1 - _cur;
+        _column<T>( _cur ).assign( data, data + n );
+        _index.resize( n );
+        for( size_t i = 0; i < n; ++i ) _index[i] = uint32_t(i);
+    }
+
+    /// \brief Destroys values of the batch.
+    /// \details Storage is kept for subsequent batches.
+    void clear() {
+        for( unsigned i = 0; i < 2; ++i ) if( _clear[i] ) _clear[i]( _columns[i] );
+        _index.clear();
+    }
+
+    /// Returns number of selected values.
+    size_t size() const { return _index.size(); }
+    /// Returns `true` if no values are selected.
+    bool empty() const { return _index.empty(); }
+    /// Returns positions of selected values in the input.
+    const std::vector<uint32_t> & index() const { return _index; }
+    /// Returns selected values; throws BadSlotAccess on type mismatch.
+    template<typename T> const std::vector<T> & values() const {
+        return _columns[_cur].get< std::vector<T> >();
+    }
+
+    /// Returns current column; type has to be assured by caller.
+    template<typename T> std::vector<T> & column() {
+        return _columns[_cur].get_unchecked< std::vector<T> >();
+    }
+    /// Returns pass mask of `size()` elements, to be filled by a cut.
+    uint8_t * pass_mask() {
+        _pass.resize( _index.size() );
+        return _pass.data();
+    }
+    /// \brief Keeps values of current column passed by the cut.
+    /// \details Returns `false` if no values were selected.
+    template<typename T> bool select() {
+        const uint8_t * pass = _pass.data();
+        return filter<T>( [pass, i = size_t(0)]( const T & ) mutable { return pass[i++]; } );
+    }
+    /// \brief Keeps values of current column for which `pred` returns `true`.
+    /// \details Values are compacted in the same pass the predicate is
+    /// evaluated. Returns `false` if no values were selected.
+    template<typename T, typename PredT> bool filter( PredT && pred ) {
+        std::vector<T> & v = column<T>();
+        uint32_t * idx = _index.data();
+        const size_t n = v.size();
+        size_t k = 0;
+        if constexpr( std::is_trivially_copyable<T>::value ) {
+            // branchless: copies every value, advances by predicate
+            T * d = v.data();
+            for( size_t i = 0; i < n; ++i ) {
+                const bool pass = pred( d[i] );
+                d[k] = d[i];
+                idx[k] = idx[i];
+                k += pass;
+            }
+        } else {
+            for( size_t i = 0; i < n; ++i ) {
+                if( !pred( v[i] ) ) continue;
+                if( k != i ) v[k] = std::move(v[i]);
+                idx[k++] = idx[i];
+            }
+        }
+        v.erase( v.begin() + k, v.end() );
+        _index.resize( k );
+        return k;
+    }
+    /// \brief Returns spare column of `size()` values of type `T`.
+    /// \details Has to be followed by `flip()`.
+    template<typename T> T * output() {
+        std::vector<T> & v = _column<T>( 1 - _cur );
+        v.resize( _index.size() );
+        return v.data();
+    }
+    /// Makes spare column current one.
+    void flip() { _cur = 1 - _cur; }
+};
+
+/// \brief Batch kernel of the function handler `F`.
+/// \details Default implementation adapts scalar handler calling it in
+/// the loop over the batch. The loop has no branches (cuts are evaluated
+/// and applied in single branchless compaction pass), so for simple inlined
+/// transforms compiler vectorizes it. May be specialized
+/// to provide hand-written kernel; arguments depend on the handler kind:
+///
+/// - cut: `apply( config::Span<T> values, uint8_t * pass )`, where
+///   `pass[i]` has to be set to 0 or 1;
+/// - transform: `apply( config::Span<T> values )`;
+/// - map: `apply( config::Span<T> values, U * out )`, where `out` is
+///   preallocated for `values.size()` elements.
+///
+/// Stateful handlers may provide the kernel as `call_batch()` method with
+/// the same arguments.
+template<auto F>
+struct BatchKernel {
+    typedef meta::StageTraits<decltype(F)> Traits;
+    /// Marks default (adapted scalar) kernel
+    typedef void Adapted;
+
+    template<typename... OutT> static void
+    apply( config::Span<typename Traits::Input> values, OutT *... out );
+};
+
+namespace aux {
+
+/// Calls handler `h` for each of the values, writing results to `out`.
+template<typename TraitsT, typename HandlerT, typename... OutT> inline void
+batch_loop( HandlerT && h, config::Span<typename TraitsT::Input> values, OutT *... out ) {
+    typename TraitsT::Input * d = values.data();
+    const size_t n = values.size();
+    if constexpr( kTransform == TraitsT::kind ) {
+        for( size_t i = 0; i < n; ++i ) h(d[i]);
+    } else {
+        auto * o = (out, ...);
+        typedef typename std::remove_pointer<decltype(o)>::type OutT_;
+        if constexpr( std::is_trivially_copyable<OutT_>::value ) {
+            for( size_t i = 0; i < n; ++i ) o[i] = h(d[i]);
+        } else {
+            // re-constructed rather than assigned, so the value keeps its
+            // allocator (e.g. the event arena of `std::pmr` containers);
+            // the result is obtained first, so that the element is intact
+            // if handler throws
+            for( size_t i = 0; i < n; ++i ) {
+                if constexpr( std::is_nothrow_move_constructible<OutT_>::value ) {
+                    OutT_ r( h(d[i]) );
+                    o[i].~OutT_();
+                    new (o + i) OutT_( std::move(r) );
+                } else {
+                    o[i] = h(d[i]);
+                }
+            }
+        }
+    }
+}
+
+/// \brief Applies batch kernel `k` of the handler with given traits.
+/// \details Returns `false` if no values remain in the batch.
+template<typename TraitsT, typename KernelT> inline bool
+apply_batch_kernel( KernelT && k, Batch & b ) {
+    typedef typename TraitsT::Input In;
+    std::vector<In> & v = b.column<In>();
+    config::Span<In> values( v.data(), v.size() );
+    if constexpr( kCut == TraitsT::kind ) {
+        k( values, b.pass_mask() );
+        return b.select<In>();
+    } else if constexpr( kTransform == TraitsT::kind ) {
+        k( values );
+        return true;
+    } else {
+        k( values, b.output<typename TraitsT::Output>() );
+        b.flip();
+        return true;
+    }
+}
+
+/// Detects default batch kernel adapting scalar handler.
+template<typename KernelT, typename=void> struct IsAdapted : std::false_type {};
+template<typename KernelT>
+struct IsAdapted<KernelT, std::void_t<typename KernelT::Adapted> > : std::true_type {};
+
+/// Handler with given traits may be run in batch mode.
+template<typename TraitsT> constexpr bool
+batchable() {
+    return kGenerate != TraitsT::kind
+        && ( kMap != TraitsT::kind
+          || std::is_default_constructible<typename TraitsT::Output>::value );
+}
+
+}  // namespace ::dataflow::aux
+
+template<auto F> template<typename... OutT> void
+BatchKernel<F>::apply( config::Span<typename Traits::Input> values, OutT *... out ) {
+    aux::batch_loop<Traits>( F, values, out... );
+}
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_BATCH_H
@@ -0,0 +1,113 @@
+# ifndef H_DATAFLOW_PIPELINE_CUTS_H
+# define H_DATAFLOW_PIPELINE_CUTS_H
+
+# include "pipeline/pipeline.hpp"
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Group of commutative cuts reordered by measured selectivity.
+/// \details Cuts of the group are stateless handlers `bool f(const T &)`
+/// of the same input type, explicitly marked as commutative by being put in
+/// the group: their order does not change the result, only the cost. Group
+/// runs them as single pipeline stage, in the order minimizing expected
+/// cost per value,
+///
+///     c1 + (1 - r1)*c2 + (1 - r1)*(1 - r2)*c3 + ...,
+///
+/// that is, by ascending ratio of the cost `c` to the rejection rate `r`
+/// (optimal for independent cuts). Both are sampled at run time: each
+/// `sampling`-th value is passed to all the cuts, each timed, so the
+/// estimates are not biased by the current order. After `nSamples`
+/// samples the cuts are reordered and the statistics is halved, so the
+/// order follows the changes of the data.
+///
+/// Sampling is done in per-value mode; in batch mode cuts are applied in
+/// the current order. Used by ParallelPipeline, each worker gets its own
+/// copy of the group (kCloned); statistics of the copies is summed after
+/// processing and the original group is reordered. Cuts are identified by
+/// their names, unique within the group.
+///
+/// \code
+/// auto cuts = std::make_shared<CutGroup>();
+/// cuts->add<has_hits>( "has_hits" ).add( "trigger_ok" );  // function or registered
+/// p.append( CutGroup::stage( cuts, "cuts" ) );
+/// \endcode
+class CutGroup {
+public:
+    /// Cut of the group and its statistics
+    struct Cut {
+        std::string name;
+        Stage::Invoker invoke;
+        Stage::BatchInvoker invoke_batch;
+        double nSampled;  ///< Number of values sampled (decayed)
+        double nRejected;  ///< Number of sampled values rejected (decayed)
+        double nTicks;  ///< Time spent on sampled values (decayed)
+
+        /// Returns estimated rejection rate.
+        double rejection() const { return nSampled ? nRejected/nSampled : 0; }
+        /// Returns estimated cost per value, in time stamp counter ticks.
+        double cost() const { return nSampled ? nTicks/nSampled : 0; }
+    };
+private:
+    std::vector<Cut> _cuts;  ///< Cuts in order of application
+    PortType _input;  ///< Type of accepted value
+    unsigned _sampling;  ///< Each n-th value is sampled
+    unsigned _nSamples;  ///< Samples between reorderings
+    unsigned _countdown;  ///< Values before next sample
+    unsigned _nSampled;  ///< Samples since last reordering
+    size_t _nReorders;  ///< Number of reorderings changed the order
+
+    bool _sample( Slot & v );
+    void _reorder();
+    void _add( Cut c, const PortType & input );
+
+    static bool _invoke( void * h, Slot & v ) {
+        CutGroup & g = *static_cast<CutGroup *>(h);
+        if( --g._countdown ) {
+            for( const Cut & c : g._cuts ) if( !c.invoke( nullptr, v ) ) return false;
+            return true;
+        }
+        return g._sample( v );
+    }
+    static bool _invoke_batch( void * h, Batch & b );
+    static std::shared_ptr<void> _clone( const void * h );
+    static void _merge( void * h, const void * copy );
+    static void _merged( void * h );
+public:
+    /// Creates empty group sampling every `sampling`-th value and reordering
+    /// cuts after `nSamples` samples.
+    explicit CutGroup( unsigned sampling=32, unsigned nSamples=64 );
+
+    /// Adds cut function `F`.
+    template<auto F> CutGroup & add( const std::string & name ) {
+        typedef meta::StageTraits<decltype(F)> Traits;
+        static_assert( kCut == Traits::kind && !Traits::modifies
+                     , "Only cuts not modifying the value are commutative." );
+        typedef Fused<F> Chain;
+        _add( Cut{ name, &Chain::invoke, Chain::batch_invoker(), 0, 0, 0 }
+            , PortType::of<typename Traits::Input>() );
+        return *this;
+    }
+    /// \brief Adds stateless cut registered in HandlersIndex.
+    /// \details Throws IncompatibleHandlers if handler is not a stateless
+    /// cut not modifying its value, type of value mismatches or the group
+    /// already has cut of this name.
+    CutGroup & add( const std::string & name );
+
+    /// Returns pipeline stage running the group.
+    static Stage stage( std::shared_ptr<CutGroup> g, const std::string & name );
+
+    /// Returns cuts in the current order, with their statistics.
+    const std::vector<Cut> & cuts() const { return _cuts; }
+    /// Returns number of times the order was changed.
+    size_t n_reorders() const { return _nReorders; }
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_CUTS_H
@@ -0,0 +1,171 @@
+# ifndef H_DATAFLOW_PIPELINE_GENERATOR_H
+# define H_DATAFLOW_PIPELINE_GENERATOR_H
+
+# include <cstddef>
+
+# if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#   include <coroutine>
+#   include <exception>
+#   include <iterator>
+#   include <memory>
+#   include <type_traits>
+#   include <utility>
+#   define DATAFLOW_GENERATORS 1
+# endif
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Thread-local pool of the coroutine frames.
+/// \details Frames are rounded up to `kGranularity` bytes and kept, once
+/// freed, in per-thread free lists by size, so the generator created for
+/// each value being processed takes no heap allocation once the lists are
+/// filled (frames larger than `kMaxSize` are allocated from heap). Frame
+/// freed by other thread is kept by that thread.
+class FramePool {
+public:
+    /// Frame sizes are rounded up to multiple of this
+    static constexpr size_t kGranularity = 64;
+    /// Largest frame kept in the pool
+    static constexpr size_t kMaxSize = 4096;
+
+    /// Returns block of (at least) `n` bytes.
+    static void * allocate( size_t n );
+    /// Returns block of `n` bytes to the pool of calling thread.
+    static void deallocate( void * p, size_t n ) noexcept;
+    /// Returns number of blocks calling thread has allocated from heap.
+    static size_t n_allocated();
+};
+
+# ifdef DATAFLOW_GENERATORS
+
+/// \brief Coroutine yielding values of type `T` one by one.
+/// \details Function returning the generator is a handler of kGenerate
+/// kind: the pipeline runs next stages on each value it yields (by
+/// `co_yield`) before the coroutine is resumed to produce the next one, so
+/// downstream stages start on the early values and nothing is buffered.
+/// Value yielded as rvalue is passed to the pipeline by reference (and
+/// moved into the stage slot); value yielded as lvalue is copied.
+/// Exception thrown by the coroutine is rethrown to the caller.
+///
+/// Frames are allocated from FramePool. Arguments taken by reference have
+/// to outlive the iteration (as the value being processed does).
+///
+/// Generators are available if compiled as C++20 (`DATAFLOW_GENERATORS`
+/// is defined then).
+///
+/// \code
+/// Generator<Hit> unpack( const EventView & block ) {
+///     for( size_t i = 0; i + sizeof(Hit) <= block.size; i += sizeof(Hit) ) {
+///         Hit h;
+///         memcpy( &h, block.data + i, sizeof(Hit) );
+///         co_yield std::move(h);
+///     }
+/// }
+/// Pipeline p;
+/// p.append<unpack>( "unpack" ).append<cut_noise>( "cut_noise" );
+/// \endcode
+template<typename T>
+class Generator {
+    static_assert( !std::is_reference<T>::value, "Generator yields values, not references." );
+public:
+    typedef T Yielded;  ///< Type of yielded values
+    class promise_type;
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    /// Promise of the generator coroutine.
+    class promise_type {
+    private:
+        T * _value;  ///< Value yielded last
+        std::exception_ptr _error;  ///< Exception thrown by coroutine
+
+        /// Awaiter keeping copy of the value yielded as lvalue
+        struct Copy {
+            T value;
+            promise_type * promise;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend( std::coroutine_handle<> ) noexcept {
+                promise->_value = std::addressof(value);
+            }
+            void await_resume() const noexcept {}
+        };
+        friend class Generator;
+    public:
+        Generator get_return_object() { return Generator( Handle::from_promise(*this) ); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+        std::suspend_always yield_value( T && v ) noexcept {
+            _value = std::addressof(v);
+            return {};
+        }
+        Copy yield_value( const T & v ) { return Copy{ v, this }; }
+        void return_void() const noexcept {}
+        void unhandled_exception() { _error = std::current_exception(); }
+        /// Generators do not await.
+        template<typename U> std::suspend_never await_transform( U && ) = delete;
+
+        static void * operator new( size_t n ) { return FramePool::allocate( n ); }
+        static void operator delete( void * p, size_t n ) noexcept { FramePool::deallocate( p, n ); }
+    };
+
+    /// Input iterator over the yielded values.
+    class iterator {
+    private:
+        Handle _h;
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T * pointer;
+        typedef T & reference;
+
+        explicit iterator( Handle h=nullptr ) : _h(h) {}
+        /// Returns value yielded last.
+        T & operator*() const { return *_h.promise()._value; }
+        T * operator->() const { return _h.promise()._value; }
+        /// Resumes the coroutine producing next value.
+        iterator & operator++() {
+            _resume( _h );
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==( std::default_sentinel_t ) const { return _h.done(); }
+        bool operator!=( std::default_sentinel_t ) const { return !_h.done(); }
+    };
+private:
+    Handle _h;
+
+    explicit Generator( Handle h ) : _h(h) {}
+    static void _resume( Handle h ) {
+        h.resume();
+        if( h.promise()._error ) std::rethrow_exception( h.promise()._error );
+    }
+public:
+    Generator( Generator && o ) noexcept : _h( std::exchange( o._h, nullptr ) ) {}
+    Generator & operator=( Generator && o ) noexcept {
+        std::swap( _h, o._h );
+        return *this;
+    }
+    Generator( const Generator & ) = delete;
+    Generator & operator=( const Generator & ) = delete;
+    ~Generator() { if( _h ) _h.destroy(); }
+
+    /// Starts the coroutine, returns iterator at the first value (may be
+    /// called once).
+    iterator begin() {
+        _resume( _h );
+        return iterator( _h );
+    }
+    /// Returns end of the values.
+    std::default_sentinel_t end() const { return {}; }
+};
+
+# endif  // DATAFLOW_GENERATORS
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_GENERATOR_H
@@ -0,0 +1,255 @@
+# ifndef H_DATAFLOW_PIPELINE_GRAPH_H
+# define H_DATAFLOW_PIPELINE_GRAPH_H
+
+# include "pipeline/pipeline.hpp"
+# include "pipeline/pool.hpp"
+
+# include <map>
+# include <unordered_map>
+# include <utility>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Exception thrown when the graph can not be built.
+/// \details Raised on unknown or duplicated node names, cycles and values
+/// that can not be shared between the consumers.
+class BadGraph : public std::runtime_error {
+public:
+    BadGraph( const std::string & what ) : std::runtime_error(what) {}
+};
+
+namespace aux {
+
+/// Signature of the function joining several values (undefined for others).
+template<typename F> struct JoinSignature;
+
+template<typename R, typename... As>
+struct JoinSignature<R (*)(As...)> {
+    typedef typename std::decay<R>::type Output;
+    static constexpr size_t nInputs = sizeof...(As);
+    static_assert( nInputs > 0, "Join has to take values." );
+    static_assert( !std::is_void<R>::value && !std::is_same<R, bool>::value
+                 , "Join has to produce value." );
+    static_assert( ( ( !std::is_lvalue_reference<As>::value
+                    || std::is_const<typename std::remove_reference<As>::type>::value ) && ... )
+                 , "Join can not modify its inputs." );
+    /// Returns port types of the arguments.
+    static std::vector<PortType> inputs() {
+        return { PortType::of< typename std::decay<As>::type >()... };
+    }
+    /// Calls `F` with values kept in slots `in`, puts result into `out`.
+    template<auto F, size_t... Is> static void
+    call( Slot * const * in, Slot & out, std::index_sequence<Is...> ) {
+        out.emplace<Output>( F( in[Is]->get_unchecked< typename std::decay<As>::type >()... ) );
+    }
+};
+
+template<typename R, typename... As>
+struct JoinSignature<R (*)(As...) noexcept> : JoinSignature<R (*)(As...)> {};
+
+}  // namespace ::dataflow::aux
+
+/// \brief Invoker of the function `F` joining several values into one.
+/// \details Function takes values of the producing nodes (by value or
+/// constant reference) and returns the new value.
+template<auto F>
+struct JoinInvoker {
+    typedef aux::JoinSignature<decltype(F)> Signature;
+    typedef typename Signature::Output Output;  ///< Type of produced value
+
+    /// Invoker function for use as a node of the Graph.
+    static bool invoke( Slot * const * in, Slot & out ) {
+        Signature::template call<F>( in, out, std::make_index_sequence<Signature::nInputs>() );
+        return true;
+    }
+};
+
+/// \brief Directed acyclic graph of handlers.
+/// \details Nodes of the graph are named; each node runs a stage (see
+/// Stage) over the value produced by other node or fed into the graph
+/// (node `kInput`), or joins the values of several nodes (see
+/// JoinInvoker). Ports are connected by name and checked by type when the
+/// graph is compiled; adapter is inserted between mismatching ports if
+/// HandlersIndex provides one.
+///
+/// Compiled graph is a topologically ordered schedule. Each value is
+/// computed once per event and shared by all its consumers: handlers not
+/// modifying their input read it in place, modifying handlers run in place
+/// if they are the only consumer, or get a copy otherwise. Cut failed in
+/// some node skips only the nodes depending on it. Values of leaf nodes
+/// and nodes marked with `output()` are available after the event is
+/// processed.
+///
+/// Given the number of workers, graph runs independent nodes (of the same
+/// depth) concurrently on WorkStealingPool; nodes sharing a stateful
+/// handler instance are not run concurrently. Each node has its own event
+/// Arena.
+///
+/// \code
+/// Graph g;
+/// g.add( "hits", Graph::kInput, "decode" )
+///  .add<reco_calo>( "calo", "hits" )
+///  .add<reco_tracks>( "tracks", "hits" )
+///  .join<match>( "matched", {"calo", "tracks"} );
+/// if( (g << raw).succeed() ) std::cout << g.get<Match>( "matched" ) << std::endl;
+/// \endcode
+class Graph {
+public:
+    /// Join invoker function type
+    typedef bool (*Joiner)( Slot * const * in, Slot & out );
+    /// Name of the node representing the value fed into the graph
+    static const std::string kInput;
+private:
+    /// How the node obtains its input
+    enum Mode {
+        kSource,  ///< Value fed into the graph
+        kInplace,  ///< Runs in place on the slot of the only producer
+        kRead,  ///< Reads shared value, result (if any) in own slot
+        kCopy,  ///< Runs on own copy of the shared value
+        kJoin,  ///< Joins values of several nodes
+    };
+    struct Node {
+        std::string name;
+        Stage stage;  ///< Stage (not set for source and joins)
+        Joiner join;  ///< Join invoker (joins only)
+        std::vector<std::string> from;  ///< Names of producers
+        std::vector<PortType> inputs;  ///< Types of accepted values
+        PortType output;  ///< Type of produced value
+        std::vector<Node *> producers;  ///< Resolved producers
+        std::vector<Slot *> args;  ///< Values of producers (joins only)
+        size_t nConsumers;
+        bool marked;  ///< Marked as output by user
+        bool exported;  ///< Value is available after processing
+        bool exclusive;  ///< Slot of the value is not shared with others
+        Mode mode;
+        unsigned depth;  ///< Length of the longest path from source
+        Arena arena;  ///< Memory of the event
+        Slot own;  ///< Value produced by the node
+        Slot * value;  ///< Result of current event, `nullptr` if not produced
+
+        Node( const std::string & name_, const Stage & s, const PortType & out )
+            : name(name_), stage(s), join(nullptr), output(out), nConsumers(0)
+            , marked(false), exported(false), exclusive(true), mode(kSource), depth(0)
+            , own(&arena), value(nullptr) {}
+        /// Constructs node of no stage (source or join).
+        Node( const std::string & name_, const PortType & out )
+            : Node( name_, Stage{ nullptr, nullptr, nullptr, nullptr, out, out, name_ }, out ) {}
+    };
+    /// Nodes of the same depth
+    struct Level {
+        size_t begin, end;  ///< Range in the schedule
+        bool serial;  ///< Nodes share stateful handler
+    };
+
+    std::vector< std::unique_ptr<Node> > _nodes;  ///< Source, added nodes, adapters
+    size_t _nAdded;  ///< Number of source and added nodes
+    std::unordered_map<std::string, size_t> _index;  ///< Nodes by name
+    std::vector<Node *> _schedule;  ///< Nodes in topological order
+    std::vector<Level> _levels;
+    std::vector<Node *> _outputs;
+    std::unique_ptr<WorkStealingPool> _pool;
+    bool _compiled;
+
+    Graph & _add( std::unique_ptr<Node> n );
+    Node & _node( const std::string & name ) const;
+    Node * _connect( Node & producer, const PortType & type, const Node & consumer
+                   , std::map<std::pair<Node *, TypeId>, Node *> & adapters );
+    void _sort();
+    void _begin();
+    void _execute( Node & n );
+    void _run();
+    [[noreturn]] void _throw_bad_input( const PortType & t ) const;
+public:
+    /// \brief Creates empty graph.
+    /// \details With `nWorkers` greater than one, independent nodes are run
+    /// concurrently (zero means number of hardware threads).
+    explicit Graph( unsigned nWorkers=1 );
+    Graph( const Graph & ) = delete;
+    Graph & operator=( const Graph & ) = delete;
+
+    /// \brief Adds node running the stage over the value of node `from`.
+    /// \details Throws BadGraph if node name is taken or stage is a
+    /// generator (not supported by graph).
+    Graph & add( const std::string & name, const std::string & from, Stage s );
+    /// Adds node running handler registered in HandlersIndex.
+    Graph & add( const std::string & name, const std::string & from, const std::string & handler );
+    /// Adds node running function handlers as single fused stage.
+    template<auto F, auto... Fs> Graph & add( const std::string & name
+                                            , const std::string & from ) {
+        return add( name, from, Fused<F, Fs...>::stage( name ) );
+    }
+    /// Adds node running stateful handler instance (having `call()` method).
+    template<typename C> Graph & add( const std::string & name, const std::string & from
+                                    , std::shared_ptr<C> h ) {
+        return add( name, from, MethodInvoker<C>::stage( std::move(h), name ) );
+    }
+    /// Adds node joining values of nodes `from` with function `F`.
+    template<auto F> Graph & join( const std::string & name
+                                 , const std::vector<std::string> & from ) {
+        typedef JoinInvoker<F> Invoker;
+        if( from.size() != Invoker::Signature::nInputs ) {
+            throw BadGraph( "Join \"" + name + "\" takes "
+                          + std::to_string( Invoker::Signature::nInputs ) + " values, "
+                          + std::to_string( from.size() ) + " nodes given." );
+        }
+        std::unique_ptr<Node> n( new Node( name, PortType::of<typename Invoker::Output>() ) );
+        n->join = &Invoker::invoke;
+        n->from = from;
+        n->inputs = Invoker::Signature::inputs();
+        n->mode = kJoin;
+        return _add( std::move(n) );
+    }
+    /// Makes value of intermediate node available after processing.
+    Graph & output( const std::string & name );
+
+    /// \brief Resolves connections and builds the schedule.
+    /// \details Called on the first value fed after graph was modified.
+    /// Throws BadGraph or IncompatibleHandlers.
+    void compile();
+
+    /// \brief Feeds the value into graph.
+    /// \details Throws IncompatibleHandlers if type of the value is not
+    /// accepted by the nodes reading the input.
+    template<typename T> Graph & operator<<( T && v ) {
+        typedef typename std::decay<T>::type ValueT;
+        if( !_compiled ) compile();
+        Node & source = *_nodes.front();
+        if( type_id<ValueT>() != source.output.id ) _throw_bad_input( PortType::of<ValueT>() );
+        _begin();
+        source.own.emplace<ValueT>( std::forward<T>(v) );
+        source.value = &source.own;
+        _run();
+        return *this;
+    }
+
+    /// Returns `true` if all the outputs were produced for the last value.
+    bool succeed() const {
+        for( const Node * n : _outputs ) if( !n->value ) return false;
+        return true;
+    }
+    /// Returns `true` if node produced value for the last event.
+    bool succeed( const std::string & name ) const { return _node( name ).value; }
+    /// \brief Returns value of the output node.
+    /// \details Throws BadGraph if node is unknown or not an output,
+    /// BadSlotAccess if value was not produced or type mismatches.
+    template<typename T> T & get( const std::string & name ) {
+        Node & n = _node( name );
+        if( !n.exported ) throw BadGraph( "Node \"" + name + "\" is not an output." );
+        if( !n.value ) throw BadSlotAccess();
+        return n.value->get<T>();
+    }
+
+    /// Returns number of nodes (adapters inserted by compilation included).
+    size_t size() const { return _nodes.size() - 1; }
+    /// Returns number of nodes run concurrently at most (after compilation).
+    size_t width() const;
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_GRAPH_H
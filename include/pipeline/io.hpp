@@ -0,0 +1,260 @@
+# ifndef H_DATAFLOW_PIPELINE_IO_H
+# define H_DATAFLOW_PIPELINE_IO_H
+
+# include "pipeline/pipeline.hpp"
+# include "pipeline/ring.hpp"
+# include "util/mmap.hpp"
+
+# include <cstring>
+# include <exception>
+# include <thread>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Exception thrown on malformed or truncated record.
+class BadRecord : public std::runtime_error {
+public:
+    BadRecord( const std::string & what ) : std::runtime_error(what) {}
+};
+
+/// \brief View of the binary event record.
+/// \details Points to the data kept by the source (file mapping or read
+/// buffer), so the record is not copied; the view is valid until the next
+/// record is taken from the source.
+struct EventView {
+    const char * data;  ///< Record content
+    size_t size;  ///< Size of the record, bytes
+    uint64_t number;  ///< Number of the record in the source
+};
+
+/// \brief Source of binary event records.
+/// \details Records are of fixed size, or (if size is zero) of variable
+/// size given by 4-byte prefix (native byte order).
+class EventSource {
+protected:
+    const size_t _recordSize;  ///< Size of the record, zero for variable
+    uint64_t _nRecords;  ///< Records taken
+
+    /// \brief Finds record at `p`, not exceeding `end`.
+    /// \details Returns size of the record with prefix, or zero if record
+    /// is not complete; sets view to its content.
+    size_t _frame( const char * p, const char * end, EventView & v ) const {
+        size_t n = _recordSize, prefix = 0;
+        if( !n ) {
+            if( end - p < 4 ) return 0;
+            uint32_t len;
+            memcpy( &len, p, 4 );
+            n = len;
+            prefix = 4;
+        }
+        if( size_t(end - p) < prefix + n ) return 0;
+        v.data = p + prefix;
+        v.size = n;
+        v.number = _nRecords;
+        return prefix + n;
+    }
+public:
+    explicit EventSource( size_t recordSize ) : _recordSize(recordSize), _nRecords(0) {}
+    virtual ~EventSource() {}
+
+    /// \brief Takes next record.
+    /// \details Returns `false` at the end of input; throws BadRecord if
+    /// the input ends with incomplete record (once the complete records
+    /// preceding it are taken).
+    virtual bool next( EventView & v ) = 0;
+    /// Returns number of records taken.
+    uint64_t n_records() const { return _nRecords; }
+};
+
+/// \brief Source reading records from memory-mapped file.
+/// \details Views point directly into the mapping. The kernel is hinted
+/// to read the file sequentially and, if `prefetch` is non-zero, to read
+/// ahead the window of `prefetch` bytes beyond the current record, so the
+/// page faults do not stall the handlers.
+class MappedSource : public EventSource {
+private:
+    util::MappedFile _file;
+    const size_t _prefetch;  ///< Size of the read-ahead window
+    size_t _pos;  ///< Offset of the next record
+    size_t _prefetched;  ///< End of the range requested from the kernel
+
+    void _advise();
+public:
+    explicit MappedSource( const std::string & path, size_t recordSize=0
+                         , size_t prefetch=8 << 20 );
+
+    bool next( EventView & v ) override {
+        if( _prefetch && _pos + _prefetch/2 > _prefetched ) _advise();
+        const size_t n = _frame( _file.data() + _pos, _file.data() + _file.size(), v );
+        if( !n ) {
+            if( _pos != _file.size() ) throw BadRecord( "File ends with incomplete record." );
+            return false;
+        }
+        _pos += n;
+        ++_nRecords;
+        return true;
+    }
+};
+
+/// \brief Source reading records with `read()` into rotating buffers.
+/// \details With `nBuffers` greater than one, buffers are filled by the
+/// background thread (double, triple buffering) while the handlers process
+/// the records of the current buffer; with single buffer it is filled by
+/// the calling thread when exhausted. Buffers keep whole records only
+/// (record crossing the end of buffer is moved to the next one, buffer
+/// grows to fit record larger than it).
+class StreamSource : public EventSource {
+private:
+    struct Buffer {
+        std::vector<char> data;
+        size_t size;  ///< Bytes of whole records
+        bool last;  ///< End of input
+        bool truncated;  ///< Input ends with incomplete record after `size` bytes
+    };
+
+    int _fd;
+    std::vector< std::unique_ptr<Buffer> > _buffers;
+    SpscRing<Buffer *> _free, _full;
+    std::thread _thread;
+    std::atomic<bool> _stop;
+    std::exception_ptr _error;  ///< Error of the reading thread
+    std::vector<char> _carry;  ///< Incomplete record of the last buffer
+    bool _eof;
+    Buffer * _cur;  ///< Buffer records are taken from
+    size_t _pos;  ///< Offset of the next record in current buffer
+    size_t _nStalls;  ///< Times records were not read in time
+
+    void _fill( Buffer & b );
+    void _read();
+    bool _advance();
+    bool _end() const;
+public:
+    explicit StreamSource( const std::string & path, size_t recordSize=0
+                         , unsigned nBuffers=3, size_t bufferSize=4 << 20 );
+    ~StreamSource();
+
+    bool next( EventView & v ) override {
+        for(;;) {
+            if( _cur ) {
+                const size_t n = _frame( _cur->data.data() + _pos
+                                       , _cur->data.data() + _cur->size, v );
+                if( n ) {
+                    _pos += n;
+                    ++_nRecords;
+                    return true;
+                }
+            }
+            if( !_advance() ) return false;
+        }
+    }
+    /// Returns number of times the handlers waited for the data.
+    size_t n_stalls() const { return _nStalls; }
+};
+
+/// \brief Sink writing records to the file in batches.
+/// \details Records are gathered in the buffer; full buffer is written by
+/// the background thread while the next one is being filled (with single
+/// buffer it is written by the calling thread). Records are framed as
+/// for EventSource. Errors of writing are rethrown by the following
+/// `write()`, `flush()` or `close()`.
+///
+/// \code
+/// auto sink = std::make_shared<AsyncSink>( "out.dat" );
+/// p.append( AsyncSink::stage<Track>( sink, "write" ) );  // or sink->write()
+/// \endcode
+class AsyncSink {
+private:
+    struct Buffer {
+        std::vector<char> data;
+        size_t size;
+    };
+
+    int _fd;
+    const size_t _recordSize;
+    std::vector< std::unique_ptr<Buffer> > _buffers;
+    SpscRing<Buffer *> _free, _full;
+    std::thread _thread;
+    std::exception_ptr _error;  ///< Error of the writing thread
+    std::atomic<size_t> _nWritten;  ///< Buffers written
+    size_t _nSubmitted;  ///< Buffers submitted for writing
+    Buffer * _cur;  ///< Buffer being filled
+
+    void _write( Buffer & b );
+    void _writer();
+    void _submit();
+    void _check_error();
+public:
+    /// Creates (truncates) file; `recordSize` of zero means variable size.
+    explicit AsyncSink( const std::string & path, size_t recordSize=0
+                      , unsigned nBuffers=2, size_t bufferSize=1 << 20 );
+    AsyncSink( const AsyncSink & ) = delete;
+    AsyncSink & operator=( const AsyncSink & ) = delete;
+    ~AsyncSink();
+
+    /// Appends record; throws BadRecord if size differs from fixed one.
+    void write( const void * data, size_t n ) {
+        if( _recordSize && n != _recordSize ) {
+            throw BadRecord( "Record of " + std::to_string(n) + " bytes, "
+                           + std::to_string(_recordSize) + " expected." );
+        }
+        const size_t total = n + (_recordSize ? 0 : 4);
+        if( _cur->size + total > _cur->data.size() ) {
+            if( _cur->size ) _submit();
+            if( total > _cur->data.size() ) _cur->data.resize( total );
+        }
+        char * p = _cur->data.data() + _cur->size;
+        if( !_recordSize ) {
+            const uint32_t len = uint32_t(n);
+            memcpy( p, &len, 4 );
+            p += 4;
+        }
+        if( n ) memcpy( p, data, n );
+        _cur->size += total;
+    }
+    /// Waits until all the records are written.
+    void flush();
+    /// Flushes and closes the file.
+    void close();
+
+    /// \brief Returns pipeline stage writing values of type `T`.
+    /// \details Value is passed further unchanged. Type has to be
+    /// trivially copyable (written as is) or EventView (its content is
+    /// written).
+    template<typename T> static Stage stage( std::shared_ptr<AsyncSink> s
+                                           , const std::string & name );
+};
+
+namespace aux {
+/// Handler writing the values to AsyncSink
+template<typename T>
+struct SinkWriter {
+    static_assert( std::is_trivially_copyable<T>::value || std::is_same<T, EventView>::value
+                 , "Only trivially copyable values may be written." );
+    std::shared_ptr<AsyncSink> sink;
+    void call( const T & v ) {
+        if constexpr( std::is_same<T, EventView>::value ) sink->write( v.data, v.size );
+        else sink->write( &v, sizeof(T) );
+    }
+};
+}  // namespace ::dataflow::aux
+
+template<typename T> Stage
+AsyncSink::stage( std::shared_ptr<AsyncSink> s, const std::string & name ) {
+    auto w = std::make_shared< aux::SinkWriter<T> >();
+    w->sink = std::move(s);
+    return MethodInvoker< aux::SinkWriter<T> >::stage( std::move(w), name );
+}
+
+/// \brief Feeds all the records of the source into the pipeline.
+/// \details Pipeline has to accept EventView. Returns number of records
+/// passed all the stages.
+size_t drain( EventSource & src, Pipeline & p );
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_IO_H
@@ -0,0 +1,49 @@
+# ifndef H_DATAFLOW_PIPELINE_NUMA_H
+# define H_DATAFLOW_PIPELINE_NUMA_H
+
+# include <string>
+# include <vector>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief NUMA node: CPUs sharing the memory controller.
+/// \details Memory touched first by the thread running on the node's CPU
+/// is allocated on that node (default Linux policy), so the state created
+/// by the thread pinned to the node is local to it.
+struct NumaNode {
+    unsigned id;  ///< Number of the node
+    std::vector<unsigned> cpus;  ///< CPUs of the node the process may use
+};
+
+namespace aux {
+/// Parses the list of CPUs as given by sysfs (e.g. "0-3,8,10-11").
+std::vector<unsigned> parse_cpu_list( const std::string & list );
+}  // namespace ::dataflow::aux
+
+/// Returns CPUs the calling thread may run on.
+std::vector<unsigned> allowed_cpus();
+
+/// \brief Returns NUMA nodes having CPUs of `allowed` ones.
+/// \details Topology is read from sysfs directory `sysfs` (entries
+/// `node<N>/cpulist`). If it is not available (e.g. kernel without NUMA
+/// support), all the allowed CPUs are returned as single node.
+std::vector<NumaNode> numa_nodes( const std::string & sysfs
+                                , const std::vector<unsigned> & allowed );
+/// Returns NUMA nodes of the machine having CPUs the process may run on.
+inline std::vector<NumaNode> numa_nodes() {
+    return numa_nodes( "/sys/devices/system/node", allowed_cpus() );
+}
+
+/// \brief Pins calling thread to the CPUs.
+/// \details Returns `false` (leaving thread as it was) if none of the CPUs
+/// may be used.
+bool pin_thread( const std::vector<unsigned> & cpus );
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_NUMA_H
@@ -0,0 +1,149 @@
+# ifndef H_DATAFLOW_PIPELINE_PARALLEL_H
+# define H_DATAFLOW_PIPELINE_PARALLEL_H
+
+# include "pipeline/pipeline.hpp"
+# include "pipeline/pool.hpp"
+
+# include <atomic>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Pipeline processing independent values concurrently.
+/// \details Built from the Pipeline, runs its stages on the workers of
+/// WorkStealingPool, each worker processing its own values (events) with
+/// its own copy of the stage list. How the stateful handler is shared
+/// between the workers is defined by its ConcurrencyPolicy:
+///
+/// - kReentrant (and stateless function handlers): the same instance is
+///   called concurrently, at no additional cost;
+/// - kSerialized: the same instance is called under the lock;
+/// - kCloned: each worker gets its own copy of the handler; at the end of
+///   `process()` the copies are merged into the original instance
+///   pairwise, by `log2(workers)` levels of merges run concurrently (see
+///   also accumulators, e.g. Histogram1D); afterwards `Stage::merged`, if
+///   set, is called once on the original instance.
+///
+/// Values are processed in arbitrary order. Each worker has its own event
+/// Arena.
+///
+/// Placed on NUMA nodes, the pipeline runs pinned workers of each node on
+/// contiguous part of the input; per-worker state (arena, stage list and
+/// copies of cloned handlers) is allocated by the worker itself, so it
+/// resides in the memory of its node.
+///
+/// \code
+/// ParallelPipeline pp( p );  // p is Pipeline
+/// std::vector<float> energies( n );
+/// pp.process( amplitudes, n, [&]( size_t i, Slot & r ) {
+///         energies[i] = r.get<float>();
+///     } );
+/// \endcode
+class ParallelPipeline {
+private:
+    /// Stage called under lock
+    struct Serialized {
+        std::mutex * m;
+        Stage::Invoker invoke;
+        void * handler;
+    };
+    /// Per-worker state
+    struct alignas(64) Lane {
+        std::vector<Stage> stages;  ///< Stages used by worker
+        std::vector<Serialized> serialized;  ///< Serialized stages wrappers
+        std::vector< std::shared_ptr<void> > clones;  ///< Per-worker copies
+        Arena arena;  ///< Memory of the event being processed
+        Slot value;  ///< Value being processed
+        size_t nPassed;  ///< Number of values passed all the stages
+
+        Lane() : value(&arena), nPassed(0) {}
+    };
+
+    WorkStealingPool _pool;
+    const std::vector<Stage> _stages;
+    std::vector< std::unique_ptr<std::mutex> > _mutexes;
+    std::vector< std::unique_ptr<Lane> > _lanes;
+    size_t _grain;
+
+    /// Creates per-worker lanes.
+    void _init();
+    static bool _invoke_serialized( void * h, Slot & v );
+    /// Creates per-worker copies of cloned handlers.
+    void _prepare();
+    /// Merges per-worker copies, returns number of values passed.
+    size_t _finish();
+    [[noreturn]] void _throw_bad_input( const PortType & t ) const;
+public:
+    /// \brief Builds parallel counterpart of the pipeline.
+    /// \details Handler instances are shared with the original pipeline.
+    /// `nWorkers` of zero means number of hardware threads; `grain` is the
+    /// number of values taken by worker at once. Throws
+    /// IncompatibleHandlers if pipeline has generator stages.
+    explicit ParallelPipeline( const Pipeline & p, unsigned nWorkers=0, size_t grain=256 );
+    /// \brief Builds parallel counterpart of the pipeline running on NUMA nodes.
+    /// \details Runs `workersPerNode` pinned workers on each node (zero
+    /// means one per CPU), see WorkStealingPool.
+    ParallelPipeline( const Pipeline & p, const std::vector<NumaNode> & nodes
+                    , unsigned workersPerNode=0, size_t grain=256 );
+
+    /// Returns number of NUMA nodes the workers run on.
+    unsigned nodes() const { return _pool.n_nodes(); }
+
+    /// Returns number of workers.
+    unsigned workers() const { return _pool.size(); }
+
+    /// \brief Processes `n` values concurrently.
+    /// \details For each value passed all the stages `sink( i, result )` is
+    /// called from the worker thread (`i` is the position of the value in
+    /// the input). Returns the number of values passed.
+    template<typename T, typename SinkT> size_t
+    process( const T * data, size_t n, SinkT && sink ) {
+        if( !_stages.empty() && type_id<T>() != _stages.front().input.id ) {
+            _throw_bad_input( PortType::of<T>() );
+        }
+        _prepare();
+        try {
+            _pool.run( n, _grain, [&]( unsigned w, size_t b, size_t e ) {
+                    Lane & l = *_lanes[w];
+                    aux::EventArenaScope scope( &l.arena );
+                    aux::ProfileTable * prof = aux::profile_table();
+                    size_t nPassed = 0;
+                    for( size_t i = b; i < e; ++i ) {
+                        if( l.arena.used() ) {
+                            l.value.reset();
+                            l.arena.reset();
+                        }
+                        l.value.emplace<T>( data[i] );
+                        bool passed = true;
+                        for( const Stage & s : l.stages ) {
+                            if( aux::profiled( prof, s.probe, [&]() {
+                                        return s.invoke( s.handler, l.value );
+                                    } ) ) continue;
+                            passed = false;
+                            break;
+                        }
+                        if( !passed ) continue;
+                        sink( i, l.value );
+                        ++nPassed;
+                    }
+                    l.nPassed += nPassed;
+                } );
+        } catch( ... ) {
+            _finish();
+            throw;
+        }
+        return _finish();
+    }
+    /// Processes `n` values concurrently, returns the number of values passed.
+    template<typename T> size_t process( const T * data, size_t n ) {
+        return process( data, n, []( size_t, Slot & ) {} );
+    }
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_PARALLEL_H
@@ -0,0 +1,234 @@
+# ifndef H_DATAFLOW_PIPELINE_PIPELINE_H
+# define H_DATAFLOW_PIPELINE_PIPELINE_H
+
+# include "handlers/index.hpp"
+# include "pipeline/arena.hpp"
+# include "pipeline/profile.hpp"
+
+# include <initializer_list>
+# include <stdexcept>
+# include <vector>
+
+/*!\defgroup Pipeline
+ * \brief Pipeline engine module.
+ *
+ * Chains handlers into sequences processing the values fed into the
+ * pipeline one by one. Chains known at compile time are fused into inlined
+ * call sequence (Fused, StaticPipeline); chains built at run time are kept
+ * as sequence of type-erased stages (Pipeline).
+ * */
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Exception thrown when handlers can not be chained.
+/// \details Raised when the pipeline is being built: output type of the
+/// handler does not match input type of the next one.
+class IncompatibleHandlers : public std::runtime_error {
+public:
+    /// Constructs exception describing mismatching stages.
+    IncompatibleHandlers( const Stage & prev, const Stage & next );
+    /// Constructs exception with message.
+    IncompatibleHandlers( const std::string & what ) : std::runtime_error(what) {}
+};
+
+/// \brief Pipeline built at run time.
+/// \details Keeps the sequence of type-erased stages (see Stage). Types of
+/// the adjacent stages are checked once, when the stage is appended, so
+/// the per-event processing is a loop of indirect calls with neither type
+/// checks nor heap allocations (values are passed in Slot). Chain segments
+/// known at compile time may be appended as single fused stage.
+///
+/// Memory allocated by handlers from `event_arena()` (see Arena), and
+/// values too large for the Slot buffer are kept until the next value is
+/// fed (or next batch is processed).
+///
+/// Handlers registered in HandlersIndex may be appended by name. Then the
+/// adapter stage is inserted between handlers of mismatching types, if
+/// index provides one (e.g. for `float` to `double` conversion).
+///
+/// Generator stage (see Generator) runs the rest of the stages on each
+/// value it yields, before the next one is produced, so no values are
+/// buffered in between. Value fed then succeeds if some of the yielded
+/// values passed all the stages; `get()` returns the last one processed.
+///
+/// \code
+/// bool cut( double & x ) { return x > 0; }
+/// DATAFLOW_REGISTER_HANDLER( "cut_negative", cut )
+///
+/// Pipeline p( "cut_negative" );  // or p.append<cut>( "cut_negative" )
+/// if( (p << 3.).succeed() ) std::cout << p.get<double>() << std::endl;
+/// \endcode
+class Pipeline {
+private:
+    /// Stages following the generator stage, run on the yielded value
+    struct Rest {
+        Pipeline * pipeline;
+        size_t first;
+    };
+
+    std::vector<Stage> _stages;  ///< Stages in order of invocation
+    Arena _arena;  ///< Memory of the event being processed
+    Slot _value;  ///< Value being processed
+    /// Values yielded by generator stages (`nullptr` for other stages)
+    std::vector< std::unique_ptr<Slot> > _yielded;
+    Slot * _result;  ///< Slot keeping the result of the processing
+    bool _succeed;  ///< Result of the last processing
+    Batch _batch;  ///< Values being processed in batch mode
+    bool _batchable;  ///< All the stages support batch mode
+
+    /// Runs the value through the stages starting from `first`.
+    bool _run( size_t first, Slot & value ) {
+        aux::ProfileTable * prof = aux::profile_table();
+        for( size_t i = first; i < _stages.size(); ++i ) {
+            const Stage & s = _stages[i];
+            if( s.expand ) return _expand( i, value );
+            if( !aux::profiled( prof, s.probe, [&]() { return s.invoke( s.handler, value ); } ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+    /// Runs generator stage `i`, and the rest of the stages on each value
+    /// it yields.
+    bool _expand( size_t i, Slot & value );
+    /// Continuation of the generator stage (see Rest).
+    static bool _continue( void * rest, Slot & value );
+    /// Throws IncompatibleHandlers if value of type `t` can not be fed.
+    [[noreturn]] void _throw_bad_input( const PortType & t ) const;
+    /// Throws IncompatibleHandlers naming stage not supporting batch mode.
+    [[noreturn]] void _throw_not_batchable() const;
+public:
+    Pipeline() : _value(&_arena), _result(&_value), _succeed(false), _batchable(true) {}
+    /// Builds pipeline of single registered handler.
+    explicit Pipeline( const std::string & name )
+            : _value(&_arena), _result(&_value), _succeed(false), _batchable(true) { append( name ); }
+    /// Builds pipeline of registered handlers.
+    Pipeline( std::initializer_list<std::string> names )
+            : _value(&_arena), _result(&_value), _succeed(false), _batchable(true) {
+        for( const std::string & name : names ) append( name );
+    }
+    Pipeline( const Pipeline & ) = delete;
+    Pipeline & operator=( const Pipeline & ) = delete;
+
+    /// \brief Appends stage, checking its input type.
+    /// \details Throws IncompatibleHandlers if stage does not accept
+    /// output of the last one.
+    Pipeline & append( Stage s );
+    /// \brief Appends handler registered in HandlersIndex.
+    /// \details Inserts adapter stage if handler does not accept output
+    /// of the last one and index provides the conversion. Throws
+    /// UnknownHandler or IncompatibleHandlers.
+    Pipeline & append( const std::string & name );
+    /// Appends registered handler (see `append(const std::string &)`).
+    Pipeline & append( const char * name ) { return append( std::string(name) ); }
+    /// \brief Appends function handlers as single fused stage.
+    /// \details Single handler may be given as well.
+    template<auto F, auto... Fs> Pipeline & append( const std::string & name="" ) {
+        return append( Fused<F, Fs...>::stage( name ) );
+    }
+    /// Appends stateful handler instance (having `call()` method).
+    template<typename C> Pipeline & append( std::shared_ptr<C> h
+                                          , const std::string & name="" ) {
+        return append( MethodInvoker<C>::stage( std::move(h), name ) );
+    }
+
+    /// \brief Feeds the value into pipeline.
+    /// \details Throws IncompatibleHandlers if type of the value is not
+    /// accepted by the first stage (single pointer compare).
+    template<typename T> Pipeline & operator<<( T && v ) {
+        typedef typename std::decay<T>::type ValueT;
+        if( !_stages.empty() && type_id<ValueT>() != _stages.front().input.id ) {
+            _throw_bad_input( PortType::of<ValueT>() );
+        }
+        if( _arena.used() ) {
+            // previous event leaves the pipeline
+            _value.reset();
+            for( auto & y : _yielded ) if( y ) y->reset();
+            _arena.reset();
+        }
+        _value.emplace<ValueT>( std::forward<T>(v) );
+        aux::EventArenaScope scope( &_arena );
+        _succeed = _run( 0, _value );
+        return *this;
+    }
+    /// Returns `true` if last value passed all the stages.
+    bool succeed() const { return _succeed; }
+    /// Returns result of the processing; throws BadSlotAccess on type mismatch.
+    template<typename T> T & get() { return _result->get<T>(); }
+
+    /// \brief Feeds `n` values into pipeline in batch mode.
+    /// \details Values are pushed through each stage as a whole (see
+    /// Batch). Returned batch keeps values passed all the stages and their
+    /// positions in the input; if it is empty, type of its values is
+    /// undefined. Throws IncompatibleHandlers if type of the values is not
+    /// accepted or some stage does not support batch mode.
+    template<typename T> const Batch & process( const T * data, size_t n ) {
+        if( !_stages.empty() && type_id<T>() != _stages.front().input.id ) {
+            _throw_bad_input( PortType::of<T>() );
+        }
+        if( !_batchable ) _throw_not_batchable();
+        // previous batch leaves the pipeline
+        _batch.clear();
+        _arena.reset();
+        _batch.assign( data, n );
+        aux::EventArenaScope scope( &_arena );
+        aux::ProfileTable * prof = aux::profile_table();
+        for( const Stage & s : _stages ) {
+            if( _batch.empty() ) break;
+            if( !aux::profiled_batch( prof, s.probe, _batch, [&]() {
+                        return s.invoke_batch( s.handler, _batch );
+                    } ) ) break;
+        }
+        return _batch;
+    }
+    /// Feeds values into pipeline in batch mode.
+    template<typename T> const Batch & process( config::Span<const T> values ) {
+        return process( values.data(), values.size() );
+    }
+
+    /// Returns arena of the event being processed (or processed last).
+    const Arena & arena() const { return _arena; }
+    /// Returns stages of the pipeline.
+    const std::vector<Stage> & stages() const { return _stages; }
+    /// Returns number of stages.
+    size_t size() const { return _stages.size(); }
+};
+
+/// \brief Pipeline fused entirely at compile time.
+/// \details Offers the same API as Pipeline for the chain of function
+/// handlers known at compile time (see Fused).
+///
+/// \code
+/// StaticPipeline<cut, twice> p;
+/// if( (p << 3.).succeed() ) std::cout << p.get() << std::endl;
+/// \endcode
+template<auto... Fs>
+class StaticPipeline {
+public:
+    typedef Fused<Fs...> Chain;  ///< Fused chain of handlers
+    typedef typename Chain::Input Input;  ///< Type of accepted value
+    typedef typename Chain::Output Output;  ///< Type of produced value
+private:
+    Output _result;
+    bool _succeed;
+public:
+    StaticPipeline() : _result(), _succeed(false) {}
+    /// Feeds the value into pipeline.
+    StaticPipeline & operator<<( Input v ) {
+        _succeed = Chain::run( v, [this]( Output & o ) { _result = std::move(o); } );
+        return *this;
+    }
+    /// Returns `true` if last value passed all the stages.
+    bool succeed() const { return _succeed; }
+    /// Returns result of the processing.
+    const Output & get() const { return _result; }
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_PIPELINE_H
@@ -0,0 +1,101 @@
+# ifndef H_DATAFLOW_PIPELINE_POOL_H
+# define H_DATAFLOW_PIPELINE_POOL_H
+
+# include "pipeline/numa.hpp"
+
+# include <condition_variable>
+# include <cstddef>
+# include <cstdint>
+# include <exception>
+# include <functional>
+# include <memory>
+# include <mutex>
+# include <thread>
+# include <vector>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Pool of worker threads processing index ranges with work stealing.
+/// \details `run()` splits the range `[0, n)` evenly between the workers.
+/// Each worker takes chunks of `grain` indices from the front of its own
+/// range; worker exhausted its range steals the upper half of the largest
+/// remaining range of the others. Ranges are protected by per-worker locks
+/// taken once per chunk, so for sufficiently large grain the workers do not
+/// contend. The thread calling `run()` acts as worker 0.
+///
+/// Pool placed on NUMA nodes runs all the workers on its threads, each
+/// pinned to single CPU of its node; workers are numbered node by node, so
+/// each node gets contiguous part of the range, and exhausted worker steals
+/// from the workers of its own node first.
+class WorkStealingPool {
+public:
+    /// Task processing indices `[begin, end)` on the worker `worker`
+    typedef std::function<void(unsigned worker, size_t begin, size_t end)> Task;
+private:
+    /// Range of indices remaining for the worker
+    struct alignas(64) Range {
+        std::mutex m;
+        size_t begin, end;
+    };
+
+    std::vector<std::thread> _threads;
+    std::unique_ptr<Range[]> _ranges;
+    const unsigned _nWorkers;
+    std::vector<unsigned> _nodes;  ///< Node of each worker (empty if not placed)
+    std::vector<unsigned> _cpus;  ///< CPU each worker is pinned to
+
+    std::mutex _m;
+    std::condition_variable _cvStart, _cvDone;
+    const Task * _task;  ///< Task being run
+    size_t _grain;  ///< Number of indices taken at once
+    uint64_t _generation;  ///< Number of the current `run()` call
+    unsigned _nBusy;  ///< Number of threads not finished current run
+    bool _each;  ///< Task is run once by each worker (see `run_each()`)
+    bool _stop;  ///< Pool is being destroyed
+    std::exception_ptr _error;  ///< First exception thrown by task
+
+    void _start();
+    void _thread( unsigned id );
+    void _run( const Task & task, bool each );
+    void _work( unsigned id );
+    bool _take( unsigned id, size_t & b, size_t & e );
+    bool _steal( unsigned id, size_t & b, size_t & e );
+    void _cancel();
+public:
+    /// Creates pool of `nWorkers` workers (`nWorkers - 1` threads); zero
+    /// means number of hardware threads.
+    explicit WorkStealingPool( unsigned nWorkers=0 );
+    /// \brief Creates pool of workers placed on NUMA nodes.
+    /// \details Runs `workersPerNode` workers on each node (zero means one
+    /// per CPU of the node), CPUs are taken in turn. Workers are not pinned
+    /// if the system does not permit it.
+    explicit WorkStealingPool( const std::vector<NumaNode> & nodes, unsigned workersPerNode=0 );
+    WorkStealingPool( const WorkStealingPool & ) = delete;
+    WorkStealingPool & operator=( const WorkStealingPool & ) = delete;
+    ~WorkStealingPool();
+
+    /// Returns number of workers.
+    unsigned size() const { return _nWorkers; }
+    /// Returns number of NUMA nodes the workers are placed on (one if not placed).
+    unsigned n_nodes() const { return _nodes.empty() ? 1 : _nodes.back() + 1; }
+    /// Returns index of the node (in the list given) the worker is placed on.
+    unsigned node( unsigned worker ) const { return _nodes.empty() ? 0 : _nodes[worker]; }
+    /// \brief Runs the task over indices `[0, n)`, blocks until done.
+    /// \details If task throws, remaining chunks are cancelled and the first
+    /// exception is rethrown.
+    void run( size_t n, size_t grain, const Task & task );
+    /// \brief Runs `task( worker, worker, worker + 1 )` once by each worker
+    /// on its own thread, blocks until done.
+    /// \details Used to create per-worker state on the thread (and so on
+    /// the NUMA node) using it. Exceptions are handled as of `run()`.
+    void run_each( const Task & task );
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_POOL_H
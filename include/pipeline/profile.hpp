@@ -0,0 +1,248 @@
+# ifndef H_DATAFLOW_PIPELINE_PROFILE_H
+# define H_DATAFLOW_PIPELINE_PROFILE_H
+
+# include "pipeline/batch.hpp"
+
+# include <array>
+# include <atomic>
+# include <cstdint>
+# include <ctime>
+# include <iosfwd>
+# include <map>
+# include <memory>
+# include <mutex>
+# include <string>
+# include <unordered_map>
+# include <vector>
+
+# if defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>
+# endif
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Statistics of the handler invocations.
+/// \details Calls are counted exactly, while the latency is measured for
+/// the sample of calls (see `Profiler::set_sampling()`); total time is
+/// extrapolated from the sample. In batch mode the call is counted for
+/// every value of the batch, while the latency histogram gets single entry
+/// (mean latency per value) per batch.
+struct HandlerStats {
+    /// Number of latency histogram bins
+    static constexpr unsigned kNBins = 40;
+
+    uint64_t nCalls;  ///< Number of values passed to the handler
+    uint64_t nPassed;  ///< Number of values propagated further
+    uint64_t nRejected;  ///< Number of values rejected (by cut)
+    double time;  ///< Total time spent in the handler (estimate), ns
+    /// Number of sampled calls of latency within `[edge(i-1), edge(i))`
+    std::array<uint64_t, kNBins> histogram;
+    double nsPerTick;  ///< Period of the counter histogram is built of
+
+    /// Returns upper edge of the histogram bin, ns.
+    double edge( unsigned i ) const { return nsPerTick*double(uint64_t(1) << (i + 1)); }
+    /// Returns mean latency, ns.
+    double mean() const { return nCalls ? time/nCalls : 0; }
+    /// Returns upper edge of the bin containing `q`-quantile of latency, ns.
+    double quantile( double q ) const;
+};
+
+namespace aux {
+
+/// Every n-th call is timed (see `Profiler::set_sampling()`)
+extern std::atomic<unsigned> gSamplingPeriod;
+
+/// \brief Returns current value of the time stamp counter.
+/// \details Uses TSC where available (ticks of constant rate), monotonic
+/// clock (ns) otherwise.
+inline uint64_t
+ticks() {
+    # if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+    # else
+    timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return uint64_t(ts.tv_sec)*1000000000 + ts.tv_nsec;
+    # endif
+}
+
+/// \brief Counters of the handler invocations made by single thread.
+/// \details Counters are written only by the owning thread, with relaxed
+/// loads and stores (no locked instructions), and read by Profiler when
+/// merging. Counters of the probe are allocated on its first use, in
+/// blocks never moved.
+class ProfileTable {
+public:
+    /// Counters of single probe
+    struct Counters {
+        std::atomic<uint64_t> nCalls, nPassed;
+        std::atomic<uint64_t> nTimed, nTicks;  ///< Values in timed calls and their ticks
+        std::atomic<uint64_t> histogram[HandlerStats::kNBins];  ///< By log2 of ticks
+    };
+    static constexpr unsigned kBlockSize = 64;  ///< Counters per block
+    static constexpr unsigned kNBlocks = 1024;  ///< Blocks at most
+private:
+    std::atomic<Counters *> _blocks[kNBlocks];
+    unsigned _countdown;  ///< Calls before the next timed one
+
+    Counters * _allocate( unsigned probe );
+    Counters & _counters( unsigned probe ) {
+        Counters * b = _blocks[probe/kBlockSize].load( std::memory_order_relaxed );
+        return b ? b[probe % kBlockSize] : *_allocate( probe );
+    }
+    static void _add( std::atomic<uint64_t> & c, uint64_t n ) {
+        c.store( c.load( std::memory_order_relaxed ) + n, std::memory_order_relaxed );
+    }
+public:
+    ProfileTable();
+    ProfileTable( const ProfileTable & ) = delete;
+    ProfileTable & operator=( const ProfileTable & ) = delete;
+    ~ProfileTable();
+
+    /// Returns `true` if the next call has to be timed.
+    bool sample() {
+        if( --_countdown ) return false;
+        _countdown = gSamplingPeriod.load( std::memory_order_relaxed );
+        return true;
+    }
+    /// Records `nIn` values passed to handler, `nOut` passed further.
+    void count( unsigned probe, uint64_t nIn, uint64_t nOut ) {
+        Counters & c = _counters( probe );
+        _add( c.nCalls, nIn );
+        _add( c.nPassed, nOut );
+    }
+    /// Records timed call: `nIn` values passed to handler, `nOut` further.
+    void record( unsigned probe, uint64_t nTicks, uint64_t nIn, uint64_t nOut ) {
+        Counters & c = _counters( probe );
+        _add( c.nCalls, nIn );
+        _add( c.nPassed, nOut );
+        _add( c.nTimed, nIn );
+        _add( c.nTicks, nTicks );
+        const uint64_t perValue = nIn > 1 ? nTicks/nIn : nTicks;
+        const unsigned bin = 63 - __builtin_clzll( perValue | 1 );
+        _add( c.histogram[bin < HandlerStats::kNBins ? bin : HandlerStats::kNBins - 1], 1 );
+    }
+    /// Returns counters of the probe (`nullptr` if it was not used).
+    const Counters * find( unsigned probe ) const;
+};
+
+/// Returns counters of the calling thread (created on first use).
+ProfileTable * thread_profile_table();
+
+/// Returns counters of calling thread, `nullptr` if profiling is disabled.
+inline ProfileTable *
+profile_table() {
+    # ifdef DATAFLOW_PROFILING
+    return thread_profile_table();
+    # else
+    return nullptr;
+    # endif
+}
+
+/// Calls `f()`, recording the call (and its result) as invocation of the probe.
+template<typename F> inline bool
+profiled( ProfileTable * t, unsigned probe, F && f ) {
+    # ifdef DATAFLOW_PROFILING
+    if( !t->sample() ) {
+        const bool passed = f();
+        t->count( probe, 1, passed );
+        return passed;
+    }
+    const uint64_t t0 = ticks();
+    const bool passed = f();
+    t->record( probe, ticks() - t0, 1, passed );
+    return passed;
+    # else
+    (void) t; (void) probe;
+    return f();
+    # endif
+}
+
+/// Calls `f()` processing the batch, recording values passed and selected.
+template<typename F> inline bool
+profiled_batch( ProfileTable * t, unsigned probe, const Batch & b, F && f ) {
+    # ifdef DATAFLOW_PROFILING
+    const size_t n = b.size();
+    if( !t->sample() ) {
+        const bool passed = f();
+        t->count( probe, n, b.size() );
+        return passed;
+    }
+    const uint64_t t0 = ticks();
+    const bool passed = f();
+    t->record( probe, ticks() - t0, n, b.size() );
+    return passed;
+    # else
+    (void) t; (void) probe; (void) b;
+    return f();
+    # endif
+}
+
+}  // namespace ::dataflow::aux
+
+/// \brief Registry of the handler statistics.
+/// \details When the library is built with `DATAFLOW_PROFILING` defined
+/// (CMake option of the same name), pipelines record every invocation of
+/// their stages: call counts, values accepted and rejected by cuts, and
+/// latency histograms (log2 bins) measured with time stamp counter for
+/// every 16th call by default (reading the counter may cost tens of ns on
+/// virtual machines). Stages are keyed by their names (names of the
+/// HandlersIndex entries for the handlers appended by name); stages of the
+/// same name are merged.
+/// Each thread writes its own counters, they are merged on `snapshot()`.
+/// Without `DATAFLOW_PROFILING` the instrumentation is removed at compile
+/// time and snapshot is empty.
+///
+/// \code
+/// Profiler::self().report( std::cout );  // or report_json()
+/// HandlerStats s = Profiler::self().snapshot()["cut_negative"];
+/// \endcode
+class Profiler {
+public:
+    /// Instrumentation is compiled in
+    # ifdef DATAFLOW_PROFILING
+    static constexpr bool enabled = true;
+    # else
+    static constexpr bool enabled = false;
+    # endif
+private:
+    mutable std::mutex _m;
+    std::unordered_map<std::string, unsigned> _probes;
+    std::vector<std::string> _names;  ///< Names of the probes
+    std::vector< std::shared_ptr<aux::ProfileTable> > _tables;  ///< All threads
+    std::map<std::string, HandlerStats> _baseline;  ///< Snapshot of last reset
+    uint64_t _ticks0;  ///< Counter at construction (for calibration)
+    double _t0;  ///< Time at construction, ns
+
+    Profiler();
+    double _ns_per_tick() const;
+    std::map<std::string, HandlerStats> _merge() const;
+
+    friend aux::ProfileTable * aux::thread_profile_table();
+public:
+    /// Returns instance of the profiler.
+    static Profiler & self();
+
+    /// Returns identifier of the probe named `name` (registered on first call).
+    unsigned probe( const std::string & name );
+    /// Returns statistics of all the probes, accumulated since last reset.
+    std::map<std::string, HandlerStats> snapshot() const;
+    /// Starts accumulation of statistics anew.
+    void reset();
+    /// Sets timing of every `period`-th call (1 to time all the calls).
+    void set_sampling( unsigned period );
+
+    /// Prints the table of statistics.
+    void report( std::ostream & os ) const;
+    /// Prints the statistics as JSON object.
+    void report_json( std::ostream & os ) const;
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_PROFILE_H
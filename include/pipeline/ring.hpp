@@ -0,0 +1,157 @@
+# ifndef H_DATAFLOW_PIPELINE_RING_H
+# define H_DATAFLOW_PIPELINE_RING_H
+
+# include <atomic>
+# include <chrono>
+# include <cstddef>
+# include <memory>
+# include <thread>
+# include <type_traits>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// Occupancy statistics of the ring buffer.
+struct RingStats {
+    size_t capacity;  ///< Capacity of the ring
+    size_t nPushed;  ///< Number of elements pushed
+    size_t maxOccupancy;  ///< Maximal number of elements in the ring
+    double meanOccupancy;  ///< Mean number of elements (upper estimate, sampled on push)
+    size_t nFull;  ///< Number of failed pushes (producer stalls)
+    size_t nEmpty;  ///< Number of failed pops (consumer stalls)
+};
+
+/// \brief Bounded lock-free single-producer/single-consumer ring buffer.
+/// \details Producer and consumer indices are kept on separate cache lines,
+/// each side keeps cached copy of the other's index and re-reads it only
+/// when the ring looks full (empty), so in steady state push and pop touch
+/// no shared cache line but the slot itself. Capacity is rounded up to the
+/// power of two.
+///
+/// Ring counts the stalls (push to full or pop from empty ring) and samples
+/// occupancy on each push, see Stats.
+template<typename T>
+class SpscRing {
+public:
+    static_assert( std::is_trivially_copyable<T>::value
+                 , "Ring elements have to be trivially copyable." );
+    typedef RingStats Stats;  ///< Occupancy statistics of the ring
+private:
+    const size_t _mask;
+    std::unique_ptr<T[]> _slots;
+    /// Producer-side state
+    struct alignas(64) {
+        std::atomic<size_t> head;  ///< Next position to write
+        size_t cachedTail;
+        std::atomic<size_t> nFull, sumOccupancy, maxOccupancy;
+    } _p;
+    /// Consumer-side state
+    struct alignas(64) {
+        std::atomic<size_t> tail;  ///< Next position to read
+        size_t cachedHead;
+        std::atomic<size_t> nEmpty;
+    } _c;
+
+    static size_t _round_up( size_t n ) {
+        size_t c = 2;
+        while( c < n ) c <<= 1;
+        return c;
+    }
+    /// Increments counter owned by the calling thread.
+    static void _inc( std::atomic<size_t> & c, size_t d=1 ) {
+        c.store( c.load(std::memory_order_relaxed) + d, std::memory_order_relaxed );
+    }
+public:
+    /// Creates ring of at least `capacity` elements.
+    explicit SpscRing( size_t capacity )
+            : _mask( _round_up(capacity) - 1 )
+            , _slots( new T[_mask + 1] ) {
+        _p.head = 0;
+        _p.cachedTail = 0;
+        _p.nFull = _p.sumOccupancy = _p.maxOccupancy = 0;
+        _c.tail = 0;
+        _c.cachedHead = 0;
+        _c.nEmpty = 0;
+    }
+    SpscRing( const SpscRing & ) = delete;
+    SpscRing & operator=( const SpscRing & ) = delete;
+
+    /// Returns capacity of the ring.
+    size_t capacity() const { return _mask + 1; }
+
+    /// Pushes element; returns `false` if ring is full (producer only).
+    bool try_push( const T & v ) {
+        const size_t head = _p.head.load( std::memory_order_relaxed );
+        if( head - _p.cachedTail > _mask ) {
+            _p.cachedTail = _c.tail.load( std::memory_order_acquire );
+            if( head - _p.cachedTail > _mask ) {
+                _inc( _p.nFull );
+                return false;
+            }
+        }
+        _slots[head & _mask] = v;
+        _p.head.store( head + 1, std::memory_order_release );
+        const size_t occupancy = head + 1 - _p.cachedTail;
+        _inc( _p.sumOccupancy, occupancy );
+        if( occupancy > _p.maxOccupancy.load(std::memory_order_relaxed) ) {
+            _p.maxOccupancy.store( occupancy, std::memory_order_relaxed );
+        }
+        return true;
+    }
+    /// Pops element; returns `false` if ring is empty (consumer only).
+    bool try_pop( T & v ) {
+        const size_t tail = _c.tail.load( std::memory_order_relaxed );
+        if( tail == _c.cachedHead ) {
+            _c.cachedHead = _p.head.load( std::memory_order_acquire );
+            if( tail == _c.cachedHead ) {
+                _inc( _c.nEmpty );
+                return false;
+            }
+        }
+        v = _slots[tail & _mask];
+        _c.tail.store( tail + 1, std::memory_order_release );
+        return true;
+    }
+
+    /// Returns occupancy statistics (approximate while ring is in use).
+    Stats stats() const {
+        const size_t n = _p.head.load( std::memory_order_relaxed );
+        return Stats{ capacity(), n
+                    , _p.maxOccupancy.load( std::memory_order_relaxed )
+                    , n ? double(_p.sumOccupancy.load( std::memory_order_relaxed ))/n : 0.
+                    , _p.nFull.load( std::memory_order_relaxed )
+                    , _c.nEmpty.load( std::memory_order_relaxed ) };
+    }
+};
+
+/// \brief Waiting strategy for the ring buffer users.
+/// \details Spins for a while, then yields the processor, then sleeps, so
+/// idle thread does not burn the core (nor starve the others when threads
+/// outnumber the cores).
+class Backoff {
+private:
+    unsigned _n;
+public:
+    Backoff() : _n(0) {}
+    /// Waits a bit longer than the previous time.
+    void pause() {
+        if( _n < 16 ) {
+            ++_n;
+        } else if( _n < 1024 ) {
+            ++_n;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for( std::chrono::microseconds(50) );
+        }
+    }
+    /// Restarts from spinning.
+    void reset() { _n = 0; }
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_RING_H
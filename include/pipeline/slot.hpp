@@ -0,0 +1,161 @@
+# ifndef H_DATAFLOW_PIPELINE_SLOT_H
+# define H_DATAFLOW_PIPELINE_SLOT_H
+
+# include <cstddef>
+# include <memory_resource>
+# include <new>
+# include <stdexcept>
+# include <type_traits>
+# include <utility>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Lightweight run-time type identifier.
+/// \details Address of the per-type static variable. Unlike `typeid()`
+/// comparison (which may involve string compare of mangled names) it is a
+/// single pointer compare, so may be used on per-event path.
+typedef const void * TypeId;
+
+namespace aux {
+template<typename T> struct TypeTag { static const char id; };
+template<typename T> const char TypeTag<T>::id = 0;
+}  // namespace ::dataflow::aux
+
+/// Returns run-time identifier of the type (cv-qualifiers dropped).
+template<typename T> constexpr TypeId
+type_id() {
+    return &aux::TypeTag<typename std::remove_cv<T>::type>::id;
+}
+
+/// \brief Exception thrown on the Slot access with wrong type.
+class BadSlotAccess : public std::logic_error {
+public:
+    BadSlotAccess() : std::logic_error( "Slot keeps value of different type." ) {}
+};
+
+/// \brief Type-erased value holder with small-buffer optimization.
+/// \details Keeps the value passed between pipeline stages. Values of
+/// types not exceeding `kCapacity` bytes (and suitably aligned, nothrow
+/// movable) are stored inline, so no heap allocation happens on per-event
+/// path. Larger values are allocated from the memory resource given at
+/// construction (e.g. the event Arena), or from the heap. Re-assignment of
+/// the value of the same type assigns it in place.
+class Slot {
+public:
+    /// Size of the embedded buffer, bytes
+    static constexpr size_t kCapacity = 48;
+    /// Alignment of the embedded buffer
+    static constexpr size_t kAlignment = alignof(std::max_align_t);
+private:
+    /// Operations on the value of particular type
+    struct Ops {
+        TypeId type;  ///< Type of the value
+        void (*destroy)( void *, std::pmr::memory_resource * );  ///< Calls destructor
+        bool inplace;  ///< Value is stored in embedded buffer
+    };
+
+    template<typename T> static constexpr bool
+    _fits() {
+        return sizeof(T) <= kCapacity && kAlignment % alignof(T) == 0
+            && std::is_nothrow_move_constructible<T>::value;
+    }
+    template<typename T> static void
+    _destroy( void * p, std::pmr::memory_resource * mr ) {
+        if constexpr( _fits<T>() ) {
+            static_cast<T *>(p)->~T();
+        } else if( mr ) {
+            static_cast<T *>(p)->~T();
+            mr->deallocate( p, sizeof(T), alignof(T) );
+        } else {
+            delete static_cast<T *>(p);
+        }
+    }
+    template<typename T> static const Ops *
+    _ops() {
+        static const Ops ops = { type_id<T>(), &_destroy<T>, _fits<T>() };
+        return &ops;
+    }
+
+    alignas(kAlignment) unsigned char _bf[kCapacity];
+    void * _ptr;  ///< Value (points to `_bf` or heap)
+    const Ops * _o;  ///< Operations, `nullptr` if slot is empty
+    std::pmr::memory_resource * const _mr;  ///< Resource for large values
+public:
+    /// Creates empty slot; large values are allocated from `mr` (if given).
+    explicit Slot( std::pmr::memory_resource * mr=nullptr ) : _ptr(nullptr), _o(nullptr), _mr(mr) {}
+    Slot( const Slot & ) = delete;
+    Slot & operator=( const Slot & ) = delete;
+    ~Slot() { reset(); }
+
+    /// Destroys the value kept.
+    void reset() {
+        if( _o ) {
+            _o->destroy( _ptr, _mr );
+            _o = nullptr;
+            _ptr = nullptr;
+        }
+    }
+
+    /// \brief Sets new value of type `T`, constructed from the arguments.
+    /// \details If slot already keeps value of the same type, it is
+    /// assigned in place.
+    template<typename T, typename... ArgsT> T &
+    emplace( ArgsT && ... args ) {
+        if constexpr( std::is_move_assignable<T>::value ) {
+            if( _o && type_id<T>() == _o->type ) {
+                T & v = *static_cast<T *>(_ptr);
+                v = T( std::forward<ArgsT>(args)... );
+                return v;
+            }
+        }
+        reset();
+        if constexpr( _fits<T>() ) {
+            _ptr = new (_bf) T( std::forward<ArgsT>(args)... );
+        } else if( _mr ) {
+            void * p = _mr->allocate( sizeof(T), alignof(T) );
+            try {
+                _ptr = new (p) T( std::forward<ArgsT>(args)... );
+            } catch( ... ) {
+                _mr->deallocate( p, sizeof(T), alignof(T) );
+                throw;
+            }
+        } else {
+            _ptr = new T( std::forward<ArgsT>(args)... );
+        }
+        _o = _ops<T>();
+        return *static_cast<T *>(_ptr);
+    }
+
+    /// Returns `true` if slot keeps no value.
+    bool empty() const { return !_o; }
+    /// Returns type of the value kept (`nullptr` if empty).
+    TypeId type() const { return _o ? _o->type : nullptr; }
+    /// Returns `true` if slot keeps value of type `T`.
+    template<typename T> bool holds() const { return type() == type_id<T>(); }
+    /// Returns pointer to the value.
+    void * data() { return _ptr; }
+
+    /// Returns value; throws BadSlotAccess if type differs.
+    template<typename T> T & get() {
+        if( !holds<T>() ) throw BadSlotAccess();
+        return *static_cast<T *>(_ptr);
+    }
+    /// Returns value; throws BadSlotAccess if type differs.
+    template<typename T> const T & get() const {
+        if( !holds<T>() ) throw BadSlotAccess();
+        return *static_cast<const T *>(_ptr);
+    }
+    /// Returns value; type has to be assured by caller.
+    template<typename T> T & get_unchecked() { return *static_cast<T *>(_ptr); }
+    /// Returns value; type has to be assured by caller.
+    template<typename T> const T & get_unchecked() const { return *static_cast<const T *>(_ptr); }
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_SLOT_H
@@ -0,0 +1,464 @@
+# ifndef H_DATAFLOW_PIPELINE_STAGE_H
+# define H_DATAFLOW_PIPELINE_STAGE_H
+
+# include "pipeline/batch.hpp"
+
+# include <memory>
+# include <string>
+# include <typeindex>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Type of the value passed through the pipeline stage port.
+/// \details Keeps both the `std::type_index` (used to check and report
+/// the compatibility of the stages when pipeline is built) and lightweight
+/// TypeId (used to check the input fed into the pipeline). Port also knows
+/// how to copy the value between slots, for the value shared by several
+/// consumers (see Graph).
+struct PortType {
+    TypeId id;  ///< Lightweight identifier
+    std::type_index index;  ///< Standard type index
+    /// Copies value from the second slot into first one (`nullptr` if type
+    /// is not copyable)
+    void (*copy)( Slot & to, Slot & from );
+
+    /// Returns port type for given value type.
+    template<typename T> static PortType of() {
+        if constexpr( std::is_copy_constructible<T>::value ) {
+            return PortType{ type_id<T>(), std::type_index(typeid(T)), &_copy<T> };
+        } else {
+            return PortType{ type_id<T>(), std::type_index(typeid(T)), nullptr };
+        }
+    }
+    bool operator==( const PortType & o ) const { return id == o.id; }
+    bool operator!=( const PortType & o ) const { return id != o.id; }
+private:
+    template<typename T> static void _copy( Slot & to, Slot & from ) {
+        to.emplace<T>( from.get_unchecked<T>() );
+    }
+};
+
+/// \brief Type-erased pipeline stage.
+/// \details Keeps the pointer to the invoker function, knowing the handler
+/// type, and the handler instance (for stateful handlers). The invoker
+/// takes the value from the Slot, passes it to the handler, and puts the
+/// result (if any) back to the slot; returns `false` to abort propagation.
+/// All the types are resolved when the invoker is instantiated, so calling
+/// the stage costs single indirect call. Batch invoker does the same for the
+/// Batch of values (see BatchKernel); it returns `false` if no values
+/// remain in the batch. Handlers not modifying their input provide the read
+/// invoker as well: it leaves the input slot intact and puts the result of
+/// mapping (if any) into other slot, so the value may be shared by several
+/// consumers without copying (see Graph). Generator handlers (see
+/// kGenerate) provide the expand invoker instead of the invoker: it puts
+/// each value produced from the input into other slot and passes it to the
+/// continuation running the rest of the pipeline.
+struct Stage {
+    /// Invoker function type
+    typedef bool (*Invoker)( void * handler, Slot & value );
+    /// Batch invoker function type
+    typedef bool (*BatchInvoker)( void * handler, Batch & values );
+    /// Read invoker function type; `out` is left empty if handler does not
+    /// produce new value
+    typedef bool (*ReadInvoker)( void * handler, Slot & in, Slot & out );
+    /// Rest of the pipeline run on the values produced by expand invoker
+    struct Continuation {
+        bool (*run)( void * ctx, Slot & value );
+        void * ctx;
+        /// Runs the rest of the pipeline, returns `true` if value passed.
+        bool operator()( Slot & value ) const { return run( ctx, value ); }
+    };
+    /// Expand invoker function type; returns `true` if some of the
+    /// produced values passed the continuation
+    typedef bool (*ExpandInvoker)( void * handler, Slot & in, Slot & out
+                                 , const Continuation & k );
+
+    Invoker invoke;  ///< Invoker function (`nullptr` for generators)
+    BatchInvoker invoke_batch;  ///< Batch invoker (`nullptr` if not supported)
+    void * handler;  ///< Handler instance (`nullptr` for functions)
+    std::shared_ptr<void> owner;  ///< Keeps handler instance alive
+    PortType input;  ///< Type of accepted value
+    PortType output;  ///< Type of produced value
+    std::string name;  ///< Name (for diagnostics)
+    /// How the handler may be used by concurrent workers
+    ConcurrencyPolicy concurrency = kReentrant;
+    /// Creates per-worker copy of the handler (for kCloned)
+    std::shared_ptr<void> (*clone)( const void * handler ) = nullptr;
+    /// Merges state of per-worker copy into handler (for kCloned)
+    void (*merge)( void * handler, const void * copy ) = nullptr;
+    /// Called once all the copies are merged into handler (for kCloned,
+    /// optional)
+    void (*merged)( void * handler ) = nullptr;
+    /// Read invoker (`nullptr` if handler modifies its input)
+    ReadInvoker invoke_read = nullptr;
+    /// Profiling probe (see Profiler), assigned when stage is appended
+    unsigned probe = 0;
+    /// Expand invoker (`nullptr` unless handler is a generator)
+    ExpandInvoker expand = nullptr;
+};
+
+namespace aux {
+
+/// Applies handler `h` of given traits to the value kept in the slot.
+template<typename TraitsT, typename HandlerT> inline bool
+apply_handler( HandlerT && h, Slot & s ) {
+    typename TraitsT::Input & v = s.template get_unchecked<typename TraitsT::Input>();
+    if constexpr( kCut == TraitsT::kind ) {
+        return h(v);
+    } else if constexpr( kTransform == TraitsT::kind ) {
+        h(v);
+        return true;
+    } else {
+        // result may refer to the input, so it is copied before the slot
+        // is re-assigned
+        typename TraitsT::Output r = h(v);
+        s.template emplace<typename TraitsT::Output>( std::move(r) );
+        return true;
+    }
+}
+
+/// Applies handler `h` of given traits, not modifying its input, to the
+/// value kept in slot `in`; result of mapping is put into `out`.
+template<typename TraitsT, typename HandlerT> inline bool
+read_handler( HandlerT && h, Slot & in, Slot & out ) {
+    static_assert( !TraitsT::modifies, "Handler modifies its input." );
+    typename TraitsT::Input & v = in.template get_unchecked<typename TraitsT::Input>();
+    if constexpr( kCut == TraitsT::kind ) {
+        return h(v);
+    } else if constexpr( kTransform == TraitsT::kind ) {
+        h(v);
+        return true;
+    } else {
+        out.template emplace<typename TraitsT::Output>( h(v) );
+        return true;
+    }
+}
+
+/// Applies generator handler `h` of given traits to the value kept in slot
+/// `in`; each produced value is put into `out` and passed to continuation.
+template<typename TraitsT, typename HandlerT> inline bool
+expand_handler( HandlerT && h, Slot & in, Slot & out, const Stage::Continuation & k ) {
+    static_assert( kGenerate == TraitsT::kind, "Handler is not a generator." );
+    bool passed = false;
+    for( typename TraitsT::Output & v : h( in.template get_unchecked<typename TraitsT::Input>() ) ) {
+        out.template emplace<typename TraitsT::Output>( std::move(v) );
+        passed = k( out ) || passed;
+    }
+    return passed;
+}
+
+/// Terminal step of the fused chain: passes the value to continuation.
+template<typename T>
+struct FusedEnd {
+    typedef T Input;
+    typedef T Output;
+    template<typename K> static inline bool
+    run( T & v, K && k ) { k(v); return true; }
+};
+
+/// Step of the fused chain calling handler `F` and proceeding to `NextT`.
+template<auto F, typename NextT>
+struct FusedStep {
+    typedef meta::StageTraits<decltype(F)> Traits;
+    typedef typename Traits::Input Input;
+    typedef typename NextT::Output Output;
+    static_assert( std::is_same<typename Traits::Output, typename NextT::Input>::value
+                 , "Output of the handler does not match input of the next one." );
+
+    template<typename K> static inline bool
+    run( Input & v, K && k ) {
+        if constexpr( kCut == Traits::kind ) {
+            if( !F(v) ) return false;
+            return NextT::run( v, k );
+        } else if constexpr( kTransform == Traits::kind ) {
+            F(v);
+            return NextT::run( v, k );
+        } else if constexpr( kGenerate == Traits::kind ) {
+            bool passed = false;
+            for( typename Traits::Output & u : F(v) ) passed = NextT::run( u, k ) || passed;
+            return passed;
+        } else {
+            typename Traits::Output u = F(v);
+            return NextT::run( u, k );
+        }
+    }
+};
+
+template<auto... Fs> struct FusedChainBuilder;
+
+/// Runs batch kernel of handler `F` over the batch.
+template<auto F> inline bool
+batch_step( Batch & b ) {
+    typedef meta::StageTraits<decltype(F)> Traits;
+    if constexpr( kCut == Traits::kind && IsAdapted< BatchKernel<F> >::value ) {
+        // scalar cut: evaluate and compact in single pass, without mask
+        return b.filter<typename Traits::Input>( F );
+    } else {
+        return apply_batch_kernel<Traits>(
+                []( auto values, auto *... out ) { BatchKernel<F>::apply( values, out... ); }
+                , b );
+    }
+}
+
+template<auto F>
+struct FusedChainBuilder<F> {
+    typedef FusedStep<F, FusedEnd<typename meta::StageTraits<decltype(F)>::Output> > Type;
+};
+
+template<auto F, auto G, auto... Fs>
+struct FusedChainBuilder<F, G, Fs...> {
+    typedef FusedStep<F, typename FusedChainBuilder<G, Fs...>::Type> Type;
+};
+
+}  // namespace ::dataflow::aux
+
+/// \brief Chain of handlers fused at compile time.
+/// \details Handlers `Fs` are given as template arguments (functions), so
+/// the compiler sees the whole sequence of calls and inlines it: there is
+/// no indirection between the handlers and no type checks at run time.
+/// Handler's output type has to match the input of the next one (checked
+/// by `static_assert`). Chain including generator (see kGenerate) passes
+/// to continuation each value produced; it succeeds if some of them passed.
+///
+/// \code
+/// bool cut( double & x ) { return x > 0; }
+/// double twice( double x ) { return 2*x; }
+/// typedef Fused<cut, twice> Chain;
+/// double v = 3;
+/// Chain::run( v, []( double & r ){ std::cout << r << std::endl; } );
+/// \endcode
+template<auto... Fs>
+struct Fused {
+    static_assert( sizeof...(Fs) > 0, "Empty fused chain." );
+    typedef typename aux::FusedChainBuilder<Fs...>::Type Chain;
+    typedef typename Chain::Input Input;  ///< Type of accepted value
+    typedef typename Chain::Output Output;  ///< Type of produced value
+    /// Chain includes generator
+    static constexpr bool expands = ( (kGenerate == meta::StageTraits<decltype(Fs)>::kind) || ... );
+
+    /// \brief Runs the chain, passes the result to continuation `k`.
+    /// \details Returns `false` if propagation was aborted by a cut.
+    template<typename K> static inline bool
+    run( Input & v, K && k ) { return Chain::run( v, std::forward<K>(k) ); }
+
+    /// Invoker function for use as a Stage of the dynamic Pipeline.
+    static bool invoke( void *, Slot & s ) {
+        return Chain::run( s.get_unchecked<Input>(), [&s]( Output & o ) {
+                    if( static_cast<void *>(&o) != s.data() ) {
+                        s.emplace<Output>( std::move(o) );
+                    }
+                } );
+    }
+    /// Returns invoker or `nullptr` if chain includes generator.
+    static constexpr Stage::Invoker invoker() {
+        if constexpr( !expands ) return &invoke;
+        else return nullptr;
+    }
+
+    /// Expand invoker for use as a Stage of the dynamic Pipeline.
+    static bool invoke_expand( void *, Slot & in, Slot & out, const Stage::Continuation & k ) {
+        bool passed = false;
+        // values produced by generator are never the input, so are moved
+        Chain::run( in.get_unchecked<Input>(), [&out, &k, &passed]( Output & o ) {
+                    out.emplace<Output>( std::move(o) );
+                    passed = k( out ) || passed;
+                } );
+        return passed;
+    }
+    /// Returns expand invoker or `nullptr` if chain includes no generator.
+    static constexpr Stage::ExpandInvoker expand_invoker() {
+        if constexpr( expands ) return &invoke_expand;
+        else return nullptr;
+    }
+
+    /// Read invoker for use as a Stage of the Graph.
+    static bool invoke_read( void *, Slot & in, Slot & out ) {
+        Input & v = in.get_unchecked<Input>();
+        return Chain::run( v, [&v, &out]( Output & o ) {
+                    if( static_cast<void *>(&o) != &v ) out.emplace<Output>( std::move(o) );
+                } );
+    }
+    /// Returns read invoker or `nullptr` if some handler modifies its input
+    /// (or chain includes generator).
+    static constexpr Stage::ReadInvoker read_invoker() {
+        if constexpr( !expands && ( !meta::StageTraits<decltype(Fs)>::modifies && ... ) ) {
+            return &invoke_read;
+        } else return nullptr;
+    }
+
+    /// \brief Batch invoker for use as a Stage of the dynamic Pipeline.
+    /// \details Runs handlers one after another, each over the whole batch.
+    static bool invoke_batch( void *, Batch & b ) {
+        return ( aux::batch_step<Fs>( b ) && ... );
+    }
+    /// Returns batch invoker or `nullptr` if chain can not run in batch mode.
+    static constexpr Stage::BatchInvoker batch_invoker() {
+        if constexpr( ( aux::batchable< meta::StageTraits<decltype(Fs)> >() && ... ) ) {
+            return &invoke_batch;
+        } else return nullptr;
+    }
+
+    /// Returns pipeline stage object running the chain.
+    static Stage stage( const std::string & name ) {
+        Stage s{ invoker(), batch_invoker(), nullptr, nullptr
+               , PortType::of<Input>(), PortType::of<Output>(), name };
+        s.invoke_read = read_invoker();
+        s.expand = expand_invoker();
+        return s;
+    }
+};
+
+namespace aux {
+template<typename C, typename=void> struct HasBatchCall : std::false_type {};
+template<typename C>
+struct HasBatchCall<C, std::void_t<decltype(&C::call_batch)> > : std::true_type {};
+template<typename C, typename=void> struct HasClone : std::false_type {};
+template<typename C>
+struct HasClone<C, std::void_t<decltype(&C::clone)> > : std::true_type {};
+
+template<typename C, typename=void>
+struct DeclaredConcurrency : std::integral_constant<ConcurrencyPolicy, kSerialized> {};
+template<typename C>
+struct DeclaredConcurrency<C, std::void_t<decltype(C::kConcurrency)> >
+        : std::integral_constant<ConcurrencyPolicy, C::kConcurrency> {};
+}  // namespace ::dataflow::aux
+
+/// \brief Concurrency traits of the stateful handler class `C`.
+/// \details Policy is taken from `C::kConcurrency` static member
+/// (kSerialized if not declared). Handlers declared as kCloned have to
+/// provide `clone()` method creating per-worker copy, that keeps the
+/// configuration of the handler, but not its accumulated state, and
+/// `merge( const C & copy )` method accumulating the state of the copy.
+/// Copy constructor is not used, as it would copy the accumulated state
+/// too, counting it once per worker on merge. May be specialized.
+///
+/// \code
+/// struct Histogram {
+///     static constexpr ConcurrencyPolicy kConcurrency = kCloned;
+///     std::vector<size_t> bins;
+///     void call( const double & x );
+///     Histogram clone() const { return Histogram( bins.size() ); }
+///     void merge( const Histogram & o );
+/// };
+/// \endcode
+template<typename C>
+struct ConcurrencyTraits {
+    /// Concurrency policy of the handler
+    static constexpr ConcurrencyPolicy policy = aux::DeclaredConcurrency<C>::value;
+    static_assert( kCloned != policy || aux::HasClone<C>::value
+                 , "Handler declared as kCloned has to provide clone() method." );
+
+    /// Creates per-worker copy of the handler.
+    static std::shared_ptr<void> clone( const void * h ) {
+        return std::make_shared<C>( static_cast<const C *>(h)->clone() );
+    }
+    /// Merges the state of per-worker copy into handler.
+    static void merge( void * h, const void * copy ) {
+        static_cast<C *>(h)->merge( *static_cast<const C *>(copy) );
+    }
+};
+
+/// \brief Invoker of the stateful handler instance.
+/// \details Handler class `C` has to provide `call()` method of single
+/// argument (see meta::StageTraits). It may also provide batch kernel as
+/// `call_batch()` method (see BatchKernel).
+template<typename C>
+struct MethodInvoker {
+    typedef meta::StageTraits<decltype(&C::call)> Traits;
+    typedef typename Traits::Input Input;  ///< Type of accepted value
+    typedef typename Traits::Output Output;  ///< Type of produced value
+
+    /// Invoker function for use as a Stage of the dynamic Pipeline.
+    static bool invoke( void * h, Slot & s ) {
+        C & c = *static_cast<C *>(h);
+        return aux::apply_handler<Traits>(
+                [&c]( typename Traits::Argument v ) -> typename Traits::Return {
+                    return c.call(v);
+                }, s );
+    }
+    /// Returns invoker or `nullptr` if handler is a generator.
+    static constexpr Stage::Invoker invoker() {
+        if constexpr( kGenerate != Traits::kind ) return &invoke;
+        else return nullptr;
+    }
+
+    /// Expand invoker for use as a Stage of the dynamic Pipeline.
+    static bool invoke_expand( void * h, Slot & in, Slot & out, const Stage::Continuation & k ) {
+        C & c = *static_cast<C *>(h);
+        return aux::expand_handler<Traits>(
+                [&c]( typename Traits::Argument v ) -> typename Traits::Return {
+                    return c.call(v);
+                }, in, out, k );
+    }
+    /// Returns expand invoker or `nullptr` if handler is not a generator.
+    static constexpr Stage::ExpandInvoker expand_invoker() {
+        if constexpr( kGenerate == Traits::kind ) return &invoke_expand;
+        else return nullptr;
+    }
+
+    /// Batch invoker for use as a Stage of the dynamic Pipeline.
+    static bool invoke_batch( void * h, Batch & b ) {
+        C & c = *static_cast<C *>(h);
+        if constexpr( kCut == Traits::kind && !aux::HasBatchCall<C>::value ) {
+            return b.filter<Input>( [&c]( typename Traits::Argument v ) { return c.call(v); } );
+        }
+        return aux::apply_batch_kernel<Traits>( [&c]( auto values, auto *... out ) {
+                    if constexpr( aux::HasBatchCall<C>::value ) {
+                        c.call_batch( values, out... );
+                    } else {
+                        aux::batch_loop<Traits>( [&c]( typename Traits::Argument v )
+                                -> typename Traits::Return { return c.call(v); }
+                            , values, out... );
+                    }
+                }, b );
+    }
+    /// Returns batch invoker or `nullptr` if handler can not run in batch mode.
+    static constexpr Stage::BatchInvoker batch_invoker() {
+        if constexpr( aux::batchable<Traits>() ) return &invoke_batch;
+        else return nullptr;
+    }
+
+    /// Read invoker for use as a Stage of the Graph.
+    static bool invoke_read( void * h, Slot & in, Slot & out ) {
+        C & c = *static_cast<C *>(h);
+        return aux::read_handler<Traits>(
+                [&c]( typename Traits::Argument v ) -> typename Traits::Return {
+                    return c.call(v);
+                }, in, out );
+    }
+    /// Returns read invoker or `nullptr` if handler modifies its input (or
+    /// is a generator).
+    static constexpr Stage::ReadInvoker read_invoker() {
+        if constexpr( !Traits::modifies && kGenerate != Traits::kind ) return &invoke_read;
+        else return nullptr;
+    }
+
+    /// Sets the concurrency policy fields of the stage.
+    static void set_concurrency( Stage & s ) {
+        s.concurrency = ConcurrencyTraits<C>::policy;
+        if constexpr( kCloned == ConcurrencyTraits<C>::policy ) {
+            s.clone = &ConcurrencyTraits<C>::clone;
+            s.merge = &ConcurrencyTraits<C>::merge;
+        }
+    }
+
+    /// Returns pipeline stage object for given handler instance.
+    static Stage stage( std::shared_ptr<C> h, const std::string & name ) {
+        void * ptr = h.get();
+        Stage s{ invoker(), batch_invoker(), ptr, std::move(h)
+               , PortType::of<Input>(), PortType::of<Output>(), name };
+        s.invoke_read = read_invoker();
+        s.expand = expand_invoker();
+        set_concurrency( s );
+        return s;
+    }
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_STAGE_H
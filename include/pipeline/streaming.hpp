@@ -0,0 +1,130 @@
+# ifndef H_DATAFLOW_PIPELINE_STREAMING_H
+# define H_DATAFLOW_PIPELINE_STREAMING_H
+
+# include "pipeline/pipeline.hpp"
+# include "pipeline/ring.hpp"
+
+# include <atomic>
+# include <exception>
+# include <functional>
+# include <mutex>
+# include <thread>
+
+namespace dataflow {
+
+/// \addtogroup Pipeline
+/// @{
+
+/// \brief Pipeline running groups of stages on their own threads.
+/// \details Stages of the Pipeline are split into groups; each group runs
+/// on dedicated thread, processing the batches of values (see Batch) in
+/// batch mode and passing them to the next group through SpscRing. Each
+/// handler is thus called from single thread, in order of the values fed,
+/// so stateful handlers which can neither be shared nor cloned may still
+/// run in parallel with the other stages.
+///
+/// The number of batches in flight is bounded (batch objects are recycled
+/// through the ring returning them from the last group to the feeding
+/// thread), so `feed()` blocks when the stages can not keep up
+/// (backpressure), and steady-state processing does no allocations.
+/// Each batch has its own Arena, reset when the batch is recycled.
+/// Results are delivered to the sink, called from the thread of the last
+/// group. Exception thrown by a stage stops the processing of the further
+/// batches and is rethrown by `feed()`, `flush()` or `close()`.
+///
+/// \code
+/// StreamingPipeline sp( p, {2, 1}, []( size_t offset, const Batch & b ) {
+///         // b.index()[i] + offset is the position of the value in the input
+///     } );
+/// sp.feed( amplitudes.data(), amplitudes.size() );
+/// sp.close();  // drains the pipeline and stops the threads
+/// \endcode
+class StreamingPipeline {
+public:
+    /// Consumer of the processed batches
+    typedef std::function<void(size_t offset, const Batch & b)> Sink;
+private:
+    /// Batch in flight
+    struct Item {
+        Batch batch;
+        Arena arena;  ///< Memory of the batch
+        size_t offset;  ///< Position of the first value in the input
+    };
+    /// Group of stages run by single thread
+    struct Group {
+        std::vector<Stage> stages;
+        SpscRing<Item *> * in;  ///< Queue of incoming batches
+        SpscRing<Item *> * out;  ///< Queue for processed batches
+        std::thread thread;
+    };
+
+    const std::vector<Stage> _stages;
+    const Sink _sink;
+    const size_t _batchSize;
+    std::vector< std::unique_ptr<Item> > _items;
+    std::vector< std::unique_ptr< SpscRing<Item *> > > _queues;  ///< Last one returns free items
+    std::vector<Group> _groups;
+    size_t _nFed;  ///< Number of values fed
+    size_t _nSubmitted;  ///< Number of batches submitted
+    std::atomic<size_t> _nDelivered;  ///< Number of batches done with
+    std::atomic<bool> _failed;
+    std::mutex _errorMutex;
+    std::exception_ptr _error;
+    bool _closed;
+
+    void _run( Group & g, bool last );
+    Item * _acquire();
+    void _submit( Item * item );
+    void _check_error();
+    [[noreturn]] void _throw_bad_input( const PortType & t ) const;
+public:
+    /// \brief Builds streaming counterpart of the pipeline.
+    /// \details `groups` gives number of stages in each group (empty means
+    /// single stage per group); `batchSize` is the maximal number of values
+    /// in batch; `capacity` is the number of batches each queue may keep.
+    /// Handler instances are shared with the original pipeline, which must
+    /// not be used meanwhile. Throws IncompatibleHandlers if some stage does
+    /// not support batch mode.
+    StreamingPipeline( const Pipeline & p
+                     , const std::vector<size_t> & groups
+                     , Sink sink
+                     , size_t batchSize=256
+                     , size_t capacity=16 );
+    StreamingPipeline( const StreamingPipeline & ) = delete;
+    StreamingPipeline & operator=( const StreamingPipeline & ) = delete;
+    /// Closes the pipeline (exception of the stage is not rethrown).
+    ~StreamingPipeline();
+
+    /// \brief Feeds `n` values; blocks while queues are full.
+    /// \details Values are copied, so the array may be released on return.
+    template<typename T> void feed( const T * data, size_t n ) {
+        if( !_stages.empty() && type_id<T>() != _stages.front().input.id ) {
+            _throw_bad_input( PortType::of<T>() );
+        }
+        for( size_t i = 0; i < n; i += _batchSize ) {
+            Item * item = _acquire();
+            const size_t m = std::min( _batchSize, n - i );
+            item->batch.assign( data + i, m );
+            item->offset = _nFed;
+            _nFed += m;
+            _submit( item );
+        }
+    }
+    /// Waits until all the values fed are delivered to the sink.
+    void flush();
+    /// Flushes the pipeline and stops the threads.
+    void close();
+
+    /// Returns number of threads (groups of stages).
+    size_t threads() const { return _groups.size(); }
+    /// \brief Returns statistics of the queues.
+    /// \details Queue `i` feeds the group `i`; the last one returns
+    /// processed batches to the feeding thread.
+    std::vector<RingStats> queue_stats() const;
+};
+
+/// @} End of Pipeline group
+
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_PIPELINE_STREAMING_H
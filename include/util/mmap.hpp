@@ -0,0 +1,50 @@
+# ifndef H_DATAFLOW_UTIL_MMAP_H
+# define H_DATAFLOW_UTIL_MMAP_H
+
+# include <string>
+# include <cstddef>
+
+namespace dataflow {
+
+/// \brief Auxiliary system utilities.
+namespace util {
+
+/// \brief Read-only memory mapping of the file.
+/// \details RAII wrapper over `mmap()`/`munmap()`. The mapping is shared,
+/// so the pages are shared among the processes mapping the same file.
+/// Throws `std::runtime_error` if file can not be opened or mapped.
+///
+/// \code
+/// MappedFile f("calibrations.json");
+/// process( f.data(), f.size() );
+/// \endcode
+class MappedFile {
+private:
+    void * _addr;  ///< Mapping address (`nullptr` for empty file)
+    size_t _size;  ///< Size of the mapping
+public:
+    /// Maps given file.
+    explicit MappedFile( const std::string & path );
+    /// Unmaps the file.
+    ~MappedFile();
+    /// Mapping can not be copied.
+    MappedFile( const MappedFile & ) = delete;
+    /// Mapping can not be copied.
+    MappedFile & operator=( const MappedFile & ) = delete;
+    /// Takes ownership over the mapping.
+    MappedFile( MappedFile && );
+    /// Takes ownership over the mapping.
+    MappedFile & operator=( MappedFile && );
+
+    /// Returns pointer to the mapped content.
+    const char * data() const { return static_cast<const char *>(_addr); }
+    /// Returns size of the mapped content.
+    size_t size() const { return _size; }
+    /// Hints the kernel that mapping will be read sequentially.
+    void advise_sequential() const;
+};
+
+}  // namespace ::dataflow::util
+}  // namespace ::dataflow
+
+# endif  // H_DATAFLOW_UTIL_MMAP_H
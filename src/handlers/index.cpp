@@ -1,14 +1,237 @@
 # include "handlers/index.hpp"
 
+# include <cstring>
+
+# include <dlfcn.h>
+
 namespace dataflow {
 
-HandlersIndex * HandlersIndex::_self = nullptr;
+namespace aux {
+
+static std::atomic<const HandlersModule *> gModules{ nullptr };
+
+HandlersModule::HandlersModule( const HandlerEntry * const * b, const HandlerEntry * const * e )
+        : begin(b), end(e), next( gModules.load() ) {
+    while( !gModules.compare_exchange_weak( next, this ) ) {}
+}
+
+const HandlersModule *
+handlers_modules() {
+    return gModules.load( std::memory_order_acquire );
+}
+
+}  // namespace ::dataflow::aux
+
+Stage
+HandlerDescription::stage( const std::string & name ) const {
+    Stage s{ invoke, invoke_batch, nullptr, nullptr, input, output, name };
+    s.invoke_read = invoke_read;
+    s.expand = expand;
+    if( construct ) {
+        s.owner = construct();
+        s.handler = s.owner.get();
+    }
+    if( set_concurrency ) set_concurrency( s );
+    return s;
+}
 
 HandlersIndex &
 HandlersIndex::self() {
-    if( ! HandlersIndex::_self ) _self = new HandlersIndex();
-    return *_self;
+    // never destroyed: handlers may be looked up by static destructors
+    static HandlersIndex * idx = new HandlersIndex();
+    return *idx;
 }
 
-}  // namespace ::dataflow
+template<typename From, typename... ToTs> static void
+_add_arithmetic_adapters( HandlersIndex & idx ) {
+    ( idx.add_adapter<From, ToTs>(), ... );
+}
+
+HandlersIndex::HandlersIndex()
+        : _nEntries( 0 ), _indexed( nullptr ), _nAdded( 0 ), _loading( nullptr ) {
+    _add_arithmetic_adapters<int, long, float, double>( *this );
+    _add_arithmetic_adapters<long, int, float, double>( *this );
+    _add_arithmetic_adapters<float, int, long, double>( *this );
+    _add_arithmetic_adapters<double, int, long, float>( *this );
+}
+
+void
+HandlersIndex::add( const std::string & name, const HandlerDescription & d ) {
+    std::lock_guard<std::recursive_mutex> lock( _mutex );
+    // added by static initializers of the plugin being loaded
+    const std::string key = _loading ? *_loading + "/" + name : name;
+    if( !_loading ) _index();
+    if( (!_loading && _entry( key )) || ! _handlers.emplace( key, d ).second ) {
+        throw std::runtime_error( "Handler \"" + key + "\" is already registered." );
+    }
+    ++_nAdded;
+}
 
+size_t
+HandlersIndex::_slot( const std::vector<const HandlerEntry *> & entries
+                     , const char * name, size_t n, uint64_t hash ) {
+    // linear probing; table is at most half full
+    const size_t mask = entries.size() - 1;
+    for( size_t i = hash & mask; ; i = (i + 1) & mask ) {
+        const HandlerEntry * e = entries[i];
+        if( !e || (e->hash == hash && !strncmp( e->name, name, n ) && !e->name[n]) ) {
+            return i;
+        }
+    }
+}
+
+const HandlerEntry *
+HandlersIndex::_entry( const std::vector<const HandlerEntry *> & entries
+                      , const char * name, size_t n ) {
+    if( entries.empty() ) return nullptr;
+    return entries[_slot( entries, name, n, aux::hash_name( name, n ) )];
+}
+
+void
+HandlersIndex::_index() {
+    // modules loaded since last indexing are at the head of the list
+    const aux::HandlersModule * head = aux::handlers_modules();
+    // modules of the plugin being loaded are its own
+    if( head == _indexed || _loading ) return;
+    size_t n = _nEntries;
+    for( const aux::HandlersModule * m = head; m != _indexed; m = m->next ) n += m->end - m->begin;
+    if( 2*n > _entries.size() ) {
+        std::vector<const HandlerEntry *> entries;
+        entries.swap( _entries );
+        size_t capacity = 16;
+        while( capacity < 2*n ) capacity *= 2;
+        _entries.resize( capacity, nullptr );
+        for( const HandlerEntry * e : entries ) {
+            if( e ) _entries[_slot( _entries, e->name, strlen(e->name), e->hash )] = e;
+        }
+    }
+    const char * duplicate = nullptr;
+    for( const aux::HandlersModule * m = head; m != _indexed; m = m->next ) {
+        for( const HandlerEntry * const * e = m->begin; e != m->end; ++e ) {
+            const size_t i = _slot( _entries, (*e)->name, strlen((*e)->name), (*e)->hash );
+            if( _entries[i] || _handlers.count( (*e)->name ) ) {
+                duplicate = (*e)->name;
+                continue;
+            }
+            _entries[i] = *e;
+            ++_nEntries;
+        }
+    }
+    _indexed = head;
+    if( duplicate ) {
+        throw std::runtime_error( "Handler \"" + std::string(duplicate)
+                                + "\" is already registered." );
+    }
+}
+
+const HandlerDescription *
+HandlersIndex::_find( const std::string & name ) {
+    auto it = _handlers.find( name );
+    if( _handlers.end() != it ) return &it->second;
+    const size_t n = name.find( '/' );
+    if( std::string::npos != n ) return _find_plugin( name, n );
+    _index();
+    if( const HandlerEntry * e = _entry( name ) ) {
+        return &_handlers.emplace( name, e->describe() ).first->second;
+    }
+    return nullptr;
+}
+
+const HandlerDescription *
+HandlersIndex::_find_plugin( const std::string & name, size_t n ) {
+    const std::string plugin = name.substr( 0, n );
+    load( plugin );
+    Plugin & p = _loaded.find( plugin )->second;
+    if( p.entries.empty() && !p.modules.empty() ) {
+        size_t nEntries = 0;
+        for( const aux::HandlersModule * m : p.modules ) nEntries += m->end - m->begin;
+        size_t capacity = 16;
+        while( capacity < 2*nEntries ) capacity *= 2;
+        p.entries.resize( capacity, nullptr );
+        for( const aux::HandlersModule * m : p.modules ) {
+            for( const HandlerEntry * const * e = m->begin; e != m->end; ++e ) {
+                // the first of duplicates is taken
+                const size_t i = _slot( p.entries, (*e)->name, strlen((*e)->name), (*e)->hash );
+                if( !p.entries[i] ) p.entries[i] = *e;
+            }
+        }
+    }
+    const HandlerEntry * e = _entry( p.entries, name.c_str() + n + 1, name.size() - n - 1 );
+    if( !e ) return nullptr;
+    return &_handlers.emplace( name, e->describe() ).first->second;
+}
+
+const HandlerDescription *
+HandlersIndex::find( const std::string & name ) const {
+    // lookup completes the index, so it is logically const
+    HandlersIndex & idx = const_cast<HandlersIndex &>( *this );
+    std::lock_guard<std::recursive_mutex> lock( _mutex );
+    return idx._find( name );
+}
+
+size_t
+HandlersIndex::size() const {
+    HandlersIndex & idx = const_cast<HandlersIndex &>( *this );
+    std::lock_guard<std::recursive_mutex> lock( _mutex );
+    idx._index();
+    return _nEntries + _nAdded;
+}
+
+void
+HandlersIndex::add_plugin( const std::string & plugin, const std::string & path ) {
+    std::lock_guard<std::recursive_mutex> lock( _mutex );
+    _plugins[plugin] = path;
+}
+
+void
+HandlersIndex::load( const std::string & plugin ) {
+    std::lock_guard<std::recursive_mutex> lock( _mutex );
+    if( _loaded.count( plugin ) ) return;
+    auto it = _plugins.find( plugin );
+    const std::string path = _plugins.end() == it ? "lib" + plugin + ".so" : it->second;
+    // plugin registers its table while being loaded: modules registered
+    // since then are plugin's (libraries loaded by other threads meanwhile
+    // are not expected to have handlers)
+    _index();
+    const aux::HandlersModule * before = aux::handlers_modules();
+    _loading = &plugin;
+    void * h = dlopen( path.c_str(), RTLD_NOW | RTLD_LOCAL );
+    _loading = nullptr;
+    if( !h ) {
+        const char * err = dlerror();
+        throw BadPlugin( "Unable to load plugin \"" + plugin + "\": " + (err ? err : path) + "." );
+    }
+    Plugin & p = _loaded[plugin];  // never unloaded, handlers may be in use
+    p.handle = h;
+    const aux::HandlersModule * head = aux::handlers_modules();
+    for( const aux::HandlersModule * m = head; m != before; m = m->next ) p.modules.push_back( m );
+    if( _indexed == before ) _indexed = head;  // not indexed globally
+}
+
+bool
+HandlersIndex::loaded( const std::string & plugin ) const {
+    std::lock_guard<std::recursive_mutex> lock( _mutex );
+    return _loaded.count( plugin );
+}
+
+const HandlerDescription &
+HandlersIndex::get( const std::string & name ) const {
+    const HandlerDescription * d = find( name );
+    if( !d ) throw UnknownHandler( name );
+    return *d;
+}
+
+Stage
+HandlersIndex::adapter( const PortType & from, const PortType & to ) const {
+    std::lock_guard<std::recursive_mutex> lock( _mutex );
+    auto it = _adapters.find( std::make_pair( from.index, to.index ) );
+    Stage s{ nullptr, nullptr, nullptr, nullptr, from, to
+           , std::string("<") + from.index.name() + " to " + to.index.name() + ">" };
+    if( _adapters.end() != it ) {
+        s.invoke = it->second.first;
+        s.invoke_batch = it->second.second;
+    }
+    return s;
+}
+
+}  // namespace ::dataflow
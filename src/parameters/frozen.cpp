@@ -0,0 +1,456 @@
+# include "parameters/frozen.hpp"
+# include "util/mmap.hpp"
+
+# include <algorithm>
+# include <cstddef>
+# include <cstdio>
+# include <cstring>
+# include <cerrno>
+# include <unordered_map>
+# include <vector>
+
+# include <sys/stat.h>
+# include <unistd.h>
+
+namespace dataflow {
+namespace config {
+
+namespace frozen {
+const char gMagic[8] = { 'D', 'F', 'C', 'F', 'G', '\0', '\0', '\0' };
+}  // namespace ::dataflow::config::frozen
+
+//
+// Snapshot building
+
+namespace {
+
+/// Writes the tree into growing buffer. Since buffer may be reallocated,
+/// entries are always addressed by offsets.
+class FreezeBuilder {
+private:
+    std::vector<char> _bf;
+    /// Offsets of dictionary keys written (same keys are shared)
+    std::unordered_map<std::string_view, uint64_t> _keys;
+public:
+    /// Allocates aligned block of given size, returns its offset.
+    uint64_t allocate( size_t sz ) {
+        const size_t off = (_bf.size() + 7) & ~size_t(7);
+        if( off + sz > UINT32_MAX ) {
+            throw std::runtime_error( "Frozen config exceeds arena limit." );
+        }
+        _bf.resize( off + sz, '\0' );
+        return off;
+    }
+    /// Returns pointer to the entry by its offset (invalidated by allocate()).
+    template<typename T> T * at( uint64_t off ) {
+        return reinterpret_cast<T *>( _bf.data() + off );
+    }
+    /// Copies characters into arena, returns offset.
+    uint64_t put_str( const char * s, size_t len ) {
+        uint64_t off = allocate( len + 1 );
+        memcpy( _bf.data() + off, s, len );
+        return off;
+    }
+    /// Copies dictionary key into arena (once), returns offset.
+    uint64_t put_key( const std::string & k ) {
+        auto it = _keys.find( k );
+        if( _keys.end() != it ) return it->second;
+        const uint64_t off = put_str( k.data(), k.size() );
+        _keys.emplace( k, off );  // view refers to key in the source tree
+        return off;
+    }
+    /// Fills node at given offset with given parameter.
+    void put( uint64_t nodeOff, const AbstractParameter & p );
+    /// Returns the buffer.
+    std::vector<char> & buffer() { return _bf; }
+};
+
+void
+FreezeBuilder::put( uint64_t nodeOff, const AbstractParameter & p ) {
+    frozen::Node n;
+    n.type = p.type_code();
+    n.flags = 0;
+    n.count = 0;
+    n.v.off = 0;
+    switch( p.type_code() ) {
+        case kLogic :
+            n.v.i = p.as<bool>();
+            break;
+        case kInt :
+            n.v.i = p.as<int>();
+            break;
+        case kReal :
+            n.v.d = p.as<double>();
+            break;
+        case kString : {
+            const std::string & s = p.as<std::string>();
+            n.count = s.size();
+            n.v.off = put_str( s.data(), s.size() );
+        } break;
+        case kRealArray : {
+            const RealArray & a = p.as<RealArray>();
+            n.count = a.size();
+            n.v.off = allocate( sizeof(double)*a.size() );
+            std::copy( a.begin(), a.end(), at<double>(n.v.off) );
+        } break;
+        case kIntArray : {
+            const IntArray & a = p.as<IntArray>();
+            n.count = a.size();
+            n.v.off = allocate( sizeof(int)*a.size() );
+            std::copy( a.begin(), a.end(), at<int>(n.v.off) );
+        } break;
+        case kDict : {
+            const Dictionary & d = static_cast<const Dictionary &>(p);
+            n.count = d.size();
+            const uint64_t keysOff = allocate( sizeof(frozen::KeyRef)*d.size() )
+                         , nodesOff = allocate( sizeof(frozen::Node)*d.size() );
+            n.v.off = keysOff;
+            size_t i = 0;
+            // dictionary is ordered by symbols, image -- by the key strings
+            std::vector<const Dictionary::value_type *> entries;
+            entries.reserve( d.size() );
+            for( const auto & e : d ) entries.push_back( &e );
+            std::sort( entries.begin(), entries.end()
+                     , []( const Dictionary::value_type * a, const Dictionary::value_type * b ) {
+                            return a->first.str() < b->first.str(); } );
+            for( const Dictionary::value_type * e : entries ) {
+                if( !e->second ) {
+                    throw std::runtime_error( "Unable to freeze null dictionary entry." );
+                }
+                const uint64_t keyOff = put_key( e->first );
+                frozen::KeyRef & kr = at<frozen::KeyRef>(keysOff)[i];
+                kr.off = keyOff;
+                kr.len = e->first.size();
+                put( nodesOff + sizeof(frozen::Node)*i, *e->second );
+                ++i;
+            }
+        } break;
+        case kTuple : {
+            const Tuple & t = static_cast<const Tuple &>(p);
+            n.count = t.size();
+            const bool dense = t.empty() || t.rbegin()->first == t.size() - 1;
+            uint64_t nodesOff;
+            if( dense ) {
+                n.flags |= frozen::kDenseTuple;
+                n.v.off = nodesOff = allocate( sizeof(frozen::Node)*t.size() );
+            } else {
+                n.v.off = allocate( sizeof(uint64_t)*t.size() );
+                nodesOff = allocate( sizeof(frozen::Node)*t.size() );
+            }
+            size_t i = 0;
+            for( const auto & e : t ) {
+                if( !e.second ) {
+                    throw std::runtime_error( "Unable to freeze null tuple entry." );
+                }
+                if( !dense ) at<uint64_t>(n.v.off)[i] = e.first;
+                put( nodesOff + sizeof(frozen::Node)*i, *e.second );
+                ++i;
+            }
+        } break;
+        default : {
+            char bf[128];
+            snprintf( bf, sizeof(bf), "Unable to freeze parameter of type %#x."
+                    , (int) p.type_code() );
+            throw std::runtime_error( bf );
+        }
+    };
+    *at<frozen::Node>(nodeOff) = n;
+}
+
+}  // anonymous namespace
+
+FrozenConfig
+freeze( const AbstractParameter & root ) {
+    FreezeBuilder b;
+    const uint64_t hdrOff = b.allocate( sizeof(frozen::Header) );
+    b.put( hdrOff + offsetof(frozen::Header, root), root );
+    frozen::Header & hdr = *b.at<frozen::Header>(hdrOff);
+    memcpy( hdr.magic, frozen::gMagic, sizeof(hdr.magic) );
+    hdr.version = frozen::gVersion;
+    hdr.byteOrder = frozen::gByteOrderMark;
+    hdr.size = b.buffer().size();
+    // Copy to (aligned) storage of exact size
+    const size_t nWords = (hdr.size + 7)/8;
+    std::shared_ptr<uint64_t> storage( new uint64_t [nWords]
+                                     , std::default_delete<uint64_t[]>() );
+    memcpy( storage.get(), b.buffer().data(), hdr.size );
+    return FrozenConfig( storage
+                       , reinterpret_cast<const char *>(storage.get()) );
+}
+
+//
+// Snapshot
+
+FrozenConfig::FrozenConfig( std::shared_ptr<const void> storage
+                          , const char * base )
+        : _storage(storage), _base(base) {
+    const frozen::Header & hdr = *reinterpret_cast<const frozen::Header *>(base);
+    if( memcmp( hdr.magic, frozen::gMagic, sizeof(hdr.magic) ) ) {
+        throw std::runtime_error( "Bad frozen config magic." );
+    }
+    if( frozen::gVersion != hdr.version ) {
+        char bf[128];
+        snprintf( bf, sizeof(bf), "Unsupported frozen config version %u."
+                , hdr.version );
+        throw std::runtime_error( bf );
+    }
+    if( frozen::gByteOrderMark != hdr.byteOrder ) {
+        throw std::runtime_error( "Frozen config byte order differs from native." );
+    }
+}
+
+//
+// Binary image
+
+void
+write_image( const FrozenConfig & cfg, const std::string & filename ) {
+    // image is written aside and renamed over the target, so processes
+    // having the old image mapped keep reading its (unlinked) content
+    char bf[256];
+    std::string tmpName = filename + ".XXXXXX";
+    const int fd = mkstemp( &tmpName[0] );
+    FILE * f = fd < 0 ? nullptr : fdopen( fd, "wb" );
+    if( !f ) {
+        snprintf( bf, sizeof(bf), "Unable to open \"%s\" for writing: %s."
+                , tmpName.c_str(), strerror(errno) );
+        if( fd >= 0 ) {
+            close( fd );
+            unlink( tmpName.c_str() );
+        }
+        throw std::runtime_error( bf );
+    }
+    // mkstemp() creates file readable by owner only
+    const mode_t mask = umask( 0 );
+    umask( mask );
+    const bool chmodOk = 0 == fchmod( fd, 0666 & ~mask );
+    const size_t nWritten = fwrite( cfg.data(), 1, cfg.size(), f );
+    if( fclose( f ) || nWritten != cfg.size() || !chmodOk
+     || rename( tmpName.c_str(), filename.c_str() ) ) {
+        snprintf( bf, sizeof(bf), "Unable to write \"%s\": %s."
+                , filename.c_str(), strerror(errno) );
+        unlink( tmpName.c_str() );
+        throw std::runtime_error( bf );
+    }
+}
+
+/// \brief Checks that all the offsets of the image refer within its size.
+/// \details Children of each container are written after its node, so
+/// requiring increasing offsets also excludes cycles. Nodes are checked
+/// iteratively, as corrupt image may nest arbitrary deep.
+static const char *
+_check_image( const char * base, uint64_t size ) {
+    // range of `n` entries of given size at given offset is within image
+    auto fits = [size]( uint64_t off, uint64_t n, uint64_t entrySize ) {
+        return off <= size && n <= (size - off)/entrySize;
+    };
+    std::vector<uint64_t> nodes( 1, offsetof(frozen::Header, root) );
+    while( !nodes.empty() ) {
+        const uint64_t nodeOff = nodes.back();
+        nodes.pop_back();
+        const frozen::Node & n = *reinterpret_cast<const frozen::Node *>(base + nodeOff);
+        const uint64_t off = n.v.off;
+        switch( n.type ) {
+            case kLogic :
+            case kInt :
+            case kReal :
+                continue;
+            case kString :
+                if( !fits( off, n.count, 1 ) ) return "string out of image";
+                continue;
+            case kRealArray :
+            case kIntArray :
+                if( off % 8 || !fits( off, n.count, kRealArray == n.type ? sizeof(double) : sizeof(int) ) ) {
+                    return "array out of image";
+                }
+                continue;
+            case kDict :
+            case kTuple :
+                break;
+            default :
+                return "unknown node type";
+        }
+        if( off <= nodeOff || off % 8 ) return "bad container offset";
+        uint64_t nodesOff = off;
+        if( kDict == n.type ) {
+            if( !fits( off, n.count, sizeof(frozen::KeyRef) ) ) return "keys out of image";
+            const frozen::KeyRef * keys = reinterpret_cast<const frozen::KeyRef *>(base + off);
+            for( uint32_t i = 0; i < n.count; ++i ) {
+                if( !fits( keys[i].off, keys[i].len, 1 ) ) return "key out of image";
+            }
+            nodesOff += sizeof(frozen::KeyRef)*n.count;
+        } else if( !(n.flags & frozen::kDenseTuple) ) {
+            if( !fits( off, n.count, sizeof(uint64_t) ) ) return "indexes out of image";
+            nodesOff += sizeof(uint64_t)*n.count;
+        }
+        nodesOff = (nodesOff + 7) & ~uint64_t(7);
+        if( !fits( nodesOff, n.count, sizeof(frozen::Node) ) ) return "entries out of image";
+        for( uint32_t i = 0; i < n.count; ++i ) nodes.push_back( nodesOff + sizeof(frozen::Node)*i );
+    }
+    return nullptr;
+}
+
+FrozenConfig
+map_image( const std::string & filename ) {
+    auto file = std::make_shared<util::MappedFile>( filename );
+    char bf[256];
+    if( file->size() < sizeof(frozen::Header)
+     || reinterpret_cast<const frozen::Header *>(file->data())->size != file->size() ) {
+        snprintf( bf, sizeof(bf), "File \"%s\" is not a frozen config image"
+                  " or is truncated.", filename.c_str() );
+        throw std::runtime_error( bf );
+    }
+    const char * base = file->data();
+    FrozenConfig cfg( file, base );
+    if( const char * what = _check_image( base, file->size() ) ) {
+        snprintf( bf, sizeof(bf), "Frozen config image \"%s\" is corrupt: %s."
+                , filename.c_str(), what );
+        throw std::runtime_error( bf );
+    }
+    return cfg;
+}
+
+FrozenNode
+FrozenConfig::root() const {
+    return FrozenNode( _base
+                     , &reinterpret_cast<const frozen::Header *>(_base)->root );
+}
+
+size_t
+FrozenConfig::size() const {
+    return reinterpret_cast<const frozen::Header *>(_base)->size;
+}
+
+//
+// Node view
+
+void
+FrozenNode::_throw_bad_type( ParameterType expected ) const {
+    throw BadParameterType( type_code(), expected );
+}
+
+bool
+FrozenNode::find( std::string_view key, FrozenNode & dest ) const {
+    if( kDict != type_code() ) _throw_bad_type( kDict );
+    const frozen::KeyRef * keys
+            = reinterpret_cast<const frozen::KeyRef *>(_base + _node->v.off);
+    const frozen::KeyRef * it = std::lower_bound( keys, keys + _node->count, key
+            , [this]( const frozen::KeyRef & kr, std::string_view k ) {
+                return std::string_view(_base + kr.off, kr.len) < k;
+            } );
+    if( it == keys + _node->count
+     || std::string_view(_base + it->off, it->len) != key ) return false;
+    dest = value( it - keys );
+    return true;
+}
+
+bool
+FrozenNode::find( size_t n, FrozenNode & dest ) const {
+    if( array_element_type( type_code() ) ) {
+        if( n >= _node->count ) return false;
+        dest = FrozenNode( _base, _node, uint32_t(n) );
+        return true;
+    }
+    if( kTuple != type_code() ) _throw_bad_type( kTuple );
+    if( _node->flags & frozen::kDenseTuple ) {
+        if( n >= _node->count ) return false;
+        dest = value( n );
+        return true;
+    }
+    const uint64_t * idxs = reinterpret_cast<const uint64_t *>(_base + _node->v.off);
+    const uint64_t * it = std::lower_bound( idxs, idxs + _node->count, n );
+    if( it == idxs + _node->count || *it != n ) return false;
+    dest = value( it - idxs );
+    return true;
+}
+
+std::string_view
+FrozenNode::key( size_t i ) const {
+    if( kDict != type_code() ) _throw_bad_type( kDict );
+    const frozen::KeyRef & kr
+            = reinterpret_cast<const frozen::KeyRef *>(_base + _node->v.off)[i];
+    return std::string_view( _base + kr.off, kr.len );
+}
+
+size_t
+FrozenNode::index( size_t i ) const {
+    if( kTuple != type_code() ) _throw_bad_type( kTuple );
+    if( _node->flags & frozen::kDenseTuple ) return i;
+    return reinterpret_cast<const uint64_t *>(_base + _node->v.off)[i];
+}
+
+FrozenNode
+FrozenNode::value( size_t i ) const {
+    uint64_t nodesOff = _node->v.off;
+    if( kDict == _node->type ) {
+        nodesOff += sizeof(frozen::KeyRef)*_node->count;
+    } else if( !(_node->flags & frozen::kDenseTuple) ) {
+        nodesOff += sizeof(uint64_t)*_node->count;
+    }
+    nodesOff = (nodesOff + 7) & ~uint64_t(7);
+    return FrozenNode( _base
+                     , reinterpret_cast<const frozen::Node *>(_base + nodesOff) + i );
+}
+
+//
+// Path traversal
+
+FrozenNode
+get_entry( FrozenNode c, const PathToken & tok ) {
+    char bf[128];
+    FrozenNode r( c );
+    if( tok.isStr ) {
+        if( kDict != c.type_code() ) {
+            snprintf( bf, sizeof(bf)
+                    , "Unable to retrieve \"%.*s\": not a dictionary."
+                    , (int) tok.str.size(), tok.str.data() );
+            throw std::runtime_error( bf );
+        }
+        if( ! c.find( tok.str, r ) ) {
+            snprintf( bf, sizeof(bf)
+                    , "No entry \"%.*s\" in frozen dictionary."
+                    , (int) tok.str.size(), tok.str.data() );
+            throw std::runtime_error( bf );
+        }
+    } else {
+        if( kTuple != c.type_code() && !array_element_type( c.type_code() ) ) {
+            snprintf( bf, sizeof(bf)
+                    , "Unable to retrieve #%zu: not a list."
+                    , tok.n );
+            throw std::runtime_error( bf );
+        }
+        if( ! c.find( tok.n, r ) ) {
+            snprintf( bf, sizeof(bf)
+                    , "No entry #%zu in frozen list."
+                    , tok.n );
+            throw std::runtime_error( bf );
+        }
+    }
+    return r;
+}
+
+FrozenNode
+get_parameter_ref( FrozenNode root, std::string_view strPath ) {
+    PathTokenizer t( strPath );
+    PathToken tok;
+    while( t.next(tok) ) {
+        root = get_entry( root, tok );
+    }
+    return root;
+}
+
+FrozenNode
+get_parameter_ref( FrozenNode root, const Path * pathPtr ) {
+    for( ; pathPtr; pathPtr = pathPtr->next() ) {
+        PathToken tok;
+        if( (tok.isStr = pathPtr->is_str()) ) {
+            tok.str = pathPtr->str_first();
+        } else {
+            tok.n = pathPtr->n();
+        }
+        root = get_entry( root, tok );
+    }
+    return root;
+}
+
+}  // namespace ::dataflow::config
+}  // namespace ::dataflow
@@ -0,0 +1,75 @@
+# include "parameters/handle.hpp"
+
+# include <cstdio>
+
+namespace dataflow {
+namespace config {
+
+CompiledPath::CompiledPath( std::string_view strPath )
+        : _src( std::make_shared<const std::string>(strPath) ) {
+    PathTokenizer t( *_src );
+    PathToken tok;
+    while( t.next(tok) ) _toks.push_back(tok);
+}
+
+/// Returns modifications counter of the container (or dense array) or
+/// `nullptr` for scalars.
+static const MutationCounter *
+_mutation_counter( const AbstractParameter & p ) {
+    if( p.type_code() & kDict ) {
+        return &static_cast<const Dictionary &>(p);
+    }
+    if( p.type_code() & kTuple ) {
+        return &static_cast<const Tuple &>(p);
+    }
+    if( kRealArray == p.type_code() ) {
+        return &static_cast<const Parameter<RealArray> &>(p);
+    }
+    if( kIntArray == p.type_code() ) {
+        return &static_cast<const Parameter<IntArray> &>(p);
+    }
+    return nullptr;
+}
+
+AbstractParameter &
+CompiledPath::resolve( AbstractParameter & root
+                     , std::vector<Guard> * guards ) const {
+    AbstractParameter * c = &root;
+    for( const auto & tok : _toks ) {
+        if( guards ) {
+            const MutationCounter * mc = _mutation_counter(*c);
+            if( mc ) guards->push_back( Guard{ mc, mc->generation() } );
+        }
+        c = &get_entry( *c, tok );
+    }
+    return *c;
+}
+
+const void *
+CompiledPath::resolve_value( AbstractParameter & root
+                           , ParameterType expected
+                           , std::vector<Guard> * guards ) const {
+    AbstractParameter * c = &root;
+    try {
+        for( auto it = _toks.begin(); _toks.end() != it; ++it ) {
+            if( guards ) {
+                const MutationCounter * mc = _mutation_counter(*c);
+                if( mc ) guards->push_back( Guard{ mc, mc->generation() } );
+            }
+            if( !it->isStr && array_element_type( c->type_code() )
+             && _toks.end() == it + 1 ) {
+                return aux::array_element_ptr( *c, it->n, expected );
+            }
+            c = &get_entry( *c, *it );
+        }
+        return aux::value_ptr( *c, expected );
+    } catch( BadParameterType & e ) {
+        char bf[192];
+        snprintf( bf, sizeof(bf), "Parameter \"%s\": %s"
+                , _src->c_str(), e.what() );
+        throw std::runtime_error( bf );
+    }
+}
+
+}  // namespace ::dataflow::config
+}  // namespace ::dataflow
@@ -0,0 +1,544 @@
+# include "parameters/json.hpp"
+
+# include <charconv>
+# include <cstdio>
+# include <cstring>
+
+namespace dataflow {
+namespace config {
+namespace json {
+
+ParseError::ParseError( const std::string & what, size_t line, size_t column )
+        : std::runtime_error( what ), _line(line), _column(column) {}
+
+//
+// Scanner
+
+/// \brief Single-pass JSON scanner filling the document tape.
+/// \details Non-recursive: the stack of open containers is kept explicitly.
+/// Strings are scanned by eight bytes at once (SWAR) looking for quote or
+/// backslash characters.
+class Scanner {
+private:
+    Document & _doc;
+    const char * _begin, * _p, * _end;
+    std::vector<uint32_t> _stack;
+    /// Tape indices of the elements of open arrays
+    std::vector<uint32_t> _pending;
+
+    [[noreturn]] void _error( const char * what ) const;
+    void _skip_ws() {
+        while( _p < _end && (' ' == *_p || '\n' == *_p || '\r' == *_p || '\t' == *_p) ) ++_p;
+    }
+    void _push( uint16_t type, uint16_t flags, uint64_t off, uint32_t count ) {
+        TapeEntry e;
+        e.type = type;
+        e.flags = flags;
+        e.count = count;
+        e.off = off;
+        _doc._tape.push_back( e );
+    }
+    void _open( uint16_t type ) {
+        _stack.push_back( _doc._tape.size() );
+        _push( type, 0, 0, 0 );
+        ++_p;
+    }
+    void _close() {
+        const uint32_t idx = _stack.back();
+        TapeEntry & e = _doc._tape[idx];
+        e.c.end = _doc._tape.size();
+        e.c.elements = kFlat;
+        if( kTuple == e.type ) {
+            // elements are indexed unless they follow each other
+            const auto first = _pending.end() - e.count;
+            if( e.c.end != idx + 1 + e.count ) {
+                e.c.elements = _doc._elements.size();
+                _doc._elements.insert( _doc._elements.end(), first, _pending.end() );
+            }
+            _pending.erase( first, _pending.end() );
+        }
+        _stack.pop_back();
+        ++_p;
+    }
+    void _string( uint16_t flags );
+    void _unescape( const char * s );
+    void _key();
+    void _number();
+    void _literal();
+public:
+    Scanner( Document & doc ) : _doc(doc)
+                              , _begin(doc._text)
+                              , _p(doc._text)
+                              , _end(doc._text + doc._size) {}
+    void scan();
+};
+
+void
+Scanner::_error( const char * what ) const {
+    size_t line = 1, column = 1;
+    for( const char * c = _begin; c < _p && c < _end; ++c ) {
+        if( '\n' == *c ) {
+            ++line;
+            column = 1;
+        } else {
+            ++column;
+        }
+    }
+    char bf[256];
+    snprintf( bf, sizeof(bf), "JSON syntax error at %zu:%zu: %s."
+            , line, column, what );
+    throw ParseError( bf, line, column );
+}
+
+void
+Scanner::_string( uint16_t flags ) {
+    const char * s = ++_p;
+    # if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const uint64_t ones = 0x0101010101010101ULL
+                 , highs = 0x8080808080808080ULL;
+    while( _p + 8 <= _end ) {
+        uint64_t w;
+        memcpy( &w, _p, 8 );
+        // quote, backslash or control character (byte below 0x20)
+        const uint64_t q = w ^ (ones*'"')
+                     , b = w ^ (ones*'\\')
+                     , m = (((q - ones) & ~q) | ((b - ones) & ~b) | ((w - ones*0x20) & ~w)) & highs;
+        if( m ) {
+            _p += __builtin_ctzll(m)/8;
+            break;
+        }
+        _p += 8;
+    }
+    # endif
+    while( _p < _end && '"' != *_p && '\\' != *_p && uint8_t(*_p) >= 0x20 ) ++_p;
+    if( _p == _end ) _error( "unterminated string" );
+    if( uint8_t(*_p) < 0x20 ) _error( "control character in string" );
+    if( '\\' == *_p ) {
+        _unescape( s );
+        return;
+    }
+    _push( kString, flags, s - _begin, _p - s );
+    ++_p;
+}
+
+static void
+_append_utf8( std::string & dest, uint32_t cp ) {
+    if( cp < 0x80 ) {
+        dest += (char) cp;
+    } else if( cp < 0x800 ) {
+        dest += (char) (0xC0 | (cp >> 6));
+        dest += (char) (0x80 | (cp & 0x3F));
+    } else if( cp < 0x10000 ) {
+        dest += (char) (0xE0 | (cp >> 12));
+        dest += (char) (0x80 | ((cp >> 6) & 0x3F));
+        dest += (char) (0x80 | (cp & 0x3F));
+    } else {
+        dest += (char) (0xF0 | (cp >> 18));
+        dest += (char) (0x80 | ((cp >> 12) & 0x3F));
+        dest += (char) (0x80 | ((cp >> 6) & 0x3F));
+        dest += (char) (0x80 | (cp & 0x3F));
+    }
+}
+
+void
+Scanner::_unescape( const char * s ) {
+    std::string & u = _doc._unescaped;
+    const size_t off = u.size();
+    u.append( s, _p - s );
+    auto hex4 = [this]() {
+        uint32_t cp = 0;
+        for( int i = 0; i < 4; ++i, ++_p ) {
+            if( _p == _end ) _error( "unterminated string" );
+            const char c = *_p;
+            cp <<= 4;
+            if( c >= '0' && c <= '9' ) cp |= c - '0';
+            else if( c >= 'a' && c <= 'f' ) cp |= c - 'a' + 10;
+            else if( c >= 'A' && c <= 'F' ) cp |= c - 'A' + 10;
+            else _error( "bad unicode escape sequence" );
+        }
+        return cp;
+    };
+    while( _p < _end && '"' != *_p ) {
+        if( uint8_t(*_p) < 0x20 ) _error( "control character in string" );
+        if( '\\' != *_p ) {
+            u += *(_p++);
+            continue;
+        }
+        if( ++_p == _end ) break;
+        switch( *(_p++) ) {
+            case '"'  : u += '"'; break;
+            case '\\' : u += '\\'; break;
+            case '/'  : u += '/'; break;
+            case 'b'  : u += '\b'; break;
+            case 'f'  : u += '\f'; break;
+            case 'n'  : u += '\n'; break;
+            case 'r'  : u += '\r'; break;
+            case 't'  : u += '\t'; break;
+            case 'u'  : {
+                uint32_t cp = hex4();
+                if( cp >= 0xD800 && cp < 0xDC00 ) {
+                    // surrogate pair
+                    if( _end - _p < 6 || '\\' != _p[0] || 'u' != _p[1] ) {
+                        _error( "unpaired surrogate in unicode escape sequence" );
+                    }
+                    _p += 2;
+                    const uint32_t lo = hex4();
+                    if( lo < 0xDC00 || lo > 0xDFFF ) {
+                        _error( "bad surrogate in unicode escape sequence" );
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                _append_utf8( u, cp );
+            } break;
+            default:
+                --_p;
+                _error( "bad escape sequence" );
+        };
+    }
+    if( _p == _end ) _error( "unterminated string" );
+    _push( kString, kUnescaped, off, u.size() - off );
+    ++_p;
+}
+
+void
+Scanner::_key() {
+    if( _p == _end || '"' != *_p ) _error( "object member key expected" );
+    _string( kKey );
+    _skip_ws();
+    if( _p == _end || ':' != *_p ) _error( "':' expected" );
+    ++_p;
+}
+
+void
+Scanner::_number() {
+    const char * s = _p;
+    bool isReal = false;
+    if( '-' == *_p ) ++_p;
+    if( _p == _end || *_p < '0' || *_p > '9' ) _error( "bad number" );
+    if( '0' == *_p ) {
+        ++_p;
+    } else {
+        while( _p < _end && *_p >= '0' && *_p <= '9' ) ++_p;
+    }
+    if( _p < _end && '.' == *_p ) {
+        isReal = true;
+        ++_p;
+        if( _p == _end || *_p < '0' || *_p > '9' ) _error( "bad number" );
+        while( _p < _end && *_p >= '0' && *_p <= '9' ) ++_p;
+    }
+    if( _p < _end && ('e' == *_p || 'E' == *_p) ) {
+        isReal = true;
+        ++_p;
+        if( _p < _end && ('+' == *_p || '-' == *_p) ) ++_p;
+        if( _p == _end || *_p < '0' || *_p > '9' ) _error( "bad number" );
+        while( _p < _end && *_p >= '0' && *_p <= '9' ) ++_p;
+    }
+    if( !isReal ) {
+        // integers out of `int` range are kept as real numbers
+        int v;
+        isReal = std::errc() != std::from_chars( s, _p, v ).ec;
+    }
+    _push( isReal ? kReal : kInt, 0, s - _begin, _p - s );
+}
+
+void
+Scanner::_literal() {
+    const size_t left = _end - _p;
+    if( left >= 4 && !memcmp( _p, "true", 4 ) ) {
+        _push( kLogic, 0, _p - _begin, 4 );
+        _p += 4;
+    } else if( left >= 5 && !memcmp( _p, "false", 5 ) ) {
+        _push( kLogic, 0, _p - _begin, 5 );
+        _p += 5;
+    } else {
+        _error( "unexpected literal" );
+    }
+}
+
+void
+Scanner::scan() {
+    bool expectValue = true;
+    for(;;) {
+        _skip_ws();
+        if( expectValue ) {
+            if( _p == _end ) _error( "unexpected end of document" );
+            if( !_stack.empty() ) {
+                TapeEntry & parent = _doc._tape[_stack.back()];
+                ++parent.count;
+                if( kTuple == parent.type ) _pending.push_back( _doc._tape.size() );
+            }
+            switch( *_p ) {
+                case '{' :
+                    _open( kDict );
+                    _skip_ws();
+                    if( _p < _end && '}' == *_p ) {
+                        _close();
+                        expectValue = false;
+                    } else {
+                        _key();
+                    }
+                    continue;
+                case '[' :
+                    _open( kTuple );
+                    _skip_ws();
+                    if( _p < _end && ']' == *_p ) {
+                        _close();
+                        expectValue = false;
+                    }
+                    continue;
+                case '"' :
+                    _string( 0 );
+                    break;
+                case 't' :
+                case 'f' :
+                    _literal();
+                    break;
+                case 'n' :
+                    _error( "null values are not supported" );
+                default:
+                    if( '-' == *_p || (*_p >= '0' && *_p <= '9') ) {
+                        _number();
+                    } else {
+                        _error( "unexpected character" );
+                    }
+            };
+            expectValue = false;
+        } else {
+            if( _stack.empty() ) {
+                if( _p != _end ) _error( "trailing characters after document" );
+                return;
+            }
+            if( _p == _end ) _error( "unexpected end of document" );
+            const uint16_t type = _doc._tape[_stack.back()].type;
+            if( ',' == *_p ) {
+                ++_p;
+                if( kDict == type ) {
+                    _skip_ws();
+                    _key();
+                }
+                expectValue = true;
+            } else if( (kDict == type && '}' == *_p)
+                    || (kTuple == type && ']' == *_p) ) {
+                _close();
+            } else {
+                _error( "',' or closing bracket expected" );
+            }
+        }
+    }
+}
+
+//
+// Document
+
+void
+Document::_parse() {
+    // Typical configuration has an entry per 16 or more characters (keys,
+    // numbers and indentation); denser documents make the tape grow
+    _tape.reserve( _size/16 + 1 );
+    Scanner( *this ).scan();
+}
+
+std::unique_ptr<Document>
+Document::load( const std::string & filename ) {
+    std::unique_ptr<Document> doc( new Document() );
+    doc->_file.reset( new util::MappedFile( filename ) );
+    doc->_file->advise_sequential();
+    doc->_text = doc->_file->data();
+    doc->_size = doc->_file->size();
+    doc->_parse();
+    return doc;
+}
+
+std::unique_ptr<Document>
+Document::parse( std::string_view text ) {
+    std::unique_ptr<Document> doc( new Document() );
+    doc->_ownText.reset( new char [text.size() + 1] );
+    memcpy( doc->_ownText.get(), text.data(), text.size() );
+    doc->_text = doc->_ownText.get();
+    doc->_size = text.size();
+    doc->_parse();
+    return doc;
+}
+
+Value
+Document::root() const {
+    return Value( *this, 0 );
+}
+
+//
+// Value
+
+void
+Value::_throw_bad_type( ParameterType expected ) const {
+    throw BadParameterType( type_code(), expected );
+}
+
+size_t
+Value::size() const {
+    const TapeEntry & e = entry();
+    if( kDict != e.type && kTuple != e.type && kString != e.type ) {
+        _throw_bad_type( kDict );
+    }
+    return e.count;
+}
+
+Value
+Value::next() const {
+    const TapeEntry & e = entry();
+    if( kDict == e.type || kTuple == e.type ) return Value( *_doc, e.c.end );
+    return Value( *_doc, _idx + 1 );
+}
+
+template<> bool
+Value::as<bool>() const {
+    if( kLogic != entry().type ) _throw_bad_type( kLogic );
+    return 't' == _doc->text( entry() )[0];
+}
+
+template<> int
+Value::as<int>() const {
+    if( kInt != entry().type ) _throw_bad_type( kInt );
+    const std::string_view t = _doc->text( entry() );
+    int v;
+    auto r = std::from_chars( t.data(), t.data() + t.size(), v );
+    if( std::errc() != r.ec ) {
+        char bf[128];
+        snprintf( bf, sizeof(bf), "Integer value %.*s is out of range."
+                , (int) t.size(), t.data() );
+        throw std::runtime_error( bf );
+    }
+    return v;
+}
+
+template<> double
+Value::as<double>() const {
+    if( kReal != entry().type ) _throw_bad_type( kReal );
+    const std::string_view t = _doc->text( entry() );
+    double v;
+    auto r = std::from_chars( t.data(), t.data() + t.size(), v );
+    if( std::errc() != r.ec ) {
+        char bf[128];
+        snprintf( bf, sizeof(bf), "Floating point value %.*s is out of range."
+                , (int) t.size(), t.data() );
+        throw std::runtime_error( bf );
+    }
+    return v;
+}
+
+template<> std::string_view
+Value::as<std::string>() const {
+    if( kString != entry().type ) _throw_bad_type( kString );
+    return _doc->text( entry() );
+}
+
+bool
+Value::find( std::string_view key, Value & dest ) const {
+    if( kDict != entry().type ) _throw_bad_type( kDict );
+    const std::vector<TapeEntry> & tape = _doc->tape();
+    uint32_t i = _idx + 1;
+    bool found = false;
+    // all the members are checked, so the last of duplicates is taken
+    for( uint32_t n = 0; n < entry().count; ++n ) {
+        Value v( *_doc, i + 1 );
+        if( _doc->text( tape[i] ) == key ) {
+            dest = v;
+            found = true;
+        }
+        i = v.next()._idx;
+    }
+    return found;
+}
+
+bool
+Value::find( size_t n, Value & dest ) const {
+    if( kTuple != entry().type ) _throw_bad_type( kTuple );
+    if( n >= entry().count ) return false;
+    dest = Value( *_doc, _doc->element( entry(), _idx, n ) );
+    return true;
+}
+
+//
+// Path traversal and conversion
+
+Value
+get_entry( Value c, const PathToken & tok ) {
+    char bf[128];
+    Value r( c );
+    if( tok.isStr ) {
+        if( kDict != c.type_code() ) {
+            snprintf( bf, sizeof(bf)
+                    , "Unable to retrieve \"%.*s\": not an object."
+                    , (int) tok.str.size(), tok.str.data() );
+            throw std::runtime_error( bf );
+        }
+        if( ! c.find( tok.str, r ) ) {
+            snprintf( bf, sizeof(bf)
+                    , "No member \"%.*s\" in JSON object."
+                    , (int) tok.str.size(), tok.str.data() );
+            throw std::runtime_error( bf );
+        }
+    } else {
+        if( kTuple != c.type_code() ) {
+            snprintf( bf, sizeof(bf)
+                    , "Unable to retrieve #%zu: not an array."
+                    , tok.n );
+            throw std::runtime_error( bf );
+        }
+        if( ! c.find( tok.n, r ) ) {
+            snprintf( bf, sizeof(bf)
+                    , "No element #%zu in JSON array."
+                    , tok.n );
+            throw std::runtime_error( bf );
+        }
+    }
+    return r;
+}
+
+Value
+get_parameter_ref( Value root, std::string_view strPath ) {
+    PathTokenizer t( strPath );
+    PathToken tok;
+    while( t.next(tok) ) {
+        root = get_entry( root, tok );
+    }
+    return root;
+}
+
+std::shared_ptr<AbstractParameter>
+to_parameters( Value v ) {
+    switch( v.type_code() ) {
+        case kLogic :
+            return std::make_shared<Parameter<bool> >( v.as<bool>() );
+        case kInt :
+            return std::make_shared<Parameter<int> >( v.as<int>() );
+        case kReal :
+            return std::make_shared<Parameter<double> >( v.as<double>() );
+        case kString :
+            return std::make_shared<Parameter<std::string> >( std::string(v.as<std::string>()) );
+        case kDict : {
+            auto d = std::make_shared<Dictionary>();
+            Value k = v.first();
+            for( size_t n = 0; n < v.size(); ++n ) {
+                Value val = k.next();
+                d->insert_or_assign( std::string(k.as<std::string>())
+                                   , to_parameters( val ) );
+                k = val.next();
+            }
+            return d;
+        }
+        case kTuple : {
+            auto t = std::make_shared<Tuple>();
+            Value e = v.first();
+            for( size_t n = 0; n < v.size(); ++n, e = e.next() ) {
+                t->emplace_hint( t->end(), n, to_parameters( e ) );
+            }
+            return t;
+        }
+        default :
+            throw std::runtime_error( "Unexpected JSON entry type." );
+    };
+}
+
+}  // namespace ::dataflow::config::json
+}  // namespace ::dataflow::config
+}  // namespace ::dataflow
@@ -0,0 +1,169 @@
+# include "parameters/overlay.hpp"
+
+# include <cstdio>
+
+namespace dataflow {
+namespace config {
+
+template<typename T> static std::shared_ptr<AbstractParameter>
+_copy( const AbstractParameter & p ) {
+    return std::make_shared<T>( static_cast<const T &>(p) );
+}
+
+std::shared_ptr<AbstractParameter>
+shallow_copy( const AbstractParameter & p ) {
+    switch( p.type_code() ) {
+        case kDict : return _copy<Dictionary>(p);
+        case kTuple : return _copy<Tuple>(p);
+        case kLogic : return _copy<Parameter<bool> >(p);
+        case kInt : return _copy<Parameter<int> >(p);
+        case kReal : return _copy<Parameter<double> >(p);
+        case kString : return _copy<Parameter<std::string> >(p);
+        case kRealArray : return _copy<Parameter<RealArray> >(p);
+        case kIntArray : return _copy<Parameter<IntArray> >(p);
+    };
+    char bf[64];
+    snprintf( bf, sizeof(bf), "Unable to copy parameter of type %#x."
+            , (int) p.type_code() );
+    throw std::runtime_error( bf );
+}
+
+/// Throws exception if token can not dereference the container.
+static void
+_check_container( const AbstractParameter & c, const PathToken & tok, const char * what="set" ) {
+    if( tok.isStr ? kDict == c.type_code() : kTuple == c.type_code() ) return;
+    char bf[128];
+    if( tok.isStr ) {
+        snprintf( bf, sizeof(bf)
+                , "Unable to %s \"%.*s\" in %p: not a dictionary."
+                , what, (int) tok.str.size(), tok.str.data(), &c );
+    } else {
+        snprintf( bf, sizeof(bf)
+                , "Unable to %s #%zu in %p: not a list.", what, tok.n, &c );
+    }
+    throw std::runtime_error( bf );
+}
+
+Overlay::Overlay( std::shared_ptr<const AbstractParameter> base )
+        : _root( std::const_pointer_cast<AbstractParameter>(base) ) {}
+
+AbstractParameter &
+Overlay::_own( std::shared_ptr<AbstractParameter> & p ) {
+    if( !_owned.count( p.get() ) ) {
+        p = shallow_copy( *p );
+        _owned.insert( p.get() );
+        _keep.push_back( p );
+    }
+    return *p;
+}
+
+std::shared_ptr<AbstractParameter> &
+Overlay::_child( AbstractParameter & c
+               , const PathToken & tok
+               , const PathToken & nextTok ) {
+    _check_container( c, tok );
+    // Container is owned, so the entry may be replaced in place. Note that
+    // try_emplace() and operator[] are counted as modification, covering
+    // the replacement of the entry (see _own()).
+    std::shared_ptr<AbstractParameter> * slot;
+    if( tok.isStr ) {
+        Dictionary & d = static_cast<Dictionary &>(c);
+        slot = &d.try_emplace( std::string(tok.str) ).first->second;
+    } else {
+        slot = &static_cast<Tuple &>(c)[tok.n];
+    }
+    if( !*slot ) {
+        if( nextTok.isStr ) *slot = std::make_shared<Dictionary>();
+        else *slot = std::make_shared<Tuple>();
+        _owned.insert( slot->get() );
+        _keep.push_back( *slot );
+    }
+    return *slot;
+}
+
+void
+Overlay::set( std::string_view strPath
+            , std::shared_ptr<const AbstractParameter> value ) {
+    PathTokens toks( strPath );
+    auto v = std::const_pointer_cast<AbstractParameter>(value);
+    if( toks.empty() ) {
+        _root = v;
+        return;
+    }
+    AbstractParameter * c = &_own( _root );
+    for( size_t i = 0; i + 1 < toks.size(); ++i ) {
+        c = &_own( _child( *c, toks[i], toks[i+1] ) );
+    }
+    const PathToken & last = toks[toks.size() - 1];
+    _check_container( *c, last );
+    if( last.isStr ) {
+        static_cast<Dictionary *>(c)->insert_or_assign( std::string(last.str), v );
+    } else {
+        static_cast<Tuple *>(c)->insert_or_assign( last.n, v );
+    }
+}
+
+bool
+Overlay::erase( std::string_view strPath ) {
+    PathTokens toks( strPath );
+    if( toks.empty() || !find_parameter( *_root, strPath ) ) return false;
+    AbstractParameter * c = &_own( _root );
+    for( size_t i = 0; i + 1 < toks.size(); ++i ) {
+        c = &_own( _child( *c, toks[i], toks[i+1] ) );
+    }
+    const PathToken & last = toks[toks.size() - 1];
+    // elements of dense arrays can not be removed
+    _check_container( *c, last, "erase" );
+    if( last.isStr ) {
+        Dictionary & d = static_cast<Dictionary &>(*c);
+        d.erase( d.find( last.str ) );
+    } else {
+        static_cast<Tuple *>(c)->erase( last.n );
+    }
+    return true;
+}
+
+void
+Overlay::_merge( std::shared_ptr<AbstractParameter> & dst
+               , const std::shared_ptr<AbstractParameter> & src ) {
+    if( !dst || !src || dst->type_code() != src->type_code()
+     || !(src->type_code() & (kDict | kTuple)) ) {
+        dst = src;
+        return;
+    }
+    AbstractParameter & c = _own( dst );
+    if( kDict == c.type_code() ) {
+        Dictionary & d = static_cast<Dictionary &>(c);
+        for( const auto & e : static_cast<const Dictionary &>(*src) ) {
+            _merge( d[e.first], e.second );
+        }
+    } else {
+        Tuple & t = static_cast<Tuple &>(c);
+        for( const auto & e : static_cast<const Tuple &>(*src) ) {
+            _merge( t[e.first], e.second );
+        }
+    }
+}
+
+void
+Overlay::merge( std::shared_ptr<const AbstractParameter> patch ) {
+    _merge( _root, std::const_pointer_cast<AbstractParameter>(patch) );
+}
+
+std::shared_ptr<const AbstractParameter>
+Overlay::result() {
+    _owned.clear();
+    _keep.clear();
+    return _root;
+}
+
+std::shared_ptr<const AbstractParameter>
+overlay( std::shared_ptr<const AbstractParameter> base
+       , std::shared_ptr<const AbstractParameter> patch ) {
+    Overlay o( base );
+    o.merge( patch );
+    return o.result();
+}
+
+}  // namespace ::dataflow::config
+}  // namespace ::dataflow
@@ -0,0 +1,16 @@
+# include "parameters/parameter.tcc"
+
+# include <cstdio>
+
+namespace dataflow {
+namespace config {
+
+BadParameterType::BadParameterType( ParameterType actual
+                                  , ParameterType expected ) {
+    snprintf( _bf, sizeof(_bf)
+            , "Parameter is of type %#x while %#x expected."
+            , (int) actual, (int) expected );
+}
+
+}  // namespace ::dataflow::config
+}  // namespace ::dataflow
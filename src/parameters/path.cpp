@@ -1,18 +1,15 @@
 # include "parameters/path.hpp"
 
+# include <algorithm>
+# include <cstdint>
+# include <cstdio>
 # include <cstring>
-# include <regex>
-
-static std::regex gReStrPathTok( "^[a-zA-Z_][a-zA-Z0-9_]*$" )
-                , gReIntPathTok( "^0|([1-9][0-9]*)$" )
-                ;
 
 namespace dataflow {
 namespace config {
 
 const char gPathDelimeter = '.';
 const char gIndexBrackets[2] = { '[', ']' };
-static const char _gDelims[] = { gPathDelimeter, gIndexBrackets[0], '\0' };
 
 InvalidPathString::InvalidPathString( const char * reason ) :
     std::runtime_error(reason) {}
@@ -35,52 +32,149 @@ InvalidPathString::what() const throw () {
     return _bf;
 }
 
-Path *
-Path::from_string( const std::string & strPath ) {
-    if( strPath.empty() ) return nullptr;
-    Path * result;
-    size_t nextTokStart;
-    std::string cToken;
-    if( gIndexBrackets[0] == strPath[0] ) {
-        cToken = strPath.substr(1, (nextTokStart = strPath.find(gIndexBrackets[1]))-1 );
-        if( ! std::regex_match(cToken, gReIntPathTok ) ) {
-            char bf[128];
-            snprintf( bf, sizeof(bf), "Bad integer path token: \"%s\""
-                    , cToken.c_str() );
-            throw InvalidPathString( bf );
+//
+// Tokenizer
+
+static inline bool
+_is_ident_head( char c ) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || '_' == c;
+}
+
+static inline bool
+_is_digit( char c ) {
+    return c >= '0' && c <= '9';
+}
+
+static inline bool
+_is_ident_tail( char c ) {
+    return _is_ident_head(c) || _is_digit(c);
+}
+
+void
+PathTokenizer::_throw( const char * reason, size_t tokStart ) const {
+    InvalidPathString e( reason );
+    // Re-tokenize the (valid) prefix to provide the stack of tokens being
+    // parsed. Pushed in reverse order to keep the order of the former
+    // recursive implementation (innermost token first).
+    std::list<std::string> toks;
+    PathTokenizer prefix( _src.substr(0, tokStart) );
+    PathToken tok;
+    try {
+        while( prefix.next(tok) ) {
+            toks.push_front( tok.isStr ? std::string(tok.str)
+                                       : std::to_string(tok.n) );
         }
-        result = new Path( std::stol( cToken ));
-        // todo: ^^^ octal/hex literals
-        if( std::string::npos == nextTokStart ) {
-            delete result;
-            throw InvalidPathString( "Unbalanced brackets." );
+    } catch( InvalidPathString & ) {
+        // Prefix terminates with a delimiter: nothing else to add.
+    }
+    for( const auto & t : toks ) e.push_token(t);
+    throw e;
+}
+
+bool
+PathTokenizer::next( PathToken & tok ) {
+    if( _pos >= _src.size() ) return false;
+    const size_t tokStart = _pos;
+    char bf[128];
+    if( gIndexBrackets[0] == _src[_pos] ) {
+        // integer token: `[<digits>]'
+        const size_t closing = _src.find( gIndexBrackets[1], _pos + 1 );
+        if( std::string_view::npos == closing ) {
+            _throw( "Unbalanced brackets.", tokStart );
         }
-        ++nextTokStart;
-        if( gPathDelimeter == strPath[nextTokStart] ) ++nextTokStart;
+        const std::string_view digits = _src.substr( _pos + 1
+                                                   , closing - _pos - 1 );
+        bool good = !digits.empty()
+                 && !( '0' == digits[0] && digits.size() > 1 );
+        size_t n = 0;
+        for( auto c : digits ) {
+            if( !good ) break;
+            if( !_is_digit(c) || n > (SIZE_MAX - (c - '0'))/10 ) {
+                good = false;
+                break;
+            }
+            n = n*10 + (c - '0');
+        }
+        if( ! good ) {
+            snprintf( bf, sizeof(bf), "Bad integer path token: \"%.*s\""
+                    , (int) digits.size(), digits.data() );
+            _throw( bf, tokStart );
+        }
+        tok.isStr = false;
+        tok.n = n;
+        _pos = closing + 1;
     } else {
-        nextTokStart = strPath.find_first_of( _gDelims );
-        result = new Path( cToken = strPath.substr(0, nextTokStart) );
-        if( nextTokStart != std::string::npos 
-         && strPath[nextTokStart] != gIndexBrackets[0] ) ++nextTokStart;
-    }
-    # if 0
-    // XXX, Useful to debug complex cases
-    std::cout << " + token \"" << cToken << "\", "
-              << nextTokStart
-              << " ? "
-              << strPath.size() << std::endl;
-    # endif
+        // string token, possibly preceded by delimiter
+        if( gPathDelimeter == _src[_pos] && _pos ) ++_pos;
+        size_t end = _pos;
+        while( end < _src.size()
+            && gPathDelimeter != _src[end]
+            && gIndexBrackets[0] != _src[end] ) ++end;
+        const std::string_view word = _src.substr( _pos, end - _pos );
+        if( word.empty() ) {
+            _throw( "Empty path str-token provided", tokStart );
+        }
+        bool good = _is_ident_head(word[0]);
+        for( size_t i = 1; good && i < word.size(); ++i ) {
+            good = _is_ident_tail(word[i]);
+        }
+        if( ! good ) {
+            snprintf( bf, sizeof(bf), "Bad string path token: \"%.*s\""
+                    , (int) word.size(), word.data() );
+            _throw( bf, tokStart );
+        }
+        tok.isStr = true;
+        tok.str = word;
+        _pos = end;
+    }
+    // Only delimiter, opening bracket or end of string may follow the token
+    if( _pos < _src.size()
+     && gPathDelimeter != _src[_pos]
+     && gIndexBrackets[0] != _src[_pos] ) {
+        _throw( "Path token is not delimited.", _pos );
+    }
+    return true;
+}
+
+void
+PathTokens::assign( std::string_view strPath ) {
+    clear();
+    PathTokenizer t( strPath );
+    PathToken tok;
+    while( t.next(tok) ) push_back(tok);
+}
+
+void
+PathTokens::push_back( const PathToken & tok ) {
+    if( _size == _capacity ) {
+        std::unique_ptr<PathToken[]> newData( new PathToken [2*_capacity] );
+        std::copy( _data, _data + _size, newData.get() );
+        _heap = std::move(newData);
+        _data = _heap.get();
+        _capacity *= 2;
+    }
+    _data[_size++] = tok;
+}
+
+//
+// Path
+
+Path *
+Path::from_string( const std::string & strPath ) {
+    Path * head = nullptr
+       , ** tail = &head;
+    PathTokenizer t( strPath );
+    PathToken tok;
     try {
-        if( nextTokStart < strPath.size() ) {
-            result->_next = from_string( strPath.substr( nextTokStart
-                                                       , std::string::npos) );
+        while( t.next(tok) ) {
+            *tail = tok.isStr ? new Path( tok.str ) : new Path( tok.n );
+            tail = &((*tail)->_next);
         }
-    } catch( InvalidPathString & e ) {
-        e.push_token( cToken );
-        delete result;
-        throw e;
+    } catch( InvalidPathString & ) {
+        delete head;
+        throw;
     }
-    return result;
+    return head;
 }
 
 Path::Path( size_t index ) : _isStr(false)
@@ -88,29 +182,25 @@ Path::Path( size_t index ) : _isStr(false)
     _key.n = index;
 }
 
-Path::Path( const std::string & strTok ) : _isStr(false)  // protect from delete on failure
-                                         , _next(nullptr) {
+Path::Path( std::string_view strTok ) : _isStr(true)
+                                      , _next(nullptr) {
     if( strTok.empty() ) {
         throw InvalidPathString( "Empty path str-token provided" );
     }
-    if( !std::regex_match(strTok, gReStrPathTok) ) {
-        char bf[128];
-        snprintf( bf, sizeof(bf), "Bad string path token: \"%s\""
-                , strTok.c_str() );
-        throw InvalidPathString( bf );
-    }
-    _key.str = new char [ strTok.size() + 1 ];
-    _isStr = true;  // set it now -- dtr is now responsible for cleaning
-    strncpy( _key.str, strTok.c_str(), strTok.size() );
-    _key.str[strTok.size()] = '\0';
+    _key.sym = Symbol( strTok ).id();
 }
 
 const char *
 Path::str_first() const {
+    return symbol().c_str();
+}
+
+Symbol
+Path::symbol() const {
     if( ! is_str() ) {
         throw std::runtime_error( "Path token is an index while string requested." );
     }
-    return _key.str;
+    return Symbol::from_id( _key.sym );
 }
 
 size_t
@@ -134,37 +224,189 @@ operator<<( std::ostream & os, const Path & path ) {
     return os;
 }
 
-AbstractParameter &
-get_parameter_ref( AbstractParameter & root
-                 , const Path * pathPtr ) {
-    if( !pathPtr ) return root;
-    if( pathPtr->is_str() ) {
-        if( ! (root.type_code() & kDict) ) {
-            char bf[128];
+const AbstractParameter *
+find_entry( const AbstractParameter & c
+          , const PathToken & tok ) {
+    char bf[128];
+    if( tok.isStr ) {
+        if( ! (c.type_code() & kDict) ) {
             snprintf( bf, sizeof(bf)
-                    , "Unable to retrieve \"%s\" from %p: not a dictionary."
-                    , pathPtr->str_first()
-                    , &root );
+                    , "Unable to retrieve \"%.*s\" from %p: not a dictionary."
+                    , (int) tok.str.size(), tok.str.data()
+                    , &c );
             throw std::runtime_error( bf );
         }
-        Dictionary & d = static_cast<Dictionary &>( root );
-        return get_parameter_ref( *d[pathPtr->str_first()]
-                                , pathPtr->next() );
+        const Dictionary & d = static_cast<const Dictionary &>( c );
+        auto it = d.find( tok.str );
+        return d.end() == it ? nullptr : it->second.get();
     } else {
-        if( ! (root.type_code() & kTuple) ) {
-            char bf[128];
+        if( array_element_type( c.type_code() ) ) {
+            snprintf( bf, sizeof(bf)
+                    , "Unable to retrieve #%zu from %p: elements of dense"
+                      " array are not parameters."
+                    , tok.n
+                    , &c );
+            throw std::runtime_error( bf );
+        }
+        if( ! (c.type_code() & kTuple) ) {
             snprintf( bf, sizeof(bf)
-                    , "Unable to retrieve #%d from %p: not a list."
-                    , pathPtr->_key.n
-                    , &root );
+                    , "Unable to retrieve #%zu from %p: not a list."
+                    , tok.n
+                    , &c );
             throw std::runtime_error( bf );
         }
-        Tuple & t = static_cast<Tuple &>( root );
-        return get_parameter_ref( *t[pathPtr->n()]
-                                , pathPtr->next() );
+        const Tuple & t = static_cast<const Tuple &>( c );
+        auto it = t.find( tok.n );
+        return t.end() == it ? nullptr : it->second.get();
+    }
+}
+
+const AbstractParameter &
+get_entry( const AbstractParameter & c
+         , const PathToken & tok ) {
+    const AbstractParameter * r = find_entry( c, tok );
+    if( r ) return *r;
+    char bf[128];
+    if( tok.isStr ) {
+        snprintf( bf, sizeof(bf)
+                , "No entry \"%.*s\" in dictionary %p."
+                , (int) tok.str.size(), tok.str.data()
+                , &c );
+    } else {
+        snprintf( bf, sizeof(bf)
+                , "No entry #%zu in list %p."
+                , tok.n
+                , &c );
+    }
+    throw std::runtime_error( bf );
+}
+
+const AbstractParameter &
+get_parameter_ref( const AbstractParameter & root
+                 , const Path * pathPtr ) {
+    const AbstractParameter * c = &root;
+    for( ; pathPtr; pathPtr = pathPtr->next() ) {
+        PathToken tok;
+        if( (tok.isStr = pathPtr->is_str()) ) {
+            // symbol is known, so the lookup compares integers only
+            if( c->type_code() & kDict ) {
+                const Dictionary & d = static_cast<const Dictionary &>( *c );
+                auto it = d.find( pathPtr->symbol() );
+                if( d.end() != it ) {
+                    c = it->second.get();
+                    continue;
+                }
+            }
+            tok.str = pathPtr->str_first();  // reports error
+        } else {
+            tok.n = pathPtr->n();
+        }
+        c = &get_entry( *c, tok );
+    }
+    return *c;
+}
+
+const AbstractParameter &
+get_parameter_ref( const AbstractParameter & root
+                 , std::string_view strPath ) {
+    const AbstractParameter * c = &root;
+    PathTokenizer t( strPath );
+    PathToken tok;
+    while( t.next(tok) ) {
+        c = &get_entry( *c, tok );
+    }
+    return *c;
+}
+
+const AbstractParameter *
+find_parameter( const AbstractParameter & root
+              , std::string_view strPath ) {
+    const AbstractParameter * c = &root;
+    PathTokenizer t( strPath );
+    PathToken tok;
+    while( c && t.next(tok) ) {
+        c = find_entry( *c, tok );
+    }
+    return c;
+}
+
+namespace aux {
+
+const void *
+value_ptr( const AbstractParameter & p, ParameterType expected ) {
+    if( expected != p.type_code() ) {
+        throw BadParameterType( p.type_code(), expected );
+    }
+    switch( expected ) {
+        case kLogic :
+            return static_cast<const Parameter<bool> &>(p).value_ptr();
+        case kInt :
+            return static_cast<const Parameter<int> &>(p).value_ptr();
+        case kReal :
+            return static_cast<const Parameter<double> &>(p).value_ptr();
+        case kString :
+            return static_cast<const Parameter<std::string> &>(p).value_ptr();
+        case kRealArray :
+            return static_cast<const Parameter<RealArray> &>(p).value_ptr();
+        case kIntArray :
+            return static_cast<const Parameter<IntArray> &>(p).value_ptr();
+        default :
+            return &p;  // containers
+    };
+}
+
+const void *
+find_array_element( const AbstractParameter & arr, size_t n ) {
+    if( kRealArray == arr.type_code() ) {
+        const RealArray & a = arr.as_unchecked<RealArray>();
+        return n < a.size() ? a.data() + n : nullptr;
+    }
+    const IntArray & a = arr.as_unchecked<IntArray>();
+    return n < a.size() ? a.data() + n : nullptr;
+}
+
+const void *
+array_element_ptr( const AbstractParameter & arr
+                 , size_t n
+                 , ParameterType expected ) {
+    const ParameterType elType = array_element_type( arr.type_code() );
+    if( expected != elType ) {
+        throw BadParameterType( elType ? elType : arr.type_code(), expected );
+    }
+    const void * data = find_array_element( arr, n );
+    if( !data ) {
+        char bf[128];
+        snprintf( bf, sizeof(bf)
+                , "No entry #%zu in array %p of size %zu."
+                , n, &arr, kRealArray == arr.type_code()
+                         ? arr.as_unchecked<RealArray>().size()
+                         : arr.as_unchecked<IntArray>().size() );
+        throw std::runtime_error( bf );
+    }
+    return data;
+}
+
+const void *
+get_value_ptr( const AbstractParameter & root
+             , std::string_view strPath
+             , ParameterType expected ) {
+    const AbstractParameter * c = &root;
+    PathTokenizer t( strPath );
+    PathToken tok;
+    while( t.next(tok) ) {
+        if( !tok.isStr && array_element_type( c->type_code() ) ) {
+            const void * r = array_element_ptr( *c, tok.n, expected );
+            if( t.next(tok) ) {
+                throw std::runtime_error( "Path refers past the array element." );
+            }
+            return r;
+        }
+        c = &get_entry( *c, tok );
     }
+    return value_ptr( *c, expected );
 }
 
+}  // namespace ::dataflow::config::aux
 
 }  // namespace ::dataflow::config
 }  // namespace ::dataflow
@@ -0,0 +1,97 @@
+# include "parameters/schema.hpp"
+
+# include <cstring>
+
+namespace dataflow {
+namespace config {
+
+static std::string
+_join_errors( const std::list<std::string> & errors ) {
+    std::string r = "Configuration does not conform the schema:";
+    for( const auto & e : errors ) {
+        r += " ";
+        r += e;
+        r += ";";
+    }
+    return r;
+}
+
+SchemaError::SchemaError( const std::list<std::string> & errors )
+        : std::runtime_error( _join_errors(errors) )
+        , _errors( errors ) {}
+
+namespace aux {
+
+bool
+SchemaApplication::find( const char * path
+                       , ParameterType expected
+                       , const void *& dest ) {
+    const std::string_view strPath( path );
+    // split the path to parent path and last token
+    size_t n = strPath.find_last_of( ".[" );
+    std::string_view parentPath, lastTok;
+    if( std::string_view::npos == n ) {
+        lastTok = strPath;
+    } else {
+        parentPath = strPath.substr( 0, n );
+        lastTok = strPath.substr( '.' == strPath[n] ? n + 1 : n );
+    }
+    if( !resolved || parentPath != prefix ) {
+        // missing parent and traversal error are cached as well
+        prefix = parentPath;
+        resolved = true;
+        parent = nullptr;
+        parentError.clear();
+        try {
+            parent = find_parameter( *root, parentPath );
+        } catch( std::runtime_error & e ) {
+            parentError = e.what();
+        }
+    }
+    if( !parentError.empty() ) {
+        error( path, parentError.c_str() );
+        return false;
+    }
+    dest = nullptr;
+    if( !parent ) return true;
+    try {
+        PathTokenizer t( lastTok );
+        PathToken tok;
+        const bool hasTok = t.next( tok );
+        const ParameterType elType = array_element_type( parent->type_code() );
+        if( hasTok && !tok.isStr && elType ) {
+            // element of dense array is read in place
+            if( expected != elType ) {
+                error( path, "parameter type mismatch" );
+                return false;
+            }
+            dest = find_array_element( *parent, tok.n );
+            return true;
+        }
+        const AbstractParameter * p = hasTok ? find_entry( *parent, tok ) : parent;
+        if( !p ) return true;
+        if( expected != p->type_code() ) {
+            error( path, "parameter type mismatch" );
+            return false;
+        }
+        dest = value_ptr( *p, expected );
+        return true;
+    } catch( std::runtime_error & e ) {
+        error( path, e.what() );
+        return false;
+    }
+}
+
+void
+SchemaApplication::error( const char * path, const char * what ) {
+    std::string msg = "\"";
+    msg += path;
+    msg += "\": ";
+    msg += what;
+    errors.push_back( msg );
+}
+
+}  // namespace ::dataflow::config::aux
+
+}  // namespace ::dataflow::config
+}  // namespace ::dataflow
@@ -0,0 +1,81 @@
+# include "parameters/symbol.hpp"
+
+# include <stdexcept>
+
+namespace dataflow {
+namespace config {
+
+static size_t
+_hash( std::string_view s ) {
+    return std::hash<std::string_view>()( s );
+}
+
+SymbolTable::SymbolTable() : _size( 1 ) {
+    for( auto & c : _chunks ) c.store( nullptr, std::memory_order_relaxed );
+    _chunks[0].store( new std::string [1u << kChunkBits], std::memory_order_release );
+    Index * ix = new Index{ 1023, std::unique_ptr<std::atomic<uint32_t>[]>(
+                            new std::atomic<uint32_t> [1024] ), nullptr };
+    for( size_t i = 0; i <= ix->mask; ++i ) ix->slots[i].store( 0, std::memory_order_relaxed );
+    _insert( *ix, 0, _hash( "" ) );  // empty string
+    _index.store( ix, std::memory_order_release );
+}
+
+SymbolTable &
+SymbolTable::self() {
+    // never deleted: symbols may be used by the static objects' destructors
+    static SymbolTable * table = new SymbolTable();
+    return *table;
+}
+
+void
+SymbolTable::_insert( Index & ix, uint32_t id, size_t hash ) {
+    size_t i = hash & ix.mask;
+    while( ix.slots[i].load( std::memory_order_relaxed ) ) i = (i + 1) & ix.mask;
+    ix.slots[i].store( id + 1, std::memory_order_release );
+}
+
+bool
+SymbolTable::find( std::string_view s, uint32_t & id ) const {
+    const Index & ix = *_index.load( std::memory_order_acquire );
+    for( size_t i = _hash( s ) & ix.mask; ; i = (i + 1) & ix.mask ) {
+        const uint32_t v = ix.slots[i].load( std::memory_order_acquire );
+        if( !v ) return false;
+        if( str( v - 1 ) == s ) {
+            id = v - 1;
+            return true;
+        }
+    }
+}
+
+uint32_t
+SymbolTable::intern( std::string_view s ) {
+    uint32_t id;
+    if( find( s, id ) ) return id;
+    std::lock_guard<std::mutex> lock( _mutex );
+    if( find( s, id ) ) return id;  // interned meanwhile
+    id = _size.load( std::memory_order_relaxed );
+    const size_t nChunk = id >> kChunkBits;
+    if( nChunk >= kMaxChunks ) throw std::length_error( "Symbol table is full." );
+    std::string * chunk = _chunks[nChunk].load( std::memory_order_relaxed );
+    if( !chunk ) chunk = new std::string [1u << kChunkBits];
+    chunk[id & ((1u << kChunkBits) - 1)].assign( s.data(), s.size() );
+    // string is set before it may be found by lock-free readers
+    _chunks[nChunk].store( chunk, std::memory_order_release );
+    Index * ix = _index.load( std::memory_order_relaxed );
+    if( 2*(id + 1) > ix->mask + 1 ) {
+        const size_t capacity = 2*(ix->mask + 1);
+        Index * grown = new Index{ capacity - 1, std::unique_ptr<std::atomic<uint32_t>[]>(
+                                   new std::atomic<uint32_t> [capacity] ), nullptr };
+        for( size_t i = 0; i < capacity; ++i ) grown->slots[i].store( 0, std::memory_order_relaxed );
+        for( uint32_t n = 0; n < id; ++n ) _insert( *grown, n, _hash( str(n) ) );
+        grown->previous.reset( ix );
+        _index.store( grown, std::memory_order_release );
+        ix = grown;
+    }
+    _insert( *ix, id, _hash( s ) );
+    _size.store( id + 1, std::memory_order_release );
+    return id;
+}
+
+}  // namespace ::dataflow::config
+}  // namespace ::dataflow
@@ -0,0 +1,69 @@
+# include "pipeline/accumulators.hpp"
+
+# include <algorithm>
+
+namespace dataflow {
+
+namespace aux {
+
+/// Slots of the threads: number of slots ever taken, and the ones released
+static std::mutex gSlotsMutex;
+static unsigned gNSlots = 0;
+static std::vector<unsigned> gFreeSlots;
+
+static unsigned
+_acquire_slot() {
+    std::lock_guard<std::mutex> lock( gSlotsMutex );
+    if( !gFreeSlots.empty() ) {
+        const unsigned id = gFreeSlots.back();
+        gFreeSlots.pop_back();
+        return id;
+    }
+    if( gNSlots == kMaxThreadSlots ) {
+        throw std::length_error( "Too many threads fill sharded accumulators." );
+    }
+    return gNSlots++;
+}
+
+ThreadSlot::ThreadSlot() : id( _acquire_slot() ) {}
+
+ThreadSlot::~ThreadSlot() {
+    // the next thread taking the slot continues filling the same shards
+    std::lock_guard<std::mutex> lock( gSlotsMutex );
+    gFreeSlots.push_back( id );
+}
+
+}  // namespace ::dataflow::aux
+
+void
+Moments::merge( const Moments & o ) {
+    const uint64_t na = count(), nb = o.count();
+    if( !nb ) return;
+    const uint64_t n = na + nb;
+    const double d = o.mean() - mean();
+    _mean.store( mean() + d*nb/n );
+    _m2.store( _m2.load() + o._m2.load() + d*d*(double(na)*nb/n) );
+    _n.store( n );
+}
+
+FixedAxis::FixedAxis( size_t n, double lo, double hi )
+        : _n(n), _lo(lo), _hi(hi), _scale( n/(hi - lo) ) {
+    if( !n ) throw BadBinning( "Axis has no bins." );
+    if( !(lo < hi) ) throw BadBinning( "Lower edge of the axis is not below the upper one." );
+}
+
+VariableAxis::VariableAxis( std::vector<double> edges ) : _edges( std::move(edges) ) {
+    if( _edges.size() < 2 ) throw BadBinning( "Axis has no bins." );
+    for( size_t i = 1; i < _edges.size(); ++i ) {
+        if( _edges[i - 1] < _edges[i] ) continue;
+        throw BadBinning( "Edges of the axis are not increasing." );
+    }
+}
+
+size_t
+VariableAxis::index( double x ) const {
+    if( !(x >= _edges.front()) ) return 0;
+    return std::upper_bound( _edges.begin(), _edges.end(), x ) - _edges.begin();
+}
+
+}  // namespace ::dataflow
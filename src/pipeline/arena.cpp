@@ -0,0 +1,61 @@
+# include "pipeline/arena.hpp"
+
+# include <algorithm>
+
+namespace dataflow {
+
+Arena::Arena( size_t chunkSize, std::pmr::memory_resource * upstream )
+        : _chunkSize( std::max( chunkSize, size_t(256) ) )
+        , _upstream( upstream )
+        , _first(nullptr), _current(nullptr)
+        , _ptr(nullptr), _end(nullptr)
+        , _nAllocations(0), _nBytes(0)
+        , _nChunks(0), _capacity(0) {}
+
+Arena::~Arena() {
+    for( Chunk * c = _first; c; ) {
+        Chunk * next = c->next;
+        _upstream->deallocate( c, sizeof(Chunk) + c->size, alignof(std::max_align_t) );
+        c = next;
+    }
+}
+
+void *
+Arena::_allocate_slow( size_t bytes, size_t alignment ) {
+    // use the next chunk kept since previous events, if it is large enough
+    Chunk * next = _current ? _current->next : _first;
+    if( !next || next->size < bytes + alignment ) {
+        const size_t size = std::max( _chunkSize, bytes + alignment );
+        Chunk * c = static_cast<Chunk *>( _upstream->allocate( sizeof(Chunk) + size
+                                                             , alignof(std::max_align_t) ) );
+        c->size = size;
+        c->next = next;
+        if( _current ) _current->next = c;
+        else _first = c;
+        next = c;
+        ++_nChunks;
+        _capacity += size;
+    }
+    _current = next;
+    _ptr = next->data();
+    _end = _ptr + next->size;
+    return do_allocate( bytes, alignment );
+}
+
+static thread_local std::pmr::memory_resource * _eventArena = nullptr;
+
+std::pmr::memory_resource *
+event_arena() {
+    return _eventArena ? _eventArena : std::pmr::get_default_resource();
+}
+
+namespace aux {
+std::pmr::memory_resource *
+set_event_arena( std::pmr::memory_resource * mr ) {
+    std::pmr::memory_resource * prev = _eventArena;
+    _eventArena = mr;
+    return prev;
+}
+}  // namespace ::dataflow::aux
+
+}  // namespace ::dataflow
@@ -0,0 +1,142 @@
+# include "pipeline/cuts.hpp"
+
+# include <algorithm>
+# include <limits>
+
+namespace dataflow {
+
+CutGroup::CutGroup( unsigned sampling, unsigned nSamples )
+        : _input( PortType::of<void>() )
+        , _sampling( std::max( sampling, 1u ) )
+        , _nSamples( std::max( nSamples, 1u ) )
+        , _countdown( 1 )  // first value is sampled
+        , _nSampled( 0 )
+        , _nReorders( 0 ) {}
+
+void
+CutGroup::_add( Cut c, const PortType & input ) {
+    if( !_cuts.empty() && input != _input ) {
+        throw IncompatibleHandlers( "Cut \"" + c.name + "\" accepts " + input.index.name()
+                                  + " while group accepts " + _input.index.name() + "." );
+    }
+    for( const Cut & other : _cuts ) {
+        if( other.name == c.name ) {
+            throw IncompatibleHandlers( "Cut \"" + c.name + "\" is already in the group." );
+        }
+    }
+    _input = input;
+    _cuts.push_back( std::move(c) );
+}
+
+CutGroup &
+CutGroup::add( const std::string & name ) {
+    const HandlerDescription & d = HandlersIndex::self().get( name );
+    if( kCut != d.kind || d.construct || !d.invoke_read ) {
+        throw IncompatibleHandlers( "Handler \"" + name + "\" is not a stateless cut"
+                                    " not modifying its value." );
+    }
+    _add( Cut{ name, d.invoke, d.invoke_batch, 0, 0, 0 }, d.input );
+    return *this;
+}
+
+bool
+CutGroup::_sample( Slot & v ) {
+    // all the cuts are evaluated, so rates do not depend on the order
+    _countdown = _sampling;
+    bool passed = true;
+    for( Cut & c : _cuts ) {
+        const uint64_t t0 = aux::ticks();
+        const bool p = c.invoke( nullptr, v );
+        c.nTicks += aux::ticks() - t0;
+        c.nSampled += 1;
+        c.nRejected += !p;
+        passed = passed && p;
+    }
+    if( ++_nSampled >= _nSamples ) {
+        _reorder();
+        // older samples weigh less, so the order follows the data
+        for( Cut & c : _cuts ) {
+            c.nSampled /= 2;
+            c.nRejected /= 2;
+            c.nTicks /= 2;
+        }
+    }
+    return passed;
+}
+
+void
+CutGroup::_reorder() {
+    _nSampled = 0;
+    auto rank = []( const Cut & c ) {
+        const double r = c.rejection();
+        return r > 0 ? c.cost()/r : std::numeric_limits<double>::infinity();
+    };
+    std::vector<Cut> ordered( _cuts );
+    std::stable_sort( ordered.begin(), ordered.end()
+                    , [&]( const Cut & a, const Cut & b ) { return rank(a) < rank(b); } );
+    for( size_t i = 0; i < _cuts.size(); ++i ) {
+        if( ordered[i].name == _cuts[i].name ) continue;
+        ++_nReorders;
+        break;
+    }
+    _cuts.swap( ordered );
+}
+
+bool
+CutGroup::_invoke_batch( void * h, Batch & b ) {
+    CutGroup & g = *static_cast<CutGroup *>(h);
+    for( const Cut & c : g._cuts ) {
+        if( !c.invoke_batch( nullptr, b ) ) return false;
+    }
+    return true;
+}
+
+std::shared_ptr<void>
+CutGroup::_clone( const void * h ) {
+    // copy keeps the order, but gathers its own statistics
+    auto g = std::make_shared<CutGroup>( *static_cast<const CutGroup *>(h) );
+    for( Cut & c : g->_cuts ) c.nSampled = c.nRejected = c.nTicks = 0;
+    g->_nSampled = 0;
+    g->_nReorders = 0;
+    return g;
+}
+
+void
+CutGroup::_merge( void * h, const void * copy ) {
+    CutGroup & g = *static_cast<CutGroup *>(h);
+    const CutGroup & o = *static_cast<const CutGroup *>(copy);
+    for( Cut & c : g._cuts ) {
+        for( const Cut & oc : o._cuts ) {
+            if( oc.name != c.name ) continue;
+            c.nSampled += oc.nSampled;
+            c.nRejected += oc.nRejected;
+            c.nTicks += oc.nTicks;
+            break;
+        }
+    }
+    // statistics is summed with no decay, the order is revised once all
+    // the copies are merged (see _merged())
+    g._nReorders += o._nReorders;
+}
+
+void
+CutGroup::_merged( void * h ) {
+    static_cast<CutGroup *>(h)->_reorder();
+}
+
+Stage
+CutGroup::stage( std::shared_ptr<CutGroup> g, const std::string & name ) {
+    if( g->_cuts.empty() ) throw IncompatibleHandlers( "Cut group \"" + name + "\" is empty." );
+    bool batchable = true;
+    for( const Cut & c : g->_cuts ) batchable = batchable && c.invoke_batch;
+    void * ptr = g.get();
+    Stage s{ &_invoke, batchable ? &_invoke_batch : nullptr, ptr, std::move(g)
+           , static_cast<CutGroup *>(ptr)->_input, static_cast<CutGroup *>(ptr)->_input, name };
+    s.concurrency = kCloned;
+    s.clone = &_clone;
+    s.merge = &_merge;
+    s.merged = &_merged;
+    return s;
+}
+
+}  // namespace ::dataflow
@@ -0,0 +1,55 @@
+# include "pipeline/generator.hpp"
+
+# include <new>
+
+namespace dataflow {
+
+namespace {
+
+/// Free blocks of the thread by size class
+struct FrameCache {
+    static constexpr size_t kNClasses = FramePool::kMaxSize/FramePool::kGranularity;
+    void * free[kNClasses] = {};  ///< Lists linked through the first word
+    size_t nAllocated = 0;
+
+    ~FrameCache() {
+        for( void * p : free ) {
+            while( p ) {
+                void * next = *static_cast<void **>(p);
+                ::operator delete( p );
+                p = next;
+            }
+        }
+    }
+};
+
+thread_local FrameCache gFrames;
+
+}  // anonymous namespace
+
+void *
+FramePool::allocate( size_t n ) {
+    if( !n || n > kMaxSize ) return ::operator new( n );
+    void *& head = gFrames.free[(n - 1)/kGranularity];
+    if( void * p = head ) {
+        head = *static_cast<void **>(p);
+        return p;
+    }
+    ++gFrames.nAllocated;
+    return ::operator new( (n + kGranularity - 1)/kGranularity*kGranularity );
+}
+
+void
+FramePool::deallocate( void * p, size_t n ) noexcept {
+    if( !n || n > kMaxSize ) return ::operator delete( p );
+    void *& head = gFrames.free[(n - 1)/kGranularity];
+    *static_cast<void **>(p) = head;
+    head = p;
+}
+
+size_t
+FramePool::n_allocated() {
+    return gFrames.nAllocated;
+}
+
+}  // namespace ::dataflow
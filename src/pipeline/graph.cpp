@@ -0,0 +1,258 @@
+# include "pipeline/graph.hpp"
+
+# include <algorithm>
+
+namespace dataflow {
+
+const std::string Graph::kInput = "input";
+
+static const unsigned kUnplaced = ~0u;
+
+Graph::Graph( unsigned nWorkers ) : _nAdded(1), _compiled(false) {
+    _nodes.emplace_back( new Node( kInput, PortType::of<void>() ) );
+    _index[kInput] = 0;
+    if( 1 != nWorkers ) _pool.reset( new WorkStealingPool( nWorkers ) );
+}
+
+Graph &
+Graph::_add( std::unique_ptr<Node> n ) {
+    if( _index.count( n->name ) ) {
+        throw BadGraph( "Node \"" + n->name + "\" is already defined." );
+    }
+    _nodes.resize( _nAdded );  // adapters are re-inserted by compilation
+    if( Profiler::enabled ) n->stage.probe = Profiler::self().probe( n->stage.name );
+    _index[n->name] = _nodes.size();
+    _nodes.push_back( std::move(n) );
+    _nAdded = _nodes.size();
+    _compiled = false;
+    return *this;
+}
+
+Graph &
+Graph::add( const std::string & name, const std::string & from, Stage s ) {
+    if( s.expand ) throw BadGraph( "Stage of node \"" + name + "\" is a generator." );
+    if( !s.invoke ) throw BadGraph( "Stage of node \"" + name + "\" has no invoker." );
+    std::unique_ptr<Node> n( new Node( name, s, s.output ) );
+    n->from.push_back( from );
+    n->inputs.push_back( s.input );
+    return _add( std::move(n) );
+}
+
+Graph &
+Graph::add( const std::string & name, const std::string & from, const std::string & handler ) {
+    return add( name, from, HandlersIndex::self().get( handler ).stage( handler ) );
+}
+
+Graph &
+Graph::output( const std::string & name ) {
+    _node( name ).marked = true;
+    _compiled = false;
+    return *this;
+}
+
+Graph::Node &
+Graph::_node( const std::string & name ) const {
+    auto it = _index.find( name );
+    if( _index.end() == it ) throw BadGraph( "Unknown node \"" + name + "\"." );
+    return *_nodes[it->second];
+}
+
+Graph::Node *
+Graph::_connect( Node & p, const PortType & type, const Node & consumer
+               , std::map<std::pair<Node *, TypeId>, Node *> & adapters ) {
+    if( p.output == type ) return &p;
+    // conversion is shared by all the consumers of the same type
+    auto it = adapters.find( std::make_pair( &p, type.id ) );
+    if( adapters.end() != it ) return it->second;
+    Stage a = HandlersIndex::self().adapter( p.output, type );
+    if( !a.invoke ) {
+        throw IncompatibleHandlers( "Node \"" + consumer.name + "\" accepts "
+                                  + type.index.name() + " while node \"" + p.name
+                                  + "\" produces " + p.output.index.name() + "." );
+    }
+    if( Profiler::enabled ) a.probe = Profiler::self().probe( a.name );
+    std::unique_ptr<Node> n( new Node( p.name + " " + a.name, a, type ) );
+    n->from.push_back( p.name );
+    n->inputs.push_back( p.output );
+    n->producers.push_back( &p );
+    Node * ptr = n.get();
+    _nodes.push_back( std::move(n) );
+    adapters[std::make_pair( &p, type.id )] = ptr;
+    return ptr;
+}
+
+void
+Graph::compile() {
+    _nodes.resize( _nAdded );
+    Node & source = *_nodes.front();
+    // type of the input is defined by the first node reading it
+    source.output = PortType::of<void>();
+    for( size_t i = 1; i < _nAdded && source.output == PortType::of<void>(); ++i ) {
+        const Node & n = *_nodes[i];
+        for( size_t k = 0; k < n.from.size(); ++k ) {
+            if( kInput != n.from[k] ) continue;
+            source.output = n.inputs[k];
+            break;
+        }
+    }
+    if( source.output == PortType::of<void>() ) throw BadGraph( "No node reads the graph input." );
+    for( size_t i = 1; i < _nAdded; ++i ) _nodes[i]->producers.clear();
+    std::map<std::pair<Node *, TypeId>, Node *> adapters;
+    for( size_t i = 1; i < _nAdded; ++i ) {
+        Node & n = *_nodes[i];
+        for( size_t k = 0; k < n.from.size(); ++k ) {
+            n.producers.push_back( _connect( _node( n.from[k] ), n.inputs[k], n, adapters ) );
+        }
+    }
+    for( auto & n : _nodes ) n->nConsumers = 0;
+    for( auto & n : _nodes ) for( Node * p : n->producers ) ++p->nConsumers;
+    _outputs.clear();
+    for( size_t i = 1; i < _nodes.size(); ++i ) {
+        Node & n = *_nodes[i];
+        n.exported = n.marked || !n.nConsumers;
+        if( n.exported ) _outputs.push_back( &n );
+    }
+    _sort();
+    // choose how each node obtains its input, in order of execution
+    for( Node * n : _schedule ) {
+        if( n->producers.empty() ) continue;
+        if( n->join ) {
+            n->mode = kJoin;
+            n->exclusive = true;
+            n->args.resize( n->producers.size() );
+            continue;
+        }
+        const Node & p = *n->producers.front();
+        if( p.exclusive && 1 == p.nConsumers && !p.exported ) {
+            n->mode = kInplace;
+            n->exclusive = true;
+        } else if( n->stage.invoke_read ) {
+            // result may be the shared value itself
+            n->mode = kRead;
+            n->exclusive = false;
+        } else if( n->stage.input.copy ) {
+            n->mode = kCopy;
+            n->exclusive = true;
+        } else {
+            throw BadGraph( "Node \"" + n->name + "\" modifies value of node \""
+                          + p.name + "\" shared with other nodes, but "
+                          + p.output.index.name() + " can not be copied." );
+        }
+    }
+    _compiled = true;
+}
+
+void
+Graph::_sort() {
+    std::vector<Node *> pending;
+    for( auto & n : _nodes ) n->depth = kUnplaced;
+    _nodes.front()->depth = 0;
+    for( size_t i = 1; i < _nodes.size(); ++i ) pending.push_back( _nodes[i].get() );
+    while( !pending.empty() ) {
+        size_t nPending = 0;
+        for( Node * n : pending ) {
+            unsigned depth = 0;
+            bool ready = true;
+            for( const Node * p : n->producers ) {
+                if( kUnplaced == p->depth ) { ready = false; break; }
+                depth = std::max( depth, p->depth + 1 );
+            }
+            if( ready ) n->depth = depth;
+            else pending[nPending++] = n;
+        }
+        if( nPending == pending.size() ) {
+            throw BadGraph( "Node \"" + pending.front()->name + "\" depends on itself." );
+        }
+        pending.resize( nPending );
+    }
+    _schedule.clear();
+    for( auto & n : _nodes ) _schedule.push_back( n.get() );
+    std::stable_sort( _schedule.begin(), _schedule.end()
+                    , []( const Node * a, const Node * b ) { return a->depth < b->depth; } );
+    _levels.clear();
+    for( size_t b = 0, e; b < _schedule.size(); b = e ) {
+        Level l{ b, b, false };
+        for( e = b; e < _schedule.size() && _schedule[e]->depth == _schedule[b]->depth; ++e ) {
+            // stateful handler instance shared by nodes of the same depth
+            const Stage & s = _schedule[e]->stage;
+            for( size_t k = b; k < e && s.handler && kReentrant != s.concurrency; ++k ) {
+                l.serial = l.serial || _schedule[k]->stage.handler == s.handler;
+            }
+        }
+        l.end = e;
+        _levels.push_back( l );
+    }
+}
+
+void
+Graph::_begin() {
+    // previous event leaves the graph
+    for( auto & n : _nodes ) {
+        n->value = nullptr;
+        n->own.reset();
+        if( n->arena.used() ) n->arena.reset();
+    }
+}
+
+void
+Graph::_execute( Node & n ) {
+    for( const Node * p : n.producers ) if( !p->value ) return;  // pruned
+    Slot & in = *n.producers.front()->value;
+    aux::EventArenaScope scope( &n.arena );
+    aux::profiled( aux::profile_table(), n.stage.probe, [&]() {
+            switch( n.mode ) {
+                case kInplace:
+                    if( n.stage.invoke( n.stage.handler, in ) ) n.value = &in;
+                    break;
+                case kRead:
+                    if( n.stage.invoke_read( n.stage.handler, in, n.own ) ) {
+                        n.value = n.own.empty() ? &in : &n.own;
+                    }
+                    break;
+                case kCopy:
+                    n.stage.input.copy( n.own, in );
+                    if( n.stage.invoke( n.stage.handler, n.own ) ) n.value = &n.own;
+                    break;
+                case kJoin:
+                    for( size_t i = 0; i < n.producers.size(); ++i ) {
+                        n.args[i] = n.producers[i]->value;
+                    }
+                    if( n.join( n.args.data(), n.own ) ) n.value = &n.own;
+                    break;
+                case kSource:
+                    break;
+            }
+            return nullptr != n.value;
+        } );
+}
+
+void
+Graph::_run() {
+    // first level is the source
+    for( size_t k = 1; k < _levels.size(); ++k ) {
+        const Level & l = _levels[k];
+        if( !_pool || l.serial || l.end - l.begin < 2 ) {
+            for( size_t i = l.begin; i < l.end; ++i ) _execute( *_schedule[i] );
+            continue;
+        }
+        _pool->run( l.end - l.begin, 1, [this, &l]( unsigned, size_t b, size_t e ) {
+                for( size_t i = b; i < e; ++i ) _execute( *_schedule[l.begin + i] );
+            } );
+    }
+}
+
+size_t
+Graph::width() const {
+    size_t w = 0;
+    for( const Level & l : _levels ) w = std::max( w, l.end - l.begin );
+    return w;
+}
+
+void
+Graph::_throw_bad_input( const PortType & t ) const {
+    throw IncompatibleHandlers( std::string("Graph accepts ")
+                              + _nodes.front()->output.index.name()
+                              + " while " + t.index.name() + " is given." );
+}
+
+}  // namespace ::dataflow
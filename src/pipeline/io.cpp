@@ -0,0 +1,290 @@
+# include "pipeline/io.hpp"
+
+# include <cerrno>
+# include <cstdio>
+
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+
+namespace dataflow {
+
+static std::runtime_error
+_system_error( const char * what, const std::string & path ) {
+    char bf[256];
+    snprintf( bf, sizeof(bf), "Unable to %s \"%s\": %s.", what, path.c_str(), strerror(errno) );
+    return std::runtime_error( bf );
+}
+
+//
+// Mapped source
+
+MappedSource::MappedSource( const std::string & path, size_t recordSize, size_t prefetch )
+        : EventSource( recordSize )
+        , _file( path )
+        , _prefetch( prefetch )
+        , _pos( 0 )
+        , _prefetched( 0 ) {
+    _file.advise_sequential();
+}
+
+void
+MappedSource::_advise() {
+    static const size_t page = sysconf( _SC_PAGESIZE );
+    const size_t b = _prefetched & ~(page - 1);
+    const size_t e = std::min( _pos + _prefetch, _file.size() );
+    if( b < e ) {
+        madvise( const_cast<char *>(_file.data()) + b, e - b, MADV_WILLNEED );
+    }
+    _prefetched = _pos + _prefetch;
+}
+
+//
+// Stream source
+
+StreamSource::StreamSource( const std::string & path, size_t recordSize
+                          , unsigned nBuffers, size_t bufferSize )
+        : EventSource( recordSize )
+        , _fd( open( path.c_str(), O_RDONLY ) )
+        , _free( std::max( nBuffers, 1u ) )
+        , _full( std::max( nBuffers, 1u ) + 1 )  // and end marker
+        , _stop( false )
+        , _eof( false )
+        , _cur( nullptr )
+        , _pos( 0 )
+        , _nStalls( 0 ) {
+    if( _fd < 0 ) throw _system_error( "open", path );
+    posix_fadvise( _fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+    for( unsigned i = 0; i < std::max( nBuffers, 1u ); ++i ) {
+        _buffers.emplace_back( new Buffer{ std::vector<char>( std::max( bufferSize, size_t(4096) ) )
+                                         , 0, false, false } );
+    }
+    if( 1 == _buffers.size() ) return;
+    for( auto & b : _buffers ) _free.try_push( b.get() );
+    _thread = std::thread( &StreamSource::_read, this );
+}
+
+StreamSource::~StreamSource() {
+    if( _thread.joinable() ) {
+        _stop = true;
+        _thread.join();
+    }
+    ::close( _fd );
+}
+
+void
+StreamSource::_fill( Buffer & b ) {
+    // incomplete record of the previous buffer goes first
+    if( b.data.size() < _carry.size() ) b.data.resize( _carry.size() );
+    if( !_carry.empty() ) memcpy( b.data.data(), _carry.data(), _carry.size() );
+    size_t n = _carry.size();
+    _carry.clear();
+    for(;;) {
+        while( n < b.data.size() && !_eof ) {
+            const ssize_t r = ::read( _fd, b.data.data() + n, b.data.size() - n );
+            if( r < 0 ) {
+                if( EINTR == errno ) continue;
+                throw std::runtime_error( std::string("Unable to read: ") + strerror(errno) + "." );
+            }
+            if( !r ) _eof = true;
+            n += r;
+        }
+        // buffer ends at the boundary of the last complete record
+        EventView v;
+        const char * p = b.data.data(), * end = p + n;
+        size_t k;
+        while( (k = _frame( p, end, v )) ) p += k;
+        b.size = p - b.data.data();
+        if( b.size || _eof ) break;
+        b.data.resize( 2*b.data.size() );  // record does not fit
+    }
+    _carry.assign( b.data.data() + b.size, b.data.data() + n );
+    b.last = _eof;
+    // reported once the complete records of the buffer are taken
+    b.truncated = _eof && !_carry.empty();
+}
+
+void
+StreamSource::_read() {
+    Backoff backoff;
+    try {
+        for(;;) {
+            Buffer * b;
+            while( !_free.try_pop( b ) ) {
+                if( _stop.load( std::memory_order_relaxed ) ) return;
+                backoff.pause();
+            }
+            backoff.reset();
+            _fill( *b );
+            _full.try_push( b );  // never full: buffers are counted
+            if( b->last ) return;
+        }
+    } catch( ... ) {
+        _error = std::current_exception();
+        _full.try_push( nullptr );
+    }
+}
+
+bool
+StreamSource::_end() const {
+    if( _cur->truncated ) throw BadRecord( "File ends with incomplete record." );
+    return false;
+}
+
+bool
+StreamSource::_advance() {
+    if( 1 == _buffers.size() ) {
+        // read by the calling thread
+        if( _cur && _cur->last ) return _end();
+        _cur = _buffers.front().get();
+        _fill( *_cur );
+        ++_nStalls;
+        _pos = 0;
+        return _cur->size || !_cur->last || _end();
+    }
+    if( _cur ) {
+        if( _cur->last ) return _end();
+        _free.try_push( _cur );
+        _cur = nullptr;
+    }
+    Backoff backoff;
+    Buffer * b;
+    if( !_full.try_pop( b ) ) {
+        ++_nStalls;
+        while( !_full.try_pop( b ) ) backoff.pause();
+    }
+    if( !b ) {
+        std::rethrow_exception( _error );
+    }
+    _cur = b;
+    _pos = 0;
+    return _cur->size || !_cur->last || _end();
+}
+
+//
+// Asynchronous sink
+
+AsyncSink::AsyncSink( const std::string & path, size_t recordSize
+                    , unsigned nBuffers, size_t bufferSize )
+        : _fd( open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 ) )
+        , _recordSize( recordSize )
+        , _free( std::max( nBuffers, 1u ) )
+        , _full( std::max( nBuffers, 1u ) + 1 )  // and end marker
+        , _nWritten( 0 )
+        , _nSubmitted( 0 ) {
+    if( _fd < 0 ) throw _system_error( "create", path );
+    for( unsigned i = 0; i < std::max( nBuffers, 1u ); ++i ) {
+        _buffers.emplace_back( new Buffer{ std::vector<char>( std::max( bufferSize, size_t(4096) ) ), 0 } );
+    }
+    _cur = _buffers.front().get();
+    if( 1 == _buffers.size() ) return;
+    for( size_t i = 1; i < _buffers.size(); ++i ) _free.try_push( _buffers[i].get() );
+    _thread = std::thread( &AsyncSink::_writer, this );
+}
+
+AsyncSink::~AsyncSink() {
+    try {
+        close();
+    } catch( ... ) {}
+}
+
+void
+AsyncSink::_write( Buffer & b ) {
+    for( size_t n = 0; n < b.size; ) {
+        const ssize_t r = ::write( _fd, b.data.data() + n, b.size - n );
+        if( r < 0 ) {
+            if( EINTR == errno ) continue;
+            throw std::runtime_error( std::string("Unable to write: ") + strerror(errno) + "." );
+        }
+        n += r;
+    }
+    b.size = 0;
+}
+
+void
+AsyncSink::_writer() {
+    Backoff backoff;
+    for(;;) {
+        Buffer * b;
+        while( !_full.try_pop( b ) ) backoff.pause();
+        backoff.reset();
+        if( !b ) return;
+        if( !_error ) {
+            try {
+                _write( *b );
+            } catch( ... ) {
+                _error = std::current_exception();
+            }
+        }
+        b->size = 0;
+        _free.try_push( b );
+        _nWritten.fetch_add( 1, std::memory_order_release );
+    }
+}
+
+void
+AsyncSink::_check_error() {
+    if( _nWritten.load( std::memory_order_acquire ) == _nSubmitted && _error ) {
+        std::exception_ptr e = _error;
+        _error = nullptr;
+        std::rethrow_exception( e );
+    }
+}
+
+void
+AsyncSink::_submit() {
+    if( !_thread.joinable() ) {
+        _write( *_cur );
+        return;
+    }
+    _full.try_push( _cur );
+    ++_nSubmitted;
+    Backoff backoff;
+    while( !_free.try_pop( _cur ) ) backoff.pause();
+    _check_error();
+}
+
+void
+AsyncSink::flush() {
+    if( _fd < 0 ) return;
+    if( _cur->size ) _submit();
+    Backoff backoff;
+    while( _nWritten.load( std::memory_order_acquire ) != _nSubmitted ) backoff.pause();
+    _check_error();
+}
+
+void
+AsyncSink::close() {
+    if( _fd < 0 ) return;
+    try {
+        flush();
+    } catch( ... ) {
+        if( _thread.joinable() ) {
+            _full.try_push( nullptr );
+            _thread.join();
+        }
+        ::close( _fd );
+        _fd = -1;
+        throw;
+    }
+    if( _thread.joinable() ) {
+        _full.try_push( nullptr );
+        _thread.join();
+    }
+    const int rc = ::close( _fd );
+    _fd = -1;
+    if( rc ) throw std::runtime_error( std::string("Unable to close: ") + strerror(errno) + "." );
+}
+
+//
+// Pipeline driver
+
+size_t
+drain( EventSource & src, Pipeline & p ) {
+    size_t nPassed = 0;
+    EventView v;
+    while( src.next( v ) ) nPassed += (p << v).succeed();
+    return nPassed;
+}
+
+}  // namespace ::dataflow
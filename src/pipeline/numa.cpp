@@ -0,0 +1,84 @@
+# include "pipeline/numa.hpp"
+
+# include <algorithm>
+# include <cstdlib>
+# include <fstream>
+
+# include <dirent.h>
+# include <sched.h>
+
+namespace dataflow {
+
+std::vector<unsigned>
+aux::parse_cpu_list( const std::string & list ) {
+    std::vector<unsigned> cpus;
+    const char * p = list.c_str();
+    for(;;) {
+        char * end;
+        const unsigned long first = strtoul( p, &end, 10 );
+        if( end == p ) break;
+        unsigned long last = first;
+        p = end;
+        if( '-' == *p ) {
+            last = strtoul( p + 1, &end, 10 );
+            if( end == p + 1 ) break;
+            p = end;
+        }
+        for( unsigned long c = first; c <= last; ++c ) cpus.push_back( unsigned(c) );
+        if( ',' != *p ) break;
+        ++p;
+    }
+    std::sort( cpus.begin(), cpus.end() );
+    cpus.erase( std::unique( cpus.begin(), cpus.end() ), cpus.end() );
+    return cpus;
+}
+
+std::vector<unsigned>
+allowed_cpus() {
+    std::vector<unsigned> cpus;
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    if( 0 == sched_getaffinity( 0, sizeof(set), &set ) ) {
+        for( unsigned c = 0; c < CPU_SETSIZE; ++c ) if( CPU_ISSET( c, &set ) ) cpus.push_back( c );
+    }
+    if( cpus.empty() ) cpus.push_back( 0 );
+    return cpus;
+}
+
+std::vector<NumaNode>
+numa_nodes( const std::string & sysfs, const std::vector<unsigned> & allowed ) {
+    std::vector<NumaNode> nodes;
+    std::vector<unsigned> sorted( allowed );
+    std::sort( sorted.begin(), sorted.end() );
+    if( DIR * dir = opendir( sysfs.c_str() ) ) {
+        while( const dirent * e = readdir( dir ) ) {
+            const std::string name( e->d_name );
+            if( name.size() < 5 || name.compare( 0, 4, "node" )
+             || name.find_first_not_of( "0123456789", 4 ) != std::string::npos ) continue;
+            std::ifstream ifs( sysfs + "/" + name + "/cpulist" );
+            std::string list;
+            if( !std::getline( ifs, list ) ) continue;
+            NumaNode n{ unsigned( std::stoul( name.substr(4) ) ), {} };
+            for( unsigned c : aux::parse_cpu_list( list ) ) {
+                if( std::binary_search( sorted.begin(), sorted.end(), c ) ) n.cpus.push_back( c );
+            }
+            // memory-only nodes and nodes of the CPUs not allowed are skipped
+            if( !n.cpus.empty() ) nodes.push_back( std::move(n) );
+        }
+        closedir( dir );
+    }
+    if( nodes.empty() ) nodes.push_back( NumaNode{ 0, sorted } );
+    std::sort( nodes.begin(), nodes.end()
+             , []( const NumaNode & a, const NumaNode & b ) { return a.id < b.id; } );
+    return nodes;
+}
+
+bool
+pin_thread( const std::vector<unsigned> & cpus ) {
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    for( unsigned c : cpus ) if( c < CPU_SETSIZE ) CPU_SET( c, &set );
+    return 0 == sched_setaffinity( 0, sizeof(set), &set );
+}
+
+}  // namespace ::dataflow
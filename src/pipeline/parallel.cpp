@@ -0,0 +1,121 @@
+# include "pipeline/parallel.hpp"
+
+# include <algorithm>
+
+namespace dataflow {
+
+ParallelPipeline::ParallelPipeline( const Pipeline & p, unsigned nWorkers, size_t grain )
+        : _pool( nWorkers )
+        , _stages( p.stages() )
+        , _grain( grain ) {
+    _init();
+}
+
+ParallelPipeline::ParallelPipeline( const Pipeline & p, const std::vector<NumaNode> & nodes
+                                  , unsigned workersPerNode, size_t grain )
+        : _pool( nodes, workersPerNode )
+        , _stages( p.stages() )
+        , _grain( grain ) {
+    _init();
+}
+
+void
+ParallelPipeline::_init() {
+    for( const Stage & s : _stages ) {
+        if( !s.expand ) continue;
+        throw IncompatibleHandlers( "Generator \"" + s.name + "\" can not run in parallel pipeline." );
+    }
+    std::vector<std::mutex *> mutexes( _stages.size(), nullptr );
+    for( size_t i = 0; i < _stages.size(); ++i ) {
+        if( kSerialized != _stages[i].concurrency ) continue;
+        _mutexes.emplace_back( new std::mutex() );
+        mutexes[i] = _mutexes.back().get();
+    }
+    // lanes are allocated by their workers, so that placed worker touches
+    // the memory of its own node first
+    _lanes.resize( _pool.size() );
+    _pool.run_each( [&]( unsigned w, size_t, size_t ) {
+        _lanes[w].reset( new Lane() );
+        Lane & l = *_lanes[w];
+        l.stages = _stages;
+        l.serialized.reserve( _mutexes.size() );
+        for( size_t i = 0; i < _stages.size(); ++i ) {
+            if( !mutexes[i] ) continue;
+            l.serialized.push_back( Serialized{ mutexes[i], _stages[i].invoke, _stages[i].handler } );
+            l.stages[i].invoke = &_invoke_serialized;
+            l.stages[i].handler = &l.serialized.back();
+        }
+    } );
+}
+
+bool
+ParallelPipeline::_invoke_serialized( void * h, Slot & v ) {
+    Serialized & s = *static_cast<Serialized *>(h);
+    std::lock_guard<std::mutex> lock(*s.m);
+    return s.invoke( s.handler, v );
+}
+
+void
+ParallelPipeline::_prepare() {
+    for( auto & l : _lanes ) l->nPassed = 0;
+    const bool cloned = std::any_of( _stages.begin(), _stages.end()
+                                   , []( const Stage & s ) { return kCloned == s.concurrency; } );
+    if( !cloned ) return;
+    // copies are made by the workers using them; worker 0 uses original
+    // instances
+    _pool.run_each( [this]( unsigned w, size_t, size_t ) {
+        if( !w ) return;
+        Lane & l = *_lanes[w];
+        l.clones.clear();
+        for( size_t i = 0; i < _stages.size(); ++i ) {
+            if( kCloned != _stages[i].concurrency ) continue;
+            l.clones.push_back( _stages[i].clone( _stages[i].handler ) );
+            l.stages[i].handler = l.clones.back().get();
+        }
+    } );
+}
+
+size_t
+ParallelPipeline::_finish() {
+    size_t nPassed = 0;
+    for( auto & l : _lanes ) nPassed += l->nPassed;
+    // copies are merged pairwise, the pairs of each level concurrently;
+    // worker 0 keeps the original instances
+    const size_t nLanes = _lanes.size();
+    const bool cloned = std::any_of( _stages.begin(), _stages.end()
+                                   , []( const Stage & s ) { return kCloned == s.concurrency; } );
+    for( size_t s = 1; cloned && s < nLanes; s *= 2 ) {
+        const size_t nPairs = (nLanes - s + 2*s - 1)/(2*s);
+        _pool.run( nPairs, 1, [this, s]( unsigned, size_t b, size_t e ) {
+                for( size_t k = b; k < e; ++k ) {
+                    Lane & to = *_lanes[2*s*k], & from = *_lanes[2*s*k + s];
+                    for( size_t i = 0; i < _stages.size(); ++i ) {
+                        if( kCloned != _stages[i].concurrency ) continue;
+                        _stages[i].merge( to.stages[i].handler, from.stages[i].handler );
+                    }
+                }
+            } );
+    }
+    for( size_t i = 0; cloned && nLanes > 1 && i < _stages.size(); ++i ) {
+        if( kCloned == _stages[i].concurrency && _stages[i].merged ) {
+            _stages[i].merged( _stages[i].handler );
+        }
+    }
+    for( unsigned w = 1; w < nLanes; ++w ) {
+        Lane & l = *_lanes[w];
+        for( size_t i = 0; i < _stages.size(); ++i ) {
+            if( kCloned == _stages[i].concurrency ) l.stages[i].handler = _stages[i].handler;
+        }
+        l.clones.clear();
+    }
+    return nPassed;
+}
+
+void
+ParallelPipeline::_throw_bad_input( const PortType & t ) const {
+    throw IncompatibleHandlers( std::string("Pipeline accepts ")
+                              + _stages.front().input.index.name()
+                              + " while " + t.index.name() + " is given." );
+}
+
+}  // namespace ::dataflow
@@ -0,0 +1,79 @@
+# include "pipeline/pipeline.hpp"
+
+namespace dataflow {
+
+static std::string
+_stage_name( const Stage & s ) {
+    return s.name.empty() ? std::string("<unnamed>") : "\"" + s.name + "\"";
+}
+
+IncompatibleHandlers::IncompatibleHandlers( const Stage & prev, const Stage & next )
+    : std::runtime_error( "Handler " + _stage_name(next) + " accepts "
+                        + next.input.index.name() + " while previous handler "
+                        + _stage_name(prev) + " produces "
+                        + prev.output.index.name() + "." ) {}
+
+Pipeline &
+Pipeline::append( Stage s ) {
+    if( !s.invoke && !s.expand ) {
+        throw IncompatibleHandlers( "Stage " + _stage_name(s) + " has no invoker." );
+    }
+    if( !_stages.empty() && _stages.back().output != s.input ) {
+        throw IncompatibleHandlers( _stages.back(), s );
+    }
+    _batchable = _batchable && s.invoke_batch;
+    if( Profiler::enabled ) s.probe = Profiler::self().probe( s.name.empty() ? "<unnamed>" : s.name );
+    if( s.expand ) {
+        _yielded.emplace_back( new Slot(&_arena) );
+        _result = _yielded.back().get();
+    } else _yielded.emplace_back();
+    _stages.push_back( std::move(s) );
+    return *this;
+}
+
+Pipeline &
+Pipeline::append( const std::string & name ) {
+    Stage s = HandlersIndex::self().get( name ).stage( name );
+    if( !_stages.empty() && _stages.back().output != s.input ) {
+        Stage a = HandlersIndex::self().adapter( _stages.back().output, s.input );
+        if( !a.invoke ) throw IncompatibleHandlers( _stages.back(), s );
+        append( std::move(a) );
+    }
+    return append( std::move(s) );
+}
+
+bool
+Pipeline::_expand( size_t i, Slot & value ) {
+    const Stage & s = _stages[i];
+    Rest rest{ this, i + 1 };
+    const Stage::Continuation k{ &_continue, &rest };
+    // time of the generator includes the stages run on yielded values
+    return aux::profiled( aux::profile_table(), s.probe, [&]() {
+                return s.expand( s.handler, value, *_yielded[i], k );
+            } );
+}
+
+bool
+Pipeline::_continue( void * rest, Slot & value ) {
+    const Rest & r = *static_cast<const Rest *>(rest);
+    return r.pipeline->_run( r.first, value );
+}
+
+void
+Pipeline::_throw_bad_input( const PortType & t ) const {
+    throw IncompatibleHandlers( std::string("Pipeline accepts ")
+                              + _stages.front().input.index.name()
+                              + " while " + t.index.name() + " is given." );
+}
+
+void
+Pipeline::_throw_not_batchable() const {
+    for( const Stage & s : _stages ) {
+        if( s.invoke_batch ) continue;
+        throw IncompatibleHandlers( "Handler " + _stage_name(s)
+                                  + " does not support batch mode." );
+    }
+    throw std::logic_error( "Pipeline is expected to have non-batchable stage." );
+}
+
+}  // namespace ::dataflow
@@ -0,0 +1,227 @@
+# include "pipeline/pool.hpp"
+
+# include <algorithm>
+# include <chrono>
+
+namespace dataflow {
+
+/// Waits on condition variable until predicate is satisfied.
+template<typename PredT> static void
+_wait( std::condition_variable & cv, std::unique_lock<std::mutex> & lock, PredT pred ) {
+# ifdef DATAFLOW_OLD_LIBSTDCXX
+    // untimed wait() of GCC >= 11 is a new versioned symbol of libstdc++
+    // (GLIBCXX_3.4.30), missing in older runtime
+    while( !cv.wait_for( lock, std::chrono::seconds(1), pred ) ) {}
+# else
+    cv.wait( lock, pred );
+# endif
+}
+
+/// Number of workers placed on the nodes
+static unsigned
+_n_placed( const std::vector<NumaNode> & nodes, unsigned workersPerNode ) {
+    unsigned n = 0;
+    for( const NumaNode & node : nodes ) {
+        n += workersPerNode ? workersPerNode : std::max( size_t(1), node.cpus.size() );
+    }
+    return std::max( n, 1u );
+}
+
+WorkStealingPool::WorkStealingPool( unsigned nWorkers )
+        : _nWorkers( nWorkers ? nWorkers : std::max( 1u, std::thread::hardware_concurrency() ) )
+        , _task(nullptr)
+        , _grain(1)
+        , _generation(0)
+        , _nBusy(0)
+        , _each(false)
+        , _stop(false) {
+    _start();
+}
+
+WorkStealingPool::WorkStealingPool( const std::vector<NumaNode> & nodes, unsigned workersPerNode )
+        : _nWorkers( _n_placed( nodes, workersPerNode ) )
+        , _task(nullptr)
+        , _grain(1)
+        , _generation(0)
+        , _nBusy(0)
+        , _each(false)
+        , _stop(false) {
+    for( unsigned i = 0; i < nodes.size(); ++i ) {
+        const std::vector<unsigned> & cpus = nodes[i].cpus;
+        const size_t n = workersPerNode ? workersPerNode : std::max( size_t(1), cpus.size() );
+        for( size_t k = 0; k < n; ++k ) {
+            _nodes.push_back( i );
+            // node without known CPUs leaves its workers unpinned
+            _cpus.push_back( cpus.empty() ? ~0u : cpus[k % cpus.size()] );
+        }
+    }
+    if( _nodes.empty() ) {
+        _nodes.push_back( 0 );
+        _cpus.push_back( ~0u );
+    }
+    _start();
+}
+
+void
+WorkStealingPool::_start() {
+    _ranges.reset( new Range[_nWorkers] );
+    for( unsigned i = 0; i < _nWorkers; ++i ) _ranges[i].begin = _ranges[i].end = 0;
+    // caller acts as worker 0 unless workers are placed on nodes
+    for( unsigned i = _nodes.empty() ? 1 : 0; i < _nWorkers; ++i ) {
+        _threads.emplace_back( &WorkStealingPool::_thread, this, i );
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(_m);
+        _stop = true;
+    }
+    _cvStart.notify_all();
+    for( std::thread & t : _threads ) t.join();
+}
+
+void
+WorkStealingPool::run( size_t n, size_t grain, const Task & task ) {
+    _grain = std::max( grain, size_t(1) );
+    for( unsigned i = 0; i < _nWorkers; ++i ) {
+        std::lock_guard<std::mutex> lock(_ranges[i].m);
+        _ranges[i].begin = n*i/_nWorkers;
+        _ranges[i].end = n*(i + 1)/_nWorkers;
+    }
+    _run( task, false );
+}
+
+void
+WorkStealingPool::run_each( const Task & task ) {
+    // single index per worker, not to be stolen
+    _grain = 1;
+    for( unsigned i = 0; i < _nWorkers; ++i ) {
+        std::lock_guard<std::mutex> lock(_ranges[i].m);
+        _ranges[i].begin = i;
+        _ranges[i].end = i + 1;
+    }
+    _run( task, true );
+}
+
+void
+WorkStealingPool::_run( const Task & task, bool each ) {
+    _error = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_m);
+        _task = &task;
+        _each = each;
+        _nBusy = unsigned( _threads.size() );
+        ++_generation;
+    }
+    _cvStart.notify_all();
+    if( _nodes.empty() ) _work( 0 );
+    {
+        std::unique_lock<std::mutex> lock(_m);
+        _wait( _cvDone, lock, [this]{ return !_nBusy; } );
+        _task = nullptr;
+    }
+    if( _error ) std::rethrow_exception( _error );
+}
+
+void
+WorkStealingPool::_thread( unsigned id ) {
+    if( !_cpus.empty() && _cpus[id] != ~0u ) pin_thread( { _cpus[id] } );
+    uint64_t seen = 0;
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lock(_m);
+            _wait( _cvStart, lock, [&]{ return _stop || _generation != seen; } );
+            if( _stop ) return;
+            seen = _generation;
+        }
+        _work( id );
+        {
+            std::lock_guard<std::mutex> lock(_m);
+            --_nBusy;
+        }
+        _cvDone.notify_one();
+    }
+}
+
+void
+WorkStealingPool::_work( unsigned id ) {
+    size_t b, e;
+    while( _take( id, b, e ) || (!_each && _steal( id, b, e )) ) {
+        try {
+            (*_task)( id, b, e );
+        } catch( ... ) {
+            {
+                std::lock_guard<std::mutex> lock(_m);
+                if( !_error ) _error = std::current_exception();
+            }
+            _cancel();
+        }
+    }
+}
+
+bool
+WorkStealingPool::_take( unsigned id, size_t & b, size_t & e ) {
+    Range & r = _ranges[id];
+    std::lock_guard<std::mutex> lock(r.m);
+    if( r.begin == r.end ) return false;
+    b = r.begin;
+    e = std::min( r.begin + _grain, r.end );
+    r.begin = e;
+    return true;
+}
+
+bool
+WorkStealingPool::_steal( unsigned id, size_t & b, size_t & e ) {
+    for(;;) {
+        // find the victim having largest remaining range, on the same node
+        // if there is any
+        unsigned victim = id;
+        for( int sameNode = 1; sameNode >= 0 && victim == id; --sameNode ) {
+            size_t largest = 0;
+            for( unsigned k = 1; k < _nWorkers; ++k ) {
+                const unsigned other = (id + k) % _nWorkers;
+                if( (node( other ) == node( id )) != bool(sameNode) ) continue;
+                Range & r = _ranges[other];
+                std::lock_guard<std::mutex> lock(r.m);
+                if( r.end - r.begin > largest ) {
+                    largest = r.end - r.begin;
+                    victim = other;
+                }
+            }
+        }
+        if( victim == id ) return false;
+        {
+            Range & r = _ranges[victim];
+            std::lock_guard<std::mutex> lock(r.m);
+            const size_t remaining = r.end - r.begin;
+            if( !remaining ) continue;  // exhausted meanwhile, look again
+            if( remaining <= _grain ) {
+                b = r.begin;
+                e = r.end;
+                r.begin = r.end;
+                return true;
+            }
+            b = r.begin + remaining/2;
+            e = r.end;
+            r.end = b;
+        }
+        // keep the first chunk, put the rest into own range
+        Range & own = _ranges[id];
+        std::lock_guard<std::mutex> lock(own.m);
+        own.begin = std::min( b + _grain, e );
+        own.end = e;
+        e = own.begin;
+        return true;
+    }
+}
+
+void
+WorkStealingPool::_cancel() {
+    for( unsigned i = 0; i < _nWorkers; ++i ) {
+        std::lock_guard<std::mutex> lock(_ranges[i].m);
+        _ranges[i].begin = _ranges[i].end;
+    }
+}
+
+}  // namespace ::dataflow
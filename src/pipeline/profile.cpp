@@ -0,0 +1,231 @@
+# include "pipeline/profile.hpp"
+
+# include <chrono>
+# include <cstdio>
+# include <ostream>
+# include <stdexcept>
+# include <thread>
+
+namespace dataflow {
+
+static double
+_now() {
+    return std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+double
+HandlerStats::quantile( double q ) const {
+    uint64_t n = 0, total = 0;
+    for( uint64_t c : histogram ) total += c;
+    if( !total ) return 0;
+    for( unsigned i = 0; i < kNBins; ++i ) {
+        n += histogram[i];
+        if( n >= q*total ) return edge(i);
+    }
+    return edge( kNBins - 1 );
+}
+
+namespace aux {
+
+std::atomic<unsigned> gSamplingPeriod{16};
+
+ProfileTable::ProfileTable() : _countdown(1) {
+    for( auto & b : _blocks ) b.store( nullptr, std::memory_order_relaxed );
+}
+
+ProfileTable::~ProfileTable() {
+    for( auto & b : _blocks ) delete [] b.load( std::memory_order_relaxed );
+}
+
+ProfileTable::Counters *
+ProfileTable::_allocate( unsigned probe ) {
+    if( probe >= kBlockSize*kNBlocks ) {
+        throw std::length_error( "Too many profiling probes." );
+    }
+    Counters * b = new Counters[kBlockSize];
+    for( unsigned i = 0; i < kBlockSize; ++i ) {
+        b[i].nCalls = b[i].nPassed = b[i].nTimed = b[i].nTicks = 0;
+        for( auto & h : b[i].histogram ) h = 0;
+    }
+    // counters have to be zeroed before they are seen by profiler
+    _blocks[probe/kBlockSize].store( b, std::memory_order_release );
+    return b + probe % kBlockSize;
+}
+
+const ProfileTable::Counters *
+ProfileTable::find( unsigned probe ) const {
+    if( probe >= kBlockSize*kNBlocks ) return nullptr;
+    const Counters * b = _blocks[probe/kBlockSize].load( std::memory_order_acquire );
+    return b ? b + probe % kBlockSize : nullptr;
+}
+
+ProfileTable *
+thread_profile_table() {
+    // kept alive by profiler after the thread exits
+    thread_local std::shared_ptr<ProfileTable> table = []() {
+        auto t = std::make_shared<ProfileTable>();
+        Profiler & p = Profiler::self();
+        std::lock_guard<std::mutex> lock(p._m);
+        p._tables.push_back( t );
+        return t;
+    }();
+    return table.get();
+}
+
+}  // namespace ::dataflow::aux
+
+Profiler::Profiler() : _ticks0( aux::ticks() ), _t0( _now() ) {
+    _names.push_back( "<unregistered>" );
+}
+
+Profiler &
+Profiler::self() {
+    static Profiler p;
+    return p;
+}
+
+unsigned
+Profiler::probe( const std::string & name ) {
+    std::lock_guard<std::mutex> lock(_m);
+    auto ir = _probes.emplace( name, unsigned(_names.size()) );
+    if( ir.second ) _names.push_back( name );
+    return ir.first->second;
+}
+
+double
+Profiler::_ns_per_tick() const {
+    # if defined(__x86_64__) || defined(__i386__)
+    // calibrated against the clock over the time elapsed since construction
+    double t = _now();
+    if( t - _t0 < 1e7 ) {
+        std::this_thread::sleep_for( std::chrono::nanoseconds( int64_t(1e7 - (t - _t0)) ) );
+        t = _now();
+    }
+    return ( t - _t0 )/double( aux::ticks() - _ticks0 );
+    # else
+    return 1;
+    # endif
+}
+
+std::map<std::string, HandlerStats>
+Profiler::_merge() const {
+    const double nsPerTick = _ns_per_tick();
+    std::map<std::string, HandlerStats> r;
+    std::lock_guard<std::mutex> lock(_m);
+    for( unsigned probe = 0; probe < _names.size(); ++probe ) {
+        HandlerStats s = {};
+        uint64_t nTimed = 0, nTicks = 0;
+        for( const auto & t : _tables ) {
+            const aux::ProfileTable::Counters * c = t->find( probe );
+            if( !c ) continue;
+            s.nCalls += c->nCalls.load( std::memory_order_relaxed );
+            s.nPassed += c->nPassed.load( std::memory_order_relaxed );
+            nTimed += c->nTimed.load( std::memory_order_relaxed );
+            nTicks += c->nTicks.load( std::memory_order_relaxed );
+            for( unsigned i = 0; i < HandlerStats::kNBins; ++i ) {
+                s.histogram[i] += c->histogram[i].load( std::memory_order_relaxed );
+            }
+        }
+        if( !s.nCalls ) continue;
+        s.nRejected = s.nCalls - s.nPassed;
+        // extrapolated from the timed calls
+        s.time = nTimed ? nTicks*nsPerTick*double(s.nCalls)/nTimed : 0;
+        s.nsPerTick = nsPerTick;
+        r[_names[probe]] = s;
+    }
+    return r;
+}
+
+std::map<std::string, HandlerStats>
+Profiler::snapshot() const {
+    std::map<std::string, HandlerStats> r = _merge();
+    std::lock_guard<std::mutex> lock(_m);
+    for( auto it = r.begin(); it != r.end(); ) {
+        auto b = _baseline.find( it->first );
+        if( _baseline.end() != b ) {
+            HandlerStats & s = it->second;
+            s.nCalls -= b->second.nCalls;
+            s.nPassed -= b->second.nPassed;
+            s.nRejected -= b->second.nRejected;
+            s.time -= b->second.time;
+            for( unsigned i = 0; i < HandlerStats::kNBins; ++i ) {
+                s.histogram[i] -= b->second.histogram[i];
+            }
+        }
+        if( it->second.nCalls ) ++it;
+        else it = r.erase( it );
+    }
+    return r;
+}
+
+void
+Profiler::reset() {
+    // counters belong to the threads, so the current state is remembered
+    std::map<std::string, HandlerStats> b = _merge();
+    std::lock_guard<std::mutex> lock(_m);
+    _baseline.swap( b );
+}
+
+void
+Profiler::set_sampling( unsigned period ) {
+    aux::gSamplingPeriod.store( period ? period : 1, std::memory_order_relaxed );
+}
+
+void
+Profiler::report( std::ostream & os ) const {
+    char bf[256];
+    snprintf( bf, sizeof(bf), "%-32s %12s %12s %12s %10s %10s %10s %12s\n"
+            , "handler", "calls", "passed", "rejected", "mean,ns", "p50,ns", "p99,ns"
+            , "total,ms" );
+    os << bf;
+    for( const auto & e : snapshot() ) {
+        const HandlerStats & s = e.second;
+        snprintf( bf, sizeof(bf), "%-32s %12llu %12llu %12llu %10.1f %10.0f %10.0f %12.3f\n"
+                , e.first.c_str(), (unsigned long long) s.nCalls
+                , (unsigned long long) s.nPassed, (unsigned long long) s.nRejected
+                , s.mean(), s.quantile(.5), s.quantile(.99), s.time*1e-6 );
+        os << bf;
+    }
+}
+
+static void
+_json_string( std::ostream & os, const std::string & s ) {
+    os << '"';
+    for( char c : s ) {
+        if( '"' == c || '\\' == c ) os << '\\' << c;
+        else if( (unsigned char) c < 0x20 ) {
+            char bf[8];
+            snprintf( bf, sizeof(bf), "\\u%04x", c );
+            os << bf;
+        } else os << c;
+    }
+    os << '"';
+}
+
+void
+Profiler::report_json( std::ostream & os ) const {
+    const std::map<std::string, HandlerStats> stats = snapshot();
+    os << "{";
+    bool first = true;
+    for( const auto & e : stats ) {
+        const HandlerStats & s = e.second;
+        if( !first ) os << ",";
+        first = false;
+        os << "\n  ";
+        _json_string( os, e.first );
+        os << ": {\"calls\": " << s.nCalls << ", \"passed\": " << s.nPassed
+           << ", \"rejected\": " << s.nRejected << ", \"time_ns\": " << s.time
+           << ", \"mean_ns\": " << s.mean() << ", \"p50_ns\": " << s.quantile(.5)
+           << ", \"p99_ns\": " << s.quantile(.99) << ", \"histogram\": [";
+        unsigned last = HandlerStats::kNBins;
+        while( last && !s.histogram[last - 1] ) --last;
+        for( unsigned i = 0; i < last; ++i ) {
+            os << (i ? ", " : "") << "[" << s.edge(i) << ", " << s.histogram[i] << "]";
+        }
+        os << "]}";
+    }
+    os << "\n}\n";
+}
+
+}  // namespace ::dataflow
@@ -0,0 +1,154 @@
+# include "pipeline/streaming.hpp"
+
+namespace dataflow {
+
+StreamingPipeline::StreamingPipeline( const Pipeline & p
+                                    , const std::vector<size_t> & groups
+                                    , Sink sink
+                                    , size_t batchSize
+                                    , size_t capacity )
+        : _stages( p.stages() )
+        , _sink( std::move(sink) )
+        , _batchSize( std::max( batchSize, size_t(1) ) )
+        , _nFed(0)
+        , _nSubmitted(0)
+        , _nDelivered(0)
+        , _failed(false)
+        , _closed(false) {
+    for( const Stage & s : _stages ) {
+        if( s.invoke_batch ) continue;
+        throw IncompatibleHandlers( "Handler \"" + s.name + "\" does not support batch mode." );
+    }
+    std::vector<size_t> sizes( groups );
+    if( sizes.empty() ) sizes.assign( _stages.size(), 1 );
+    if( sizes.empty() ) sizes.push_back( 0 );  // no stages, single thread
+    size_t nStages = 0;
+    for( size_t n : sizes ) nStages += n;
+    if( nStages != _stages.size() ) {
+        throw std::runtime_error( "Groups cover " + std::to_string(nStages)
+                                + " stages while pipeline has "
+                                + std::to_string(_stages.size()) + "." );
+    }
+    // queue feeding each group, and the one returning free items (enough
+    // items to fill all the queues and keep one in each group, plus room
+    // for the shutdown marker)
+    for( size_t i = 0; i < sizes.size(); ++i ) {
+        _queues.emplace_back( new SpscRing<Item *>( capacity ) );
+    }
+    const size_t nItems = _queues.front()->capacity()*sizes.size() + sizes.size() + 1;
+    _queues.emplace_back( new SpscRing<Item *>( nItems + 1 ) );
+    for( size_t i = 0; i < nItems; ++i ) {
+        _items.emplace_back( new Item() );
+        _queues.back()->try_push( _items.back().get() );
+    }
+    _groups.resize( sizes.size() );
+    auto it = _stages.begin();
+    for( size_t i = 0; i < sizes.size(); ++i ) {
+        _groups[i].stages.assign( it, it + sizes[i] );
+        it += sizes[i];
+        _groups[i].in = _queues[i].get();
+        _groups[i].out = _queues[i + 1].get();
+    }
+    for( size_t i = 0; i < _groups.size(); ++i ) {
+        _groups[i].thread = std::thread( &StreamingPipeline::_run, this
+                                       , std::ref(_groups[i]), i + 1 == _groups.size() );
+    }
+}
+
+StreamingPipeline::~StreamingPipeline() {
+    try {
+        close();
+    } catch( ... ) {}
+}
+
+void
+StreamingPipeline::_run( Group & g, bool last ) {
+    Backoff backoff;
+    for(;;) {
+        Item * item;
+        while( !g.in->try_pop( item ) ) backoff.pause();
+        backoff.reset();
+        if( item && !_failed.load( std::memory_order_relaxed ) ) {
+            try {
+                aux::EventArenaScope scope( &item->arena );
+                aux::ProfileTable * prof = aux::profile_table();
+                for( const Stage & s : g.stages ) {
+                    if( item->batch.empty() ) break;
+                    aux::profiled_batch( prof, s.probe, item->batch, [&]() {
+                            return s.invoke_batch( s.handler, item->batch );
+                        } );
+                }
+                if( last && !item->batch.empty() ) _sink( item->offset, item->batch );
+            } catch( ... ) {
+                std::lock_guard<std::mutex> lock(_errorMutex);
+                if( !_error ) _error = std::current_exception();
+                _failed = true;
+            }
+        }
+        while( !g.out->try_push( item ) ) backoff.pause();
+        backoff.reset();
+        if( !item ) return;  // shutdown marker passed further
+        if( last ) _nDelivered.fetch_add( 1, std::memory_order_release );
+    }
+}
+
+StreamingPipeline::Item *
+StreamingPipeline::_acquire() {
+    _check_error();
+    if( _closed ) throw std::logic_error( "Streaming pipeline is closed." );
+    Item * item;
+    Backoff backoff;
+    while( !_queues.back()->try_pop( item ) ) backoff.pause();
+    // batch left the pipeline
+    item->batch.clear();
+    item->arena.reset();
+    return item;
+}
+
+void
+StreamingPipeline::_submit( Item * item ) {
+    Backoff backoff;
+    while( !_queues.front()->try_push( item ) ) backoff.pause();
+    ++_nSubmitted;
+}
+
+void
+StreamingPipeline::_check_error() {
+    if( !_failed ) return;
+    std::lock_guard<std::mutex> lock(_errorMutex);
+    std::rethrow_exception( _error );
+}
+
+void
+StreamingPipeline::flush() {
+    Backoff backoff;
+    while( _nDelivered.load( std::memory_order_acquire ) != _nSubmitted ) backoff.pause();
+    _check_error();
+}
+
+void
+StreamingPipeline::close() {
+    if( _closed ) return;
+    _closed = true;
+    // shutdown marker travels through all the groups
+    Backoff backoff;
+    while( !_queues.front()->try_push( nullptr ) ) backoff.pause();
+    for( Group & g : _groups ) g.thread.join();
+    _check_error();
+}
+
+std::vector<RingStats>
+StreamingPipeline::queue_stats() const {
+    std::vector<RingStats> r;
+    for( const auto & q : _queues ) r.push_back( q->stats() );
+    return r;
+}
+
+void
+StreamingPipeline::_throw_bad_input( const PortType & t ) const {
+    throw IncompatibleHandlers( std::string("Pipeline accepts ")
+                              + _stages.front().input.index.name()
+                              + " while " + t.index.name() + " is given." );
+}
+
+}  // namespace ::dataflow
@@ -0,0 +1,70 @@
+# include "util/mmap.hpp"
+
+# include <cerrno>
+# include <cstdio>
+# include <cstring>
+# include <stdexcept>
+# include <utility>
+
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+
+namespace dataflow {
+namespace util {
+
+MappedFile::MappedFile( const std::string & path ) : _addr(nullptr)
+                                                   , _size(0) {
+    char bf[256];
+    int fd = open( path.c_str(), O_RDONLY );
+    if( fd < 0 ) {
+        snprintf( bf, sizeof(bf), "Unable to open \"%s\": %s."
+                , path.c_str(), strerror(errno) );
+        throw std::runtime_error( bf );
+    }
+    struct stat st;
+    if( fstat( fd, &st ) ) {
+        snprintf( bf, sizeof(bf), "Unable to stat \"%s\": %s."
+                , path.c_str(), strerror(errno) );
+        close( fd );
+        throw std::runtime_error( bf );
+    }
+    _size = st.st_size;
+    if( _size ) {
+        _addr = mmap( nullptr, _size, PROT_READ, MAP_SHARED, fd, 0 );
+        if( MAP_FAILED == _addr ) {
+            _addr = nullptr;
+            snprintf( bf, sizeof(bf), "Unable to map \"%s\": %s."
+                    , path.c_str(), strerror(errno) );
+            close( fd );
+            throw std::runtime_error( bf );
+        }
+    }
+    close( fd );  // mapping keeps the reference to file
+}
+
+MappedFile::~MappedFile() {
+    if( _addr ) munmap( _addr, _size );
+}
+
+MappedFile::MappedFile( MappedFile && o ) : _addr(o._addr)
+                                          , _size(o._size) {
+    o._addr = nullptr;
+    o._size = 0;
+}
+
+MappedFile &
+MappedFile::operator=( MappedFile && o ) {
+    std::swap( _addr, o._addr );
+    std::swap( _size, o._size );
+    return *this;
+}
+
+void
+MappedFile::advise_sequential() const {
+    if( _addr ) madvise( _addr, _size, MADV_SEQUENTIAL );
+}
+
+}  // namespace ::dataflow::util
+}  // namespace ::dataflow
@@ -0,0 +1,129 @@
+# include "pipeline/pipeline.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking handlers registry and pipelines built from names.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+bool cut( double & x ) { return x >= 0; }
+bool cut_n_double( double & x ) {
+    if( x < 0 ) return false;
+    x = 2*x;
+    return true;
+}
+float to_float( const std::string & s ) { return std::stof(s); }
+std::string to_string( const double & x ) { return std::to_string(x); }
+
+struct Summator {
+    double sum = 0;
+    void call( const double & x ) { sum += x; }
+};
+
+}  // anonymous namespace
+
+DATAFLOW_REGISTER_HANDLER( "test_cut_negative", cut )
+DATAFLOW_REGISTER_HANDLER( "test_cut_negative_double_positive", cut_n_double )
+DATAFLOW_REGISTER_HANDLER( "test_to_float", to_float )
+DATAFLOW_REGISTER_HANDLER( "test_to_string", to_string )
+DATAFLOW_REGISTER_CLASS( "test_summator", Summator )
+
+// Tests handlers are registered with their port signatures
+TEST( Handlers, index ) {
+    const HandlersIndex & idx = HandlersIndex::self();
+    const HandlerDescription & d = idx.get( "test_to_float" );
+    EXPECT_EQ( std::type_index(typeid(std::string)), d.input.index );
+    EXPECT_EQ( std::type_index(typeid(float)), d.output.index );
+    EXPECT_EQ( kMap, d.kind );
+    EXPECT_FALSE( d.construct );
+    EXPECT_EQ( kCut, idx.get( "test_cut_negative" ).kind );
+    EXPECT_TRUE( idx.get( "test_summator" ).construct );
+    EXPECT_FALSE( idx.find( "test_absent" ) );
+    EXPECT_THROW( idx.get( "test_absent" ), UnknownHandler );
+    EXPECT_THROW( HandlersIndex::self().add<cut>( "test_cut_negative" )
+                , std::runtime_error );
+}
+
+// Tests handlers added at run time are looked up with ones of the macros
+TEST( Handlers, runtimeAdded ) {
+    HandlersIndex & idx = HandlersIndex::self();
+    const size_t n = idx.size();
+    ASSERT_LE( 5u, n );
+    ASSERT_TRUE( idx.add<to_float>( "test_runtime_to_float" ) );
+    EXPECT_EQ( n + 1, idx.size() );
+    EXPECT_EQ( kMap, idx.get( "test_runtime_to_float" ).kind );
+    EXPECT_THROW( idx.add<cut>( "test_runtime_to_float" ), std::runtime_error );
+}
+
+// Tests plugin is loaded on the first lookup of its handler
+TEST( Handlers, plugin ) {
+    HandlersIndex & idx = HandlersIndex::self();
+    idx.add_plugin( "test", DATAFLOW_TEST_PLUGIN );
+    EXPECT_FALSE( idx.loaded( "test" ) );
+    EXPECT_FALSE( idx.find( "test_plugin_scale" ) );  // not loaded yet
+    Pipeline p{ "test_cut_negative", "test/test_plugin_scale", "test/test_plugin_counter" };
+    EXPECT_TRUE( idx.loaded( "test" ) );
+    ASSERT_TRUE( (p << 1.5).succeed() );
+    EXPECT_EQ( 15., p.get<double>() );
+    EXPECT_FALSE( (p << -1.5).succeed() );
+    // plugin handlers are referred by qualified names only
+    EXPECT_FALSE( idx.find( "test_plugin_scale" ) );
+    EXPECT_THROW( idx.get( "test/test_absent" ), UnknownHandler );
+    EXPECT_THROW( idx.get( "test/test_cut_negative" ), UnknownHandler );
+    EXPECT_THROW( idx.get( "test_absent_plugin/test_cut" ), BadPlugin );
+    EXPECT_FALSE( idx.loaded( "test_absent_plugin" ) );
+
+    // handler of the same name in another plugin
+    idx.add_plugin( "test_other", DATAFLOW_TEST_PLUGIN_OTHER );
+    Pipeline o{ "test_other/test_plugin_scale", "test/test_plugin_scale" };
+    ASSERT_TRUE( (o << 1.5).succeed() );
+    EXPECT_EQ( 1500., o.get<double>() );
+    EXPECT_THROW( idx.get( "test_other/test_plugin_counter" ), UnknownHandler );
+    EXPECT_TRUE( idx.find( "test_other/test_plugin_added" ) );
+    EXPECT_FALSE( idx.find( "test_plugin_added" ) );
+    EXPECT_TRUE( idx.find( "test_cut_negative" ) );  // index still complete
+}
+
+// Tests README examples
+TEST( Handlers, pipelineByName ) {
+    const double values[] = { -1, -2, 3, -4, 5 };
+    std::vector<double> r1, r2;
+    Pipeline p1( "test_cut_negative" )
+           , p2( "test_cut_negative_double_positive" );
+    for( double v : values ) {
+        if( (p1 << v).succeed() ) r1.push_back( p1.get<double>() );
+        if( (p2 << v).succeed() ) r2.push_back( p2.get<double>() );
+    }
+    EXPECT_EQ( (std::vector<double>{3, 5}), r1 );
+    EXPECT_EQ( (std::vector<double>{6, 10}), r2 );
+}
+
+// Tests adapter is inserted between handlers of mismatching types
+TEST( Handlers, adapters ) {
+    Pipeline p{ "test_to_float", "test_cut_negative_double_positive" };
+    ASSERT_EQ( 3u, p.size() );  // float -> double adapter
+    ASSERT_TRUE( (p << std::string("1.5")).succeed() );
+    EXPECT_EQ( 3., p.get<double>() );
+    EXPECT_FALSE( (p << std::string("-1.5")).succeed() );
+    // no conversion from float to std::string
+    EXPECT_THROW( Pipeline({ "test_to_float", "test_to_float" }), IncompatibleHandlers );
+}
+
+// Tests each pipeline gets its own instance of stateful handler
+TEST( Handlers, statefulByName ) {
+    Pipeline p1{ "test_cut_negative", "test_summator" }
+           , p2{ "test_summator" };
+    for( double v : {-1., 2., 3.} ) {
+        p1 << v;
+        p2 << v;
+    }
+    const Summator & s1 = *static_cast<const Summator *>(p1.stages().back().handler)
+                 , & s2 = *static_cast<const Summator *>(p2.stages().back().handler)
+                 ;
+    EXPECT_EQ( 5., s1.sum );
+    EXPECT_EQ( 4., s2.sum );
+}
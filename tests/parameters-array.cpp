@@ -0,0 +1,125 @@
+# include "parameters/handle.hpp"
+# include "parameters/frozen.hpp"
+# include "parameters/schema.hpp"
+
+# include "gtest/gtest.h"
+
+# include <cstdint>
+# include <numeric>
+
+/*
+ * Unit test checking dense array parameters.
+ */
+
+using namespace dataflow::config;
+
+namespace {
+struct ChannelCfg {
+    double pedestal;
+    int threshold;
+};
+}  // anonymous namespace
+
+// Tests array keeps aligned contiguous storage
+TEST( Configuration, arrayStorage ) {
+    RealArray a( 1000, 1.5 );
+    ASSERT_EQ( 1000, a.size() );
+    ASSERT_EQ( 0, reinterpret_cast<uintptr_t>(a.data()) % RealArray::kAlignment );
+    Span<const double> s = a.span();
+    ASSERT_EQ( 1500., std::accumulate( s.begin(), s.end(), 0. ) );
+    ASSERT_THROW( a.at(1000), std::out_of_range );
+    // Assignment of the same size keeps the storage
+    const double * p = a.data();
+    RealArray b( 1000, 4. );
+    a = b;
+    ASSERT_EQ( p, a.data() );
+    ASSERT_EQ( 4., a[999] );
+    IntArray ia{ 1, 2, 3 };
+    ASSERT_EQ( 3, ia.size() );
+    ASSERT_EQ( 6, std::accumulate( ia.begin(), ia.end(), 0 ) );
+}
+
+// Tests arrays are first-class parameters addressable by path
+TEST( Configuration, arrayParameters ) {
+    Dictionary root;
+    auto calib = std::make_shared<Dictionary>();
+    calib->emplace( "pedestals", new Parameter<RealArray>( RealArray{ .5, 1.5, 2.5 } ) );
+    calib->emplace( "thresholds", new Parameter<IntArray>( IntArray{ 10, 20 } ) );
+    root.emplace( "calib", calib );
+
+    AbstractParameter & p = get_parameter_ref( root, "calib.pedestals" );
+    ASSERT_EQ( kRealArray, p.type_code() );
+    ASSERT_EQ( 3, p.as<RealArray>().span().size() );
+    ASSERT_THROW( p.as<IntArray>(), BadParameterType );
+
+    // Path indexing refers to elements
+    ASSERT_EQ( 1.5, get_value<double>( root, "calib.pedestals[1]" ) );
+    ASSERT_EQ( 20, get_value<int>( root, "calib.thresholds[1]" ) );
+    ASSERT_EQ( 2, get_value<IntArray>( root, "calib.thresholds" ).size() );
+    ASSERT_THROW( get_value<double>( root, "calib.pedestals[3]" ), std::runtime_error );
+    ASSERT_THROW( get_value<int>( root, "calib.pedestals[0]" ), BadParameterType );
+    ASSERT_THROW( get_value<double>( root, "calib.pedestals[0].x" ), std::runtime_error );
+    // ... same as for tuples of scalars
+    auto t = std::make_shared<Tuple>();
+    t->emplace( 1, new Parameter<double>(1.5) );
+    calib->emplace( "gains", t );
+    ASSERT_EQ( 1.5, get_value<double>( root, "calib.gains[1]" ) );
+
+    // Handle refers to the element and sees in-place modification
+    ParamHandle<double> ped( root, "calib.pedestals[2]" );
+    ASSERT_EQ( 2.5, *ped );
+    static_cast<Parameter<RealArray>&>(p).value_ptr()->data()[2] = 3.5;
+    ASSERT_EQ( 3.5, ped.get() );
+    ASSERT_THROW( ParamHandle<int>( root, "calib.pedestals[2]" ), std::runtime_error );
+
+    // Replacing the array value is tracked by the handle
+    static_cast<Parameter<RealArray>&>(p).value( RealArray{ 7.5, 8.5, 9.5, 10.5 } );
+    ASSERT_EQ( 9.5, ped.get() );
+    static_cast<Parameter<RealArray>&>(p).value( RealArray{ .5 } );
+    ASSERT_THROW( ped.get(), std::runtime_error );
+    static_cast<Parameter<RealArray>&>(p).value( RealArray{ .5, 1.5, 4.5 } );
+
+    // Elements are not parameters
+    ASSERT_THROW( get_parameter_ref( root, "calib.pedestals[2]" ), std::runtime_error );
+    ASSERT_THROW( find_parameter( root, "calib.thresholds[2]" ), std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( root, "calib.thresholds[0].x" ), std::runtime_error );
+    // ... yet read by schemas
+    const ChannelCfg cfg = make_schema<ChannelCfg>(
+              required( &ChannelCfg::pedestal, "calib.pedestals[2]" )
+            , required( &ChannelCfg::threshold, "calib.thresholds[1]" ) ).extract( root );
+    ASSERT_EQ( 4.5, cfg.pedestal );
+    ASSERT_EQ( 20, cfg.threshold );
+    ChannelCfg dflt = make_schema<ChannelCfg>(
+              field( &ChannelCfg::pedestal, "calib.pedestals[3]", -1. )
+            , field( &ChannelCfg::threshold, "calib.thresholds[2]", -1 ) ).extract( root );
+    ASSERT_EQ( -1., dflt.pedestal );
+    ASSERT_EQ( -1, dflt.threshold );
+    ASSERT_THROW( make_schema<ChannelCfg>(
+              required( &ChannelCfg::threshold, "calib.pedestals[0]" ) ).extract( root )
+                , SchemaError );
+    ASSERT_THROW( make_schema<ChannelCfg>(
+              required( &ChannelCfg::threshold, "calib.thresholds[0].x" ) ).extract( root )
+                , SchemaError );
+}
+
+// Tests arrays are kept contiguous in frozen snapshot
+TEST( Configuration, arrayFrozen ) {
+    Dictionary root;
+    root.emplace( "pedestals", new Parameter<RealArray>( RealArray{ .5, 1.5, 2.5 } ) );
+    root.emplace( "thresholds", new Parameter<IntArray>( IntArray{ 10, 20 } ) );
+    FrozenConfig cfg = freeze( root );
+    Span<const double> peds = get_parameter_ref( cfg, "pedestals" ).as<RealArray>();
+    ASSERT_EQ( 3, peds.size() );
+    ASSERT_EQ( 2.5, peds[2] );
+    Span<const int> thrs = get_parameter_ref( cfg, "thresholds" ).as<IntArray>();
+    ASSERT_EQ( 2, thrs.size() );
+    ASSERT_EQ( 20, thrs[1] );
+    ASSERT_THROW( get_parameter_ref( cfg, "thresholds" ).as<RealArray>(), BadParameterType );
+    // Path indexing refers to elements
+    ASSERT_EQ( 1.5, get_parameter_ref( cfg, "pedestals[1]" ).as<double>() );
+    ASSERT_EQ( kInt, get_parameter_ref( cfg, "thresholds[1]" ).type_code() );
+    ASSERT_EQ( 20, get_parameter_ref( cfg, "thresholds[1]" ).as<int>() );
+    ASSERT_THROW( get_parameter_ref( cfg, "thresholds[1]" ).as<double>(), BadParameterType );
+    ASSERT_THROW( get_parameter_ref( cfg, "thresholds[2]" ), std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( cfg, "thresholds[1][0]" ), std::runtime_error );
+}
@@ -0,0 +1,110 @@
+# include "parameters/frozen.hpp"
+
+# include "gtest/gtest.h"
+
+# include <cstdio>
+# include <unistd.h>
+
+/*
+ * Unit test checking frozen configuration snapshot.
+ */
+
+using namespace dataflow::config;
+
+// Tests frozen snapshot preserves the tree content
+TEST( Configuration, frozenSnapshot ) {
+    Dictionary root;
+    auto dense = std::make_shared<Tuple>();
+    auto sparse = std::make_shared<Tuple>();
+    auto chamber = std::make_shared<Dictionary>();
+    chamber->emplace( "pedestal", new Parameter<double>(1.5) );
+    chamber->emplace( "name", new Parameter<std::string>("MWPC28") );
+    for( size_t i = 0; i < 5; ++i ) dense->emplace( i, new Parameter<int>(10*i) );
+    sparse->emplace( 28, chamber );
+    sparse->emplace( 3, new Parameter<bool>(true) );
+    root.emplace( "dense", dense );
+    root.emplace( "sparse", sparse );
+    root.emplace( "flag", new Parameter<bool>(false) );
+
+    FrozenConfig cfg = freeze( root );
+    ASSERT_EQ( kDict, cfg.root().type_code() );
+    ASSERT_EQ( 3, cfg.root().size() );
+    ASSERT_FALSE( get_parameter_ref( cfg, "flag" ).as<bool>() );
+    ASSERT_EQ( 5, get_parameter_ref( cfg, "dense" ).size() );
+    ASSERT_EQ( 30, get_parameter_ref( cfg, "dense[3]" ).as<int>() );
+    ASSERT_TRUE( get_parameter_ref( cfg, "sparse[3]" ).as<bool>() );
+    ASSERT_EQ( 1.5, get_parameter_ref( cfg, "sparse[28].pedestal" ).as<double>() );
+    ASSERT_EQ( "MWPC28", get_parameter_ref( cfg, "sparse[28].name" ).as<std::string>() );
+    // Iteration is sorted
+    FrozenNode s = get_parameter_ref( cfg, "sparse" );
+    ASSERT_EQ( 3, s.index(0) );
+    ASSERT_EQ( 28, s.index(1) );
+    FrozenNode c = s.value(1);
+    ASSERT_EQ( "name", c.key(0) );
+    ASSERT_EQ( "pedestal", c.key(1) );
+    // Path list version
+    std::unique_ptr<Path> p( Path::from_string( "dense[4]" ) );
+    ASSERT_EQ( 40, get_parameter_ref( cfg.root(), p.get() ).as<int>() );
+    // Errors
+    ASSERT_THROW( get_parameter_ref( cfg, "dense[5]" ), std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( cfg, "sparse[4]" ), std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( cfg, "nope" ), std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( cfg, "flag.x" ), std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( cfg, "flag" ).as<int>(), BadParameterType );
+    // Copies share the arena; snapshot does not depend on the source tree
+    FrozenConfig cpy( cfg );
+    root.clear();
+    ASSERT_EQ( cfg.data(), cpy.data() );
+    ASSERT_EQ( 1.5, get_parameter_ref( cpy, "sparse[28].pedestal" ).as<double>() );
+}
+
+// Tests binary image is written and mapped back
+TEST( Configuration, frozenImage ) {
+    Dictionary root;
+    auto chambers = std::make_shared<Tuple>();
+    for( size_t i = 0; i < 32; ++i ) {
+        auto ch = std::make_shared<Dictionary>();
+        ch->emplace( "pedestal", new Parameter<double>(i + .5) );
+        ch->emplace( "name", new Parameter<std::string>("ch" + std::to_string(i)) );
+        chambers->emplace( i, ch );
+    }
+    root.emplace( "chambers", chambers );
+    char tmpName[] = "/tmp/dataflow-test-XXXXXX";
+    int fd = mkstemp( tmpName );
+    ASSERT_LE( 0, fd );
+    close( fd );
+    const std::string filename( tmpName );
+    write_image( freeze( root ), filename );
+    {
+        FrozenConfig cfg = map_image( filename );
+        ASSERT_EQ( 28.5, get_parameter_ref( cfg, "chambers[28].pedestal" ).as<double>() );
+        ASSERT_EQ( "ch31", get_parameter_ref( cfg, "chambers[31].name" ).as<std::string>() );
+        // rewriting the image does not affect the mapping
+        Dictionary other;
+        other.emplace( "x", new Parameter<int>(1) );
+        write_image( freeze( other ), filename );
+        ASSERT_EQ( "ch31", get_parameter_ref( cfg, "chambers[31].name" ).as<std::string>() );
+        ASSERT_EQ( 1, get_parameter_ref( map_image( filename ), "x" ).as<int>() );
+        write_image( freeze( root ), filename );
+    }
+    // Image having offsets out of its size is rejected
+    {
+        FrozenConfig cfg = freeze( root );
+        std::string corrupt( cfg.data(), cfg.size() );
+        reinterpret_cast<frozen::Header &>(corrupt[0]).root.v.off = cfg.size() - 8;
+        FILE * f = fopen( filename.c_str(), "wb" );
+        ASSERT_NE( nullptr, f );
+        ASSERT_EQ( corrupt.size(), fwrite( corrupt.data(), 1, corrupt.size(), f ) );
+        fclose( f );
+        ASSERT_THROW( map_image( filename ), std::runtime_error );
+        write_image( cfg, filename );
+        ASSERT_NO_THROW( map_image( filename ) );
+    }
+    // Truncated image is rejected
+    FILE * f = fopen( filename.c_str(), "r+b" );
+    ASSERT_NE( nullptr, f );
+    ASSERT_EQ( 0, ftruncate( fileno(f), 64 ) );
+    fclose( f );
+    ASSERT_THROW( map_image( filename ), std::runtime_error );
+    remove( filename.c_str() );
+}
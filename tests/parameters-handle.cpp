@@ -0,0 +1,81 @@
+# include "parameters/handle.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking cached parameter handles.
+ */
+
+using namespace dataflow::config;
+
+// Tests handle resolves value and keeps it until tree is modified
+TEST( Configuration, paramHandle ) {
+    Dictionary root;
+    auto chambers = std::make_shared<Tuple>();
+    auto chamber = std::make_shared<Dictionary>();
+    chamber->emplace( "pedestal", new Parameter<double>(1.5) );
+    chamber->emplace( "enabled", new Parameter<bool>(true) );
+    chambers->emplace( 28, chamber );
+    root.emplace( "chambers", chambers );
+
+    ParamHandle<double> ped( root, "chambers[28].pedestal" );
+    ASSERT_TRUE( ped.valid() );
+    ASSERT_EQ( 1.5, *ped );
+    ASSERT_EQ( 1.5, ped.get() );
+    // Value modification is visible without re-resolution
+    static_cast<Parameter<double>&>(get_parameter_ref( root, "chambers[28].pedestal" )).value( 2.5 );
+    ASSERT_TRUE( ped.valid() );
+    ASSERT_EQ( 2.5, *ped );
+    // Unrelated read via get_parameter_ref does not invalidate the handle
+    ASSERT_TRUE( get_parameter_ref( root, "chambers[28].enabled" ).as<bool>() );
+    ASSERT_TRUE( ped.valid() );
+    // Replacing the entry invalidates handle, checked accessor re-resolves
+    chamber->erase( "pedestal" );
+    chamber->emplace( "pedestal", new Parameter<double>(3.5) );
+    ASSERT_FALSE( ped.valid() );
+    ASSERT_EQ( 3.5, ped.get() );
+    ASSERT_TRUE( ped.valid() );
+    // Modification of the upper level container invalidates handle as well
+    auto other = std::make_shared<Dictionary>();
+    other->emplace( "pedestal", new Parameter<double>(4.5) );
+    chambers->insert_or_assign( 28, other );
+    ASSERT_FALSE( ped.valid() );
+    ASSERT_EQ( 4.5, ped.get() );
+    // Non-const lookups are not modifications, edit through iterator is
+    // marked explicitly
+    const uint64_t epoch = MutationCounter::epoch();
+    auto it = other->find( "pedestal" );
+    ASSERT_TRUE( other->end() != it && other->begin() == it );
+    ASSERT_EQ( 4.5, other->at( Symbol( "pedestal" ) )->as<double>() );
+    ASSERT_EQ( epoch, MutationCounter::epoch() );
+    ASSERT_TRUE( ped.valid() );
+    it->second.reset( new Parameter<double>(5.5) );
+    other->touch();
+    ASSERT_FALSE( ped.valid() );
+    ASSERT_EQ( 5.5, ped.get() );
+    Dictionary swapped;
+    swapped.emplace( "pedestal", new Parameter<double>(6.5) );
+    // ... swap and extract are modifications
+    swap( *other, swapped );
+    ASSERT_FALSE( ped.valid() );
+    ASSERT_EQ( 6.5, ped.get() );
+    auto node = other->extract( other->cbegin() );
+    ASSERT_FALSE( ped.valid() );
+    ASSERT_THROW( ped.get(), std::runtime_error );
+    other->insert( std::move(node) );
+    ASSERT_EQ( 6.5, ped.get() );
+    // Removal makes re-resolution fail
+    chambers->clear();
+    ASSERT_THROW( ped.get(), std::runtime_error );
+}
+
+// Tests handle checks parameter type
+TEST( Configuration, paramHandleType ) {
+    Dictionary root;
+    root.emplace( "n", new Parameter<int>(3) );
+    ASSERT_EQ( 3, *ParamHandle<int>( root, "n" ) );
+    ASSERT_THROW( ParamHandle<double>( root, "n" ), std::runtime_error );
+    ASSERT_THROW( ParamHandle<int>( root, "m" ), std::runtime_error );
+    CompiledPath p( "n" );
+    ASSERT_EQ( 3, p.resolve( root ).as<int>() );
+}
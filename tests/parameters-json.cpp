@@ -0,0 +1,115 @@
+# include "parameters/json.hpp"
+
+# include "gtest/gtest.h"
+
+# include <cstdio>
+# include <fstream>
+# include <unistd.h>
+
+/*
+ * Unit test checking JSON configuration adaptor.
+ */
+
+using namespace dataflow::config;
+
+static const char gJSONSample[] = R"~({
+    "flag" : true,
+    "calibration" : {
+        "chambers" : [ { "pedestal" : 1.5, "threshold" : 12 },
+                       { "pedestal" : -2.5e-1, "threshold" : -3, "name": "MWPC² \"28\"" } ],
+        "empty" : {}, "none" : []
+    },
+    "name" : "some"
+})~";
+
+// Tests document parsing and retrieval of values by path
+TEST( Configuration, jsonDocument ) {
+    auto doc = json::Document::parse( gJSONSample );
+    ASSERT_EQ( kDict, doc->root().type_code() );
+    ASSERT_EQ( 3, doc->root().size() );
+    ASSERT_TRUE( get_parameter_ref( *doc, "flag" ).as<bool>() );
+    ASSERT_EQ( "some", get_parameter_ref( *doc, "name" ).as<std::string>() );
+    ASSERT_EQ( 2, get_parameter_ref( *doc, "calibration.chambers" ).size() );
+    ASSERT_EQ( 1.5, get_parameter_ref( *doc, "calibration.chambers[0].pedestal" ).as<double>() );
+    ASSERT_EQ( -.25, get_parameter_ref( *doc, "calibration.chambers[1].pedestal" ).as<double>() );
+    ASSERT_EQ( -3, get_parameter_ref( *doc, "calibration.chambers[1].threshold" ).as<int>() );
+    ASSERT_EQ( "MWPC\xc2\xb2 \"28\"", get_parameter_ref( *doc, "calibration.chambers[1].name" ).as<std::string>() );
+    ASSERT_EQ( 0, get_parameter_ref( *doc, "calibration.empty" ).size() );
+    ASSERT_EQ( 0, get_parameter_ref( *doc, "calibration.none" ).size() );
+    // Lookup errors
+    ASSERT_THROW( get_parameter_ref( *doc, "calibration.chambers[2]" ), std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( *doc, "calibration.foo" ), std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( *doc, "flag" ).as<int>(), BadParameterType );
+}
+
+// Tests integers out of range, duplicated keys and arrays of mixed elements
+TEST( Configuration, jsonValues ) {
+    auto doc = json::Document::parse( R"~({ "big" : 12345678901, "small" : -2147483648,
+            "a" : 1, "a" : 2,
+            "mixed" : [ 1, [ 2, 3 ], { "x" : [ 4 ] }, "five", [], 6 ] })~" );
+    ASSERT_EQ( kReal, get_parameter_ref( *doc, "big" ).type_code() );
+    ASSERT_EQ( 12345678901., get_parameter_ref( *doc, "big" ).as<double>() );
+    ASSERT_EQ( -2147483648, get_parameter_ref( *doc, "small" ).as<int>() );
+    // the last of duplicates is taken, by lookup and conversion alike
+    ASSERT_EQ( 2, get_parameter_ref( *doc, "a" ).as<int>() );
+    std::shared_ptr<AbstractParameter> root = json::to_parameters( doc->root() );
+    ASSERT_EQ( 2, get_parameter_ref( *root, "a" ).as<int>() );
+    ASSERT_EQ( 12345678901., get_parameter_ref( *root, "big" ).as<double>() );
+    // elements of array having containers
+    ASSERT_EQ( 6, get_parameter_ref( *doc, "mixed" ).size() );
+    ASSERT_EQ( 1, get_parameter_ref( *doc, "mixed[0]" ).as<int>() );
+    ASSERT_EQ( 3, get_parameter_ref( *doc, "mixed[1][1]" ).as<int>() );
+    ASSERT_EQ( 4, get_parameter_ref( *doc, "mixed[2].x[0]" ).as<int>() );
+    ASSERT_EQ( "five", get_parameter_ref( *doc, "mixed[3]" ).as<std::string>() );
+    ASSERT_EQ( 0, get_parameter_ref( *doc, "mixed[4]" ).size() );
+    ASSERT_EQ( 6, get_parameter_ref( *doc, "mixed[5]" ).as<int>() );
+    ASSERT_EQ( 6, get_parameter_ref( *root, "mixed[5]" ).as<int>() );
+}
+
+// Tests conversion to parameters tree
+TEST( Configuration, jsonToParameters ) {
+    auto doc = json::Document::parse( gJSONSample );
+    std::shared_ptr<AbstractParameter> root = json::to_parameters( doc->root() );
+    doc.reset();  // tree does not refer to the document
+    ASSERT_EQ( 12, get_parameter_ref( *root, "calibration.chambers[0].threshold" ).as<int>() );
+    ASSERT_EQ( "some", get_parameter_ref( *root, "name" ).as<std::string>() );
+    ASSERT_TRUE( get_parameter_ref( *root, "flag" ).as<bool>() );
+}
+
+// Tests loading from memory-mapped file
+TEST( Configuration, jsonLoad ) {
+    char filename[] = "/tmp/dataflow-test-XXXXXX";
+    int fd = mkstemp( filename );
+    ASSERT_LE( 0, fd );
+    close( fd );
+    {
+        std::ofstream ofs( filename );
+        ofs << gJSONSample;
+    }
+    auto doc = json::Document::load( filename );
+    remove( filename );  // mapping is kept
+    ASSERT_EQ( 1.5, get_parameter_ref( *doc, "calibration.chambers[0].pedestal" ).as<double>() );
+    ASSERT_THROW( json::Document::load( "/nonexisting/file.json" ), std::runtime_error );
+}
+
+// Tests syntax errors are reported with location
+TEST( Configuration, jsonErrors ) {
+    ASSERT_THROW( json::Document::parse( "" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "{" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "[1,]" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "{\"a\" 1}" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "{\"a\": null}" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "[01]" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "[\"abc]" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "[1] 2" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "[\"a\tb\"]" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "[\"a long string with\nnewline\"]" ), json::ParseError );
+    ASSERT_THROW( json::Document::parse( "[\"esc\\\"aped\nnewline\"]" ), json::ParseError );
+    try {
+        json::Document::parse( "{\n  \"a\" : tru }" );
+        FAIL() << "exception expected";
+    } catch( json::ParseError & e ) {
+        ASSERT_EQ( 2, e.line() );
+        ASSERT_EQ( 9, e.column() );
+    }
+}
@@ -0,0 +1,103 @@
+# include "parameters/overlay.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking copy-on-write configuration overlays.
+ */
+
+using namespace dataflow::config;
+
+static std::shared_ptr<const AbstractParameter>
+make_base() {
+    auto root = std::make_shared<Dictionary>();
+    auto calib = std::make_shared<Dictionary>();
+    auto chambers = std::make_shared<Tuple>();
+    for( size_t i = 0; i < 3; ++i ) {
+        auto ch = std::make_shared<Dictionary>();
+        ch->emplace( "pedestal", new Parameter<double>(i) );
+        ch->emplace( "gain", new Parameter<double>(1.) );
+        chambers->emplace( i, ch );
+    }
+    calib->emplace( "chambers", chambers );
+    root->emplace( "calib", calib );
+    root->emplace( "name", new Parameter<std::string>("default") );
+    return root;
+}
+
+// Tests overlay copies only the path to modified entry
+TEST( Configuration, overlaySet ) {
+    auto base = make_base();
+    Overlay o( base );
+    o.set( "calib.chambers[1].pedestal", 1.5 );
+    o.set( "name", "run42" );
+    o.set( "extra.list[2]", 7 );
+    // root, calib, chambers, chambers[1], extra, extra.list
+    ASSERT_EQ( 6, o.n_owned() );
+    auto v = o.result();
+    ASSERT_EQ( 0, o.n_owned() );
+    // variant
+    ASSERT_EQ( 1.5, get_parameter_ref( *v, "calib.chambers[1].pedestal" ).as<double>() );
+    ASSERT_EQ( "run42", get_parameter_ref( *v, "name" ).as<std::string>() );
+    ASSERT_EQ( 7, get_parameter_ref( *v, "extra.list[2]" ).as<int>() );
+    // base is intact
+    ASSERT_EQ( 1., get_parameter_ref( *base, "calib.chambers[1].pedestal" ).as<double>() );
+    ASSERT_EQ( "default", get_parameter_ref( *base, "name" ).as<std::string>() );
+    ASSERT_FALSE( find_parameter( *base, "extra" ) );
+    // unchanged subtrees are shared
+    ASSERT_EQ( &get_parameter_ref( *base, "calib.chambers[0]" )
+             , &get_parameter_ref( *v, "calib.chambers[0]" ) );
+    ASSERT_EQ( &get_parameter_ref( *base, "calib.chambers[1].gain" )
+             , &get_parameter_ref( *v, "calib.chambers[1].gain" ) );
+    ASSERT_NE( &get_parameter_ref( *base, "calib.chambers[1]" )
+             , &get_parameter_ref( *v, "calib.chambers[1]" ) );
+    // further modification of overlay does not affect the result
+    o.set( "name", "run43" );
+    ASSERT_EQ( "run42", get_parameter_ref( *v, "name" ).as<std::string>() );
+    // type mismatch
+    ASSERT_THROW( o.set( "name.x", 1 ), std::runtime_error );
+}
+
+// Tests overlay removes entries
+TEST( Configuration, overlayErase ) {
+    auto base = make_base();
+    Overlay o( base );
+    ASSERT_FALSE( o.erase( "calib.nothing" ) );
+    ASSERT_EQ( 0, o.n_owned() );
+    ASSERT_TRUE( o.erase( "calib.chambers[2]" ) );
+    auto v = o.result();
+    ASSERT_FALSE( find_parameter( *v, "calib.chambers[2]" ) );
+    ASSERT_TRUE( find_parameter( *base, "calib.chambers[2]" ) );
+
+    // elements of dense array can not be removed
+    auto withArray = std::make_shared<Dictionary>();
+    withArray->emplace( "peds", new Parameter<RealArray>( RealArray{ .5, 1.5, 2.5 } ) );
+    Overlay a( withArray );
+    ASSERT_THROW( a.erase( "peds[2]" ), std::runtime_error );
+    ASSERT_THROW( a.erase( "peds[3]" ), std::runtime_error );
+    ASSERT_EQ( 3u, get_parameter_ref( *a.result(), "peds" ).as<RealArray>().size() );
+}
+
+// Tests patch tree is merged recursively
+TEST( Configuration, overlayMerge ) {
+    auto base = make_base();
+    auto patch = std::make_shared<Dictionary>();
+    {
+        auto calib = std::make_shared<Dictionary>();
+        auto chambers = std::make_shared<Tuple>();
+        auto ch = std::make_shared<Dictionary>();
+        ch->emplace( "gain", new Parameter<double>(2.) );
+        chambers->emplace( 2, ch );
+        calib->emplace( "chambers", chambers );
+        patch->emplace( "calib", calib );
+    }
+    auto v = overlay( base, patch );
+    ASSERT_EQ( 2., get_parameter_ref( *v, "calib.chambers[2].gain" ).as<double>() );
+    ASSERT_EQ( 2., get_parameter_ref( *v, "calib.chambers[2].pedestal" ).as<double>() );
+    ASSERT_EQ( 1., get_parameter_ref( *base, "calib.chambers[2].gain" ).as<double>() );
+    ASSERT_EQ( &get_parameter_ref( *base, "calib.chambers[0]" )
+             , &get_parameter_ref( *v, "calib.chambers[0]" ) );
+    // patch leaves are shared
+    ASSERT_EQ( &get_parameter_ref( *patch, "calib.chambers[2].gain" )
+             , &get_parameter_ref( *v, "calib.chambers[2].gain" ) );
+}
@@ -100,3 +100,35 @@ TEST( Configuration, emitErrors ) {
                 , InvalidPathString );
 }
 
+// Tests linear tokenizer keeps tokens in embedded storage and spills to heap
+// for deep paths
+TEST( Configuration, pathTokens ) {
+    PathTokens toks( "calibration.multiwiredChamber[28].pedestal" );
+    ASSERT_EQ( 4, toks.size() );
+    ASSERT_TRUE( toks[0].isStr );
+    ASSERT_EQ( "calibration", toks[0].str );
+    ASSERT_EQ( "multiwiredChamber", toks[1].str );
+    ASSERT_FALSE( toks[2].isStr );
+    ASSERT_EQ( 28, toks[2].n );
+    ASSERT_EQ( "pedestal", toks[3].str );
+    const std::string deep = "a[1][2][3][4][5][6][7][8][9].b.c";
+    toks.assign( deep );
+    ASSERT_EQ( 12, toks.size() );
+    ASSERT_EQ( 9, toks[9].n );
+    ASSERT_EQ( "c", toks[11].str );
+    ASSERT_THROW( toks.assign( "a[01]" ), InvalidPathString );
+    ASSERT_THROW( toks.assign( "a[1]b" ), InvalidPathString );
+    ASSERT_THROW( toks.assign( "a.1b" ), InvalidPathString );
+    ASSERT_THROW( toks.assign( "a." ), InvalidPathString );
+}
+
+// Tests stack of parsed tokens is provided in the exception
+TEST( Configuration, pathErrorStack ) {
+    try {
+        Path::from_string( "one.two[3]..four" );
+        FAIL() << "exception expected";
+    } catch( InvalidPathString & e ) {
+        std::list<std::string> expected = { "3", "two", "one" };
+        ASSERT_EQ( expected, e.stack() );
+    }
+}
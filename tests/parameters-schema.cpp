@@ -0,0 +1,99 @@
+# include "parameters/schema.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking configuration schemas.
+ */
+
+using namespace dataflow::config;
+
+static_assert( is_valid_path( "" ), "" );
+static_assert( is_valid_path( "a" ), "" );
+static_assert( is_valid_path( "[0]._one.a[3][43].four" ), "" );
+static_assert( !is_valid_path( ".two" ), "" );
+static_assert( !is_valid_path( "one..two" ), "" );
+static_assert( !is_valid_path( "one[12.two" ), "" );
+static_assert( !is_valid_path( "one[]" ), "" );
+static_assert( !is_valid_path( "one[01]" ), "" );
+static_assert( !is_valid_path( "one[1]two" ), "" );
+static_assert( !is_valid_path( "1one" ), "" );
+
+namespace {
+
+struct ChamberCfg {
+    double pedestal;
+    double gain;
+    int threshold;
+    bool enabled;
+    std::string name;
+};
+
+constexpr auto gChamberSchema = make_schema<ChamberCfg>(
+          required( &ChamberCfg::pedestal,  "calib.pedestal" )
+        , field(    &ChamberCfg::gain,      "calib.gain", 1. )
+        , field(    &ChamberCfg::threshold, "calib.threshold", 10 )
+        , field(    &ChamberCfg::enabled,   "enabled", true )
+        , field(    &ChamberCfg::name,      "name", "unnamed" )
+        );
+static_assert( 5 == gChamberSchema.size(), "" );
+
+}  // anonymous namespace
+
+// Tests schema fills the struct with values and defaults
+TEST( Configuration, schemaExtraction ) {
+    Dictionary root;
+    auto chamber = std::make_shared<Dictionary>();
+    auto calib = std::make_shared<Dictionary>();
+    calib->emplace( "pedestal", new Parameter<double>(1.5) );
+    calib->emplace( "threshold", new Parameter<int>(42) );
+    chamber->emplace( "calib", calib );
+    chamber->emplace( "name", new Parameter<std::string>("MWPC28") );
+    root.emplace( "chamber", chamber );
+
+    ChamberCfg cfg;
+    gChamberSchema.fill( root, "chamber", cfg );
+    ASSERT_EQ( 1.5, cfg.pedestal );
+    ASSERT_EQ( 1., cfg.gain );
+    ASSERT_EQ( 42, cfg.threshold );
+    ASSERT_TRUE( cfg.enabled );
+    ASSERT_EQ( "MWPC28", cfg.name );
+}
+
+// Tests schema reports all the errors at once
+TEST( Configuration, schemaErrors ) {
+    Dictionary root;
+    root.emplace( "calib", new Parameter<int>(1) );  // not a dictionary
+    root.emplace( "enabled", new Parameter<int>(1) );  // type mismatch
+    try {
+        gChamberSchema.extract( root );
+        FAIL() << "exception expected";
+    } catch( SchemaError & e ) {
+        ASSERT_EQ( 4, e.errors().size() );  // 3 fields in "calib" + "enabled"
+    }
+    // Missing required field
+    Dictionary empty;
+    try {
+        gChamberSchema.extract( empty );
+        FAIL() << "exception expected";
+    } catch( SchemaError & e ) {
+        ASSERT_EQ( 1, e.errors().size() );
+    }
+    // Parent traversal error is reported for each of its fields
+    Dictionary broken;
+    broken.emplace( "calib", std::make_shared<Tuple>() );
+    broken.emplace( "pedestal", new Parameter<double>(1.) );
+    try {
+        make_schema<ChamberCfg>(
+                  field( &ChamberCfg::pedestal, "calib.x.pedestal", 1. )
+                , field( &ChamberCfg::gain, "calib.x.gain", 1. )
+                , field( &ChamberCfg::threshold, "pedestal.threshold", 1 )
+                ).extract( broken );
+        FAIL() << "exception expected";
+    } catch( SchemaError & e ) {
+        ASSERT_EQ( 3, e.errors().size() );
+    }
+    // Bad path grammar in non-constexpr schema is reported at runtime
+    ASSERT_THROW( field( &ChamberCfg::gain, "calib..gain", 1. )
+                , InvalidPathString );
+}
@@ -0,0 +1,88 @@
+# include "parameters/path.hpp"
+
+# include "gtest/gtest.h"
+
+# include <sstream>
+# include <thread>
+# include <vector>
+
+/*
+ * Unit test checking interned symbols used as dictionary keys and path
+ * tokens.
+ */
+
+using namespace dataflow::config;
+
+// Tests equal strings give the same symbol
+TEST( Configuration, symbolInterning ) {
+    const Symbol a( "pedestal" ), b( std::string("pedestal") ), c( std::string_view("gain") );
+    EXPECT_EQ( a, b );
+    EXPECT_NE( a, c );
+    EXPECT_EQ( a.id(), b.id() );
+    EXPECT_EQ( &a.str(), &b.str() );  // shared
+    EXPECT_TRUE( a == "pedestal" );
+    EXPECT_TRUE( c == std::string("gain") );
+    EXPECT_EQ( 8u, a.size() );
+    EXPECT_STREQ( "gain", c.c_str() );
+    const std::string & s = a;
+    EXPECT_EQ( "pedestal", s );
+    EXPECT_TRUE( Symbol().empty() );
+    EXPECT_EQ( Symbol(), Symbol("") );
+    std::ostringstream oss;
+    oss << a << '.' << c;
+    EXPECT_EQ( "pedestal.gain", oss.str() );
+    Symbol found;
+    EXPECT_TRUE( Symbol::find( "pedestal", found ) );
+    EXPECT_EQ( a, found );
+    EXPECT_FALSE( Symbol::find( "test_never_interned_symbol", found ) );
+}
+
+// Tests concurrent interning gives the same symbols to all the threads
+TEST( Configuration, symbolConcurrentInterning ) {
+    const size_t nThreads = 4, nSymbols = 5000;
+    std::vector< std::vector<uint32_t> > ids( nThreads );
+    std::vector<std::thread> threads;
+    for( size_t t = 0; t < nThreads; ++t ) {
+        threads.emplace_back( [t, &ids]() {
+            for( size_t i = 0; i < nSymbols; ++i ) {
+                const size_t n = (i*(t + 1)) % nSymbols;  // different orders
+                ids[t].push_back( Symbol( "test_concurrent_" + std::to_string(n) ).id() );
+            }
+        } );
+    }
+    for( auto & t : threads ) t.join();
+    for( size_t t = 0; t < nThreads; ++t ) {
+        for( size_t i = 0; i < nSymbols; ++i ) {
+            const size_t n = (i*(t + 1)) % nSymbols;
+            const Symbol s( "test_concurrent_" + std::to_string(n) );
+            ASSERT_EQ( s.id(), ids[t][i] );
+            ASSERT_EQ( "test_concurrent_" + std::to_string(n), s.str() );
+        }
+    }
+}
+
+// Tests dictionary keyed by symbols is looked up by strings without
+// interning absent keys
+TEST( Configuration, symbolDictionary ) {
+    Dictionary d;
+    d.emplace( "threshold", new Parameter<int>(42) );
+    d.insert_or_assign( std::string("gain"), std::make_shared<Parameter<double> >(1.5) );
+    d[Symbol("pedestal")] = std::make_shared<Parameter<double> >(.5);
+    ASSERT_EQ( 3u, d.size() );
+    EXPECT_EQ( 42, d.find( "threshold" )->second->as<int>() );
+    EXPECT_EQ( 1.5, d.find( std::string("gain") )->second->as<double>() );
+    EXPECT_EQ( .5, d.find( std::string_view("pedestal") )->second->as<double>() );
+    EXPECT_EQ( 1u, d.count( "gain" ) );
+    const size_t nSymbols = SymbolTable::self().size();
+    EXPECT_EQ( d.end(), d.find( "test_absent_key" ) );
+    EXPECT_EQ( 0u, d.count( std::string("test_absent_key") ) );
+    EXPECT_EQ( nSymbols, SymbolTable::self().size() );
+    EXPECT_EQ( 42, get_value<int>( d, "threshold" ) );
+    EXPECT_EQ( nullptr, find_parameter( d, "test_absent_key" ) );
+
+    std::unique_ptr<Path> p( Path::from_string( "gain" ) );
+    EXPECT_EQ( Symbol("gain"), p->symbol() );
+    EXPECT_EQ( 1.5, get_parameter_ref( d, p.get() ).as<double>() );
+    std::unique_ptr<Path> absent( Path::from_string( "test_absent_path_key" ) );
+    EXPECT_THROW( get_parameter_ref( d, absent.get() ), std::runtime_error );
+}
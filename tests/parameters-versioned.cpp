@@ -0,0 +1,120 @@
+# include "parameters/versioned.hpp"
+# include "parameters/path.hpp"
+
+# include "gtest/gtest.h"
+
+# include <thread>
+
+/*
+ * Unit test checking versioned configuration holder.
+ */
+
+using namespace dataflow::config;
+
+namespace {
+/// Counts instances alive to check reclamation.
+struct Counted {
+    static int nAlive;
+    int value;
+    Counted( int v ) : value(v) { ++nAlive; }
+    Counted( const Counted & o ) : value(o.value) { ++nAlive; }
+    ~Counted() { --nAlive; }
+};
+int Counted::nAlive = 0;
+}  // anonymous namespace
+
+// Tests pinned version is kept alive and reclaimed once unpinned
+TEST( Configuration, versionedReclamation ) {
+    {
+        Versioned<Counted> h( Counted(1) );
+        Versioned<Counted>::Reader r( h );
+        ASSERT_EQ( 1, h.version() );
+        {
+            auto pin = r.pin();
+            ASSERT_EQ( 1, pin->value );
+            ASSERT_THROW( r.pin(), std::logic_error );
+            ASSERT_EQ( 2, h.publish( Counted(2) ) );
+            // still pinned
+            ASSERT_EQ( 1, pin->value );
+            ASSERT_EQ( 1, h.n_retired() );
+            ASSERT_EQ( 2, Counted::nAlive );
+        }
+        h.reclaim();
+        ASSERT_EQ( 0, h.n_retired() );
+        ASSERT_EQ( 1, Counted::nAlive );
+        ASSERT_EQ( 2, r.pin()->value );
+        // Unpinned versions are reclaimed right away
+        h.update( []( const Counted & c ){ return Counted( c.value + 1 ); } );
+        ASSERT_EQ( 0, h.n_retired() );
+        auto pin = r.pin();
+        ASSERT_EQ( 3, pin->value );
+        ASSERT_EQ( 3, pin.version() );
+    }
+    ASSERT_EQ( 0, Counted::nAlive );
+}
+
+// Tests number of readers is not limited by the slots block size
+TEST( Configuration, versionedManyReaders ) {
+    const size_t nBlock = Versioned<Counted>::kBlockReaders;
+    Versioned<Counted> h( Counted(1) );
+    ASSERT_EQ( nBlock, h.n_slots() );
+    std::vector<std::unique_ptr<Versioned<Counted>::Reader>> readers;
+    std::vector<std::unique_ptr<Versioned<Counted>::Pin>> pins;
+    for( size_t i = 0; i < 2*nBlock + 1; ++i ) {
+        readers.emplace_back( new Versioned<Counted>::Reader( h ) );
+        pins.emplace_back( new Versioned<Counted>::Pin( readers.back()->pin() ) );
+    }
+    ASSERT_EQ( 3*nBlock, h.n_slots() );
+    h.publish( Counted(2) );
+    // pinned by the last reader (in the chained block) only
+    for( size_t i = 0; i < 2*nBlock; ++i ) pins[i].reset();
+    h.reclaim();
+    ASSERT_EQ( 1, h.n_retired() );
+    pins.clear();
+    h.reclaim();
+    ASSERT_EQ( 0, h.n_retired() );
+    // released slots are reused
+    readers.clear();
+    for( size_t i = 0; i < 2*nBlock; ++i ) {
+        readers.emplace_back( new Versioned<Counted>::Reader( h ) );
+    }
+    ASSERT_EQ( 3*nBlock, h.n_slots() );
+    ASSERT_EQ( 2, readers.back()->pin()->value );
+}
+
+// Tests readers always see consistent version under concurrent writer
+TEST( Configuration, versionedConcurrentReaders ) {
+    typedef std::shared_ptr<const Dictionary> Cfg;
+    auto mk = []( int v ) {
+        auto d = std::make_shared<Dictionary>();
+        d->emplace( "a", new Parameter<int>(v) );
+        d->emplace( "b", new Parameter<int>(-v) );
+        return Cfg(d);
+    };
+    Versioned<Cfg> h( mk(0) );
+    std::atomic<bool> stop(false), failed(false);
+    std::vector<std::thread> readers;
+    for( int i = 0; i < 4; ++i ) {
+        readers.emplace_back( [&]() {
+            Versioned<Cfg>::Reader r( h );
+            uint64_t last = 0;
+            while( !stop.load() ) {
+                auto pin = r.pin();
+                const Dictionary & d = **pin;
+                if( get_parameter_ref( d, "a" ).as<int>()
+                 != -get_parameter_ref( d, "b" ).as<int>()
+                 || pin.version() < last ) {
+                    failed = true;
+                }
+                last = pin.version();
+            }
+        } );
+    }
+    for( int v = 1; v <= 2000; ++v ) h.publish( mk(v) );
+    stop = true;
+    for( auto & t : readers ) t.join();
+    ASSERT_FALSE( failed.load() );
+    h.reclaim();
+    ASSERT_EQ( 0, h.n_retired() );
+    ASSERT_EQ( 2001, h.version() );
+}
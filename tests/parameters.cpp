@@ -98,3 +98,46 @@ TEST( Configuration, nestedRetrieval ) {
 }
 
 
+// Tests single-pass retrieval by path string
+TEST( Configuration, retrievalByString ) {
+    Dictionary root;
+    auto calib = std::make_shared<Dictionary>();
+    auto chambers = std::make_shared<Tuple>();
+    auto chamber = std::make_shared<Dictionary>();
+    chamber->emplace( "pedestal", new Parameter<double>(1.5) );
+    chambers->emplace( 28, chamber );
+    calib->emplace( "multiwiredChamber", chambers );
+    root.emplace( "calibration", calib );
+    ASSERT_EQ( 1.5, get_parameter_ref( root
+                    , "calibration.multiwiredChamber[28].pedestal" ).as<double>() );
+    ASSERT_EQ( &root, &get_parameter_ref( root, "" ) );
+    ASSERT_EQ( chamber.get()
+             , &get_parameter_ref( root, "calibration.multiwiredChamber[28]" ) );
+    // Absent entries and type mismatches
+    ASSERT_THROW( get_parameter_ref( root, "calibration.foo" )
+                , std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( root, "calibration.multiwiredChamber[27]" )
+                , std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( root, "calibration[0]" )
+                , std::runtime_error );
+    ASSERT_THROW( get_parameter_ref( root, "calibration.multiwiredChamber.x" )
+                , std::runtime_error );
+    // Grammar errors
+    ASSERT_THROW( get_parameter_ref( root, "calibration..foo" )
+                , InvalidPathString );
+    // Nothing was inserted by failed lookups
+    ASSERT_EQ( 1, calib->size() );
+    ASSERT_EQ( 1, chambers->size() );
+}
+
+// Tests type checking of the parameter value retrieval
+TEST( Configuration, parameterTypeCheck ) {
+    Dictionary dct;
+    dct.emplace( "one", new Parameter<int>(1) );
+    AbstractParameter & p = get_parameter_ref( dct, "one" );
+    ASSERT_EQ( 1, p.as<int>() );
+    ASSERT_EQ( 1, p.as_unchecked<int>() );
+    ASSERT_THROW( p.as<double>(), BadParameterType );
+    ASSERT_THROW( p.as<bool>(), std::bad_cast );  // compatible with former API
+    ASSERT_THROW( dct.as<std::string>(), BadParameterType );
+}
@@ -0,0 +1,162 @@
+# include "pipeline/accumulators.hpp"
+# include "pipeline/parallel.hpp"
+
+# include "gtest/gtest.h"
+
+# include <cmath>
+# include <thread>
+
+/*
+ * Unit test checking accumulators (histograms, counters, moments) filled
+ * by concurrent workers.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+double energy( const int & i ) { return (i % 100)*0.5; }
+
+}  // anonymous namespace
+
+// Tests bins of the values, including underflow, overflow and edges
+TEST( PipelineAccumulators, axes ) {
+    const FixedAxis a( 10, 0., 1. );
+    EXPECT_EQ( 10u, a.size() );
+    EXPECT_EQ( 0u, a.index( -0.1 ) );
+    EXPECT_EQ( 0u, a.index( std::nan("") ) );
+    EXPECT_EQ( 1u, a.index( 0. ) );
+    EXPECT_EQ( 4u, a.index( 0.35 ) );
+    EXPECT_EQ( 10u, a.index( std::nextafter( 1., 0. ) ) );
+    EXPECT_EQ( 11u, a.index( 1. ) );
+    EXPECT_DOUBLE_EQ( 0.3, a.lower( 4 ) );
+    EXPECT_DOUBLE_EQ( 0.4, a.upper( 4 ) );
+    EXPECT_EQ( 1., a.upper( 10 ) );
+    EXPECT_TRUE( a == FixedAxis( 10, 0., 1. ) );
+    EXPECT_TRUE( a != FixedAxis( 20, 0., 1. ) );
+
+    const VariableAxis v( { 1., 2., 4., 8. } );
+    EXPECT_EQ( 3u, v.size() );
+    EXPECT_EQ( 0u, v.index( 0.5 ) );
+    EXPECT_EQ( 1u, v.index( 1. ) );
+    EXPECT_EQ( 2u, v.index( 3.9 ) );
+    EXPECT_EQ( 3u, v.index( 4. ) );
+    EXPECT_EQ( 4u, v.index( 8. ) );
+    EXPECT_EQ( 2., v.lower( 2 ) );
+    EXPECT_EQ( 4., v.upper( 2 ) );
+
+    EXPECT_THROW( FixedAxis( 0, 0., 1. ), BadBinning );
+    EXPECT_THROW( FixedAxis( 10, 1., 1. ), BadBinning );
+    EXPECT_THROW( VariableAxis( { 1. } ), BadBinning );
+    EXPECT_THROW( VariableAxis( { 1., 3., 2. } ), BadBinning );
+}
+
+// Tests histograms, counter and moments are filled and merged
+TEST( PipelineAccumulators, accumulators ) {
+    Histogram1D<> h( FixedAxis( 4, 0., 4. ) );
+    h.fill( 0.5 );
+    h.fill( 2.5, 2. );
+    h.call( 10. );
+    EXPECT_EQ( 3u, h.entries() );
+    EXPECT_EQ( 1., h.bin( 1 ) );
+    EXPECT_EQ( 2., h.bin( 3 ) );
+    EXPECT_EQ( 1., h.bin( 5 ) );
+    Histogram1D<> c = h.clone();
+    EXPECT_EQ( 0u, c.entries() );
+    c.fill( 2.5 );
+    h.merge( c );
+    EXPECT_EQ( 3., h.bin( 3 ) );
+    EXPECT_EQ( 4u, h.entries() );
+    EXPECT_THROW( h.merge( Histogram1D<>( FixedAxis( 4, 0., 5. ) ) ), BadBinning );
+
+    Histogram2D<FixedAxis, VariableAxis> h2( FixedAxis( 2, 0., 2. ), VariableAxis( { 0., 1., 10. } ) );
+    h2.fill( 1.5, 5. );
+    h2.call( std::make_pair( -1., 0.5 ) );
+    EXPECT_EQ( 1., h2.bin( 2, 2 ) );
+    EXPECT_EQ( 1., h2.bin( 0, 1 ) );
+    Histogram2D<FixedAxis, VariableAxis> c2 = h2.clone();
+    c2.fill( 1.5, 5., 0.5 );
+    h2.merge( c2 );
+    EXPECT_EQ( 1.5, h2.bin( 2, 2 ) );
+    EXPECT_EQ( 3u, h2.entries() );
+
+    Counter<int> n;
+    for( int i = 0; i < 5; ++i ) n.call( i );
+    Counter<int> m = n.clone();
+    m.call( 0 );
+    n.merge( m );
+    EXPECT_EQ( 6u, n.count() );
+
+    // large offset does not spoil the variance
+    Moments a, b;
+    for( int i = 0; i < 1000; ++i ) ( i < 300 ? a : b ).fill( 1e9 + (i % 10) );
+    a.merge( b );
+    EXPECT_EQ( 1000u, a.count() );
+    EXPECT_DOUBLE_EQ( 1e9 + 4.5, a.mean() );
+    EXPECT_NEAR( 8.25, a.variance(), 1e-6 );
+    Moments e;
+    a.merge( e );
+    EXPECT_EQ( 1000u, a.count() );
+    e.merge( a );
+    EXPECT_DOUBLE_EQ( a.mean(), e.mean() );
+}
+
+// Tests per-worker copies of accumulators are merged by parallel pipeline
+TEST( PipelineAccumulators, parallel ) {
+    auto h = std::make_shared< Histogram1D<> >( FixedAxis( 50, 0., 50. ) );
+    auto m = std::make_shared<Moments>();
+    Pipeline p;
+    p.append<energy>( "energy" ).append( h, "histogram" ).append( m, "moments" );
+    std::vector<int> values( 10000 );
+    for( size_t i = 0; i < values.size(); ++i ) values[i] = int(i);
+    for( unsigned nWorkers : { 1u, 3u, 4u } ) {
+        ParallelPipeline pp( p, nWorkers, 64 );
+        pp.process( values.data(), values.size() );
+    }
+    EXPECT_EQ( 30000u, h->entries() );
+    EXPECT_EQ( 30000u, m->count() );
+    EXPECT_NEAR( 24.75, m->mean(), 1e-9 );
+    for( size_t i = 1; i <= 50; ++i ) ASSERT_EQ( 600., h->bin( i ) ) << "bin " << i;
+}
+
+// Tests threads fill their shards and snapshots are taken while they do
+TEST( PipelineAccumulators, sharded ) {
+    Sharded< Histogram1D<> > h( Histogram1D<>( FixedAxis( 10, 0., 10. ) ) );
+    const size_t nThreads = 4, nFills = 200000;
+    for( int round = 0; round < 2; ++round ) {
+        std::atomic<bool> done( false );
+        std::vector<std::thread> threads;
+        for( size_t t = 0; t < nThreads; ++t ) {
+            threads.emplace_back( [&h, t]() {
+                for( size_t i = 0; i < nFills; ++i ) h.call( double((i + t) % 10) );
+            } );
+        }
+        // snapshots do not stop the threads, entries grow monotonically
+        uint64_t last = 0;
+        std::thread reader( [&]() {
+            while( !done.load() ) {
+                const uint64_t n = h.snapshot().entries();
+                EXPECT_LE( last, n );
+                last = n;
+            }
+        } );
+        for( auto & t : threads ) t.join();
+        done = true;
+        reader.join();
+    }
+    // slots of exited threads are reused, so are their shards
+    EXPECT_LE( h.size(), nThreads + 1 );
+    const Histogram1D<> r = h.snapshot();
+    EXPECT_EQ( 2*nThreads*nFills, r.entries() );
+    for( size_t i = 1; i <= 10; ++i ) EXPECT_EQ( 2*nThreads*nFills/10., r.bin( i ) );
+    EXPECT_EQ( 0., r.bin( 0 ) );
+
+    // as reentrant handler of parallel pipeline
+    auto c = std::make_shared< Sharded< Counter<double> > >( Counter<double>() );
+    Pipeline p;
+    p.append<energy>( "energy" ).append( c, "count" );
+    std::vector<int> values( 1000, 1 );
+    ParallelPipeline( p, 4, 16 ).process( values.data(), values.size() );
+    EXPECT_EQ( 1000u, c->snapshot().count() );
+    EXPECT_EQ( kReentrant, ConcurrencyTraits< Sharded< Counter<double> > >::policy );
+}
@@ -0,0 +1,86 @@
+# include "pipeline/pipeline.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking per-event arena.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+struct Hit {
+    double x, y;
+};
+typedef std::pmr::vector<Hit> Hits;
+
+const std::pmr::memory_resource * gArenaSeen = nullptr;
+
+Hits reconstruct( const double & x ) {
+    gArenaSeen = event_arena();
+    Hits hits( event_arena() );
+    for( int i = 0; i < int(x); ++i ) hits.push_back( Hit{ x, double(i) } );
+    return hits;
+}
+
+double sum_y( const Hits & hits ) {
+    double s = 0;
+    for( const Hit & h : hits ) s += h.y;
+    return s;
+}
+
+}  // anonymous namespace
+
+// Tests arena serves aligned allocations and is reset keeping the chunks
+TEST( Pipeline, arena ) {
+    Arena a( 1024 );
+    EXPECT_FALSE( a.used() );
+    EXPECT_EQ( 0u, a.n_chunks() );
+    void * p1 = a.allocate( 3, 1 );
+    void * p2 = a.allocate( 8, 8 );
+    EXPECT_EQ( 0u, reinterpret_cast<uintptr_t>(p2) % 8 );
+    EXPECT_LT( p1, p2 );
+    void * big = a.allocate( 5000, 64 );  // larger than chunk
+    EXPECT_EQ( 0u, reinterpret_cast<uintptr_t>(big) % 64 );
+    EXPECT_EQ( 3u, a.n_allocations() );
+    EXPECT_EQ( 2u, a.n_chunks() );
+    a.reset();
+    EXPECT_FALSE( a.used() );
+    EXPECT_EQ( p1, a.allocate( 3, 1 ) );
+    EXPECT_TRUE( a.allocate( 5000, 64 ) );
+    EXPECT_EQ( 2u, a.n_chunks() );  // chunks are reused
+    {
+        std::pmr::vector<int> v( &a );
+        for( int i = 0; i < 1000; ++i ) v.push_back( i );
+        EXPECT_EQ( 999, v.back() );
+    }
+    // large values of the slot are allocated from the arena
+    Slot s( &a );
+    struct Big { double v[16]; };
+    const size_t n = a.n_allocations();
+    s.emplace<Big>().v[3] = 1;
+    EXPECT_EQ( n + 1, a.n_allocations() );
+    EXPECT_EQ( 1, s.get<Big>().v[3] );
+}
+
+// Tests handlers get arena of the event, reused for subsequent events
+TEST( Pipeline, eventArena ) {
+    Pipeline p;
+    p.append<reconstruct>( "reconstruct" ).append<sum_y>( "sum_y" );
+    EXPECT_EQ( std::pmr::get_default_resource(), event_arena() );
+    ASSERT_TRUE( (p << 10.).succeed() );
+    EXPECT_EQ( 45., p.get<double>() );
+    EXPECT_EQ( &p.arena(), gArenaSeen );
+    EXPECT_TRUE( p.arena().used() );
+    EXPECT_EQ( std::pmr::get_default_resource(), event_arena() );
+    for( int i = 0; i < 100; ++i ) p << 50.;
+    const size_t nChunks = p.arena().n_chunks();
+    for( int i = 0; i < 100; ++i ) p << 50.;
+    EXPECT_EQ( nChunks, p.arena().n_chunks() );
+    // batch mode
+    const double values[] = { 2, 3, 4 };
+    const Batch & b = p.process( values, 3 );
+    EXPECT_EQ( (std::vector<double>{1, 3, 6}), b.values<double>() );
+    EXPECT_EQ( 2u + 3u + 3u, p.arena().n_allocations() );  // vectors growth
+}
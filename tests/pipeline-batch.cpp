@@ -0,0 +1,122 @@
+# include "pipeline/pipeline.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking batch mode of the pipeline.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+bool cut_negative( const double & x ) { return x >= 0; }
+void halve( double & x ) { x /= 2; }
+int round_down( const double & x ) { return int(x); }
+bool cut_odd( const int & x ) { return !(x % 2); }
+std::string to_string( const int & x ) { return std::to_string(x); }
+bool cut_short( const std::string & s ) { return s.size() > 1; }
+// long strings, so that they are allocated
+std::string to_long_string( const int & x ) {
+    if( x < 0 ) throw std::runtime_error( "negative value" );
+    return std::string( 32, '0' ) + std::to_string(x);
+}
+
+bool cut_large( const double & x ) { return x < 100; }
+size_t nKernelCalls = 0;
+
+struct Summator {
+    double sum = 0;
+    size_t nBatches = 0;
+    void call( const double & x ) { sum += x; }
+    void call_batch( config::Span<double> values ) {
+        ++nBatches;
+        for( double v : values ) sum += v;
+    }
+};
+
+struct NoDefault {
+    explicit NoDefault( int ) {}
+};
+NoDefault wrap( const int & x ) { return NoDefault(x); }
+
+}  // anonymous namespace
+
+// Hand-written kernel for `cut_large`
+template<>
+struct dataflow::BatchKernel<cut_large> {
+    static void apply( config::Span<double> values, uint8_t * pass ) {
+        ++nKernelCalls;
+        for( size_t i = 0; i < values.size(); ++i ) pass[i] = values[i] < 100;
+    }
+};
+
+// Tests batch mode gives the same results as processing values one by one
+TEST( Pipeline, batchEquivalence ) {
+    const double values[] = { -3, 4, 7.5, 12, -0.5, 44, 0, 310, 5 };
+    const size_t n = sizeof(values)/sizeof(*values);
+    Pipeline p;
+    p.append<cut_negative, halve>( "fused" )
+     .append<round_down>( "round_down" )
+     .append<cut_odd>( "cut_odd" )
+     .append<to_string>( "to_string" )
+     .append<cut_short>( "cut_short" );
+    std::vector<uint32_t> index;
+    std::vector<std::string> results;
+    for( size_t i = 0; i < n; ++i ) {
+        if( !(p << values[i]).succeed() ) continue;
+        index.push_back( i );
+        results.push_back( p.get<std::string>() );
+    }
+    const Batch & b = p.process( values, n );
+    ASSERT_EQ( index.size(), b.size() );
+    EXPECT_EQ( index, b.index() );
+    EXPECT_EQ( results, b.values<std::string>() );
+    // batch object is reused
+    const Batch & b2 = p.process( values + 1, 2 );
+    EXPECT_TRUE( b2.empty() );
+    const Batch & b3 = p.process( values + 5, 1 );
+    ASSERT_EQ( 1u, b3.size() );
+    EXPECT_EQ( 0u, b3.index()[0] );
+    EXPECT_EQ( "22", b3.values<std::string>()[0] );
+}
+
+// Tests batch column stays consistent if handler throws
+TEST( Pipeline, batchException ) {
+    const int values[] = { 1, -2, 3 };
+    Pipeline p;
+    p.append<to_long_string>( "to_long_string" );
+    ASSERT_EQ( 1u, p.process( values, 1 ).size() );
+    EXPECT_THROW( p.process( values, 3 ), std::runtime_error );
+    const Batch & b = p.process( values + 2, 1 );
+    ASSERT_EQ( 1u, b.size() );
+    EXPECT_EQ( std::string( 32, '0' ) + "3", b.values<std::string>()[0] );
+}
+
+// Tests hand-written kernels and adapters are used in batch mode
+TEST( Pipeline, batchKernels ) {
+    const double values[] = { -3, 40, 7, 120, 5 };
+    auto summator = std::make_shared<Summator>();
+    Pipeline p;
+    p.append<cut_negative>( "cut_negative" )
+     .append<cut_large>( "cut_large" )
+     .append( summator, "summator" );
+    nKernelCalls = 0;
+    const Batch & b = p.process( config::Span<const double>( values, 5 ) );
+    EXPECT_EQ( 1u, nKernelCalls );
+    EXPECT_EQ( 1u, summator->nBatches );
+    EXPECT_EQ( 52., summator->sum );
+    EXPECT_EQ( (std::vector<uint32_t>{1, 2, 4}), b.index() );
+    EXPECT_EQ( (std::vector<double>{40, 7, 5}), b.values<double>() );
+}
+
+// Tests batch mode is rejected for handlers not supporting it
+TEST( Pipeline, batchUnsupported ) {
+    const int values[] = { 1, 2 };
+    Pipeline p;
+    p.append<wrap>( "wrap" );
+    EXPECT_NO_THROW( p << 1 );
+    EXPECT_THROW( p.process( values, 2 ), IncompatibleHandlers );
+    EXPECT_THROW( Pipeline().append<halve>().process( values, 2 )
+                , IncompatibleHandlers );
+}
@@ -0,0 +1,117 @@
+# include "pipeline/cuts.hpp"
+# include "pipeline/parallel.hpp"
+
+# include "gtest/gtest.h"
+
+# include <atomic>
+# include <random>
+
+/*
+ * Unit test checking adaptive reordering of commutative cuts.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+// written by concurrent workers, keeps the loop from being optimized out
+std::atomic<double> gSink;
+
+// Expensive cut rejecting nothing
+bool expensive( const double & x ) {
+    double s = 0;
+    for( int i = 0; i < 200; ++i ) s += x*i;
+    gSink.store( s, std::memory_order_relaxed );
+    return s > -1;
+}
+// Cheap cut rejecting half of the values
+bool even( const double & x ) { return 0 == int(x) % 2; }
+bool small( const double & x ) { return x < 1000; }
+bool grouped_cut( const double & x ) { return x >= 0; }
+bool int_cut( const int & x ) { return x >= 0; }
+double grouped_twice( const double & x ) { return 2*x; }
+void grouped_modify( double & x ) { x = -x; }
+
+DATAFLOW_REGISTER_HANDLER( "test-grouped-cut", grouped_cut )
+DATAFLOW_REGISTER_HANDLER( "test-grouped-twice", grouped_twice )
+
+// Pseudo-random values in [0, 2000)
+double scrambled( int i ) {
+    static std::vector<double> values;
+    if( values.empty() ) {
+        std::mt19937 gen( 1337 );
+        for( int k = 0; k < 4000; ++k ) values.push_back( double( gen() % 2000 ) );
+    }
+    return values[i];
+}
+
+}  // anonymous namespace
+
+// Tests cheap rejecting cut is moved forward and results do not change
+TEST( CutGroup, reorder ) {
+    auto cuts = std::make_shared<CutGroup>( 4, 16 );
+    cuts->add<expensive>( "expensive" ).add<small>( "small" ).add<even>( "even" );
+    Pipeline p;
+    p.append( CutGroup::stage( cuts, "cuts" ) );
+    size_t nPassed = 0;
+    for( int i = 0; i < 2000; ++i ) {
+        const double x = scrambled( i );
+        const bool passed = (p << x).succeed();
+        ASSERT_EQ( x < 1000 && 0 == int(x) % 2, passed ) << x;
+        nPassed += passed;
+    }
+    EXPECT_NEAR( 500, nPassed, 50 );
+    ASSERT_EQ( 3u, cuts->cuts().size() );
+    EXPECT_EQ( "expensive", cuts->cuts().back().name );
+    EXPECT_GE( cuts->n_reorders(), 1u );
+    EXPECT_NEAR( .5, cuts->cuts().front().rejection(), .2 );
+    // order follows the data: only odd values below 1000 come
+    for( int i = 0; i < 2000; ++i ) ASSERT_FALSE( (p << double(2*(i % 500) + 1)).succeed() );
+    EXPECT_EQ( "even", cuts->cuts().front().name );
+    EXPECT_GT( cuts->cuts().front().rejection(), .9 );
+    // batch mode applies the current order
+    std::vector<double> values( 100 );
+    for( int i = 0; i < 100; ++i ) values[i] = i;
+    EXPECT_EQ( 50u, p.process( values.data(), values.size() ).size() );
+}
+
+// Tests registered handlers are checked to be stateless cuts
+TEST( CutGroup, registered ) {
+    CutGroup g;
+    g.add( "test-grouped-cut" );
+    EXPECT_THROW( g.add( "test-grouped-twice" ), IncompatibleHandlers );
+    EXPECT_THROW( g.add( "test-grouped-none" ), UnknownHandler );
+    CutGroup h;
+    h.add<grouped_cut>( "a" );
+    EXPECT_THROW( h.add<int_cut>( "b" ), IncompatibleHandlers );
+    EXPECT_THROW( CutGroup::stage( std::make_shared<CutGroup>(), "empty" ), IncompatibleHandlers );
+    EXPECT_THROW( h.add<small>( "a" ), IncompatibleHandlers );
+    EXPECT_THROW( g.add( "test-grouped-cut" ), IncompatibleHandlers );
+    (void) grouped_modify;  // would not compile: `add<grouped_modify>()`
+}
+
+// Tests per-worker copies are merged back
+TEST( CutGroup, parallel ) {
+    auto cuts = std::make_shared<CutGroup>( 2, 8 );
+    cuts->add<expensive>( "expensive" ).add<even>( "even" );
+    Pipeline p;
+    p.append( CutGroup::stage( cuts, "cuts" ) );
+    std::vector<double> values( 4000 );
+    for( int i = 0; i < 4000; ++i ) values[i] = scrambled( i );
+    size_t nExpected = 0;
+    for( double x : values ) nExpected += 0 == int(x) % 2;
+    EXPECT_EQ( nExpected, ParallelPipeline( p, 3, 100 ).process( values.data(), values.size() ) );
+    EXPECT_EQ( "even", cuts->cuts().front().name );
+    EXPECT_GT( cuts->cuts().front().nSampled, 0 );
+
+    // with no reordering by the workers, merged statistics is exact
+    auto all = std::make_shared<CutGroup>( 1, 1u << 30 );
+    all->add<expensive>( "expensive" ).add<even>( "even" );
+    Pipeline pa;
+    pa.append( CutGroup::stage( all, "all" ) );
+    EXPECT_EQ( nExpected, ParallelPipeline( pa, 4, 100 ).process( values.data(), values.size() ) );
+    ASSERT_EQ( "even", all->cuts().front().name );
+    for( const CutGroup::Cut & c : all->cuts() ) EXPECT_EQ( 4000., c.nSampled ) << c.name;
+    EXPECT_EQ( double(values.size() - nExpected), all->cuts().front().nRejected );
+    EXPECT_EQ( 1u, all->n_reorders() );
+}
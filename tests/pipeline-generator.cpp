@@ -0,0 +1,186 @@
+# include "pipeline/generator.hpp"
+# include "pipeline/graph.hpp"
+# include "pipeline/parallel.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking generator handlers producing several values from
+ * single input.
+ */
+
+# ifdef DATAFLOW_GENERATORS
+
+using namespace dataflow;
+
+namespace {
+
+typedef std::vector<int> Block;
+
+// Log of the calls, to check the order of processing
+std::vector<std::string> gLog;
+
+Generator<int> split( const Block & b ) {
+    for( int v : b ) {
+        gLog.push_back( "yield " + std::to_string(v) );
+        co_yield int(v);
+    }
+}
+bool cut_odd( int & v ) {
+    gLog.push_back( "cut " + std::to_string(v) );
+    return 0 == v % 2;
+}
+double half( int v ) { return v/2.; }
+// Yields lvalues (copied) and references to temporaries; takes the string
+// by value, so it is kept in the coroutine frame
+Generator<std::string> repeat( std::string s ) {
+    std::string r;
+    for( char c : s ) {
+        r += c;
+        co_yield r;
+    }
+    co_yield std::string("end");
+}
+Generator<int> failing( const Block & b ) {
+    co_yield 1;
+    if( b.empty() ) throw std::runtime_error( "empty block" );
+    co_yield 2;
+}
+// Split into blocks of two values, so generators are nested
+Generator<Block> pairs( const Block & b ) {
+    for( size_t i = 0; i < b.size(); i += 2 ) {
+        co_yield Block( b.begin() + i, b.begin() + std::min( i + 2, b.size() ) );
+    }
+}
+
+struct Sum {
+    int sum = 0;
+    void call( int & v ) { sum += v; }
+};
+
+// Stateful generator numbering values it yields
+struct Enumerate {
+    int n = 0;
+    Generator<int> call( const Block & b ) {
+        for( int v : b ) co_yield v*1000 + n++;
+    }
+};
+
+}  // anonymous namespace
+
+DATAFLOW_REGISTER_HANDLER( "test-split", split )
+
+// Tests generator kind is deduced from signature
+TEST( PipelineGenerator, traits ) {
+    typedef meta::StageTraits<decltype(&split)> Traits;
+    EXPECT_EQ( kGenerate, Traits::kind );
+    EXPECT_TRUE( (std::is_same<Block, Traits::Input>::value) );
+    EXPECT_TRUE( (std::is_same<int, Traits::Output>::value) );
+    EXPECT_FALSE( aux::batchable<Traits>() );
+    typedef meta::StageTraits<decltype(&Enumerate::call)> MethodTraits;
+    EXPECT_EQ( kGenerate, MethodTraits::kind );
+    EXPECT_TRUE( MethodTraits::stateful );
+    // vector returned is single value
+    typedef meta::StageTraits<Block (*)(int)> MapTraits;
+    EXPECT_EQ( kMap, MapTraits::kind );
+}
+
+// Tests generator yields values, copying lvalues, and rethrows exceptions
+TEST( PipelineGenerator, generator ) {
+    std::vector<std::string> r;
+    for( std::string & s : repeat( "abc" ) ) r.push_back( std::move(s) );
+    EXPECT_EQ( (std::vector<std::string>{ "a", "ab", "abc", "end" }), r );
+
+    int n = 0;
+    for( int v : split( Block{} ) ) n += v;
+    EXPECT_EQ( 0, n );
+
+    Generator<int> g = failing( Block{} );
+    auto it = g.begin();
+    EXPECT_EQ( 1, *it );
+    EXPECT_THROW( ++it, std::runtime_error );
+}
+
+// Tests frames are reused by generators created one after another
+TEST( PipelineGenerator, framePool ) {
+    const Block b{ 1, 2, 3 };
+    for( int v : split( b ) ) (void) v;
+    const size_t nAllocated = FramePool::n_allocated();
+    for( int i = 0; i < 100; ++i ) {
+        for( int v : split( b ) ) (void) v;
+    }
+    EXPECT_EQ( nAllocated, FramePool::n_allocated() );
+    void * p = FramePool::allocate( 100 );
+    FramePool::deallocate( p, 100 );
+    EXPECT_EQ( p, FramePool::allocate( 120 ) );  // same size class
+    FramePool::deallocate( p, 120 );
+    p = FramePool::allocate( 2*FramePool::kMaxSize );  // not pooled
+    FramePool::deallocate( p, 2*FramePool::kMaxSize );
+}
+
+// Tests next stages run on each value before the next one is yielded
+TEST( PipelineGenerator, pipeline ) {
+    auto sum = std::make_shared<Sum>();
+    Pipeline p;
+    p.append<split>( "split" ).append<cut_odd>( "cut_odd" ).append( sum );
+    EXPECT_EQ( 3u, p.size() );
+    gLog.clear();
+    EXPECT_TRUE( (p << Block{ 1, 2, 3, 4, 5 }).succeed() );
+    EXPECT_EQ( 6, sum->sum );
+    EXPECT_EQ( 5, p.get<int>() );  // last processed, even if cut
+    EXPECT_EQ( (std::vector<std::string>{ "yield 1", "cut 1", "yield 2", "cut 2"
+                                        , "yield 3", "cut 3", "yield 4", "cut 4"
+                                        , "yield 5", "cut 5" }), gLog );
+    // nothing passed
+    EXPECT_FALSE( (p << Block{ 1, 3 }).succeed() );
+    EXPECT_FALSE( (p << Block{}).succeed() );
+    EXPECT_EQ( 6, sum->sum );
+
+    Pipeline q;
+    q.append<failing>( "failing" );
+    EXPECT_THROW( q << Block{}, std::runtime_error );
+    EXPECT_TRUE( (q << Block{ 1 }).succeed() );
+    EXPECT_EQ( 2, q.get<int>() );
+}
+
+// Tests nested, fused, stateful and registered generators
+TEST( PipelineGenerator, stages ) {
+    auto sum = std::make_shared<Sum>();
+    Pipeline p;
+    p.append<pairs>( "pairs" ).append<split, cut_odd>( "split" ).append( sum );
+    EXPECT_TRUE( (p << Block{ 1, 2, 3, 4, 5, 6, 7 }).succeed() );
+    EXPECT_EQ( 12, sum->sum );
+
+    double r = 0;
+    Block b{ 2, 3, 4 };
+    EXPECT_TRUE( (Fused<split, cut_odd, half>::run( b, [&r]( double & v ) { r += v; } )) );
+    EXPECT_EQ( 3., r );
+    EXPECT_EQ( nullptr, Fused<split>::read_invoker() );
+
+    Pipeline e;
+    e.append( std::make_shared<Enumerate>(), "enumerate" );
+    EXPECT_TRUE( (e << Block{ 7, 8 }).succeed() );
+    EXPECT_EQ( 8001, e.get<int>() );
+    EXPECT_TRUE( (e << Block{ 9 }).succeed() );
+    EXPECT_EQ( 9002, e.get<int>() );
+
+    const HandlerDescription & d = HandlersIndex::self().get( "test-split" );
+    EXPECT_EQ( kGenerate, d.kind );
+    EXPECT_EQ( nullptr, d.invoke );
+    Pipeline n{ "test-split" };
+    EXPECT_TRUE( (n << Block{ 5, 6 }).succeed() );
+    EXPECT_EQ( 6, n.get<int>() );
+}
+
+// Tests generators are rejected by the engines not supporting them
+TEST( PipelineGenerator, unsupported ) {
+    Pipeline p;
+    p.append<split>( "split" );
+    const Block b[1] = { Block{ 1 } };
+    EXPECT_THROW( p.process( b, 1 ), IncompatibleHandlers );
+    EXPECT_THROW( ParallelPipeline pp( p, 2 ), IncompatibleHandlers );
+    Graph g;
+    EXPECT_THROW( (g.add<split>( "split", Graph::kInput )), BadGraph );
+}
+
+# endif  // DATAFLOW_GENERATORS
@@ -0,0 +1,157 @@
+# include "pipeline/graph.hpp"
+
+# include "gtest/gtest.h"
+
+# include <atomic>
+
+/*
+ * Unit test checking dataflow graph.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+std::atomic<int> gNDecoded{0};
+
+std::vector<double> decode( const int & n ) {
+    ++gNDecoded;
+    std::vector<double> v;
+    for( int i = 1; i <= n; ++i ) v.push_back( i );
+    return v;
+}
+double sum( const std::vector<double> & v ) {
+    double s = 0;
+    for( double x : v ) s += x;
+    return s;
+}
+size_t count( const std::vector<double> & v ) { return v.size(); }
+bool not_empty( const std::vector<double> & v ) { return !v.empty(); }
+bool positive( const double & x ) { return x > 0; }
+void negate( std::vector<double> & v ) { for( double & x : v ) x = -x; }
+double mean( const double & s, const size_t & n ) { return s/n; }
+float halve( const double & x ) { return float(x/2); }
+double twice( const double & x ) { return 2*x; }
+int to_int( const double & x ) { return int(x); }
+
+struct Counter {
+    size_t n = 0;
+    void call( const double & ) { ++n; }
+};
+
+}  // anonymous namespace
+
+// Tests the shared value is computed once and consumed by branches
+TEST( Graph, diamond ) {
+    Graph g;
+    g.add<decode>( "decode", Graph::kInput )
+     .add<sum>( "sum", "decode" )
+     .add<count>( "count", "decode" )
+     .join<mean>( "mean", {"sum", "count"} );
+    gNDecoded = 0;
+    ASSERT_TRUE( (g << 4).succeed() );
+    EXPECT_EQ( 1, gNDecoded );
+    EXPECT_DOUBLE_EQ( 2.5, g.get<double>( "mean" ) );
+    EXPECT_EQ( 4u, g.size() );
+    EXPECT_EQ( 2u, g.width() );
+    // only leaves and marked nodes are available
+    EXPECT_THROW( g.get<double>( "sum" ), BadGraph );
+    g.output( "sum" );
+    ASSERT_TRUE( (g << 3).succeed() );
+    EXPECT_DOUBLE_EQ( 6, g.get<double>( "sum" ) );
+    EXPECT_DOUBLE_EQ( 2, g.get<double>( "mean" ) );
+    EXPECT_THROW( g.get<int>( "mean" ), BadSlotAccess );
+    EXPECT_THROW( g << 1., IncompatibleHandlers );
+}
+
+// Tests failed cut skips only the nodes depending on it
+TEST( Graph, pruning ) {
+    Graph g;
+    g.add<decode>( "decode", Graph::kInput )
+     .add<not_empty, sum>( "sum", "decode" )
+     .add<count>( "count", "decode" )
+     .join<mean>( "mean", {"sum", "count"} );
+    g.output( "count" );
+    g << 0;
+    EXPECT_FALSE( g.succeed() );
+    EXPECT_FALSE( g.succeed( "sum" ) );
+    EXPECT_FALSE( g.succeed( "mean" ) );
+    ASSERT_TRUE( g.succeed( "count" ) );
+    EXPECT_EQ( 0u, g.get<size_t>( "count" ) );
+    EXPECT_THROW( g.get<double>( "mean" ), BadSlotAccess );
+    g << 2;
+    EXPECT_TRUE( g.succeed() );
+    EXPECT_DOUBLE_EQ( 1.5, g.get<double>( "mean" ) );
+}
+
+// Tests modifying handler does not affect the value shared with others,
+// pass-through cut results in the value of its input
+TEST( Graph, sharing ) {
+    Graph g;
+    g.add<decode>( "decode", Graph::kInput )
+     .add<negate, sum>( "negated", "decode" )
+     .add<sum>( "sum", "decode" )
+     .add<positive>( "positive", "sum" )
+     .add<twice>( "twice", "sum" );
+    g << 3;
+    EXPECT_DOUBLE_EQ( -6, g.get<double>( "negated" ) );
+    EXPECT_DOUBLE_EQ( 6, g.get<double>( "positive" ) );
+    EXPECT_DOUBLE_EQ( 12, g.get<double>( "twice" ) );
+    // single consumer modifies the value in place
+    Graph h;
+    h.add<decode>( "decode", Graph::kInput )
+     .add<negate, sum>( "negated", "decode" );
+    EXPECT_DOUBLE_EQ( -3, (h << 2).get<double>( "negated" ) );
+}
+
+// Tests adapters are inserted between mismatching ports and shared
+TEST( Graph, adapters ) {
+    Graph g;
+    g.add<halve>( "halve", Graph::kInput )
+     .add<twice>( "a", "halve" )
+     .add<positive>( "b", "halve" )
+     .add<to_int>( "c", "a" );
+    g << 5.;
+    EXPECT_EQ( 5u, g.size() );  // single adapter from float to double
+    EXPECT_DOUBLE_EQ( 2.5, g.get<double>( "b" ) );
+    EXPECT_EQ( 5, g.get<int>( "c" ) );
+    g.add<sum>( "sum", "halve" );
+    EXPECT_THROW( g.compile(), IncompatibleHandlers );
+}
+
+// Tests errors of graph building
+TEST( Graph, errors ) {
+    Graph g;
+    EXPECT_THROW( g.compile(), BadGraph );
+    g.add<twice>( "a", Graph::kInput );
+    EXPECT_THROW( g.add<twice>( "a", Graph::kInput ), BadGraph );
+    EXPECT_THROW( g.add<twice>( Graph::kInput, "a" ), BadGraph );
+    EXPECT_THROW( g.join<mean>( "m", {"a"} ), BadGraph );
+    g.add<twice>( "b", "c" );
+    EXPECT_THROW( g.compile(), BadGraph );
+    g.add<twice>( "c", "b" );
+    EXPECT_THROW( g.compile(), BadGraph );  // cycle
+    EXPECT_THROW( g.output( "d" ), BadGraph );
+}
+
+// Tests independent nodes run concurrently give the same results,
+// shared stateful handler is not called concurrently
+TEST( Graph, parallel ) {
+    auto counter = std::make_shared<Counter>();
+    Graph g( 4 );
+    g.add<decode>( "decode", Graph::kInput )
+     .add<sum>( "sum", "decode" )
+     .add<count>( "count", "decode" )
+     .add<not_empty, sum>( "sum2", "decode" )
+     .join<mean>( "mean", {"sum2", "count"} )
+     .add( "c1", "sum", counter )
+     .add( "c2", "sum2", counter );
+    for( int n = 0; n < 100; ++n ) {
+        g << n;
+        ASSERT_EQ( n > 0, g.succeed( "mean" ) );
+        if( n ) {
+            ASSERT_DOUBLE_EQ( (n + 1)/2., g.get<double>( "mean" ) );
+        }
+    }
+    EXPECT_EQ( 100u + 99u, counter->n );
+}
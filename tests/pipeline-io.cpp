@@ -0,0 +1,189 @@
+# include "pipeline/io.hpp"
+
+# include "gtest/gtest.h"
+
+# include <fstream>
+
+/*
+ * Unit test checking prefetching event sources and asynchronous sink.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+struct Hit {
+    int32_t channel;
+    float amplitude;
+};
+
+std::string temp_file() {
+    char filename[] = "/tmp/dataflow-test-XXXXXX";
+    int fd = mkstemp( filename );
+    if( fd < 0 ) throw std::runtime_error( "unable to create temporary file" );
+    close( fd );
+    return filename;
+}
+
+// Record of i-th event: i repeated (i % 37) times, so records differ in size
+std::vector<uint32_t> record( uint32_t i ) {
+    return std::vector<uint32_t>( i % 37, i );
+}
+
+void check_records( EventSource & src, uint32_t nRecords ) {
+    EventView v;
+    for( uint32_t i = 0; i < nRecords; ++i ) {
+        ASSERT_TRUE( src.next( v ) ) << "record " << i;
+        ASSERT_EQ( i, v.number );
+        const std::vector<uint32_t> r = record( i );
+        ASSERT_EQ( r.size()*4, v.size ) << "record " << i;
+        ASSERT_EQ( 0, memcmp( r.data(), v.data, v.size ) ) << "record " << i;
+    }
+    ASSERT_FALSE( src.next( v ) );
+    ASSERT_FALSE( src.next( v ) );
+    ASSERT_EQ( nRecords, src.n_records() );
+}
+
+bool cut_odd( const Hit & h ) { return 0 == h.channel % 2; }
+Hit decode( const EventView & v ) {
+    Hit h;
+    memcpy( &h, v.data, sizeof(h) );
+    return h;
+}
+
+}  // anonymous namespace
+
+// Tests records of variable size are read back by all the sources
+TEST( PipelineIO, variableRecords ) {
+    const std::string filename = temp_file();
+    const uint32_t nRecords = 5000;
+    for( unsigned nBuffers : { 1u, 2u } ) {
+        // small buffers, so records cross their boundaries
+        AsyncSink sink( filename, 0, nBuffers, 1000 );
+        for( uint32_t i = 0; i < nRecords; ++i ) {
+            const std::vector<uint32_t> r = record( i );
+            sink.write( r.data(), r.size()*4 );
+        }
+        sink.close();
+
+        MappedSource mapped( filename, 0, 4096 );
+        check_records( mapped, nRecords );
+        MappedSource unadvised( filename, 0, 0 );
+        check_records( unadvised, nRecords );
+        for( unsigned n : { 1u, 2u, 3u } ) {
+            StreamSource stream( filename, 0, n, 1000 );
+            check_records( stream, nRecords );
+        }
+    }
+    remove( filename.c_str() );
+}
+
+// Tests fixed-size records and records larger than buffer
+TEST( PipelineIO, fixedRecords ) {
+    const std::string filename = temp_file();
+    {
+        AsyncSink sink( filename, 10000 );
+        std::vector<char> r( 10000 );
+        for( int i = 0; i < 10; ++i ) {
+            std::fill( r.begin(), r.end(), char(i) );
+            sink.write( r.data(), r.size() );
+        }
+        ASSERT_THROW( sink.write( r.data(), 10 ), BadRecord );
+    }  // closed by destructor
+    for( unsigned n : { 1u, 3u } ) {
+        StreamSource stream( filename, 10000, n, 4096 );
+        EventView v;
+        for( int i = 0; i < 10; ++i ) {
+            ASSERT_TRUE( stream.next( v ) );
+            ASSERT_EQ( 10000u, v.size );
+            ASSERT_EQ( char(i), v.data[0] );
+            ASSERT_EQ( char(i), v.data[9999] );
+        }
+        ASSERT_FALSE( stream.next( v ) );
+    }
+    remove( filename.c_str() );
+}
+
+// Tests truncated input and missing files are reported
+TEST( PipelineIO, errors ) {
+    const std::string filename = temp_file();
+    {
+        std::ofstream ofs( filename, std::ios::binary );
+        const uint32_t len = 8;
+        ofs.write( reinterpret_cast<const char *>(&len), 4 );
+        ofs.write( "1234", 4 );  // four bytes missing
+    }
+    EventView v;
+    MappedSource mapped( filename );
+    ASSERT_THROW( mapped.next( v ), BadRecord );
+    for( unsigned n : { 1u, 3u } ) {
+        StreamSource stream( filename, 0, n, 4096 );
+        ASSERT_THROW( stream.next( v ), BadRecord );
+    }
+    // complete records are taken before the error is reported
+    {
+        std::ofstream ofs( filename, std::ios::binary );
+        for( int i = 0; i < 3; ++i ) {
+            const uint32_t len = 4;
+            ofs.write( reinterpret_cast<const char *>(&len), 4 );
+            ofs.write( "1234", 4 );
+        }
+        const uint32_t len = 8;
+        ofs.write( reinterpret_cast<const char *>(&len), 4 );
+        ofs.write( "12", 2 );
+    }
+    MappedSource mappedTail( filename );
+    for( int i = 0; i < 3; ++i ) ASSERT_TRUE( mappedTail.next( v ) );
+    ASSERT_THROW( mappedTail.next( v ), BadRecord );
+    for( unsigned n : { 1u, 3u } ) {
+        StreamSource stream( filename, 0, n, 4096 );
+        for( int i = 0; i < 3; ++i ) {
+            ASSERT_TRUE( stream.next( v ) ) << n << " buffer(s)";
+            ASSERT_EQ( std::string( "1234" ), std::string( v.data, v.size ) );
+        }
+        ASSERT_THROW( stream.next( v ), BadRecord ) << n << " buffer(s)";
+        ASSERT_THROW( stream.next( v ), BadRecord ) << n << " buffer(s)";
+        ASSERT_EQ( 3u, stream.n_records() );
+    }
+    // empty file
+    { std::ofstream ofs( filename, std::ios::binary ); }
+    StreamSource empty( filename );
+    ASSERT_FALSE( empty.next( v ) );
+    remove( filename.c_str() );
+
+    ASSERT_THROW( MappedSource( "/nonexisting/file.dat" ), std::runtime_error );
+    ASSERT_THROW( StreamSource( "/nonexisting/file.dat" ), std::runtime_error );
+    ASSERT_THROW( AsyncSink( "/nonexisting/file.dat" ), std::runtime_error );
+}
+
+// Tests source feeding pipeline ending with sink stage
+TEST( PipelineIO, pipeline ) {
+    const std::string input = temp_file(), output = temp_file();
+    const int nRecords = 1000;
+    {
+        AsyncSink sink( input, sizeof(Hit) );
+        for( int i = 0; i < nRecords; ++i ) {
+            const Hit h{ i, 0.5f*i };
+            sink.write( &h, sizeof(h) );
+        }
+    }
+    auto sink = std::make_shared<AsyncSink>( output, sizeof(Hit), 2, 4096 );
+    Pipeline p;
+    p.append<decode, cut_odd>( "decode" )
+     .append( AsyncSink::stage<Hit>( sink, "write" ) );
+    StreamSource src( input, sizeof(Hit) );
+    ASSERT_EQ( size_t(nRecords/2), drain( src, p ) );
+    sink->close();
+
+    MappedSource result( output, sizeof(Hit) );
+    EventView v;
+    for( int i = 0; i < nRecords; i += 2 ) {
+        ASSERT_TRUE( result.next( v ) );
+        const Hit h = decode( v );
+        ASSERT_EQ( i, h.channel );
+        ASSERT_EQ( 0.5f*i, h.amplitude );
+    }
+    ASSERT_FALSE( result.next( v ) );
+    remove( input.c_str() );
+    remove( output.c_str() );
+}
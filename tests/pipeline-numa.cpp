@@ -0,0 +1,151 @@
+# include "pipeline/accumulators.hpp"
+# include "pipeline/numa.hpp"
+# include "pipeline/parallel.hpp"
+
+# include "gtest/gtest.h"
+
+# include <cstdlib>
+# include <fstream>
+# include <thread>
+
+# include <sys/stat.h>
+# include <unistd.h>
+
+/*
+ * Unit test checking NUMA topology discovery and the pool and parallel
+ * pipeline placed on the nodes.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+double energy( const int & i ) { return (i % 100)*0.5; }
+
+// Two nodes of two CPUs each, all placed on the CPUs the test may use
+std::vector<NumaNode> fake_nodes() {
+    const std::vector<unsigned> cpus = allowed_cpus();
+    return { NumaNode{ 0, { cpus.front(), cpus.back() } }
+           , NumaNode{ 1, { cpus.back(), cpus.front() } } };
+}
+
+}  // anonymous namespace
+
+// Tests CPU lists are parsed as sysfs writes them
+TEST( PipelineNuma, cpu_list ) {
+    EXPECT_EQ( std::vector<unsigned>({ 0, 1, 2, 3, 8, 10, 11 }), aux::parse_cpu_list( "0-3,8,10-11\n" ) );
+    EXPECT_EQ( std::vector<unsigned>({ 5 }), aux::parse_cpu_list( "5" ) );
+    EXPECT_EQ( std::vector<unsigned>({ 1, 2 }), aux::parse_cpu_list( "2,1-2" ) );
+    EXPECT_TRUE( aux::parse_cpu_list( "" ).empty() );
+}
+
+// Tests nodes are read from sysfs and restricted to allowed CPUs
+TEST( PipelineNuma, topology ) {
+    char dir[] = "/tmp/dataflow-numa-XXXXXX";
+    ASSERT_TRUE( mkdtemp( dir ) );
+    const std::string root( dir );
+    const char * lists[] = { "0-3", "4-7", "" };
+    for( int i = 0; i < 3; ++i ) {
+        const std::string node = root + "/node" + std::to_string( i );
+        ASSERT_EQ( 0, mkdir( node.c_str(), 0700 ) );
+        std::ofstream( node + "/cpulist" ) << lists[i] << "\n";
+    }
+    ASSERT_EQ( 0, mkdir( (root + "/power").c_str(), 0700 ) );
+
+    std::vector<NumaNode> nodes = numa_nodes( root, { 6, 1, 2, 5 } );
+    ASSERT_EQ( 2u, nodes.size() );
+    EXPECT_EQ( 0u, nodes[0].id );
+    EXPECT_EQ( std::vector<unsigned>({ 1, 2 }), nodes[0].cpus );
+    EXPECT_EQ( 1u, nodes[1].id );
+    EXPECT_EQ( std::vector<unsigned>({ 5, 6 }), nodes[1].cpus );
+
+    // node having no allowed CPUs is skipped
+    nodes = numa_nodes( root, { 4 } );
+    ASSERT_EQ( 1u, nodes.size() );
+    EXPECT_EQ( 1u, nodes[0].id );
+
+    // no sysfs: single node of all the allowed CPUs
+    nodes = numa_nodes( root + "/none", { 3, 1 } );
+    ASSERT_EQ( 1u, nodes.size() );
+    EXPECT_EQ( std::vector<unsigned>({ 1, 3 }), nodes[0].cpus );
+
+    for( int i = 0; i < 3; ++i ) {
+        const std::string node = root + "/node" + std::to_string( i );
+        unlink( (node + "/cpulist").c_str() );
+        rmdir( node.c_str() );
+    }
+    rmdir( (root + "/power").c_str() );
+    rmdir( root.c_str() );
+
+    // machine itself has at least one node
+    EXPECT_FALSE( numa_nodes().empty() );
+    EXPECT_TRUE( pin_thread( allowed_cpus() ) );
+}
+
+// Tests placed pool covers every index once, on the workers of each node
+TEST( PipelineNuma, pool ) {
+    WorkStealingPool pool( fake_nodes(), 2 );
+    EXPECT_EQ( 4u, pool.size() );
+    EXPECT_EQ( 2u, pool.n_nodes() );
+    EXPECT_EQ( 0u, pool.node( 1 ) );
+    EXPECT_EQ( 1u, pool.node( 2 ) );
+
+    std::vector<std::atomic<int>> hits( 10000 );
+    for( auto & h : hits ) h = 0;
+    pool.run( hits.size(), 16, [&]( unsigned, size_t b, size_t e ) {
+            for( size_t i = b; i < e; ++i ) ++hits[i];
+        } );
+    for( size_t i = 0; i < hits.size(); ++i ) ASSERT_EQ( 1, hits[i] ) << "index " << i;
+
+    // each worker runs once, none of them on the caller thread
+    std::vector<std::thread::id> ids( pool.size() );
+    pool.run_each( [&]( unsigned w, size_t b, size_t e ) {
+            EXPECT_EQ( w, b );
+            EXPECT_EQ( w + 1, e );
+            ids[w] = std::this_thread::get_id();
+        } );
+    for( size_t i = 0; i < ids.size(); ++i ) {
+        EXPECT_NE( std::this_thread::get_id(), ids[i] );
+        for( size_t k = 0; k < i; ++k ) EXPECT_NE( ids[k], ids[i] );
+    }
+    EXPECT_THROW( pool.run_each( []( unsigned w, size_t, size_t ) {
+            if( 3 == w ) throw std::runtime_error( "failed" );
+        } ), std::runtime_error );
+
+    // unplaced pool runs worker 0 on the caller
+    WorkStealingPool plain( 2 );
+    EXPECT_EQ( 1u, plain.n_nodes() );
+    plain.run_each( [&]( unsigned w, size_t, size_t ) {
+            ids[w] = std::this_thread::get_id();
+        } );
+    EXPECT_EQ( std::this_thread::get_id(), ids[0] );
+}
+
+// Tests placed parallel pipeline gives the same results as the serial one
+TEST( PipelineNuma, parallel ) {
+    auto h = std::make_shared< Histogram1D<> >( FixedAxis( 50, 0., 50. ) );
+    auto m = std::make_shared<Moments>();
+    Pipeline p;
+    p.append<energy>( "energy" ).append( h, "histogram" ).append( m, "moments" );
+    std::vector<int> values( 10000 );
+    for( size_t i = 0; i < values.size(); ++i ) values[i] = int(i);
+
+    ParallelPipeline pp( p, fake_nodes(), 3, 64 );
+    EXPECT_EQ( 6u, pp.workers() );
+    EXPECT_EQ( 2u, pp.nodes() );
+    std::vector<double> energies( values.size(), -1. );
+    EXPECT_EQ( values.size(), pp.process( values.data(), values.size(), [&]( size_t i, Slot & r ) {
+            energies[i] = r.get<double>();
+        } ) );
+    EXPECT_EQ( values.size(), pp.process( values.data(), values.size() ) );
+    for( size_t i = 0; i < values.size(); ++i ) ASSERT_EQ( energy( values[i] ), energies[i] );
+    EXPECT_EQ( 20000u, h->entries() );
+    EXPECT_EQ( 20000u, m->count() );
+    EXPECT_NEAR( 24.75, m->mean(), 1e-9 );
+    for( size_t i = 1; i <= 50; ++i ) ASSERT_EQ( 400., h->bin( i ) ) << "bin " << i;
+
+    // the machine's own topology
+    ParallelPipeline local( p, numa_nodes() );
+    EXPECT_EQ( values.size(), local.process( values.data(), values.size() ) );
+    EXPECT_EQ( 30000u, h->entries() );
+}
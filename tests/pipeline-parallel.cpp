@@ -0,0 +1,101 @@
+# include "pipeline/parallel.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking work-stealing pool and parallel pipeline.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+bool cut_negative( const double & x ) { return x >= 0; }
+double twice( const double & x ) { return 2*x; }
+
+// Serialized by default
+struct Counter {
+    size_t n = 0;
+    void call( const double & ) { ++n; }
+};
+
+struct Summator {
+    static constexpr ConcurrencyPolicy kConcurrency = kCloned;
+    double sum = 0;
+    size_t nMerged = 0;
+    void call( const double & x ) { sum += x; }
+    Summator clone() const { return Summator(); }
+    void merge( const Summator & o ) { sum += o.sum; ++nMerged; }
+};
+
+struct AtomicCounter {
+    static constexpr ConcurrencyPolicy kConcurrency = kReentrant;
+    std::atomic<size_t> n{0};
+    void call( const double & ) { ++n; }
+};
+
+}  // anonymous namespace
+
+// Tests each index is processed exactly once
+TEST( Pipeline, workStealingPool ) {
+    WorkStealingPool pool( 4 );
+    const size_t n = 10007;
+    std::vector<std::atomic<int> > hits( n );
+    for( int k = 0; k < 3; ++k ) {
+        pool.run( n, 13, [&]( unsigned w, size_t b, size_t e ) {
+                ASSERT_LT( w, pool.size() );
+                ASSERT_LE( e - b, 13u );
+                for( size_t i = b; i < e; ++i ) ++hits[i];
+            } );
+    }
+    for( size_t i = 0; i < n; ++i ) ASSERT_EQ( 3, hits[i] ) << "index " << i;
+    EXPECT_THROW( pool.run( n, 1, []( unsigned, size_t b, size_t ) {
+                if( 5000 == b ) throw std::runtime_error( "test" );
+            } ), std::runtime_error );
+    pool.run( 0, 1, []( unsigned, size_t, size_t ) { FAIL(); } );
+}
+
+// Tests parallel processing gives the same results as sequential one and
+// stateful handlers are used according to their policies
+TEST( Pipeline, parallel ) {
+    auto counter = std::make_shared<Counter>();
+    auto summator = std::make_shared<Summator>();
+    auto atomicCounter = std::make_shared<AtomicCounter>();
+    Pipeline p;
+    p.append<cut_negative, twice>( "fused" )
+     .append( counter, "counter" )
+     .append( summator, "summator" )
+     .append( atomicCounter, "atomicCounter" );
+    EXPECT_EQ( kSerialized, p.stages()[1].concurrency );
+    EXPECT_EQ( kCloned, p.stages()[2].concurrency );
+    EXPECT_EQ( kReentrant, p.stages()[3].concurrency );
+
+    std::vector<double> values( 20000 );
+    for( size_t i = 0; i < values.size(); ++i ) values[i] = (i % 7) - 2.;
+    std::vector<double> expected( values.size(), -1 );
+    double expectedSum = 0;
+    size_t nExpected = 0;
+    for( size_t i = 0; i < values.size(); ++i ) {
+        if( values[i] < 0 ) continue;
+        expected[i] = 2*values[i];
+        expectedSum += expected[i];
+        ++nExpected;
+    }
+
+    ParallelPipeline pp( p, 4, 64 );
+    EXPECT_EQ( 4u, pp.workers() );
+    std::vector<double> results( values.size(), -1 );
+    for( int k = 1; k <= 2; ++k ) {
+        size_t nPassed = pp.process( values.data(), values.size()
+                                   , [&]( size_t i, Slot & r ) { results[i] = r.get<double>(); } );
+        EXPECT_EQ( nExpected, nPassed );
+        EXPECT_EQ( expected, results );
+        EXPECT_EQ( k*nExpected, counter->n );
+        EXPECT_EQ( k*nExpected, atomicCounter->n );
+        EXPECT_DOUBLE_EQ( k*expectedSum, summator->sum );
+        // copies of 3 other workers merged pairwise: 2 levels into original
+        EXPECT_EQ( k*2u, summator->nMerged );
+    }
+    const int ints[] = {1};
+    EXPECT_THROW( pp.process( ints, 1 ), IncompatibleHandlers );
+}
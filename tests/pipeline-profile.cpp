@@ -0,0 +1,96 @@
+# include "pipeline/parallel.hpp"
+
+# include "gtest/gtest.h"
+
+# include <sstream>
+# include <thread>
+
+/*
+ * Unit test checking per-handler instrumentation.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+bool profiled_cut( double & x ) { return x > 0; }
+double profiled_twice( const double & x ) { return 2*x; }
+float profiled_half( const float & x ) { return x/2; }
+
+}  // anonymous namespace
+
+DATAFLOW_REGISTER_HANDLER( "test-profiled-half", profiled_half )
+
+// Tests counters of several threads are merged and reset
+TEST( Profiler, merge ) {
+    Profiler & p = Profiler::self();
+    const unsigned probe = p.probe( "test-merge" );
+    EXPECT_EQ( probe, p.probe( "test-merge" ) );
+    p.reset();
+    auto record = [probe]() {
+        aux::ProfileTable * t = aux::thread_profile_table();
+        for( int i = 0; i < 100; ++i ) t->record( probe, 10 + i, 1, i % 4 != 0 );
+        t->record( probe, 1000, 10, 5 );  // batch
+        t->count( probe, 2, 1 );  // not timed
+    };
+    record();
+    std::thread( record ).join();  // counters outlive the thread
+    std::map<std::string, HandlerStats> s = p.snapshot();
+    ASSERT_TRUE( s.count( "test-merge" ) );
+    const HandlerStats & st = s["test-merge"];
+    EXPECT_EQ( 224u, st.nCalls );
+    EXPECT_EQ( 162u, st.nPassed );
+    EXPECT_EQ( 62u, st.nRejected );
+    uint64_t nEntries = 0;
+    for( uint64_t n : st.histogram ) nEntries += n;
+    EXPECT_EQ( 202u, nEntries );
+    EXPECT_GT( st.time, 0 );
+    EXPECT_LE( st.quantile( .5 ), st.quantile( .99 ) );
+
+    std::ostringstream text, json;
+    p.report( text );
+    p.report_json( json );
+    EXPECT_NE( std::string::npos, text.str().find( "test-merge" ) );
+    EXPECT_NE( std::string::npos, json.str().find( "\"test-merge\": {\"calls\": 224" ) );
+
+    p.reset();
+    EXPECT_FALSE( p.snapshot().count( "test-merge" ) );
+    record();
+    EXPECT_EQ( 112u, p.snapshot()["test-merge"].nCalls );
+}
+
+// Tests pipelines record invocations of their stages (if enabled)
+TEST( Profiler, pipelines ) {
+    Pipeline p;
+    p.append<profiled_cut>( "profiled_cut" ).append<profiled_twice>( "profiled_twice" );
+    Profiler::self().reset();
+    const double values[] = { -1, 2, -3, 4, 5 };
+    for( double v : values ) p << v;
+    p.process( values, 5 );
+    ParallelPipeline( p, 2, 1 ).process( values, 5 );
+    std::map<std::string, HandlerStats> s = Profiler::self().snapshot();
+    if( !Profiler::enabled ) {
+        EXPECT_FALSE( s.count( "profiled_cut" ) );
+        return;
+    }
+    EXPECT_EQ( 15u, s["profiled_cut"].nCalls );
+    EXPECT_EQ( 6u, s["profiled_cut"].nRejected );
+    EXPECT_EQ( 9u, s["profiled_twice"].nCalls );
+    EXPECT_EQ( 0u, s["profiled_twice"].nRejected );
+}
+
+// Tests adapters inserted between registered handlers have their own probes
+TEST( Profiler, adapters ) {
+    Pipeline p;
+    p.append<profiled_twice>( "profiled_twice" ).append( "test-profiled-half" );
+    Profiler::self().reset();
+    const double values[] = { 1, 2, 3 };
+    p.process( values, 3 );
+    if( !Profiler::enabled ) return;
+    std::map<std::string, HandlerStats> s = Profiler::self().snapshot();
+    const std::string adapter = std::string("<") + typeid(double).name()
+                              + " to " + typeid(float).name() + ">";
+    EXPECT_EQ( 3u, s[adapter].nCalls );
+    EXPECT_EQ( 3u, s["test-profiled-half"].nCalls );
+    EXPECT_FALSE( s.count( "<unregistered>" ) );
+}
@@ -0,0 +1,122 @@
+# include "pipeline/streaming.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking SPSC ring buffer and streaming pipeline.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+bool cut_negative( const double & x ) { return x >= 0; }
+double twice( const double & x ) { return 2*x; }
+bool throw_on_large( const double & x ) {
+    if( x > 1e6 ) throw std::runtime_error( "large value" );
+    return true;
+}
+
+// Stateful handler requiring ordered input
+struct Ordered {
+    double last = -1;
+    size_t nDisordered = 0, n = 0;
+    void call( const double & x ) {
+        if( x < last ) ++nDisordered;
+        last = x;
+        ++n;
+    }
+};
+
+}  // anonymous namespace
+
+// Tests ring keeps order and capacity
+TEST( Pipeline, spscRing ) {
+    SpscRing<int> r( 5 );
+    ASSERT_EQ( 8u, r.capacity() );
+    for( int i = 0; i < 8; ++i ) ASSERT_TRUE( r.try_push( i ) );
+    EXPECT_FALSE( r.try_push( 8 ) );
+    int v;
+    for( int i = 0; i < 8; ++i ) {
+        ASSERT_TRUE( r.try_pop( v ) );
+        EXPECT_EQ( i, v );
+    }
+    EXPECT_FALSE( r.try_pop( v ) );
+    RingStats st = r.stats();
+    EXPECT_EQ( 8u, st.nPushed );
+    EXPECT_EQ( 8u, st.maxOccupancy );
+    EXPECT_EQ( 1u, st.nFull );
+    EXPECT_EQ( 1u, st.nEmpty );
+    // concurrent producer and consumer
+    const int n = 100000;
+    std::thread producer( [&]{
+            Backoff b;
+            for( int i = 0; i < n; ++i ) {
+                while( !r.try_push( i ) ) b.pause();
+                b.reset();
+            }
+        } );
+    long sum = 0;
+    bool ordered = true;
+    Backoff b;
+    for( int i = 0; i < n; ++i ) {
+        while( !r.try_pop( v ) ) b.pause();
+        b.reset();
+        ordered = ordered && v == i;
+        sum += v;
+    }
+    producer.join();
+    EXPECT_TRUE( ordered );
+    EXPECT_EQ( long(n)*(n - 1)/2, sum );
+}
+
+// Tests streaming pipeline gives the same results as sequential one, in
+// order
+TEST( Pipeline, streaming ) {
+    auto ordered = std::make_shared<Ordered>();
+    Pipeline p;
+    p.append<cut_negative>( "cut_negative" )
+     .append<twice>( "twice" )
+     .append( ordered, "ordered" );
+    std::vector<double> values( 10000 );
+    for( size_t i = 0; i < values.size(); ++i ) values[i] = (i % 3) ? double(i) : -1.;
+    std::vector<double> results( values.size(), -1 );
+    size_t nResults = 0;
+    {
+        StreamingPipeline sp( p, {2, 1}, [&]( size_t offset, const Batch & b ) {
+                for( size_t i = 0; i < b.size(); ++i ) {
+                    results[offset + b.index()[i]] = b.values<double>()[i];
+                }
+                nResults += b.size();
+            }, 64, 4 );
+        EXPECT_EQ( 2u, sp.threads() );
+        // fed in portions not aligned with batches
+        sp.feed( values.data(), 1000 );
+        sp.feed( values.data() + 1000, values.size() - 1000 );
+        sp.flush();
+        EXPECT_EQ( ordered->n, nResults );
+        sp.close();
+        std::vector<RingStats> st = sp.queue_stats();
+        ASSERT_EQ( 3u, st.size() );
+        EXPECT_EQ( 4u, st[0].capacity );
+        EXPECT_LE( st[0].maxOccupancy, 4u );
+        EXPECT_EQ( 16u + 141u + 1u, st[0].nPushed );  // batches and marker
+    }
+    for( size_t i = 0; i < values.size(); ++i ) {
+        ASSERT_EQ( values[i] < 0 ? -1. : 2*values[i], results[i] ) << "value " << i;
+    }
+    EXPECT_EQ( 0u, ordered->nDisordered );
+    EXPECT_THROW( StreamingPipeline( p, {1, 1}, nullptr ), std::runtime_error );
+}
+
+// Tests exception thrown by handler is propagated
+TEST( Pipeline, streamingError ) {
+    Pipeline p;
+    p.append<throw_on_large>( "throw_on_large" );
+    StreamingPipeline sp( p, {}, []( size_t, const Batch & ) {}, 16, 2 );
+    std::vector<double> values( 1000, 1. );
+    values[500] = 1e7;
+    EXPECT_THROW( { sp.feed( values.data(), values.size() ); sp.flush(); }
+                , std::runtime_error );
+    EXPECT_THROW( sp.feed( values.data(), 1 ), std::runtime_error );
+}
@@ -0,0 +1,117 @@
+# include "pipeline/pipeline.hpp"
+
+# include "gtest/gtest.h"
+
+/*
+ * Unit test checking pipeline engine: fused and type-erased chains of
+ * handlers.
+ */
+
+using namespace dataflow;
+
+namespace {
+
+bool cut_negative( double & x ) { return x >= 0; }
+void halve( double & x ) { x /= 2; }
+double twice( double x ) { return 2*x; }
+int round_down( const double & x ) { return int(x); }
+std::string to_string( int x ) { return std::to_string(x); }
+
+struct Counter {
+    size_t n = 0;
+    bool call( double & ) { ++n; return true; }
+};
+
+}  // anonymous namespace
+
+// Tests handler kinds are deduced from signatures
+TEST( Pipeline, stageTraits ) {
+    typedef meta::StageTraits<decltype(&cut_negative)> CutTraits;
+    EXPECT_EQ( kCut, CutTraits::kind );
+    EXPECT_TRUE( (std::is_same<double, CutTraits::Output>::value) );
+    typedef meta::StageTraits<decltype(&halve)> TransformTraits;
+    EXPECT_EQ( kTransform, TransformTraits::kind );
+    typedef meta::StageTraits<decltype(&round_down)> MapTraits;
+    EXPECT_EQ( kMap, MapTraits::kind );
+    EXPECT_TRUE( (std::is_same<double, MapTraits::Input>::value) );
+    EXPECT_TRUE( (std::is_same<int, MapTraits::Output>::value) );
+    typedef meta::StageTraits<decltype(&Counter::call)> MethodTraits;
+    EXPECT_EQ( kCut, MethodTraits::kind );
+    EXPECT_TRUE( MethodTraits::stateful );
+}
+
+// Tests slot keeps values of different types
+TEST( Pipeline, slot ) {
+    Slot s;
+    EXPECT_TRUE( s.empty() );
+    s.emplace<double>( 1.5 );
+    EXPECT_TRUE( s.holds<double>() );
+    EXPECT_EQ( 1.5, s.get<double>() );
+    EXPECT_THROW( s.get<int>(), BadSlotAccess );
+    s.emplace<std::string>( "some rather long string exceeding SSO buffer" );
+    EXPECT_EQ( "some rather long string exceeding SSO buffer", s.get<std::string>() );
+    struct Big { double v[16]; };
+    s.emplace<Big>().v[15] = 3;  // does not fit into buffer
+    EXPECT_EQ( 3, s.get<Big>().v[15] );
+    s.reset();
+    EXPECT_TRUE( s.empty() );
+}
+
+// Tests README example: `false` returned by handler aborts propagation
+TEST( Pipeline, cut ) {
+    Pipeline p;
+    p.append<cut_negative>( "cut_negative" );
+    ASSERT_TRUE( (p << 3.).succeed() );
+    EXPECT_EQ( 3., p.get<double>() );
+    EXPECT_FALSE( (p << -1.).succeed() );
+}
+
+// Tests fused and type-erased chains give the same results
+TEST( Pipeline, fusedAndDynamic ) {
+    Pipeline dyn;
+    dyn.append<cut_negative>( "cut_negative" )
+       .append<halve>( "halve" )
+       .append<twice>( "twice" )
+       .append<round_down>( "round_down" )
+       .append<to_string>( "to_string" );
+    Pipeline mixed;
+    mixed.append<cut_negative, halve, twice>( "fused" )
+         .append<round_down>( "round_down" )
+         .append<to_string>( "to_string" );
+    StaticPipeline<cut_negative, halve, twice, round_down, to_string> st;
+    EXPECT_EQ( 5u, dyn.size() );
+    EXPECT_EQ( 3u, mixed.size() );
+    for( double v : {-2.5, 0., 1.25, 7.5, 1e3} ) {
+        dyn << v;
+        mixed << v;
+        st << v;
+        ASSERT_EQ( v >= 0, dyn.succeed() );
+        ASSERT_EQ( v >= 0, mixed.succeed() );
+        ASSERT_EQ( v >= 0, st.succeed() );
+        if( !dyn.succeed() ) continue;
+        EXPECT_EQ( std::to_string(int(v)), dyn.get<std::string>() );
+        EXPECT_EQ( std::to_string(int(v)), mixed.get<std::string>() );
+        EXPECT_EQ( std::to_string(int(v)), st.get() );
+    }
+}
+
+// Tests stateful handler instances are invoked
+TEST( Pipeline, stateful ) {
+    auto counter = std::make_shared<Counter>();
+    Pipeline p;
+    p.append<cut_negative>( "cut_negative" ).append( counter, "counter" );
+    for( double v : {-1., 1., 2., -3.} ) p << v;
+    EXPECT_EQ( 2u, counter->n );
+}
+
+// Tests type mismatch is detected when pipeline is built or fed
+TEST( Pipeline, incompatible ) {
+    Pipeline p;
+    p.append<round_down>( "round_down" );
+    EXPECT_THROW( p.append<halve>( "halve" ), IncompatibleHandlers );
+    EXPECT_EQ( 1u, p.size() );
+    EXPECT_THROW( p << 1, IncompatibleHandlers );
+    EXPECT_NO_THROW( p << 1. );
+    EXPECT_EQ( 1, p.get<int>() );
+    EXPECT_THROW( p.get<double>(), BadSlotAccess );
+}
@@ -0,0 +1,19 @@
+# include "handlers/index.hpp"
+
+/*
+ * Handlers of the plugin loaded by the unit test of handlers registry.
+ */
+
+namespace {
+
+void scale( double & x ) { x *= 10; }
+
+struct Counter {
+    size_t n = 0;
+    void call( const double & ) { ++n; }
+};
+
+}  // anonymous namespace
+
+DATAFLOW_REGISTER_HANDLER( "test_plugin_scale", scale )
+DATAFLOW_REGISTER_CLASS( "test_plugin_counter", Counter )
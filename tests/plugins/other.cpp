@@ -0,0 +1,18 @@
+# include "handlers/index.hpp"
+
+/*
+ * Handlers of the second plugin loaded by the unit test of handlers
+ * registry, one of them named as in the first plugin.
+ */
+
+namespace {
+
+void scale( double & x ) { x *= 100; }
+
+}  // anonymous namespace
+
+DATAFLOW_REGISTER_HANDLER( "test_plugin_scale", scale )
+
+// added by static initializer, so referred by qualified name too
+static const bool gOtherAdded
+        = ::dataflow::HandlersIndex::self().add<scale>( "test_plugin_added" );
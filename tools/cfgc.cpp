@@ -0,0 +1,37 @@
+/*
+ * Configuration compiler: converts JSON configuration file into the binary
+ * image of frozen configuration, which then can be mapped by
+ * `dataflow::config::map_image()` with no parsing.
+ *
+ * Usage: dataflow-cfgc <input.json> <output.dfc>
+ */
+
+# include "parameters/json.hpp"
+# include "parameters/frozen.hpp"
+
+# include <cstdio>
+
+using namespace dataflow::config;
+
+int
+main( int argc, char * argv[] ) {
+    if( 3 != argc ) {
+        fprintf( stderr, "Usage: %s <input.json> <output.dfc>\n", argv[0] );
+        return 1;
+    }
+    try {
+        std::shared_ptr<AbstractParameter> root;
+        {
+            auto doc = json::Document::load( argv[1] );
+            root = json::to_parameters( doc->root() );
+        }
+        FrozenConfig cfg = freeze( *root );
+        root.reset();
+        write_image( cfg, argv[2] );
+        printf( "%s: %zu bytes written.\n", argv[2], cfg.size() );
+    } catch( std::exception & e ) {
+        fprintf( stderr, "Error: %s\n", e.what() );
+        return 1;
+    }
+    return 0;
+}